@@ -21,10 +21,27 @@
 #define MV_RESULT_LENGTH_MAX (MV_RESULT_COUNT_MAX * 4) //4(x, y, w, h) * COUNT
 #define IMAGE_INFO_MAX ((8 * MV_RESULT_LENGTH_MAX) + 4)
 
+/* default preview (detection) resolution, see CONFIG_KEY_PREVIEW_WIDTH */
 #define IMAGE_WIDTH 320
 #define IMAGE_HEIGHT 240
-#define IMAGE_RESOLUTION (320 * 240)
+#define CAMERA_CAPTURE_INTERVAL_DEFAULT 1000
+#define CAMERA_CAPTURE_TIMEOUT 3000
 #define CAMERA_IMAGE_QUALITY 100 //1~100
-#define CAMERA_PREVIEW_INTERVAL_MIN 50
+#define CAMERA_PREVIEW_INTERVAL_MIN 50 // with motion, see CONFIG_KEY_RATE_ACTIVE_INTERVAL
+#define CAMERA_PREVIEW_IDLE_INTERVAL 500
+#define CAMERA_PREVIEW_IDLE_TIMEOUT 5000
+#define CAMERA_PREVIEW_BACKOFF_MAX 3
+#define CAMERA_PREVIEW_BACKOFF_RECOVER 2000
+#define CAMERA_STREAM_MAX 4
+#define MV_ANALYSIS_WIDTH_MIN 160 // automatic pyramid level keeps at least this width
+#define CAMERA_FRAME_RING_DEPTH_DEFAULT 2 // see CONFIG_KEY_FRAME_RING_DEPTH
+#define CAMERA_FRAME_RING_DEPTH_MAX 8
+#define ENCODE_QUEUE_DEPTH 1 // snapshots waiting for the encode stage
+/*
+ * Most preview buffers held at once: the ring, the one the camera fills,
+ * the one on the main loop, the latest frame, the encode queue and the one
+ * being encoded. The persist and notify stages only hold JPEGs.
+ */
+#define CAMERA_FRAME_POOL_SIZE(ring_depth) ((ring_depth) + ENCODE_QUEUE_DEPTH + 4)
 
 #endif
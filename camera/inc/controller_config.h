@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __CONTROLLER_CONFIG_H__
+#define __CONTROLLER_CONFIG_H__
+
+/*
+ * Runtime settings, kept in the app preference store so they survive a
+ * restart. They can be changed with the "config" app control command
+ * (extra data "key" and "value").
+ */
+
+/* number of camera streams, 1 ~ CAMERA_STREAM_MAX */
+#define CONFIG_KEY_STREAM_COUNT "camera.stream.count"
+
+/*
+ * The keys below can be overridden per stream with a "stream<N>." prefix,
+ * e.g. "stream1.camera.replay.path".
+ */
+
+/* detection stream, IMAGE_WIDTH x IMAGE_HEIGHT by default */
+#define CONFIG_KEY_PREVIEW_WIDTH "camera.preview.width"
+#define CONFIG_KEY_PREVIEW_HEIGHT "camera.preview.height"
+/*
+ * snapshot stream (JPEG capture) for the image files, the dashboard and
+ * Telegram. 0 (default) makes snapshots out of the preview frames.
+ */
+#define CONFIG_KEY_CAPTURE_WIDTH "camera.capture.width"
+#define CONFIG_KEY_CAPTURE_HEIGHT "camera.capture.height"
+/*
+ * minimum time between captures in ms, motion events take one right away.
+ * 0 only captures on motion entry, the default when capturing stops the preview.
+ */
+#define CONFIG_KEY_CAPTURE_INTERVAL "camera.capture.interval"
+
+/* preview frame rate scheduler, all in ms */
+#define CONFIG_KEY_RATE_ACTIVE_INTERVAL "camera.rate.active"
+#define CONFIG_KEY_RATE_IDLE_INTERVAL "camera.rate.idle"
+#define CONFIG_KEY_RATE_IDLE_TIMEOUT "camera.rate.idle_timeout"
+/* preview frames waiting for the main loop, 1 ~ CAMERA_FRAME_RING_DEPTH_MAX */
+#define CONFIG_KEY_FRAME_RING_DEPTH "camera.frame_ring.depth"
+
+/* luma pyramid level motion is detected on, 0 (full) ~ 2 (1/4), -1 (default) picks one */
+#define CONFIG_KEY_MV_LEVEL "mv.level"
+/* "surveillance" (default, media vision) or "native" (motion_detector) */
+#define CONFIG_KEY_MV_ENGINE "mv.engine"
+/* luma difference a pixel must exceed to be moving, 0 ~ 255 */
+#define CONFIG_KEY_MV_THRESHOLD "mv.threshold"
+/*
+ * polygons in percent of the frame, "x,y x,y x,y" with ";" between them.
+ * Motion is only looked for inside the roi (whole frame if not set) and
+ * outside the exclude polygons. See motion_mask.h
+ */
+#define CONFIG_KEY_MV_ROI "mv.roi"
+#define CONFIG_KEY_MV_EXCLUDE "mv.exclude"
+/* threads the native engine splits each frame over, shared by all streams, 1 for none */
+#define CONFIG_KEY_MV_THREADS "mv.threads"
+/* 1 (default) holds back alerts when the lighting changes or the camera shakes, 0 reports them */
+#define CONFIG_KEY_MV_GLOBAL_CHANGE "mv.global_change"
+/* "off" (default) or "face": motion regions are searched for faces, and only motion with one raises an alert */
+#define CONFIG_KEY_MV_CLASSIFY "mv.classify"
+/* ms per second the search may take, 100 by default */
+#define CONFIG_KEY_MV_CLASSIFY_BUDGET "mv.classify.budget"
+
+/*
+ * directory latest.jpg is written to, e.g. a tmpfs to spare the flash, the
+ * shared data directory by default. The shared data path links to it.
+ */
+#define CONFIG_KEY_IMAGE_PUBLISH_DIR "image.publish.dir"
+/* "none" (default), "data" (file data synced) or "full" (and the directory) */
+#define CONFIG_KEY_IMAGE_FSYNC "image.fsync"
+/* slots of the shared frame ring (frames.ring), 4 by default, 0 for no ring */
+#define CONFIG_KEY_IMAGE_RING_SLOTS "image.ring.slots"
+/* KB per slot, 1024 by default, larger snapshots are not put in the ring */
+#define CONFIG_KEY_IMAGE_RING_SLOT_SIZE "image.ring.slot_size"
+/*
+ * "ascii" (default) keeps the motion info as text in the EXIF user comment
+ * next to the binary record, "none" leaves the comment out
+ */
+#define CONFIG_KEY_IMAGE_META_COMMENT "image.meta.comment"
+/*
+ * luma levels any 16x16 block mean may change by for a frame to count as
+ * unchanged and be skipped, 2 by default, -1 processes every frame
+ */
+#define CONFIG_KEY_IMAGE_STATIC_THRESHOLD "image.static.threshold"
+/* ms after which an unchanged frame is processed anyway, 10000 by default */
+#define CONFIG_KEY_IMAGE_STATIC_REFRESH "image.static.refresh"
+
+/* "device" or "replay" */
+#define CONFIG_KEY_CAMERA_SOURCE "camera.source"
+/* raw file or directory of JPEG files */
+#define CONFIG_KEY_REPLAY_PATH "camera.replay.path"
+/* "nv12", "i420", "yuyv" or "jpeg", guessed from the path if not set */
+#define CONFIG_KEY_REPLAY_FORMAT "camera.replay.format"
+#define CONFIG_KEY_REPLAY_WIDTH "camera.replay.width"
+#define CONFIG_KEY_REPLAY_HEIGHT "camera.replay.height"
+/* "realtime", "fast" or "fixed" */
+#define CONFIG_KEY_REPLAY_PACING "camera.replay.pacing"
+#define CONFIG_KEY_REPLAY_FPS "camera.replay.fps"
+#define CONFIG_KEY_REPLAY_LOOP "camera.replay.loop"
+
+int controller_config_get_int(const char *key, int default_value);
+/* Returns a newly allocated string, free it with free() */
+char *controller_config_get_string(const char *key, const char *default_value);
+int controller_config_set(const char *key, const char *value);
+/* Sets the "stream<N>." key of one stream */
+int controller_config_set_stream(int stream_id, const char *key, const char *value);
+
+int controller_config_get_stream_int(int stream_id, const char *key, int default_value);
+char *controller_config_get_stream_string(int stream_id, const char *key, const char *default_value);
+
+#endif /* __CONTROLLER_CONFIG_H__ */
@@ -17,11 +17,25 @@
 #ifndef __CONTROLLER_IMAGE_H__
 #define __CONTROLLER_IMAGE_H__
 
-void controller_image_initialize(void);
-void controller_image_finalize(void);
-int controller_image_save_image_file(const char *path,
-	unsigned int width, unsigned int height, const unsigned char *buffer,
-	unsigned char** encoded, unsigned long long* encoded_size, const char *comment, unsigned int comment_len);
-int controller_image_read_image_file(const char *path,
-	unsigned int *width, unsigned int *height, unsigned char *buffer, unsigned long long *size);
+#include "image_frame.h"
+#include "image_publish.h"
+
+typedef struct __image_data *controller_image_h;
+
+/* Each handle owns its encoder, use one per writer thread */
+controller_image_h controller_image_initialize(void);
+void controller_image_finalize(controller_image_h image);
+/* JPEG of a frame in *encoded, which the caller frees */
+int controller_image_encode(controller_image_h image, const image_frame_view_s *view,
+	unsigned char** encoded, unsigned long long* encoded_size);
+/*
+ * JPEG data, e.g. a camera capture or an encoded frame, with an EXIF APP1
+ * of the comment, written in one call and published atomically. segment
+ * is put after the APP1 as is, e.g. the APP10 motion record, and may be NULL.
+ */
+int controller_image_publish_jpeg(image_publish_h publish, const unsigned char *jpeg, unsigned int jpeg_size,
+	unsigned int width, unsigned int height, const char *comment, unsigned int comment_len,
+	const unsigned char *segment, unsigned int segment_size);
+int controller_image_read_image_file(controller_image_h image, const char *path,
+	unsigned long *width, unsigned long *height, unsigned char *buffer, unsigned long long *size);
 #endif
@@ -16,15 +16,55 @@
 
 #ifndef __CONTROLLER_MV_H__
 #define __CONTROLLER_MV_H__
-#include <mv_common.h>
+#include "controller.h"
+#include "image_frame.h"
+#include "motion_detector.h"
+#include "worker_pool.h"
+#include "region_classifier.h"
 
-typedef void (*movement_detected_cb)(int area_sum, int result[], int result_count, void *user_data);
+typedef struct __mv_data *controller_mv_h;
 
-mv_source_h controller_mv_create_source(
-		unsigned char *buffer, unsigned int size,
-		unsigned int width, unsigned int height, mv_colorspace_e colorspace);
-void controller_mv_push_source(mv_source_h source);
-int controller_mv_set_movement_detection_event_cb(movement_detected_cb movement_detected_cb, void *user_data);
-void controller_mv_unset_movement_detection_event_cb(void);
+typedef struct __controller_mv_event_s {
+	int area_sum; // of the zones, in full frame pixels
+	int result[MV_RESULT_LENGTH_MAX]; // x, y, width, height of each zone, 0 ~ 99
+	int result_count;
+	/* the same zones in full frame pixels and the area of each */
+	unsigned int region[MV_RESULT_LENGTH_MAX];
+	unsigned int region_area[MV_RESULT_COUNT_MAX];
+	/* zones with a face in them, -1 when they are not classified */
+	int object_count;
+	/* track of each zone and its age in ms, 0 for an untracked zone */
+	unsigned int track_id[MV_RESULT_COUNT_MAX];
+	unsigned int track_age[MV_RESULT_COUNT_MAX];
+	/* tracks confirmed by this event and the first of them, each track enters only once */
+	int entered;
+	unsigned int entered_id;
+} controller_mv_event_s;
+
+typedef void (*movement_detected_cb)(const controller_mv_event_s *event, void *user_data);
+
+/*
+ * Detects motion on a luma pyramid level of the frame, the movement
+ * callback is called from within when there is any. Results are reported
+ * for the full frame.
+ */
+int controller_mv_push_frame(controller_mv_h mv, const image_frame_view_s *view);
+/*
+ * One detector per video stream, stream_id is used as the surveillance video
+ * stream id. CONFIG_KEY_MV_ENGINE picks mv_surveillance or the native one.
+ */
+int controller_mv_set_movement_detection_event_cb(int stream_id,
+	movement_detected_cb movement_detected_cb, void *user_data, controller_mv_h *mv);
+void controller_mv_unset_movement_detection_event_cb(controller_mv_h mv);
+/* Reads CONFIG_KEY_MV_ROI and CONFIG_KEY_MV_EXCLUDE of the stream again, on the main loop */
+int controller_mv_reload_mask(controller_mv_h mv);
+/* Pool the native engine analyses frames on, not owned, NULL for the calling thread */
+void controller_mv_set_worker_pool(controller_mv_h mv, worker_pool_h pool);
+/* Returns -1 when the stream does not use the native engine */
+int controller_mv_get_detector_stats(controller_mv_h mv, motion_detector_stats_s *stats);
+/* Returns -1 when CONFIG_KEY_MV_CLASSIFY is off for the stream */
+int controller_mv_get_classifier_stats(controller_mv_h mv, region_classifier_stats_s *stats);
+/* Motion tracks that are still alive, confirmed or not */
+unsigned int controller_mv_get_track_count(controller_mv_h mv);
 
 #endif
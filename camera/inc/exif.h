@@ -17,13 +17,16 @@
 #ifndef __APP_EXIF_H__
 #define __APP_EXIF_H__
 
-/* CAUTION
- * This function is only for adding exif with user comment
- * to JPEG which has No existing exif data !!!
+/* room for an APP1 segment of exif_build_app1_with_comment() */
+#define EXIF_APP1_SIZE_MAX 4096
+
+/*
+ * APP1 segment, marker and length included, with the dimensions and the
+ * comment in app1, which holds EXIF_APP1_SIZE_MAX bytes. It goes right
+ * after the SOI of the JPEG.
  */
-int exif_write_jpg_file_with_comment(const char *output_file,
-		const unsigned char *jpg_data, unsigned int jpg_size,
-		unsigned int jpg_width, unsigned int jpg_height,
-		const char *comment, unsigned int comment_len);
+int exif_build_app1_with_comment(unsigned int jpg_width, unsigned int jpg_height,
+		const char *comment, unsigned int comment_len,
+		unsigned char *app1, unsigned int *app1_size);
 
 #endif /* __APP_EXIF_H__ */
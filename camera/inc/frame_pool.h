@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __FRAME_POOL_H__
+#define __FRAME_POOL_H__
+
+#include "resource_camera.h"
+
+typedef struct __frame_pool_s frame_pool_s;
+
+typedef struct __frame_pool_stats_s {
+	unsigned int frame_count;
+	unsigned int frame_size;
+	unsigned int in_use;
+	unsigned int high_water_mark;
+	unsigned long long acquired;
+	unsigned long long exhausted;
+} frame_pool_stats_s;
+
+/*
+ * Frames are handed out with a reference count of 1 and go back to the pool
+ * when the last reference is dropped. The pool itself stays alive until
+ * every frame has been returned, so it is safe to destroy it while
+ * consumers still hold frames.
+ */
+frame_pool_s *frame_pool_create(unsigned int frame_count, unsigned int frame_size);
+void frame_pool_destroy(frame_pool_s *pool);
+unsigned int frame_pool_get_frame_size(frame_pool_s *pool);
+void frame_pool_get_stats(frame_pool_s *pool, frame_pool_stats_s *stats);
+
+image_buffer_data_s *frame_pool_acquire(frame_pool_s *pool);
+image_buffer_data_s *frame_pool_ref(image_buffer_data_s *frame);
+void frame_pool_unref(image_buffer_data_s *frame);
+
+#endif /* __FRAME_POOL_H__ */
@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __FRAME_RING_H__
+#define __FRAME_RING_H__
+
+#include "resource_camera.h"
+
+typedef struct __frame_ring_s frame_ring_s;
+
+typedef struct __frame_ring_stats_s {
+	unsigned int depth;
+	unsigned long long pushed;
+	unsigned long long consumed;
+	unsigned long long overwritten;
+	unsigned long long dropped;
+	unsigned long long wakeups;
+	unsigned int max_batch;
+} frame_ring_stats_s;
+
+/* Called on the main loop for every frame, in sequence order.
+ * The callback owns the frame reference. */
+typedef void (*frame_ring_consume_cb)(image_buffer_data_s *frame, void *user_data);
+
+/*
+ * Single-producer/single-consumer ring between the camera callback thread
+ * and the Ecore main loop. When the main loop falls behind, the producer
+ * overwrites the oldest unconsumed frame (newest wins). The main loop is
+ * woken at most once per batch through an eventfd.
+ *
+ * frame_ring_create() and frame_ring_destroy() must be called on the main loop.
+ */
+frame_ring_s *frame_ring_create(unsigned int depth, frame_ring_consume_cb consume_cb, void *user_data);
+void frame_ring_destroy(frame_ring_s *ring);
+void frame_ring_push(frame_ring_s *ring, image_buffer_data_s *frame);
+void frame_ring_get_stats(frame_ring_s *ring, frame_ring_stats_s *stats);
+
+#endif /* __FRAME_RING_H__ */
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __FRAME_SCHEDULER_H__
+#define __FRAME_SCHEDULER_H__
+
+#include <stdbool.h>
+
+typedef struct __frame_scheduler_s frame_scheduler_s;
+
+typedef enum {
+	FRAME_SCHEDULER_ACTIVE, // motion seen recently, full rate
+	FRAME_SCHEDULER_IDLE, // quiet for idle_timeout, low rate
+} frame_scheduler_state_e;
+
+typedef struct __frame_scheduler_config_s {
+	unsigned int active_interval; // ms between frames with motion
+	unsigned int idle_interval; // ms between frames without motion
+	unsigned int idle_timeout; // ms without motion before going idle
+	unsigned int backoff_max; // saturation doubles the interval up to 2^backoff_max
+	unsigned int backoff_recover; // ms without saturation to undo one doubling
+} frame_scheduler_config_s;
+
+typedef struct __frame_scheduler_stats_s {
+	frame_scheduler_state_e state;
+	unsigned int backoff; // current doubling level
+	unsigned int interval; // ms, what the gate uses right now
+	double effective_fps; // delivered frames over the last full second
+	unsigned long long offered;
+	unsigned long long delivered;
+	unsigned long long motion_events;
+	unsigned long long saturation_events;
+	unsigned long long state_changes;
+} frame_scheduler_stats_s;
+
+/*
+ * Decides which camera frames go into the preview pipeline. The rate drops
+ * to idle_interval when no motion has been reported for idle_timeout and
+ * goes back to active_interval on the next motion report. Saturation
+ * reports from downstream stretch the interval on top of that.
+ *
+ * frame_scheduler_should_deliver() is called from the camera thread, the
+ * notify functions from any thread.
+ */
+frame_scheduler_s *frame_scheduler_create(const frame_scheduler_config_s *config);
+void frame_scheduler_destroy(frame_scheduler_s *scheduler);
+bool frame_scheduler_should_deliver(frame_scheduler_s *scheduler, long long int now_ms);
+void frame_scheduler_notify_motion(frame_scheduler_s *scheduler);
+void frame_scheduler_notify_saturated(frame_scheduler_s *scheduler);
+void frame_scheduler_get_stats(frame_scheduler_s *scheduler, frame_scheduler_stats_s *stats);
+
+#endif /* __FRAME_SCHEDULER_H__ */
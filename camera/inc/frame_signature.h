@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef __FRAME_SIGNATURE_H__
+#define __FRAME_SIGNATURE_H__
+
+#include "image_frame.h"
+
+/* pixels per side of a signature block */
+#define FRAME_SIGNATURE_BLOCK 16
+
+typedef struct __frame_signature_s *frame_signature_h;
+
+typedef struct __frame_signature_stats_s {
+	unsigned long long int frames;
+	unsigned long long int unchanged; // frames found like the reference
+	unsigned int average_usec;
+	unsigned int difference; // largest block difference of the last frame, in luma levels
+} frame_signature_stats_s;
+
+/*
+ * Luma sums of the 16x16 blocks of a frame, with the SIMD kernels of
+ * image_convert, compared with those of a reference frame to find frames
+ * nothing happened in.
+ */
+frame_signature_h frame_signature_create(void);
+void frame_signature_destroy(frame_signature_h signature);
+
+/*
+ * Returns 1 when no block mean of view is more than threshold luma levels
+ * from the reference, which is kept, 0 when one is or there is no
+ * reference yet, and view becomes the reference, -1 on error.
+ */
+int frame_signature_update(frame_signature_h signature, const image_frame_view_s *view, unsigned int threshold);
+/* The next frame becomes the reference whatever it is */
+void frame_signature_reset(frame_signature_h signature);
+void frame_signature_get_stats(frame_signature_h signature, frame_signature_stats_s *stats);
+
+#endif /* __FRAME_SIGNATURE_H__ */
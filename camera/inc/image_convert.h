@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __IMAGE_CONVERT_H__
+#define __IMAGE_CONVERT_H__
+
+#include <stdbool.h>
+#include "image_frame.h"
+
+typedef enum {
+	IMAGE_CONVERT_I420, // Y, U, V planes, 4:2:0
+	IMAGE_CONVERT_NV12, // Y plane, interleaved UV plane, 4:2:0
+	IMAGE_CONVERT_LUMA, // Y plane only
+} image_convert_target_e;
+
+/*
+ * Converts camera frames (NV12, NV21, I420, YV12, 422P, YUYV, UYVY,
+ * RGB565, RGB888 and RGBA) into packed I420, NV12 or luma. RGB input
+ * uses BT.601 studio range, 4:2:2 input averages chroma of row pairs.
+ * Odd sizes get (width + 1) / 2 by (height + 1) / 2 chroma samples.
+ *
+ * The row kernels are picked once at runtime from NEON, AVX2, SSE2 and
+ * scalar, and are checked against the scalar ones before they are used.
+ */
+bool image_convert_is_supported(camera_pixel_format_e format);
+unsigned int image_convert_get_size(image_convert_target_e target, unsigned int width, unsigned int height);
+int image_convert_frame(const image_frame_view_s *src, image_convert_target_e target,
+	unsigned char *dst, unsigned int dst_size);
+
+/*
+ * Same as image_convert_frame(), into *scratch which is grown as needed and
+ * owned by the caller. A packed frame already in the target format is
+ * returned as is, without a copy.
+ */
+const unsigned char *image_convert_get_frame(const image_frame_view_s *src, image_convert_target_e target,
+	unsigned char **scratch, unsigned int *scratch_size);
+
+/* "neon", "avx2", "sse2" or "scalar" */
+const char *image_convert_get_kernel_name(void);
+
+#endif /* __IMAGE_CONVERT_H__ */
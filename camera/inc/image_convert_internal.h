@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __IMAGE_CONVERT_INTERNAL_H__
+#define __IMAGE_CONVERT_INTERNAL_H__
+
+#include <stdbool.h>
+
+/*
+ * Row kernels behind image_convert. Every implementation must give the
+ * same bytes as the scalar one, for any count and any alignment.
+ */
+typedef struct __image_convert_kernels_s {
+	const char *name;
+	/* dst[i] = src[2 * i + offset], Y or chroma out of YUYV/UYVY */
+	void (*extract_bytes)(const unsigned char *src, unsigned char *dst, unsigned int count, unsigned int offset);
+	/* dst[i] = (a[i] + b[i] + 1) >> 1 */
+	void (*average_rows)(const unsigned char *a, const unsigned char *b, unsigned char *dst, unsigned int count);
+	/* count UV pairs into U and V */
+	void (*split_uv)(const unsigned char *uv, unsigned char *u, unsigned char *v, unsigned int count);
+	/* count U and V bytes into UV pairs */
+	void (*merge_uv)(const unsigned char *u, const unsigned char *v, unsigned char *uv, unsigned int count);
+	/* count RGBA pixels into BT.601 Y */
+	void (*rgba_to_y)(const unsigned char *src, unsigned char *y, unsigned int count);
+	/* dst[i] = 2x2 box of the two rows, rounded, count output pixels */
+	void (*downscale_2x)(const unsigned char *row0, const unsigned char *row1, unsigned char *dst, unsigned int count);
+
+	/* Motion detection on luma rows */
+	/*
+	 * One step of the background model, see MOTION_MODEL_*. mask[i] = 255
+	 * when cur[i] is further than max(3 dev[i], min_diff) from mean[i]
+	 */
+	void (*update_background)(const unsigned char *cur, short *mean, short *dev, unsigned char *mask,
+		unsigned int count, short min_diff);
+	/* dst[i] = min (erode) or max (dilate) of the 3x3 block around column i of rows r0 ~ r2, edge columns repeat */
+	void (*erode_3x3)(const unsigned char *r0, const unsigned char *r1, const unsigned char *r2, unsigned char *dst, unsigned int count);
+	void (*dilate_3x3)(const unsigned char *r0, const unsigned char *r1, const unsigned char *r2, unsigned char *dst, unsigned int count);
+
+	/* sums[i] += src[16 * i] + ... + src[16 * i + 15], count blocks, for frame signatures */
+	void (*sum_blocks)(const unsigned char *src, unsigned int *sums, unsigned int count);
+} image_convert_kernels_s;
+
+/*
+ * Background model: per pixel running mean and mean absolute deviation in
+ * 1/128 luma. Background pixels follow the frame at 1/32 per frame,
+ * foreground ones at 1/256 so that parked objects fade in slowly.
+ */
+#define MOTION_MODEL_FRAC_BITS 7
+#define MOTION_MODEL_RATE_SHIFT 5
+#define MOTION_MODEL_FOREGROUND_RATE_SHIFT 8
+
+extern const image_convert_kernels_s image_convert_scalar_kernels;
+
+/* Kernels picked for this CPU */
+const image_convert_kernels_s *image_convert_get_kernels(void);
+
+#if defined(__x86_64__) || defined(__i386__)
+#define IMAGE_CONVERT_X86
+extern const image_convert_kernels_s image_convert_sse2_kernels;
+extern const image_convert_kernels_s image_convert_avx2_kernels;
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define IMAGE_CONVERT_NEON
+extern const image_convert_kernels_s image_convert_neon_kernels;
+bool image_convert_neon_is_available(void);
+#endif
+
+/* Scalar kernels, also used by the SIMD ones for the tail of a row */
+void image_convert_scalar_extract_bytes(const unsigned char *src, unsigned char *dst, unsigned int count, unsigned int offset);
+void image_convert_scalar_average_rows(const unsigned char *a, const unsigned char *b, unsigned char *dst, unsigned int count);
+void image_convert_scalar_split_uv(const unsigned char *uv, unsigned char *u, unsigned char *v, unsigned int count);
+void image_convert_scalar_merge_uv(const unsigned char *u, const unsigned char *v, unsigned char *uv, unsigned int count);
+void image_convert_scalar_rgba_to_y(const unsigned char *src, unsigned char *y, unsigned int count);
+void image_convert_scalar_downscale_2x(const unsigned char *row0, const unsigned char *row1, unsigned char *dst, unsigned int count);
+void image_convert_scalar_update_background(const unsigned char *cur, short *mean, short *dev, unsigned char *mask,
+	unsigned int count, short min_diff);
+void image_convert_scalar_sum_blocks(const unsigned char *src, unsigned int *sums, unsigned int count);
+/* columns from ~ to - 1 of a 3x3 erode or dilate over rows of count pixels */
+void image_convert_scalar_morph_3x3(const unsigned char *r0, const unsigned char *r1, const unsigned char *r2,
+	unsigned char *dst, unsigned int from, unsigned int to, unsigned int count, bool dilate);
+
+#endif /* __IMAGE_CONVERT_INTERNAL_H__ */
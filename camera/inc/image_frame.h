@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __IMAGE_FRAME_H__
+#define __IMAGE_FRAME_H__
+
+#include <stdbool.h>
+#include <camera.h>
+
+#define IMAGE_PLANE_MAX 3
+
+typedef struct __image_plane_s {
+	unsigned char *data;
+	unsigned int offset; // from the start of the frame buffer
+	unsigned int stride; // bytes between two rows
+	unsigned int width; // bytes of pixel data per row
+	unsigned int height; // rows
+} image_plane_s;
+
+typedef struct __image_frame_view_s {
+	camera_pixel_format_e format;
+	unsigned int width;
+	unsigned int height;
+	unsigned int num_planes;
+	image_plane_s planes[IMAGE_PLANE_MAX];
+} image_frame_view_s;
+
+/* Number of planes and per-plane row geometry of a pixel format */
+unsigned int image_frame_get_plane_count(camera_pixel_format_e format);
+int image_frame_get_plane_geometry(camera_pixel_format_e format,
+	unsigned int width, unsigned int height, unsigned int index,
+	unsigned int *row_bytes, unsigned int *rows);
+
+/*
+ * Describes a frame whose planes start at the given offsets of base.
+ * strides (NULL, or 0 for a plane, when unknown) are the bytes between rows
+ * as reported by the source. Without one, plane_sizes may be padded: a size
+ * that divides exactly into the rows gives the stride, any other is taken
+ * as packed rows followed by padding at the end.
+ * A single plane holding a planar format is split at the packed offsets.
+ */
+int image_frame_view_init(image_frame_view_s *view, camera_pixel_format_e format,
+	unsigned int width, unsigned int height, unsigned char *base,
+	unsigned int num_planes, const unsigned int offsets[], const unsigned int plane_sizes[],
+	const unsigned int strides[]);
+
+bool image_frame_view_is_packed(const image_frame_view_s *view);
+unsigned int image_frame_view_get_packed_size(const image_frame_view_s *view);
+int image_frame_view_pack(const image_frame_view_s *view, unsigned char *dst, unsigned int dst_size);
+
+/*
+ * Returns a pointer to the frame in packed layout. No copy is made when the
+ * view is already packed, otherwise it is packed into *scratch, which is
+ * grown as needed and owned by the caller.
+ */
+const unsigned char *image_frame_view_get_packed(const image_frame_view_s *view,
+	unsigned char **scratch, unsigned int *scratch_size);
+
+#endif /* __IMAGE_FRAME_H__ */
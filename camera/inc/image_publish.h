@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef __IMAGE_PUBLISH_H__
+#define __IMAGE_PUBLISH_H__
+
+#include <stdbool.h>
+#include <sys/uio.h>
+
+typedef enum {
+	IMAGE_PUBLISH_SYNC_NONE, // page cache only, a power loss may lose the last files
+	IMAGE_PUBLISH_SYNC_DATA, // file data on storage before it is published
+	IMAGE_PUBLISH_SYNC_FULL, // and the directory after it is published
+} image_publish_sync_e;
+
+typedef struct __image_publish_stats_s {
+	unsigned long long int published;
+	unsigned long long int failed;
+	unsigned long long int bytes;
+	unsigned int average_usec; // write, sync and rename of a file
+	unsigned int max_usec;
+	bool tmpfile; // written unnamed with O_TMPFILE
+} image_publish_stats_s;
+
+typedef struct __image_publish_s *image_publish_h;
+
+/*
+ * Replaces dir/name atomically with each file, readers see the old or the
+ * new file and never a partial one. A file is written unnamed (O_TMPFILE)
+ * where the file system allows it and only linked as temp_name once it is
+ * complete, then renamed over name. Otherwise it is written as temp_name.
+ */
+image_publish_h image_publish_create(const char *dir, const char *name, const char *temp_name,
+	image_publish_sync_e sync);
+void image_publish_destroy(image_publish_h publish);
+
+/* Writes the buffers of iov in one call and publishes them as a file */
+int image_publish_write(image_publish_h publish, const struct iovec *iov, int iov_count);
+
+/*
+ * Makes link_path a symbolic link to the published file, e.g. to keep the
+ * path readers know when files are published on tmpfs
+ */
+int image_publish_link(image_publish_h publish, const char *link_path);
+void image_publish_get_stats(image_publish_h publish, image_publish_stats_s *stats);
+
+#endif /* __IMAGE_PUBLISH_H__ */
@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __IMAGE_PYRAMID_H__
+#define __IMAGE_PYRAMID_H__
+
+#include "image_frame.h"
+
+/* level 0 is the full frame, level n is 1/2^n of it in each direction */
+#define IMAGE_PYRAMID_LEVEL_MAX 2
+
+typedef struct __image_luma_s {
+	const unsigned char *data;
+	unsigned int width;
+	unsigned int height;
+	unsigned int stride;
+} image_luma_s;
+
+typedef struct __image_pyramid_s {
+	unsigned int levels; // valid entries of level[]
+	image_luma_s level[IMAGE_PYRAMID_LEVEL_MAX + 1];
+
+	/* owned storage, reused across frames */
+	unsigned char *buffer;
+	unsigned int buffer_size;
+} image_pyramid_s;
+
+/*
+ * Builds the luma levels 0 ~ top_level of a frame with 2x2 box filters,
+ * each level from the one below, in a single pass over the Y plane.
+ * Level 0 points into the frame itself when it has a Y plane, so the
+ * pyramid is only valid while the frame is.
+ */
+int image_pyramid_build(image_pyramid_s *pyramid, const image_frame_view_s *view, unsigned int top_level);
+void image_pyramid_release(image_pyramid_s *pyramid);
+
+#endif /* __IMAGE_PYRAMID_H__ */
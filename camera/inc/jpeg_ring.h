@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef __JPEG_RING_H__
+#define __JPEG_RING_H__
+
+#include <stdint.h>
+
+/*
+ * A file of frame slots the camera service maps and writes encoded frames
+ * to, for readers that map it once and pick up new frames without going
+ * through latest.jpg. All fields are little endian 32 bit words so a reader
+ * without mmap (server.js) can read them from the file too.
+ *
+ * The writer bumps lock of a slot to odd, fills it, bumps it back to even
+ * and then sets head to the frame's sequence. A reader copies the slot of
+ * head and keeps the copy only if lock was even and the same before and
+ * after (seqlock). Frame n lives in slot (n - 1) % slot_count.
+ */
+#define JPEG_RING_MAGIC 0x474e524a // "JRNG"
+#define JPEG_RING_VERSION 2
+#define JPEG_RING_META_MAX 1024
+
+typedef struct __jpeg_ring_header_s {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t slot_count;
+	uint32_t slot_size; // bytes of a slot, its header included
+	uint32_t head; // sequence of the newest frame, 0 before the first
+	uint32_t open; // 1 while a writer has it, readers open it again after 0
+	uint32_t reserved[10];
+} jpeg_ring_header_s;
+
+typedef struct __jpeg_ring_slot_s {
+	uint32_t lock; // odd while the slot is written
+	uint32_t sequence;
+	uint32_t timestamp_sec; // wall clock when the frame was written
+	uint32_t timestamp_msec;
+	uint32_t width;
+	uint32_t height;
+	uint32_t size; // of the JPEG after the slot header
+	uint32_t meta_size;
+	uint32_t reserved[8];
+	unsigned char meta[JPEG_RING_META_MAX]; // motion_meta.h record of the frame
+} jpeg_ring_slot_s;
+
+/* A frame as read from or written to the ring */
+typedef struct __jpeg_ring_frame_s {
+	unsigned int sequence;
+	unsigned int timestamp_sec;
+	unsigned int timestamp_msec;
+	unsigned int width;
+	unsigned int height;
+	unsigned int size;
+	unsigned int meta_size;
+	unsigned char meta[JPEG_RING_META_MAX];
+} jpeg_ring_frame_s;
+
+typedef struct __jpeg_ring_stats_s {
+	unsigned long long int written;
+	unsigned long long int skipped; // larger than a slot
+	unsigned int head;
+} jpeg_ring_stats_s;
+
+typedef struct __jpeg_ring_s *jpeg_ring_h;
+typedef struct __jpeg_ring_reader_s *jpeg_ring_reader_h;
+
+/* Writer, one per ring. The file is created anew, readers of an old one reopen it. */
+jpeg_ring_h jpeg_ring_create(const char *path, unsigned int slot_count, unsigned int slot_size);
+void jpeg_ring_destroy(jpeg_ring_h ring);
+/* Copies the JPEG and its metadata, which is cut at JPEG_RING_META_MAX */
+int jpeg_ring_write(jpeg_ring_h ring, const unsigned char *jpeg, unsigned int size,
+	unsigned int width, unsigned int height, const unsigned char *meta, unsigned int meta_size);
+void jpeg_ring_get_stats(jpeg_ring_h ring, jpeg_ring_stats_s *stats);
+
+/* Reader, any number of them, in any process */
+jpeg_ring_reader_h jpeg_ring_reader_open(const char *path);
+void jpeg_ring_reader_close(jpeg_ring_reader_h reader);
+/*
+ * Copies the newest frame when its sequence differs from last_sequence.
+ * Returns 1 with frame and jpeg filled, 0 when there is no other frame yet
+ * or the writer kept overwriting it, -1 when jpeg is too small for the
+ * frame or the writer closed the ring, in which case open it again.
+ */
+int jpeg_ring_reader_read(jpeg_ring_reader_h reader, unsigned int last_sequence,
+	jpeg_ring_frame_s *frame, unsigned char *jpeg, unsigned int jpeg_size);
+
+#endif /* __JPEG_RING_H__ */
@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef __LATEST_SLOT_H__
+#define __LATEST_SLOT_H__
+
+/* An immutable, reference counted buffer, such as a JPEG or an info string */
+typedef struct __latest_data_s {
+	unsigned char *data; // owned, freed with the last reference
+	unsigned long long size;
+	unsigned int width; // of an image, 0 otherwise
+	unsigned int height;
+	int refcount;
+} latest_data_s;
+
+/* Takes data, which must come from malloc, and returns it with one reference */
+latest_data_s *latest_data_new(void *data, unsigned long long size);
+latest_data_s *latest_data_ref(latest_data_s *latest);
+void latest_data_unref(latest_data_s *latest);
+
+typedef void *(*latest_slot_ref_cb)(void *item);
+typedef void (*latest_slot_unref_cb)(void *item);
+
+typedef struct __latest_slot_s *latest_slot_h;
+
+/*
+ * Holds the newest item published by a producer, for any number of readers.
+ * Readers never block and get a reference of their own, so an item stays
+ * valid for them after it was replaced, and no reader takes it away from the
+ * others. Neither side ever waits: publishing swaps the current entry and
+ * the reader counted on it, and the old item is released by whichever of
+ * the producer and the readers still taking their reference finishes last.
+ *
+ * There must be a single producer: latest_slot_publish() is called by one
+ * thread at a time. Up to 15 readers may be in latest_slot_get() at once.
+ */
+latest_slot_h latest_slot_create(latest_slot_ref_cb ref, latest_slot_unref_cb unref);
+/* No reader may be left, their references stay valid */
+void latest_slot_destroy(latest_slot_h slot);
+
+/* Takes the caller's reference to item, NULL empties the slot */
+void latest_slot_publish(latest_slot_h slot, void *item);
+/* Returns a new reference to the newest item, or NULL */
+void *latest_slot_get(latest_slot_h slot);
+
+/* Slots of latest_data_s */
+latest_slot_h latest_slot_create_data(void);
+
+#endif /* __LATEST_SLOT_H__ */
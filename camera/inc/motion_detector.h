@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MOTION_DETECTOR_H__
+#define __MOTION_DETECTOR_H__
+
+#include "image_pyramid.h"
+#include "region_extract.h"
+#include "motion_mask.h"
+#include "worker_pool.h"
+
+typedef struct __motion_detector_s *motion_detector_h;
+
+typedef struct __motion_detector_stats_s {
+	unsigned long long int frames; // processed, seeding frames not counted
+	unsigned int average_usec;
+	unsigned int max_usec;
+	unsigned int tiles;
+} motion_detector_stats_s;
+
+/*
+ * Background subtraction on a luma plane. Every pixel keeps a running mean
+ * and deviation, updated in place each frame, and is foreground when it is
+ * further from its mean than 3 deviations or threshold (0 ~ 255),
+ * whichever is more. It only needs the row kernels of image_convert, no
+ * media vision, so it also builds on a Linux host.
+ */
+motion_detector_h motion_detector_create(unsigned int threshold);
+void motion_detector_destroy(motion_detector_h detector);
+
+/*
+ * Fills regions with the bounding boxes of moving areas in luma pixels,
+ * largest first, and returns their number or -1 on error. pixels of each
+ * region is its foreground area. The first frame, and the first one after
+ * a size change, only seeds the background.
+ */
+int motion_detector_process(motion_detector_h detector, const image_luma_s *luma, region_set_s *regions);
+
+/* Drops the background, the next frame seeds it again */
+void motion_detector_reset(motion_detector_h detector);
+
+/*
+ * Only the analysed spans of mask are read and modelled, the rest of the
+ * frame is never foreground. The mask is not owned and must stay valid
+ * until it is replaced, NULL analyses the whole frame. Changing it learns
+ * the background again from the next frame.
+ */
+void motion_detector_set_mask(motion_detector_h detector, motion_mask_h mask);
+
+/*
+ * Splits each frame in horizontal tiles, one per thread of pool, analysed
+ * in parallel. Regions are the same as without a pool. The pool is not
+ * owned, NULL runs on the calling thread only.
+ */
+void motion_detector_set_pool(motion_detector_h detector, worker_pool_h pool);
+void motion_detector_get_stats(motion_detector_h detector, motion_detector_stats_s *stats);
+
+/*
+ * Foreground pixels of the last processed frame within a rectangle, in
+ * constant time from an integral image. The rectangle is clipped to the frame.
+ */
+unsigned int motion_detector_get_foreground(motion_detector_h detector,
+	unsigned int x, unsigned int y, unsigned int width, unsigned int height);
+
+/*
+ * The background model can be saved when the service stops and loaded
+ * before the first frame, so a restart does not learn the scene again.
+ * A model older than an hour or of another size is not used.
+ */
+int motion_detector_save(motion_detector_h detector, const char *path);
+int motion_detector_load(motion_detector_h detector, const char *path);
+
+#endif /* __MOTION_DETECTOR_H__ */
@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MOTION_MASK_H__
+#define __MOTION_MASK_H__
+
+#include <stdbool.h>
+
+typedef struct __motion_mask_s *motion_mask_h;
+
+/*
+ * Which pixels motion is looked for in. roi and exclude are polygons in
+ * percent of the frame, "x,y x,y x,y ..." with ";" between polygons, e.g.
+ * "0,40 100,40 100,100 0,100" for the lower 60 %. A pixel is analysed when
+ * its center is inside any roi polygon (all pixels if there is none) and
+ * inside no exclude polygon.
+ *
+ * Returns NULL when both are empty or either does not parse.
+ */
+motion_mask_h motion_mask_create(const char *roi, const char *exclude);
+void motion_mask_destroy(motion_mask_h mask);
+
+/* Compiles the polygons into analysed spans per row, kept while the size holds */
+int motion_mask_compile(motion_mask_h mask, unsigned int width, unsigned int height);
+
+/*
+ * spans of a compiled row as start, end pairs, end exclusive, in increasing
+ * order. Returns the number of pairs.
+ */
+unsigned int motion_mask_get_spans(motion_mask_h mask, unsigned int row, const unsigned short **spans);
+
+/* Share of the frame that is analysed, 0 ~ 100 */
+unsigned int motion_mask_get_coverage(motion_mask_h mask);
+
+#endif /* __MOTION_MASK_H__ */
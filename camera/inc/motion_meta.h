@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef __MOTION_META_H__
+#define __MOTION_META_H__
+
+#include <stdint.h>
+
+/*
+ * Binary record of the motion found in a frame, written to the frame ring
+ * and to an APP10 segment of each snapshot. All numbers are little endian.
+ *
+ *  0  "MVMD"
+ *  4  u16 version, u16 header size, u16 region size, u16 region count
+ * 12  u32 frame sequence
+ * 16  u64 wall clock in ms
+ * 24  u16 frame width, u16 frame height
+ * 28  u32 area of the regions
+ * 32  u8 event, s8 regions with a face (-1 not classified), u16 0
+ * 36  u32 track that entered
+ * 40  regions, each u16 x, y, width, height in frame pixels, u32 area,
+ *     u32 track id (0 untracked), u32 track age in ms
+ *
+ * Fields are only ever added at the end of the header or of a region and
+ * the sizes say where each part ends, so readers skip what they do not know.
+ */
+#define MOTION_META_VERSION 1
+#define MOTION_META_HEADER_SIZE 40
+#define MOTION_META_REGION_SIZE 20
+#define MOTION_META_REGION_MAX 32
+#define MOTION_META_SIZE_MAX (MOTION_META_HEADER_SIZE + MOTION_META_REGION_MAX * MOTION_META_REGION_SIZE)
+/* JPEG segment of the record, marker and length come before it */
+#define MOTION_META_APP_MARKER 0xEA // APP10
+#define MOTION_META_SEGMENT_SIZE_MAX (MOTION_META_SIZE_MAX + 4)
+
+typedef enum {
+	MOTION_META_EVENT_NONE = 0, // no motion in the frame
+	MOTION_META_EVENT_MOTION, // motion of tracks seen before
+	MOTION_META_EVENT_ENTERED, // a track entered, an alert was sent
+} motion_meta_event_e;
+
+typedef struct __motion_meta_region_s {
+	unsigned int x;
+	unsigned int y;
+	unsigned int width;
+	unsigned int height;
+	unsigned int area;
+	unsigned int track_id;
+	unsigned int track_age; // ms
+} motion_meta_region_s;
+
+typedef struct __motion_meta_s {
+	unsigned int sequence;
+	unsigned long long int timestamp; // ms since the epoch
+	unsigned int frame_width;
+	unsigned int frame_height;
+	unsigned int area_sum;
+	motion_meta_event_e event;
+	int object_count;
+	unsigned int entered_id;
+	unsigned int region_count;
+	motion_meta_region_s regions[MOTION_META_REGION_MAX];
+} motion_meta_s;
+
+/* Returns the size of the record written to buffer, or -1 when it does not fit */
+int motion_meta_encode(const motion_meta_s *meta, unsigned char *buffer, unsigned int size);
+/* Same, as a JPEG APP10 segment with its marker and length */
+int motion_meta_encode_segment(const motion_meta_s *meta, unsigned char *buffer, unsigned int size);
+/* Reads a record of this or a later version, 0 on success */
+int motion_meta_decode(const unsigned char *buffer, unsigned int size, motion_meta_s *meta);
+/* Finds the APP10 record in the header segments of a JPEG, 0 on success */
+int motion_meta_decode_jpeg(const unsigned char *jpeg, unsigned int size, motion_meta_s *meta);
+
+/*
+ * The older ASCII form for the EXIF user comment, see the README: %02d
+ * event and zone count, %02d x, y, width, height of each zone in 0 ~ 99,
+ * then %04u track id and age in 0.1 s of each zone. Returns its length.
+ */
+int motion_meta_to_ascii(const motion_meta_s *meta, char *text, unsigned int size);
+
+#endif /* __MOTION_META_H__ */
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __REGION_CLASSIFIER_H__
+#define __REGION_CLASSIFIER_H__
+
+#include "image_pyramid.h"
+#include "region_extract.h"
+
+typedef enum {
+	/* not looked at, the budget was spent */
+	REGION_CLASS_UNKNOWN,
+	/* looked at, nothing found */
+	REGION_CLASS_NONE,
+	REGION_CLASS_OBJECT,
+} region_class_e;
+
+/* crops get 1/8 of their size around them on each side */
+#define REGION_CLASSIFIER_CROP_MARGIN_SHIFT 3
+/* smaller crops (in full frame pixels) can not hold anything to find */
+#define REGION_CLASSIFIER_CROP_SIZE_MIN 24
+/* crops are taken from a smaller level while their shorter side stays this large */
+#define REGION_CLASSIFIER_CROP_DETAIL_MIN 160
+
+/*
+ * Looks for the object in a crop, returns 1 when it is there, 0 when it is
+ * not and -1 on error. The crop points into the frame and is only valid
+ * during the call.
+ */
+typedef int (*region_classifier_detect_cb)(const image_luma_s *crop, void *user_data);
+
+typedef struct __region_classifier_stats_s {
+	unsigned long long int runs; // calls of the detector
+	unsigned long long int cached; // regions answered from the cache
+	unsigned long long int skipped; // regions left UNKNOWN by the budget
+	unsigned int average_usec; // of a detector call
+} region_classifier_stats_s;
+
+typedef struct __region_classifier_s *region_classifier_h;
+
+/*
+ * A second stage for motion regions: the detector only sees crops of the
+ * regions, at most budget_ms of it per second of time, and a region that
+ * overlaps one classified shortly before reuses that result. The detector
+ * itself is given by the caller, so the stage builds without media vision.
+ */
+region_classifier_h region_classifier_create(region_classifier_detect_cb detect, void *user_data, unsigned int budget_ms);
+void region_classifier_destroy(region_classifier_h classifier);
+
+/*
+ * Classifies regions, given in pixels of pyramid level level, largest
+ * first. Each crop is taken from the smallest level it is still large
+ * enough on. Returns the number of OBJECT regions.
+ */
+int region_classifier_run(region_classifier_h classifier, const image_pyramid_s *pyramid,
+	unsigned int level, const region_set_s *regions, region_class_e classes[REGION_SET_MAX]);
+void region_classifier_get_stats(region_classifier_h classifier, region_classifier_stats_s *stats);
+
+#endif /* __REGION_CLASSIFIER_H__ */
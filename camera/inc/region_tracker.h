@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __REGION_TRACKER_H__
+#define __REGION_TRACKER_H__
+
+#include <stdbool.h>
+#include "region_extract.h"
+#include "region_classifier.h"
+
+#define REGION_TRACK_MAX 16
+
+typedef struct __region_track_info_s {
+	unsigned int id; // 1 ~, stable while the track lives
+	unsigned int age; // ms since the track started
+	/* the track was confirmed with this update, it is reported once */
+	bool entered;
+} region_track_info_s;
+
+typedef struct __region_tracker_s *region_tracker_h;
+
+/*
+ * Follows regions over frames by overlap, or by centroid for regions that
+ * moved further than their size allows to overlap. A track is confirmed
+ * once it was seen confirm_hits times, and ends when it was not seen for
+ * timeout_ms.
+ */
+region_tracker_h region_tracker_create(unsigned int confirm_hits, unsigned int timeout_ms);
+void region_tracker_destroy(region_tracker_h tracker);
+
+/*
+ * Matches regions to the tracks and fills the track of each region. With
+ * classes, a track is only confirmed once one of its regions was an
+ * OBJECT. Returns the number of tracks that entered with this update.
+ */
+int region_tracker_update(region_tracker_h tracker, const region_set_s *regions,
+	const region_class_e *classes, long long int now_ms, region_track_info_s info[REGION_SET_MAX]);
+
+/* Tracks seen within timeout_ms of now_ms, confirmed or not */
+unsigned int region_tracker_get_count(region_tracker_h tracker, long long int now_ms);
+
+#endif /* __REGION_TRACKER_H__ */
@@ -17,22 +17,60 @@
 #ifndef __RESOURCE_CAMERA_H__
 #define __RESOURCE_CAMERA_H__
 
+#include "image_frame.h"
+
 typedef struct __image_buffer_data_s {
     unsigned char *buffer;
 	unsigned int buffer_size;
 	unsigned int image_width;
 	unsigned int image_height;
 	camera_pixel_format_e format;
+	image_frame_view_s view;
+	unsigned long long sequence;
+	int stream_id;
 	void *user_data;
+
+	struct __frame_pool_s *pool;
+	int ref_count;
 } image_buffer_data_s;
 
+struct __frame_pool_stats_s;
+struct __frame_ring_stats_s;
+struct __frame_scheduler_stats_s;
+
+typedef struct __camera_capture_stats_s {
+	bool pauses_preview; // false with zero shutter lag and for a replay source
+	unsigned long long gaps; // captures the preview came back from
+	unsigned int gap_average_ms; // capture request to the next preview frame
+	unsigned int gap_max_ms;
+} camera_capture_stats_s;
+
+typedef struct __camera_data *resource_camera_h;
+
 typedef void (*preview_image_buffer_created_cb)(void *buffedata);
-typedef void (*capture_completed_cb)(const void *image, unsigned int size, void *user_data);
+/* image is a JPEG, only valid during the callback which may run on a camera thread */
+typedef void (*capture_completed_cb)(const void *image, unsigned int size,
+	unsigned int width, unsigned int height, void *user_data);
+
+/* stream_id selects CAMERA_DEVICE_CAMERA0 + stream_id and the per-stream settings */
+int resource_camera_init(int stream_id, preview_image_buffer_created_cb preview_image_buffer_created_cb,
+	void *user_data, resource_camera_h *camera);
+int resource_camera_start_preview(resource_camera_h camera);
+int resource_camera_stop_preview(resource_camera_h camera);
+int resource_camera_capture(resource_camera_h camera, capture_completed_cb capture_completed_cb, void *data);
+void resource_camera_get_preview_resolution(resource_camera_h camera, unsigned int *width, unsigned int *height);
+/* Returns -1 when no capture resolution is configured for the stream */
+int resource_camera_get_capture_resolution(resource_camera_h camera, unsigned int *width, unsigned int *height);
+/* True when a capture stops the preview until it completes */
+bool resource_camera_capture_pauses_preview(resource_camera_h camera);
+void resource_camera_close(resource_camera_h camera);
+int resource_camera_get_frame_pool_stats(resource_camera_h camera, struct __frame_pool_stats_s *stats);
+int resource_camera_get_frame_ring_stats(resource_camera_h camera, struct __frame_ring_stats_s *stats);
+int resource_camera_get_frame_scheduler_stats(resource_camera_h camera, struct __frame_scheduler_stats_s *stats);
+int resource_camera_get_capture_stats(resource_camera_h camera, camera_capture_stats_s *stats);
 
-int resource_camera_init(preview_image_buffer_created_cb preview_image_buffer_created_cb, void *user_data);
-int resource_camera_start_preview(void);
-int resource_camera_stop_preview(void);
-int resource_camera_capture(capture_completed_cb capture_completed_cb, void *data);
-void resource_camera_close(void);
+/* Feedback for the preview rate: motion raises it, a saturated consumer lowers it */
+void resource_camera_notify_motion(resource_camera_h camera);
+void resource_camera_notify_saturated(resource_camera_h camera);
 
 #endif
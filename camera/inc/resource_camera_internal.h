@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __RESOURCE_CAMERA_INTERNAL_H__
+#define __RESOURCE_CAMERA_INTERNAL_H__
+
+#include <stdbool.h>
+#include <camera.h>
+#include "resource_camera.h"
+#include "frame_pool.h"
+#include "frame_ring.h"
+#include "frame_scheduler.h"
+
+struct __camera_data;
+
+/* A frame source behind the resource_camera API */
+typedef struct __camera_source_ops_s {
+	const char *name;
+	int (*open)(struct __camera_data *camera_data);
+	void (*close)(struct __camera_data *camera_data);
+	int (*start_preview)(struct __camera_data *camera_data);
+	int (*stop_preview)(struct __camera_data *camera_data);
+	int (*capture)(struct __camera_data *camera_data);
+	/* optional, on the main loop after each frame the pipeline took */
+	void (*frame_consumed)(struct __camera_data *camera_data);
+} camera_source_ops_s;
+
+struct __camera_data {
+	int stream_id;
+	camera_h cam_handle;
+
+	/* preview feeds detection, capture (0 if unset) the snapshots */
+	unsigned int preview_width;
+	unsigned int preview_height;
+	unsigned int capture_width;
+	unsigned int capture_height;
+
+	void *captured_file;
+	unsigned int image_size;
+	unsigned int captured_width;
+	unsigned int captured_height;
+
+	preview_image_buffer_created_cb preview_image_buffer_created_cb;
+	void *preview_image_buffer_created_cb_data;
+
+	capture_completed_cb capture_completed_cb;
+	void *capture_completed_cb_data;
+
+	bool is_af_enabled;
+
+	/* the preview stops for a capture, and how long frames were missing */
+	bool capture_pauses_preview;
+	long long capture_started_ms;
+	bool capture_done;
+	unsigned long long capture_gaps;
+	unsigned long long capture_gap_total_ms;
+	unsigned int capture_gap_max_ms;
+
+	const camera_source_ops_s *source_ops;
+	void *source_data;
+
+	frame_pool_s *frame_pool;
+	frame_ring_s *frame_ring;
+	unsigned int frame_ring_depth;
+	frame_scheduler_s *frame_scheduler;
+	unsigned long long frame_sequence;
+};
+
+extern const camera_source_ops_s camera_source_device_ops;
+extern const camera_source_ops_s camera_source_replay_ops;
+
+/*
+ * Feeds a frame into the preview pipeline, from the source's own thread.
+ * Unpaced frames skip the frame scheduler; such sources
+ * should wait while resource_camera_is_backlogged() to avoid overwrites,
+ * and are woken through frame_consumed.
+ */
+void resource_camera_deliver_preview(struct __camera_data *camera_data,
+	camera_preview_data_s *frame, bool paced);
+bool resource_camera_is_backlogged(struct __camera_data *camera_data);
+
+#endif /* __RESOURCE_CAMERA_INTERNAL_H__ */
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __SCENE_CHANGE_H__
+#define __SCENE_CHANGE_H__
+
+#include "image_pyramid.h"
+
+typedef struct __scene_change_s *scene_change_h;
+
+typedef enum {
+	SCENE_CHANGE_NONE,
+	/* most of the frame got brighter or darker by one gain at once, lights or IR cut-over */
+	SCENE_CHANGE_LIGHTING,
+	/* the whole image moved, the camera was knocked or shakes */
+	SCENE_CHANGE_SHAKE,
+} scene_change_e;
+
+typedef struct __scene_change_info_s {
+	unsigned int mean; // luma mean of the frame, 0 ~ 255
+	unsigned int previous_mean;
+	unsigned int changed_cells; // of SCENE_CHANGE_CELLS, that changed brightness
+	unsigned int histogram_distance; // 0 ~ 100, % of the samples that moved bins
+	unsigned int gain; // median brightness of the cells in % of the previous frame
+	unsigned int gain_cells; // changed cells that follow that gain
+	unsigned int histogram_reshape; // 0 ~ 100, % of the samples off the histogram scaled by the gain
+	int shift_x; // global motion in luma pixels, 0 when there is none
+	int shift_y;
+} scene_change_info_s;
+
+#define SCENE_CHANGE_GRID 4
+#define SCENE_CHANGE_CELLS (SCENE_CHANGE_GRID * SCENE_CHANGE_GRID)
+
+/*
+ * Global statistics of consecutive luma frames, from every other pixel of
+ * every other row: a histogram, the mean of a 4x4 grid of cells, and the
+ * row and column projections whose best matching offset gives a coarse
+ * global motion. Lighting scales most cells by one gain and moves the
+ * histogram without changing its shape. Local motion such as a person
+ * changes a few cells, or many by unrelated ratios when close to the lens,
+ * and does not shift the projections, so it is left to the motion detector.
+ */
+scene_change_h scene_change_create(void);
+void scene_change_destroy(scene_change_h scene);
+
+/* Compares luma with the previous frame, the first frame and a size change give NONE */
+scene_change_e scene_change_update(scene_change_h scene, const image_luma_s *luma);
+/* Statistics of the last update */
+void scene_change_get_info(scene_change_h scene, scene_change_info_s *info);
+
+#endif /* __SCENE_CHANGE_H__ */
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __STAGE_WORKER_H__
+#define __STAGE_WORKER_H__
+
+typedef enum {
+	/* a full queue drops its oldest item, for work where only the latest matters */
+	STAGE_WORKER_DROP_OLDEST,
+	/* a full queue turns the new item away, for work that must keep its order */
+	STAGE_WORKER_DROP_NEWEST,
+} stage_worker_drop_policy_e;
+
+/* Runs on the worker thread, owns item */
+typedef void (*stage_worker_job_cb)(void *item, void *user_data);
+/* Releases an item that was dropped or left in the queue at destroy */
+typedef void (*stage_worker_drop_cb)(void *item, void *user_data);
+
+typedef struct __stage_worker_stats_s {
+	unsigned long long int pushed;
+	unsigned long long int processed;
+	unsigned long long int dropped;
+	unsigned int depth; // queued now
+	unsigned int depth_max; // most ever queued
+	unsigned int average_usec; // service time of a job
+	unsigned int max_usec;
+} stage_worker_stats_s;
+
+typedef struct __stage_worker_s *stage_worker_h;
+
+/*
+ * One long-lived thread serving a bounded queue of depth items, one at a
+ * time in order. Pushing never blocks, a full queue drops by policy.
+ */
+stage_worker_h stage_worker_create(const char *name, unsigned int depth, stage_worker_drop_policy_e policy,
+	stage_worker_job_cb job, stage_worker_drop_cb drop, void *user_data);
+/* Waits for the running job, the queued ones are dropped */
+void stage_worker_destroy(stage_worker_h worker);
+
+/* Takes item in any case, returns 1 when an item was dropped to keep the bound, 0 if not, -1 on error */
+int stage_worker_push(stage_worker_h worker, void *item);
+void stage_worker_get_stats(stage_worker_h worker, stage_worker_stats_s *stats);
+const char *stage_worker_get_name(stage_worker_h worker);
+
+#endif /* __STAGE_WORKER_H__ */
@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __WORKER_POOL_H__
+#define __WORKER_POOL_H__
+
+#define WORKER_POOL_THREAD_MAX 8
+
+typedef struct __worker_pool_s *worker_pool_h;
+
+typedef void (*worker_pool_job_cb)(unsigned int index, void *user_data);
+
+/*
+ * A fixed set of threads for fork-join work on a frame. The calling thread
+ * takes part, so a pool of n threads starts n - 1 of them.
+ */
+worker_pool_h worker_pool_create(unsigned int threads);
+void worker_pool_destroy(worker_pool_h pool);
+
+/*
+ * Calls job for every index 0 ~ count - 1, spread over the pool, and
+ * returns when all of them are done. Runs from several threads are
+ * serialized.
+ */
+void worker_pool_run(worker_pool_h pool, unsigned int count, worker_pool_job_cb job, void *user_data);
+unsigned int worker_pool_get_threads(worker_pool_h pool);
+
+#endif /* __WORKER_POOL_H__ */
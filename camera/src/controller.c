@@ -14,6 +14,9 @@
  * limitations under the License.
  */
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
 #include <glib.h>
 #include <Ecore.h>
 #include <tizen.h>
@@ -21,43 +24,115 @@
 #include <camera.h>
 #include <mv_common.h>
 #include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
 #include "controller.h"
 #include "controller_mv.h"
+#include "worker_pool.h"
+#include "stage_worker.h"
+#include "latest_slot.h"
+#include "jpeg_ring.h"
+#include "motion_meta.h"
+#include "frame_signature.h"
 #include "controller_image.h"
 #include "controller_telegram.h"
+#include "controller_config.h"
 #include "log.h"
 #include "resource_camera.h"
+#include "frame_pool.h"
+#include "frame_scheduler.h"
+#include "image_convert.h"
 
-#define THRESHOLD_VALID_EVENT_COUNT 5
-#define VALID_EVENT_INTERVAL_MS 200
 #define TELEGRAM_EVENT_INTERVAL_MS 5000
+#define STREAM_STATS_INTERVAL_SEC 10.0
+#define CAPTURE_FAILURE_MAX 3
+#define PERSIST_QUEUE_DEPTH 2
+#define NOTIFY_QUEUE_DEPTH 2
+#define JPEG_RING_SLOTS_DEFAULT 4
+#define JPEG_RING_SLOT_KB_DEFAULT 1024
+#define STATIC_THRESHOLD_DEFAULT 2
+#define STATIC_REFRESH_DEFAULT_MS 10000
 
 #define IMAGE_FILE_PREFIX "CAM_"
 
 //#define TEMP_IMAGE_FILENAME "/opt/usr/home/owner/apps_rw/org.tizen.smart-surveillance-camera/shared/data/tmp.jpg"
 //#define LATEST_IMAGE_FILENAME "/opt/usr/home/owner/apps_rw/org.tizen.smart-surveillance-camera/shared/data/latest.jpg"
 
+struct app_data_s;
+
+/* Aggregate throughput of a stream, updated from the main loop and the writer thread */
+typedef struct stream_stats_s {
+	unsigned long long frames;
+	unsigned long long detections;
+	unsigned long long encoded;
+	unsigned long long encoded_bytes;
+} stream_stats_s;
+
+/* Everything a stream owns, nothing in here is shared with other streams */
+typedef struct stream_data_s {
+	int stream_id;
+	struct app_data_s *ad;
+
+	resource_camera_h camera;
+	controller_mv_h mv;
+	controller_image_h image;
+
+	long long int last_telegram_event_time;
+
+	/* size of the preview frames motion is detected on */
+	unsigned int frame_width;
+	unsigned int frame_height;
+
+	/* high resolution snapshots, main loop only */
+	bool capture_enabled;
+	bool capture_pending;
+	int capture_failures;
+	int capture_interval;
+	long long int last_capture_time;
+
+	/* newest of each, shared by the camera, the main loop and the stages without a lock */
+	latest_slot_h frame_slot; // preview frame, image_buffer_data_s
+	latest_slot_h capture_slot; // high resolution JPEG, latest_data_s
+	latest_slot_h jpeg_slot; // last JPEG written, latest_data_s
+	latest_slot_h meta_slot; // motion of the current frame, latest_data_s of motion_meta_s
+
+	/*
+	 * Long-lived stages after detection, which runs on the main loop:
+	 * encode -> persist (file, then the latest JPEG for Telegram) and notify
+	 */
+	stage_worker_h encode_stage;
+	stage_worker_h persist_stage;
+	stage_worker_h notify_stage;
+	bool encode_pinned; // encode stage thread only
+
+	/* latest.jpg, replaced atomically by the persist stage */
+	image_publish_h publish;
+	/* the same snapshots for readers mapping frames.ring, NULL when disabled */
+	jpeg_ring_h ring;
+
+	/* frames like the last processed one are dropped, NULL when disabled, main loop only */
+	frame_signature_h signature;
+	int static_threshold;
+	int static_refresh;
+	long long int last_processed_time;
+	unsigned long long int static_skipped;
+	unsigned long long int static_saved_usec; // what the skipped frames would have cost
+
+	stream_stats_s stats;
+	stream_stats_s last_stats;
+} stream_data;
+
 typedef struct app_data_s {
-	long long int last_valid_event_time;
-	int valid_event_count;
-
-	unsigned int latest_image_width;
-	unsigned int latest_image_height;
-	char *latest_image_info;
-	unsigned char *latest_image_buffer;
-	unsigned char *latest_encoded_image_buffer;
-	unsigned int latest_encoded_image_buffer_size;
-
-	Ecore_Thread *image_writter_thread;
-	pthread_mutex_t mutex;
-
-	char* temp_image_filename;
-	char* latest_image_filename;
-
-	Ecore_Thread *telegram_thread;
-	char* telegram_message;
-	unsigned char* telegram_image_buffer;
-	unsigned long long telegram_image_buffer_size;
+	stream_data streams[CAMERA_STREAM_MAX];
+	int stream_count;
+
+	/* native motion detection of all streams, NULL when it runs on the main loop alone */
+	worker_pool_h mv_pool;
+	/* the ASCII EXIF user comment next to the APP10 motion record */
+	bool meta_ascii;
+
+	Ecore_Timer *stats_timer;
+	long long int last_stats_time;
 } app_data;
 
 static long long int __get_monotonic_ms(void)
@@ -73,433 +148,951 @@ static long long int __get_monotonic_ms(void)
 	return ret_time;
 }
 
-static mv_colorspace_e __convert_colorspace_from_cam_to_mv(camera_pixel_format_e format)
-{
-	mv_colorspace_e colorspace = MEDIA_VISION_COLORSPACE_INVALID;
-	switch (format) {
-	case CAMERA_PIXEL_FORMAT_NV12:
-		colorspace = MEDIA_VISION_COLORSPACE_NV12;
-		break;
-	case CAMERA_PIXEL_FORMAT_NV21:
-		colorspace = MEDIA_VISION_COLORSPACE_NV21;
-		break;
-	case CAMERA_PIXEL_FORMAT_YUYV:
-		colorspace = MEDIA_VISION_COLORSPACE_YUYV;
-		break;
-	case CAMERA_PIXEL_FORMAT_UYVY:
-		colorspace = MEDIA_VISION_COLORSPACE_UYVY;
-		break;
-	case CAMERA_PIXEL_FORMAT_422P:
-		colorspace = MEDIA_VISION_COLORSPACE_422P;
-		break;
-	case CAMERA_PIXEL_FORMAT_I420:
-		colorspace = MEDIA_VISION_COLORSPACE_I420;
-		break;
-	case CAMERA_PIXEL_FORMAT_YV12:
-		colorspace = MEDIA_VISION_COLORSPACE_YV12;
-		break;
-	case CAMERA_PIXEL_FORMAT_RGB565:
-		colorspace = MEDIA_VISION_COLORSPACE_RGB565;
-		break;
-	case CAMERA_PIXEL_FORMAT_RGB888:
-		colorspace = MEDIA_VISION_COLORSPACE_RGB888;
-		break;
-	case CAMERA_PIXEL_FORMAT_RGBA:
-		colorspace = MEDIA_VISION_COLORSPACE_RGBA;
-		break;
-	case CAMERA_PIXEL_FORMAT_NV12T:
-	case CAMERA_PIXEL_FORMAT_NV16:
-	case CAMERA_PIXEL_FORMAT_ARGB:
-	case CAMERA_PIXEL_FORMAT_JPEG:
-	case CAMERA_PIXEL_FORMAT_H264:
-	case CAMERA_PIXEL_FORMAT_INVALID:
-	default :
-		colorspace = MEDIA_VISION_COLORSPACE_INVALID;
-		_E("unsupported format : %d", format);
-		break;
-	}
-
-	return colorspace;
-}
-
-static void __terminate_telegram_thread(void *data)
+static unsigned long long int __get_realtime_ms(void)
 {
-	app_data *ad = (app_data *)data;
-	ad->telegram_thread = NULL;
-	_D("Telegram Thread Terminated!");
+	struct timespec time_s;
+
+	clock_gettime(CLOCK_REALTIME, &time_s);
 
+	return time_s.tv_sec * 1000ULL + time_s.tv_nsec / 1000000;
 }
-static void __thread_telegram_task(void *data, Ecore_Thread *th)
+
+/* A Telegram message and the latest JPEG at the time, for the notify stage */
+typedef struct notify_job_s {
+	char *message;
+	latest_data_s *jpeg;
+} notify_job_s;
+
+static void __drop_notify_job(void *item, void *user_data)
 {
-	app_data *ad = (app_data *)data;
-	_D("Telegram Thread Start!");
-	controller_telegram_send_message(ad->telegram_message);
-	controller_telegram_send_image(ad->telegram_image_buffer, ad->telegram_image_buffer_size);
+	notify_job_s *job = item;
+
+	free(job->message);
+	if (job->jpeg)
+		latest_data_unref(job->jpeg);
+	free(job);
 }
 
-static void __thread_telegram_task_end_cb(void *data, Ecore_Thread *th)
+static void __notify_job(void *item, void *user_data)
 {
-	_D("Telegram Thread End!");
-	ecore_main_loop_thread_safe_call_async(__terminate_telegram_thread, (app_data *)data);
+	notify_job_s *job = item;
+
+	controller_telegram_send_message(job->message);
+	if (job->jpeg)
+		controller_telegram_send_image(job->jpeg->data, job->jpeg->size);
+	__drop_notify_job(job, user_data);
 }
 
-static void __send_telegram_message(const char* msg, app_data *ad)
+static void __send_telegram_message(const char* msg, stream_data *sd)
 {
+	notify_job_s *job = NULL;
+
 	if (!msg)
 		return;
 
-	static long long int last_event_time = 0;;
 	long long int now = __get_monotonic_ms();
 
-	if (now < last_event_time + TELEGRAM_EVENT_INTERVAL_MS) {
+	if (now < sd->last_telegram_event_time + TELEGRAM_EVENT_INTERVAL_MS) {
 		return;
 	}
 
-	last_event_time = now;
+	sd->last_telegram_event_time = now;
+
+	job = calloc(1, sizeof(notify_job_s));
+	retm_if(!job, "[stream %d] Failed to allocate notify job", sd->stream_id);
+
+	if (sd->ad->stream_count > 1)
+		job->message = g_strdup_printf("[Camera %d] %s", sd->stream_id, msg);
+	else
+		job->message = strdup(msg);
 
-	if (ad->telegram_message)
-		free(ad->telegram_message);
+	/* the JPEG stays in the slot for the next message and other readers */
+	job->jpeg = latest_slot_get(sd->jpeg_slot);
 
-	ad->telegram_message = strdup(msg);
+	/* earlier messages are still sending, this one is dropped */
+	if (stage_worker_push(sd->notify_stage, job) > 0)
+		_W("[stream %d] Telegram is busy, message dropped", sd->stream_id);
+}
 
-	free(ad->telegram_image_buffer);
+/* Keep writer threads of different streams on different cores */
+static int __pin_to_stream_cpu(int stream_id)
+{
+	cpu_set_t mask;
+	long cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
 
-	pthread_mutex_lock(&ad->mutex);
-	ad->telegram_image_buffer = ad->latest_encoded_image_buffer;
-	ad->latest_encoded_image_buffer = NULL;
-	ad->telegram_image_buffer_size = ad->latest_encoded_image_buffer_size;
-	pthread_mutex_unlock(&ad->mutex);
+	if (cpu_count <= 1)
+		return -1;
 
-	if (!ad->telegram_thread) {
-		ad->telegram_thread = ecore_thread_run(__thread_telegram_task,
-			__thread_telegram_task_end_cb,
-			__thread_telegram_task_end_cb,
-			ad);
-	} else {
-		_E("Telegram Thread is running NOW");
+	CPU_ZERO(&mask);
+	CPU_SET(stream_id % cpu_count, &mask);
+
+	if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &mask)) {
+		_W("[stream %d] Failed to pin writer thread", stream_id);
+		return -1;
 	}
+
+	return 0;
+}
+
+/* A snapshot on its way through the encode and persist stages */
+typedef struct write_job_s {
+	image_buffer_data_s *buffer; // until encoded, NULL for a capture
+	latest_data_s *jpeg;
+	latest_data_s *meta; // motion_meta_s
+} write_job_s;
+
+static void __drop_write_job(void *item, void *user_data)
+{
+	write_job_s *job = item;
+
+	/* each of them may already be handed on or not be there */
+	if (job->buffer)
+		frame_pool_unref(job->buffer);
+	if (job->jpeg)
+		latest_data_unref(job->jpeg);
+	if (job->meta)
+		latest_data_unref(job->meta);
+	free(job);
 }
 
-static void __thread_write_image_file(void *data, Ecore_Thread *th)
+static void __encode_job(void *item, void *user_data)
 {
-	app_data *ad = (app_data *)data;
-	unsigned int width = 0;
-	unsigned int height = 0;
-	unsigned char *buffer = NULL;
-	unsigned char *encoded_buffer = NULL;
+	stream_data *sd = (stream_data *)user_data;
+	write_job_s *job = item;
+	unsigned char *encoded = NULL;
 	unsigned long long encoded_size = 0;
-	char *image_info = NULL;
-	int ret = 0;
 
-	pthread_mutex_lock(&ad->mutex);
-	width = ad->latest_image_width;
-	height = ad->latest_image_height;
-	buffer = ad->latest_image_buffer;
-	ad->latest_image_buffer = NULL;
-	if (ad->latest_image_info) {
-		image_info = ad->latest_image_info;
-		ad->latest_image_info = NULL;
-	} else {
-		image_info = strdup("00");
+	/* The stage thread lives as long as the stream, so it is pinned once */
+	if (!sd->encode_pinned && sd->ad->stream_count > 1) {
+		__pin_to_stream_cpu(sd->stream_id);
+		sd->encode_pinned = true;
 	}
-	pthread_mutex_unlock(&ad->mutex);
 
-	ret = controller_image_save_image_file(ad->temp_image_filename, width, height, buffer,
-		&encoded_buffer, &encoded_size, image_info, strlen(image_info));
+	/* A high resolution capture is already a JPEG and wins over the preview frame */
+	if (!job->jpeg) {
+		if (controller_image_encode(sd->image, &job->buffer->view, &encoded, &encoded_size)) {
+			_E("[stream %d] failed to encode image", sd->stream_id);
+			__drop_write_job(job, sd);
+			return;
+		}
+
+		job->jpeg = latest_data_new(encoded, encoded_size);
+		if (!job->jpeg) {
+			__drop_write_job(job, sd);
+			return;
+		}
+		job->jpeg->width = job->buffer->view.width;
+		job->jpeg->height = job->buffer->view.height;
+	}
+
+	/* the frame goes back to the pool before the file is written */
+	frame_pool_unref(job->buffer);
+	job->buffer = NULL;
+
+	if (stage_worker_push(sd->persist_stage, job) > 0)
+		_W("[stream %d] Persist stage is full, oldest image dropped", sd->stream_id);
+}
+
+static void __persist_job(void *item, void *user_data)
+{
+	stream_data *sd = (stream_data *)user_data;
+	write_job_s *job = item;
+	const motion_meta_s *meta = (const motion_meta_s *)job->meta->data;
+	unsigned char segment[MOTION_META_SEGMENT_SIZE_MAX];
+	char comment[IMAGE_INFO_MAX + 1];
+	int segment_size = 0;
+	int comment_size = 0;
+	int ret = 0;
+
+	/* the record goes to the file and the ring, the ASCII form only to the EXIF comment */
+	segment_size = motion_meta_encode_segment(meta, segment, sizeof(segment));
+	if (segment_size < 0)
+		segment_size = 0;
+	if (sd->ad->meta_ascii)
+		comment_size = motion_meta_to_ascii(meta, comment, sizeof(comment));
+	if (comment_size < 0)
+		comment_size = 0;
+
+	ret = controller_image_publish_jpeg(sd->publish, job->jpeg->data, job->jpeg->size,
+		job->jpeg->width, job->jpeg->height, comment, comment_size, segment, segment_size);
 	if (ret) {
-		_E("failed to save image file");
+		_E("[stream %d] failed to save image file", sd->stream_id);
 	} else {
-		ret = rename(ad->temp_image_filename, ad->latest_image_filename);
-		if (ret != 0 )
-			_E("Rename fail");
+		__atomic_add_fetch(&sd->stats.encoded, 1, __ATOMIC_RELAXED);
+		__atomic_add_fetch(&sd->stats.encoded_bytes, job->jpeg->size, __ATOMIC_RELAXED);
 	}
 
-	pthread_mutex_lock(&ad->mutex);
-	unsigned char *temp = ad->latest_encoded_image_buffer;
-	ad->latest_encoded_image_buffer = encoded_buffer;
-	ad->latest_encoded_image_buffer_size = encoded_size;
-	pthread_mutex_unlock(&ad->mutex);
+	if (sd->ring)
+		jpeg_ring_write(sd->ring, job->jpeg->data, job->jpeg->size, job->jpeg->width,
+			job->jpeg->height, segment + 4, segment_size ? segment_size - 4 : 0);
+
+	/* publish it for Telegram messages */
+	latest_slot_publish(sd->jpeg_slot, latest_data_ref(job->jpeg));
 
-	free(temp);
-	free(image_info);
-	free(buffer);
+	__drop_write_job(job, sd);
 }
 
-static void __thread_write_image_file_end_cb(void *data, Ecore_Thread *th)
+static void *__frame_ref(void *item)
 {
-	app_data *ad = (app_data *)data;
+	return frame_pool_ref(item);
+}
 
-	pthread_mutex_lock(&ad->mutex);
-	ad->image_writter_thread = NULL;
-	pthread_mutex_unlock(&ad->mutex);
+static void __frame_unref(void *item)
+{
+	frame_pool_unref(item);
 }
 
-static void __thread_write_image_file_cancel_cb(void *data, Ecore_Thread *th)
+static void __copy_image_buffer(image_buffer_data_s *image_buffer, stream_data *sd)
 {
-	app_data *ad = (app_data *)data;
-	unsigned char *buffer = NULL;
+	latest_slot_publish(sd->frame_slot, frame_pool_ref(image_buffer));
+}
 
-	_E("Thread %p got cancelled.\n", th);
-	pthread_mutex_lock(&ad->mutex);
-	buffer = ad->latest_image_buffer;
-	ad->latest_image_buffer = NULL;
-	ad->image_writter_thread = NULL;
-	pthread_mutex_unlock(&ad->mutex);
+/* Motion record of the current frame, without regions and NONE when event is NULL */
+static latest_data_s *__new_motion_meta(stream_data *sd, const controller_mv_event_s *event)
+{
+	motion_meta_s *meta = NULL;
+	latest_data_s *latest = NULL;
+	int i = 0;
+
+	meta = calloc(1, sizeof(motion_meta_s));
+	retvm_if(!meta, NULL, "[stream %d] Failed to allocate motion meta", sd->stream_id);
+
+	/* the frame counter is only bumped on the main loop, as are these */
+	meta->sequence = __atomic_load_n(&sd->stats.frames, __ATOMIC_RELAXED);
+	meta->timestamp = __get_realtime_ms();
+	meta->frame_width = sd->frame_width;
+	meta->frame_height = sd->frame_height;
+	meta->object_count = -1;
+
+	if (event) {
+		meta->event = event->entered ? MOTION_META_EVENT_ENTERED : MOTION_META_EVENT_MOTION;
+		meta->area_sum = event->area_sum;
+		meta->object_count = event->object_count;
+		meta->entered_id = event->entered_id;
+		for (i = 0; i < event->result_count && i < MOTION_META_REGION_MAX; i++) {
+			motion_meta_region_s *region = &meta->regions[i];
+
+			region->x = event->region[i * 4];
+			region->y = event->region[i * 4 + 1];
+			region->width = event->region[i * 4 + 2];
+			region->height = event->region[i * 4 + 3];
+			region->area = event->region_area[i];
+			region->track_id = event->track_id[i];
+			region->track_age = event->track_age[i];
+		}
+		meta->region_count = i;
+	}
 
-	free(buffer);
+	latest = latest_data_new(meta, sizeof(motion_meta_s));
+	if (latest) {
+		latest->width = meta->frame_width;
+		latest->height = meta->frame_height;
+	}
+
+	return latest;
 }
 
-static void __copy_image_buffer(image_buffer_data_s *image_buffer, app_data *ad)
+/* Hands the latest frame or capture and its info to the encode stage */
+static void __run_image_writer(stream_data *sd, bool captured)
 {
-	unsigned char *buffer = NULL;
+	write_job_s *job = NULL;
+
+	job = calloc(1, sizeof(write_job_s));
+	retm_if(!job, "[stream %d] Failed to allocate write job", sd->stream_id);
 
-	pthread_mutex_lock(&ad->mutex);
-	ad->latest_image_height = image_buffer->image_height;
-	ad->latest_image_width = image_buffer->image_width;
+	/*
+	 * The writer runs once for each new frame or capture. A capture left
+	 * from before capturing failed for good is not written again.
+	 */
+	if (captured)
+		job->jpeg = latest_slot_get(sd->capture_slot);
+	else
+		job->buffer = latest_slot_get(sd->frame_slot);
 
-	buffer = ad->latest_image_buffer;
-	ad->latest_image_buffer = image_buffer->buffer;
-	pthread_mutex_unlock(&ad->mutex);
+	if (!job->buffer && !job->jpeg) {
+		free(job);
+		return;
+	}
 
-	free(buffer);
+	job->meta = latest_slot_get(sd->meta_slot);
+	if (!job->meta)
+		job->meta = __new_motion_meta(sd, NULL);
+	if (!job->meta) {
+		__drop_write_job(job, sd);
+		return;
+	}
+
+	/* the encoder is behind, the older snapshot is dropped */
+	if (stage_worker_push(sd->encode_stage, job) > 0)
+		resource_camera_notify_saturated(sd->camera);
+}
+
+static void __captured_image_ready(void *data)
+{
+	stream_data *sd = (stream_data *)data;
+
+	sd->capture_pending = false;
+	if (sd->capture_enabled)
+		__run_image_writer(sd, true);
+}
+
+static void __capture_completed_cb(const void *image, unsigned int size,
+	unsigned int width, unsigned int height, void *user_data)
+{
+	stream_data *sd = (stream_data *)user_data;
+	unsigned char *captured = NULL;
+	latest_data_s *latest = NULL;
+
+	captured = malloc(size);
+	if (captured) {
+		memcpy(captured, image, size);
+
+		latest = latest_data_new(captured, size);
+		if (latest) {
+			latest->width = width;
+			latest->height = height;
+			latest_slot_publish(sd->capture_slot, latest);
+		}
+	} else {
+		_E("[stream %d] Failed to copy captured image", sd->stream_id);
+	}
+
+	ecore_main_loop_thread_safe_call_async(__captured_image_ready, sd);
+}
+
+/* capture_interval 0 only captures on motion entry */
+static bool __is_capture_periodic(stream_data *sd)
+{
+	return sd->capture_enabled && sd->capture_interval > 0;
+}
+
+/* Takes a snapshot every capture_interval, or right away when forced */
+static void __request_capture(stream_data *sd, bool force)
+{
+	long long int now = 0;
+
+	if (!sd->capture_enabled)
+		return;
+
+	now = __get_monotonic_ms();
+
+	if (sd->capture_pending) {
+		if (now < sd->last_capture_time + CAMERA_CAPTURE_TIMEOUT)
+			return;
+		_W("[stream %d] Capture timed out", sd->stream_id);
+	} else if (!force && now < sd->last_capture_time + sd->capture_interval) {
+		return;
+	}
+
+	sd->last_capture_time = now;
+
+	if (resource_camera_capture(sd->camera, __capture_completed_cb, sd) == -1) {
+		sd->capture_pending = false;
+		if (++sd->capture_failures >= CAPTURE_FAILURE_MAX) {
+			_W("[stream %d] Capture keeps failing, use preview frames for snapshots", sd->stream_id);
+			sd->capture_enabled = false;
+		}
+		return;
+	}
+
+	sd->capture_pending = true;
+	sd->capture_failures = 0;
+}
+
+/*
+ * A frame no block of which changed since the last written one is not
+ * encoded or written, latest.jpg and its motion record stay. It is still
+ * analysed, the block means miss small objects and the tracks must go on
+ * through a still scene. Nothing is skipped while a track is alive, and
+ * one frame every static_refresh ms is written anyway.
+ */
+static bool __is_static_frame(stream_data *sd, image_buffer_data_s *image_buffer)
+{
+	stage_worker_h stages[] = { sd->encode_stage, sd->persist_stage };
+	stage_worker_stats_s stage_stats;
+	long long int now = 0;
+	unsigned long long int saved = 0;
+	unsigned int i = 0;
+
+	if (!sd->signature)
+		return false;
+
+	now = __get_monotonic_ms();
+	if (controller_mv_get_track_count(sd->mv)) {
+		/* the next still frame is compared with this one */
+		frame_signature_reset(sd->signature);
+		frame_signature_update(sd->signature, &image_buffer->view, sd->static_threshold);
+		sd->last_processed_time = now;
+		return false;
+	}
+
+	if (now >= sd->last_processed_time + sd->static_refresh)
+		frame_signature_reset(sd->signature);
+
+	if (frame_signature_update(sd->signature, &image_buffer->view, sd->static_threshold) != 1) {
+		sd->last_processed_time = now;
+		return false;
+	}
+
+	/* the skipped work is counted at the average cost of the frames written */
+	for (i = 0; i < sizeof(stages) / sizeof(stages[0]); i++) {
+		stage_worker_get_stats(stages[i], &stage_stats);
+		saved += stage_stats.average_usec;
+	}
+
+	sd->static_skipped++;
+	sd->static_saved_usec += saved;
+
+	return true;
 }
 
 static void __preview_image_buffer_created_cb(void *data)
 {
 	image_buffer_data_s *image_buffer = data;
-	app_data *ad = (app_data *)image_buffer->user_data;
-	mv_source_h source = NULL;
-	mv_colorspace_e image_colorspace = MEDIA_VISION_COLORSPACE_INVALID;
-	char *info = NULL;
+	stream_data *sd = NULL;
 
 	ret_if(!image_buffer);
-	ret_if(!ad);
+	sd = (stream_data *)image_buffer->user_data;
+	goto_if(!sd, FREE_ALL_BUFFER);
 
-	image_colorspace = __convert_colorspace_from_cam_to_mv(image_buffer->format);
-	goto_if(image_colorspace == MEDIA_VISION_COLORSPACE_INVALID, FREE_ALL_BUFFER);
+	__atomic_add_fetch(&sd->stats.frames, 1, __ATOMIC_RELAXED);
 
-	__copy_image_buffer(image_buffer, ad);
+	if (!image_convert_is_supported(image_buffer->format)) {
+		_E("unsupported format : %d", image_buffer->format);
+		goto FREE_ALL_BUFFER;
+	}
 
-	source = controller_mv_create_source(image_buffer->buffer,
-		image_buffer->buffer_size,
-		image_buffer->image_width,
-		image_buffer->image_height,
-		image_colorspace);
+	sd->frame_width = image_buffer->image_width;
+	sd->frame_height = image_buffer->image_height;
 
-	pthread_mutex_lock(&ad->mutex);
-	info = ad->latest_image_info;
-	ad->latest_image_info = NULL;
-	pthread_mutex_unlock(&ad->mutex);
-	free(info);
+	/* the motion of this frame is set if there is any */
+	latest_slot_publish(sd->meta_slot, NULL);
 
-	if (source)
-		controller_mv_push_source(source);
+	controller_mv_push_frame(sd->mv, &image_buffer->view);
 
-	free(image_buffer);
+	if (__is_static_frame(sd, image_buffer))
+		goto FREE_ALL_BUFFER;
 
-	pthread_mutex_lock(&ad->mutex);
-	if (!ad->image_writter_thread) {
-		ad->image_writter_thread = ecore_thread_run(__thread_write_image_file,
-			__thread_write_image_file_end_cb,
-			__thread_write_image_file_cancel_cb,
-			ad);
-	} else {
-		_E("Thread is running NOW");
-	}
-	pthread_mutex_unlock(&ad->mutex);
+	/*
+	 * With periodic captures, preview frames are only used for detection.
+	 * Captures on motion entry only leave the snapshots in between to them.
+	 */
+	if (!__is_capture_periodic(sd))
+		__copy_image_buffer(image_buffer, sd);
+
+	frame_pool_unref(image_buffer);
+
+	if (__is_capture_periodic(sd))
+		__request_capture(sd, false);
+	else
+		__run_image_writer(sd, false);
 
 	return;
 
 FREE_ALL_BUFFER:
-	free(image_buffer->buffer);
-	free(image_buffer);
+	frame_pool_unref(image_buffer);
+}
+
+static void __set_result_info(const controller_mv_event_s *event, stream_data *sd)
+{
+	latest_data_s *meta = __new_motion_meta(sd, event);
+
+	if (meta)
+		latest_slot_publish(sd->meta_slot, meta);
+}
+
+/* Alerts once for every track that enters, not for every burst of motion */
+static void __mv_detection_event_cb(const controller_mv_event_s *event, void *user_data)
+{
+	stream_data *sd = (stream_data *)user_data;
+	int ratio = 0;
+
+	resource_camera_notify_motion(sd->camera);
+
+	if (!event->entered) {
+		__set_result_info(event, sd);
+		return;
+	}
+
+	__atomic_add_fetch(&sd->stats.detections, 1, __ATOMIC_RELAXED);
+	__request_capture(sd, true);
+
+	if (sd->frame_width && sd->frame_height)
+		ratio = (double) event->area_sum * 100 / (double) (sd->frame_width * sd->frame_height);
+	_D("[stream %d] area_sum [%d], ratio [%d], track %u", sd->stream_id, event->area_sum, ratio, event->entered_id);
+
+	char* msg = g_strdup_printf("Motion Detected! %d%% %d zones, track %u", ratio, event->result_count, event->entered_id);
+	__send_telegram_message(msg, sd);
+	free(msg);
+
+	__set_result_info(event, sd);
 }
 
-static void __set_result_info(int result[], int result_count, app_data *ad, int image_result_type)
+static Eina_Bool __stream_stats_timer_cb(void *data)
 {
-	char image_info[IMAGE_INFO_MAX + 1] = {'\0', };
-	char *current_position;
-	int current_index = 0;
-	int string_count = 0;
+	app_data *ad = (app_data *)data;
+	long long int now = __get_monotonic_ms();
+	long long int elapsed = now - ad->last_stats_time;
 	int i = 0;
-	char *latest_image_info = NULL;
-	char *info = NULL;
 
-	current_position = image_info;
+	retv_if(elapsed <= 0, ECORE_CALLBACK_RENEW);
+
+	for (i = 0; i < ad->stream_count; i++) {
+		stream_data *sd = &ad->streams[i];
+		stream_stats_s now_stats;
+		frame_scheduler_stats_s scheduler_stats;
+		camera_capture_stats_s capture_stats;
+		motion_detector_stats_s detector_stats;
+		region_classifier_stats_s classifier_stats;
+		stage_worker_h stages[] = { sd->encode_stage, sd->persist_stage, sd->notify_stage };
+		stage_worker_stats_s stage_stats;
+		image_publish_stats_s publish_stats;
+		jpeg_ring_stats_s ring_stats;
+		frame_signature_stats_s signature_stats;
+		unsigned int j = 0;
+
+		now_stats.frames = __atomic_load_n(&sd->stats.frames, __ATOMIC_RELAXED);
+		now_stats.detections = __atomic_load_n(&sd->stats.detections, __ATOMIC_RELAXED);
+		now_stats.encoded = __atomic_load_n(&sd->stats.encoded, __ATOMIC_RELAXED);
+		now_stats.encoded_bytes = __atomic_load_n(&sd->stats.encoded_bytes, __ATOMIC_RELAXED);
+
+		_I("[stream %d] preview %.1f fps, encode %.1f fps, %llu KB/s, frames %llu, detections %llu",
+			sd->stream_id,
+			(now_stats.frames - sd->last_stats.frames) * 1000.0 / elapsed,
+			(now_stats.encoded - sd->last_stats.encoded) * 1000.0 / elapsed,
+			(now_stats.encoded_bytes - sd->last_stats.encoded_bytes) / (unsigned long long)elapsed,
+			now_stats.frames, now_stats.detections);
+
+		sd->last_stats = now_stats;
+
+		if (!resource_camera_get_frame_scheduler_stats(sd->camera, &scheduler_stats))
+			_I("[stream %d] scheduler %s x%u, interval %u ms, %.1f fps, delivered %llu/%llu",
+				sd->stream_id,
+				scheduler_stats.state == FRAME_SCHEDULER_ACTIVE ? "active" : "idle",
+				1U << scheduler_stats.backoff, scheduler_stats.interval, scheduler_stats.effective_fps,
+				scheduler_stats.delivered, scheduler_stats.offered);
+
+		if (sd->capture_enabled && !resource_camera_get_capture_stats(sd->camera, &capture_stats)
+			&& capture_stats.gaps)
+			_I("[stream %d] preview stopped by %llu captures, %u ms avg, %u ms max",
+				sd->stream_id, capture_stats.gaps, capture_stats.gap_average_ms, capture_stats.gap_max_ms);
+
+		if (!controller_mv_get_detector_stats(sd->mv, &detector_stats))
+			_I("[stream %d] detector %u tiles, %u us avg, %u us max, frames %llu",
+				sd->stream_id, detector_stats.tiles, detector_stats.average_usec,
+				detector_stats.max_usec, detector_stats.frames);
+
+		if (!controller_mv_get_classifier_stats(sd->mv, &classifier_stats))
+			_I("[stream %d] classifier %llu runs of %u us avg, %llu cached, %llu over budget",
+				sd->stream_id, classifier_stats.runs, classifier_stats.average_usec,
+				classifier_stats.cached, classifier_stats.skipped);
+
+		for (j = 0; j < sizeof(stages) / sizeof(stages[0]); j++) {
+			if (!stages[j])
+				continue;
+			stage_worker_get_stats(stages[j], &stage_stats);
+			_I("[stream %d] %s queue %u/%u max, %llu done, %llu dropped, %u us avg, %u us max",
+				sd->stream_id, stage_worker_get_name(stages[j]), stage_stats.depth, stage_stats.depth_max,
+				stage_stats.processed, stage_stats.dropped, stage_stats.average_usec, stage_stats.max_usec);
+		}
+
+		if (sd->publish) {
+			image_publish_get_stats(sd->publish, &publish_stats);
+			_I("[stream %d] publish %llu files%s, %u us avg, %u us max, %llu failed",
+				sd->stream_id, publish_stats.published, publish_stats.tmpfile ? " (tmpfile)" : "",
+				publish_stats.average_usec, publish_stats.max_usec, publish_stats.failed);
+		}
+
+		if (sd->ring) {
+			jpeg_ring_get_stats(sd->ring, &ring_stats);
+			_I("[stream %d] ring frame %u, %llu written, %llu too large",
+				sd->stream_id, ring_stats.head, ring_stats.written, ring_stats.skipped);
+		}
+
+		if (sd->signature) {
+			frame_signature_get_stats(sd->signature, &signature_stats);
+			_I("[stream %d] static %llu skipped, %llu ms saved, signature %u us avg, difference %u",
+				sd->stream_id, sd->static_skipped, sd->static_saved_usec / 1000,
+				signature_stats.average_usec, signature_stats.difference);
+		}
+	}
 
-	current_position += snprintf(current_position, IMAGE_INFO_MAX, "%02d", image_result_type);
-	string_count += 2;
+	ad->last_stats_time = now;
 
-	current_position += snprintf(current_position, IMAGE_INFO_MAX - string_count, "%02d", result_count);
-	string_count += 2;
+	return ECORE_CALLBACK_RENEW;
+}
 
-	for (i = 0; i < result_count; i++) {
-		current_index = i * 4;
-		if (IMAGE_INFO_MAX - string_count < 8)
-			break;
+static void _start_camera(app_data *ad)
+{
+	int i = 0;
 
-		current_position += snprintf(current_position, IMAGE_INFO_MAX - string_count, "%02d%02d%02d%02d"
-			, result[current_index], result[current_index + 1], result[current_index + 2], result[current_index + 3]);
-		string_count += 8;
+	for (i = 0; i < ad->stream_count; i++) {
+		if (resource_camera_start_preview(ad->streams[i].camera) == -1) {
+			_E("[stream %d] Failed to start camera preview", i);
+		}
 	}
+}
 
-	latest_image_info = strdup(image_info);
+static void _stop_camera(app_data *ad)
+{
+	int i = 0;
 
-	pthread_mutex_lock(&ad->mutex);
-	info = ad->latest_image_info;
-	ad->latest_image_info = latest_image_info;
-	pthread_mutex_unlock(&ad->mutex);
-	free(info);
+	for (i = 0; i < ad->stream_count; i++) {
+		if (resource_camera_stop_preview(ad->streams[i].camera) == -1) {
+			_E("[stream %d] Failed to stop camera preview", i);
+		}
+	}
 }
 
-static void __mv_detection_event_cb(int area_sum, int result[], int result_count, void *user_data)
+static image_publish_sync_e __get_publish_sync(void)
 {
-	app_data *ad = (app_data *)user_data;
-	long long int now = __get_monotonic_ms();
+	image_publish_sync_e sync = IMAGE_PUBLISH_SYNC_NONE;
+	char *value = controller_config_get_string(CONFIG_KEY_IMAGE_FSYNC, "none");
+
+	if (value && !strcmp(value, "data"))
+		sync = IMAGE_PUBLISH_SYNC_DATA;
+	else if (value && !strcmp(value, "full"))
+		sync = IMAGE_PUBLISH_SYNC_FULL;
+	free(value);
 
-	if (now < ad->last_valid_event_time + VALID_EVENT_INTERVAL_MS) {
-		ad->valid_event_count++;
+	return sync;
+}
+
+static int __create_publish(stream_data *sd, const char *shared_data_path)
+{
+	char *dir = NULL;
+	char *temp_name = NULL;
+	char *latest_name = NULL;
+	char *link_path = NULL;
+	int ret = -1;
+
+	/* Stream 0 keeps the file names the dashboard has always used */
+	if (sd->stream_id == 0) {
+		temp_name = g_strdup("tmp.jpg");
+		latest_name = g_strdup("latest.jpg");
 	} else {
-		ad->valid_event_count = 1;
+		temp_name = g_strdup_printf("tmp_%d.jpg", sd->stream_id);
+		latest_name = g_strdup_printf("latest_%d.jpg", sd->stream_id);
 	}
 
-	ad->last_valid_event_time = now;
+	dir = controller_config_get_string(CONFIG_KEY_IMAGE_PUBLISH_DIR, "");
+	goto_if(!dir, FREE);
 
-	if (ad->valid_event_count < THRESHOLD_VALID_EVENT_COUNT) {
-		__set_result_info(result, result_count, ad, 0);
-		return;
+	sd->publish = image_publish_create(dir[0] ? dir : shared_data_path, latest_name, temp_name,
+		__get_publish_sync());
+	goto_if(!sd->publish, FREE);
+
+	/* readers keep finding it in the shared data directory */
+	if (dir[0]) {
+		link_path = g_strconcat(shared_data_path, latest_name, NULL);
+		if (image_publish_link(sd->publish, link_path))
+			_W("[stream %d] %s does not lead to %s", sd->stream_id, link_path, dir);
+		g_free(link_path);
 	}
 
-	int ratio = (double) area_sum * 100 / (double) IMAGE_RESOLUTION;
-	_D("area_sum [%d], ratio [%d]", area_sum, ratio);
+	_D("[stream %d] publish %s to %s", sd->stream_id, latest_name, dir[0] ? dir : shared_data_path);
+	ret = 0;
 
-	char* msg = g_strdup_printf("Motion Detected! %d%% %d zones", ratio, result_count);
-	__send_telegram_message(msg, ad);
-	free(msg);
+FREE:
+	free(dir);
+	g_free(temp_name);
+	g_free(latest_name);
+	return ret;
+}
+
+/* A stream without a ring still publishes latest.jpg, so failing here is not fatal */
+static void __create_ring(stream_data *sd, const char *shared_data_path)
+{
+	char *path = NULL;
+	int slots = controller_config_get_int(CONFIG_KEY_IMAGE_RING_SLOTS, JPEG_RING_SLOTS_DEFAULT);
+	int slot_kb = controller_config_get_int(CONFIG_KEY_IMAGE_RING_SLOT_SIZE, JPEG_RING_SLOT_KB_DEFAULT);
+
+	ret_if(slots <= 0);
+	retm_if(slot_kb <= 0, "[stream %d] Invalid ring slot size %d KB", sd->stream_id, slot_kb);
+
+	if (sd->stream_id == 0)
+		path = g_strconcat(shared_data_path, "frames.ring", NULL);
+	else
+		path = g_strdup_printf("%sframes_%d.ring", shared_data_path, sd->stream_id);
+
+	sd->ring = jpeg_ring_create(path, slots, slot_kb * 1024U);
+	if (!sd->ring)
+		_W("[stream %d] Failed to create %s, only latest.jpg is written", sd->stream_id, path);
 
-	ad->valid_event_count = 0;
-	__set_result_info(result, result_count, ad, 1);
+	g_free(path);
 }
 
-static void _start_camera(void)
+static int __stream_create(stream_data *sd, int stream_id, const char *shared_data_path, app_data *ad)
 {
-	if (resource_camera_start_preview() == -1) {
-		_E("Failed to start camera preview");
+	sd->stream_id = stream_id;
+	sd->ad = ad;
+
+	if (__create_publish(sd, shared_data_path) == -1) {
+		_E("[stream %d] Failed to create image publish", stream_id);
+		return -1;
+	}
+
+	__create_ring(sd, shared_data_path);
+
+	sd->frame_slot = latest_slot_create(__frame_ref, __frame_unref);
+	sd->capture_slot = latest_slot_create_data();
+	sd->jpeg_slot = latest_slot_create_data();
+	sd->meta_slot = latest_slot_create_data();
+	if (!sd->frame_slot || !sd->capture_slot || !sd->jpeg_slot || !sd->meta_slot) {
+		_E("[stream %d] Failed to create latest slots", stream_id);
+		return -1;
+	}
+
+	sd->image = controller_image_initialize();
+	if (!sd->image) {
+		_E("[stream %d] Failed to initialize image", stream_id);
+		return -1;
 	}
+
+	sd->encode_stage = stage_worker_create("encode", ENCODE_QUEUE_DEPTH, STAGE_WORKER_DROP_OLDEST,
+		__encode_job, __drop_write_job, sd);
+	sd->persist_stage = stage_worker_create("persist", PERSIST_QUEUE_DEPTH, STAGE_WORKER_DROP_OLDEST,
+		__persist_job, __drop_write_job, sd);
+	sd->notify_stage = stage_worker_create("notify", NOTIFY_QUEUE_DEPTH, STAGE_WORKER_DROP_NEWEST,
+		__notify_job, __drop_notify_job, sd);
+	if (!sd->encode_stage || !sd->persist_stage || !sd->notify_stage) {
+		_E("[stream %d] Failed to create image stages", stream_id);
+		return -1;
+	}
+
+	if (controller_mv_set_movement_detection_event_cb(stream_id, __mv_detection_event_cb, sd, &sd->mv) == -1) {
+		_E("[stream %d] Failed to set movement detection event callback", stream_id);
+		return -1;
+	}
+	controller_mv_set_worker_pool(sd->mv, ad->mv_pool);
+
+	if (resource_camera_init(stream_id, __preview_image_buffer_created_cb, sd, &sd->camera) == -1) {
+		_E("[stream %d] Failed to init camera", stream_id);
+		return -1;
+	}
+
+	sd->capture_enabled = !resource_camera_get_capture_resolution(sd->camera, NULL, NULL);
+	/*
+	 * A capture that stops the preview leaves detection blind until it
+	 * restarts, so by default such a camera only captures on motion entry
+	 */
+	sd->capture_interval = controller_config_get_stream_int(stream_id, CONFIG_KEY_CAPTURE_INTERVAL,
+		resource_camera_capture_pauses_preview(sd->camera) ? 0 : CAMERA_CAPTURE_INTERVAL_DEFAULT);
+	if (sd->capture_interval < 0)
+		sd->capture_interval = 0;
+
+	sd->static_threshold = controller_config_get_stream_int(stream_id,
+		CONFIG_KEY_IMAGE_STATIC_THRESHOLD, STATIC_THRESHOLD_DEFAULT);
+	sd->static_refresh = controller_config_get_stream_int(stream_id,
+		CONFIG_KEY_IMAGE_STATIC_REFRESH, STATIC_REFRESH_DEFAULT_MS);
+	if (sd->static_threshold >= 0) {
+		sd->signature = frame_signature_create();
+		if (!sd->signature)
+			_W("[stream %d] Failed to create frame signature, every frame is processed", stream_id);
+	}
+
+	if (resource_camera_start_preview(sd->camera) == -1) {
+		_E("[stream %d] Failed to start camera preview", stream_id);
+		return -1;
+	}
+
+	return 0;
 }
 
-static void _stop_camera(void)
+static void __stream_destroy(stream_data *sd)
 {
-	if (resource_camera_stop_preview() == -1) {
-		_E("Failed to stop camera preview");
+	if (sd->camera) {
+		resource_camera_close(sd->camera);
+		sd->camera = NULL;
 	}
+
+	controller_mv_unset_movement_detection_event_cb(sd->mv);
+	sd->mv = NULL;
+
+	frame_signature_destroy(sd->signature);
+	sd->signature = NULL;
+
+	/* encode feeds persist, so it stops first */
+	stage_worker_destroy(sd->encode_stage);
+	sd->encode_stage = NULL;
+	stage_worker_destroy(sd->persist_stage);
+	sd->persist_stage = NULL;
+	stage_worker_destroy(sd->notify_stage);
+	sd->notify_stage = NULL;
+
+	controller_image_finalize(sd->image);
+	sd->image = NULL;
+
+	/* the camera and the stages are gone, nothing reads the slots anymore */
+	latest_slot_destroy(sd->frame_slot);
+	sd->frame_slot = NULL;
+	latest_slot_destroy(sd->capture_slot);
+	sd->capture_slot = NULL;
+	latest_slot_destroy(sd->jpeg_slot);
+	sd->jpeg_slot = NULL;
+	latest_slot_destroy(sd->meta_slot);
+	sd->meta_slot = NULL;
+
+	jpeg_ring_destroy(sd->ring);
+	sd->ring = NULL;
+
+	image_publish_destroy(sd->publish);
+	sd->publish = NULL;
+}
+
+/* One thread per core up to 4 by default, the calling thread is one of them */
+static worker_pool_h __create_pool(const char *key)
+{
+	long cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
+	int threads = 0;
+
+	if (cpu_count < 1)
+		cpu_count = 1;
+	threads = controller_config_get_int(key, cpu_count < 4 ? cpu_count : 4);
+	if (threads <= 1)
+		return NULL;
+
+	return worker_pool_create(threads);
 }
 
 static bool service_app_create(void *data)
 {
 	app_data *ad = (app_data *)data;
+	char *comment = NULL;
+	int stream_count = 0;
+	int i = 0;
 
 	char* shared_data_path = app_get_shared_data_path();
 	if (shared_data_path == NULL) {
 		_E("Failed to get shared data path");
-		goto ERROR;
+		return false;
 	}
-	ad->temp_image_filename = g_strconcat(shared_data_path, "tmp.jpg", NULL);
-	ad->latest_image_filename = g_strconcat(shared_data_path, "latest.jpg", NULL);
-	free(shared_data_path);
 
-	_D("%s", ad->temp_image_filename);
-	_D("%s", ad->latest_image_filename);
+	stream_count = controller_config_get_int(CONFIG_KEY_STREAM_COUNT, 1);
+	if (stream_count < 1 || stream_count > CAMERA_STREAM_MAX) {
+		_W("Invalid stream count [%d], use 1", stream_count);
+		stream_count = 1;
+	}
 
-	controller_image_initialize();
+	ad->mv_pool = __create_pool(CONFIG_KEY_MV_THREADS);
 
-	pthread_mutex_init(&ad->mutex, NULL);
+	comment = controller_config_get_string(CONFIG_KEY_IMAGE_META_COMMENT, "ascii");
+	ad->meta_ascii = !comment || strcmp(comment, "none");
+	free(comment);
 
-	if (controller_mv_set_movement_detection_event_cb(__mv_detection_event_cb, data) == -1) {
-		_E("Failed to set movement detection event callback");
-		goto ERROR;
-	}
-
-	if (resource_camera_init(__preview_image_buffer_created_cb, ad) == -1) {
-		_E("Failed to init camera");
-		goto ERROR;
+	for (i = 0; i < stream_count; i++) {
+		ad->stream_count = i + 1;
+		if (__stream_create(&ad->streams[i], i, shared_data_path, ad) == -1)
+			goto ERROR;
 	}
+	free(shared_data_path);
 
-	if (resource_camera_start_preview() == -1) {
-		_E("Failed to start camera preview");
-		goto ERROR;
-	}
+	ad->last_stats_time = __get_monotonic_ms();
+	ad->stats_timer = ecore_timer_add(STREAM_STATS_INTERVAL_SEC, __stream_stats_timer_cb, ad);
+	if (!ad->stats_timer)
+		_W("Failed to add stream stats timer");
 
 	return true;
 
 ERROR:
-	resource_camera_close();
-	controller_mv_unset_movement_detection_event_cb();
-	controller_image_finalize();
+	free(shared_data_path);
+	for (i = 0; i < ad->stream_count; i++)
+		__stream_destroy(&ad->streams[i]);
+	ad->stream_count = 0;
+	if (ad->mv_pool) {
+		worker_pool_destroy(ad->mv_pool);
+		ad->mv_pool = NULL;
+	}
 
-	pthread_mutex_destroy(&ad->mutex);
 	return false;
 }
 
 static void service_app_terminate(void *data)
 {
 	app_data *ad = (app_data *)data;
-	Ecore_Thread *thread_id = NULL;
-	unsigned char *buffer = NULL;
-	unsigned char *encoded_image_buffer = NULL;
-	char *info = NULL;
-	gchar *temp_image_filename;
-	gchar *latest_image_filename;
+	int i = 0;
 	_D("App Terminated - enter");
 
-	resource_camera_close();
-	controller_mv_unset_movement_detection_event_cb();
-
-	pthread_mutex_lock(&ad->mutex);
-	thread_id = ad->image_writter_thread;
-	ad->image_writter_thread = NULL;
-	pthread_mutex_unlock(&ad->mutex);
-
-	if (thread_id)
-		ecore_thread_wait(thread_id, 3.0); // wait for 3 second
-
-	if(ad->telegram_thread)
-		ecore_thread_wait(ad->telegram_thread, 3.0); // wait for 3 second
-
-	ad->telegram_thread = NULL;
-
-	free(ad->telegram_message);
-	free(ad->telegram_image_buffer);
-
-	controller_image_finalize();
-
-	pthread_mutex_lock(&ad->mutex);
-	buffer = ad->latest_image_buffer;
-	ad->latest_image_buffer = NULL;
-	encoded_image_buffer = ad->latest_encoded_image_buffer;
-	ad->latest_encoded_image_buffer = NULL;
-	info  = ad->latest_image_info;
-	ad->latest_image_info = NULL;
-	temp_image_filename = ad->temp_image_filename;
-	ad->temp_image_filename = NULL;
-	latest_image_filename = ad->latest_image_filename;
-	ad->latest_image_filename = NULL;
-	pthread_mutex_unlock(&ad->mutex);
-	free(buffer);
-	free(encoded_image_buffer);
-	free(info);
-	g_free(temp_image_filename);
-	g_free(latest_image_filename);
-
-	pthread_mutex_destroy(&ad->mutex);
+	if (ad->stats_timer) {
+		ecore_timer_del(ad->stats_timer);
+		ad->stats_timer = NULL;
+	}
+
+	for (i = 0; i < ad->stream_count; i++)
+		__stream_destroy(&ad->streams[i]);
+	ad->stream_count = 0;
+	if (ad->mv_pool) {
+		worker_pool_destroy(ad->mv_pool);
+		ad->mv_pool = NULL;
+	}
+
 	free(ad);
 	_D("App Terminated - leave");
 }
 
+static void __set_config(app_control_h app_control)
+{
+	char *key = NULL;
+	char *value = NULL;
+
+	if (app_control_get_extra_data(app_control, "key", &key) != APP_CONTROL_ERROR_NONE
+		|| app_control_get_extra_data(app_control, "value", &value) != APP_CONTROL_ERROR_NONE) {
+		_E("config command needs key and value");
+		goto FREE;
+	}
+
+	controller_config_set(key, value);
+
+FREE:
+	free(key);
+	free(value);
+}
+
+/*
+ * "mask" command: extra data "roi" and/or "exclude" (see CONFIG_KEY_MV_ROI),
+ * for stream "stream" or all streams. Applied right away, an empty value
+ * clears it.
+ */
+static void __set_mask(app_control_h app_control, app_data *ad)
+{
+	static const char *keys[] = { CONFIG_KEY_MV_ROI, CONFIG_KEY_MV_EXCLUDE };
+	static const char *extras[] = { "roi", "exclude" };
+	char *stream = NULL;
+	int stream_id = -1;
+	int i = 0;
+	int k = 0;
+
+	if (app_control_get_extra_data(app_control, "stream", &stream) == APP_CONTROL_ERROR_NONE) {
+		stream_id = atoi(stream);
+		free(stream);
+		retm_if(stream_id < 0 || stream_id >= ad->stream_count, "No stream %d", stream_id);
+	}
+
+	for (k = 0; k < 2; k++) {
+		char *value = NULL;
+
+		if (app_control_get_extra_data(app_control, extras[k], &value) != APP_CONTROL_ERROR_NONE)
+			continue;
+
+		if (stream_id < 0)
+			controller_config_set(keys[k], value);
+		else
+			controller_config_set_stream(stream_id, keys[k], value);
+		free(value);
+	}
+
+	for (i = 0; i < ad->stream_count; i++) {
+		if (stream_id < 0 || stream_id == i)
+			controller_mv_reload_mask(ad->streams[i].mv);
+	}
+}
+
 static void service_app_control(app_control_h app_control, void *data)
 {
 	/* APP_CONTROL */
+	app_data *ad = (app_data *)data;
 	int ret = 0;
+	int i = 0;
 	char *command = NULL;
 
 	_D("App control");
@@ -509,11 +1102,16 @@ static void service_app_control(app_control_h app_control, void *data)
 	} else {
 		_D("command = [%s]", command);
 		if (!strncmp("send", command, sizeof("send"))) {
-			__send_telegram_message("", data);
+			for (i = 0; i < ad->stream_count; i++)
+				__send_telegram_message("", &ad->streams[i]);
 		} else if (!strncmp("on", command, sizeof("on"))) {
-			_start_camera();
+			_start_camera(ad);
 		} else if (!strncmp("off", command, sizeof("off"))) {
-			_stop_camera();
+			_stop_camera(ad);
+		} else if (!strncmp("config", command, sizeof("config"))) {
+			__set_config(app_control);
+		} else if (!strncmp("mask", command, sizeof("mask"))) {
+			__set_mask(app_control, ad);
 		}
 		free(command);
 	}
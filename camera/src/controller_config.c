@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <tizen.h>
+#include <app_preference.h>
+#include <glib.h>
+
+#include "log.h"
+#include "controller_config.h"
+
+int controller_config_get_int(const char *key, int default_value)
+{
+	char *value = NULL;
+	char *end = NULL;
+	long number = 0;
+
+	value = controller_config_get_string(key, NULL);
+	if (!value)
+		return default_value;
+
+	number = strtol(value, &end, 0);
+	if (end == value || *end != '\0') {
+		_W("[%s] is not a number : %s", key, value);
+		number = default_value;
+	}
+	free(value);
+
+	return (int)number;
+}
+
+char *controller_config_get_string(const char *key, const char *default_value)
+{
+	char *value = NULL;
+	bool existing = false;
+	int ret = 0;
+
+	retv_if(!key, NULL);
+
+	ret = preference_is_existing(key, &existing);
+	if (ret == PREFERENCE_ERROR_NONE && existing) {
+		ret = preference_get_string(key, &value);
+		if (ret == PREFERENCE_ERROR_NONE)
+			return value;
+
+		_E("Failed to get [%s] - [%s]", key, get_error_message(ret));
+	}
+
+	return default_value ? strdup(default_value) : NULL;
+}
+
+int controller_config_set(const char *key, const char *value)
+{
+	int ret = 0;
+
+	retv_if(!key, -1);
+	retv_if(!value, -1);
+
+	ret = preference_set_string(key, value);
+	retvm_if(ret != PREFERENCE_ERROR_NONE, -1, "Failed to set [%s] - [%s]", key, get_error_message(ret));
+
+	_I("config [%s] = [%s]", key, value);
+
+	return 0;
+}
+
+int controller_config_set_stream(int stream_id, const char *key, const char *value)
+{
+	gchar *stream_key = NULL;
+	int ret = 0;
+
+	retv_if(!key, -1);
+
+	stream_key = g_strdup_printf("stream%d.%s", stream_id, key);
+	ret = controller_config_set(stream_key, value);
+	g_free(stream_key);
+
+	return ret;
+}
+
+int controller_config_get_stream_int(int stream_id, const char *key, int default_value)
+{
+	gchar *stream_key = g_strdup_printf("stream%d.%s", stream_id, key);
+	int value = controller_config_get_int(stream_key, controller_config_get_int(key, default_value));
+
+	g_free(stream_key);
+
+	return value;
+}
+
+char *controller_config_get_stream_string(int stream_id, const char *key, const char *default_value)
+{
+	gchar *stream_key = g_strdup_printf("stream%d.%s", stream_id, key);
+	char *value = controller_config_get_string(stream_key, NULL);
+
+	g_free(stream_key);
+	if (value)
+		return value;
+
+	return controller_config_get_string(key, default_value);
+}
@@ -21,113 +21,175 @@
 #include <image_util.h>
 #include "log.h"
 #include "exif.h"
+#include "controller_image.h"
+#include "image_convert.h"
 
-static image_util_encode_h encode_h = NULL;
-static image_util_decode_h decode_h = NULL;
+struct __image_data {
+	image_util_encode_h encode_h;
+	image_util_decode_h decode_h;
+
+	/* Only used when a frame is not packed I420, reused across frames */
+	unsigned char *pack_buffer;
+	unsigned int pack_buffer_size;
+};
 
 #define IMAGE_COLORSPACE IMAGE_UTIL_COLORSPACE_I420
+#define IMAGE_QUALITY 90
 
-void controller_image_initialize(void)
+controller_image_h controller_image_initialize(void)
 {
-	int error_code = image_util_encode_create(IMAGE_UTIL_JPEG, &encode_h);
+	struct __image_data *image = calloc(1, sizeof(struct __image_data));
+	retvm_if(!image, NULL, "Failed to allocate image data");
+
+	int error_code = image_util_encode_create(IMAGE_UTIL_JPEG, &image->encode_h);
 	if (error_code != IMAGE_UTIL_ERROR_NONE) {
 		_E("image_util_encode_create [%s]", get_error_message(error_code));
 	}
 
-	error_code = image_util_decode_create(&decode_h);
+	error_code = image_util_decode_create(&image->decode_h);
 	if (error_code != IMAGE_UTIL_ERROR_NONE) {
 		_E("image_util_decode_create [%s]", get_error_message(error_code));
 	}
+
+	return image;
 }
 
-void controller_image_finalize(void)
+void controller_image_finalize(controller_image_h image)
 {
-	int error_code = image_util_encode_destroy(encode_h);
+	ret_if(!image);
+
+	int error_code = image_util_encode_destroy(image->encode_h);
 	if (error_code != IMAGE_UTIL_ERROR_NONE) {
 		_E("image_util_encode_destroy [%s]", get_error_message(error_code));
 	}
 
-	error_code = image_util_decode_destroy(decode_h);
+	error_code = image_util_decode_destroy(image->decode_h);
     if (error_code != IMAGE_UTIL_ERROR_NONE) {
         _E("image_util_decode_destroy [%s]", get_error_message(error_code));
     }
+
+	free(image->pack_buffer);
+	free(image);
 }
 
-int controller_image_save_image_file(const char *path,
-	unsigned int width, unsigned int height, const unsigned char *buffer,
-	unsigned char** encoded, unsigned long long* encoded_size, const char *comment, unsigned int comment_len)
+int controller_image_encode(controller_image_h image, const image_frame_view_s *view,
+	unsigned char** encoded, unsigned long long* encoded_size)
 {
-	int error_code = image_util_encode_set_resolution(encode_h, width, height);
+	const unsigned char *buffer = NULL;
+	int error_code = 0;
+
+	retv_if(!image, -1);
+	retv_if(!view, -1);
 
+	/* The encoder is always fed I420, whatever the camera delivers */
+	buffer = image_convert_get_frame(view, IMAGE_CONVERT_I420, &image->pack_buffer, &image->pack_buffer_size);
+	retv_if(!buffer, -1);
+
+	error_code = image_util_encode_set_resolution(image->encode_h, view->width, view->height);
 	if (error_code != IMAGE_UTIL_ERROR_NONE) {
 		_E("image_util_encode_set_resolution [%s]", get_error_message(error_code));
 		return -1;
 	}
 
-	error_code = image_util_encode_set_colorspace(encode_h, IMAGE_COLORSPACE);
+	error_code = image_util_encode_set_colorspace(image->encode_h, IMAGE_COLORSPACE);
 	if (error_code != IMAGE_UTIL_ERROR_NONE) {
 		_E("image_util_encode_set_colorspace [%s]", get_error_message(error_code));
 		return -1;
 	}
 
-	error_code = image_util_encode_set_quality(encode_h, 90);
+	error_code = image_util_encode_set_quality(image->encode_h, IMAGE_QUALITY);
 	if (error_code != IMAGE_UTIL_ERROR_NONE) {
 		_E("image_util_encode_set_quality [%s]", get_error_message(error_code));
 		return -1;
 	}
 
-	error_code = image_util_encode_set_input_buffer(encode_h, buffer);
+	error_code = image_util_encode_set_input_buffer(image->encode_h, buffer);
 	if (error_code != IMAGE_UTIL_ERROR_NONE) {
 		_E("image_util_encode_set_input_buffer [%s]", get_error_message(error_code));
 		return -1;
 	}
 
-	error_code = image_util_encode_set_output_buffer(encode_h, encoded);
+	error_code = image_util_encode_set_output_buffer(image->encode_h, encoded);
 	if (error_code != IMAGE_UTIL_ERROR_NONE) {
 		_E("image_util_encode_set_output_buffer [%s]", get_error_message(error_code));
 		return -1;
 	}
 
-	error_code = image_util_encode_run(encode_h, encoded_size);
+	error_code = image_util_encode_run(image->encode_h, encoded_size);
 	if (error_code != IMAGE_UTIL_ERROR_NONE) {
 		_E("image_util_encode_run [%s]", get_error_message(error_code));
 		return -1;
 	}
 
-	error_code = exif_write_jpg_file_with_comment(path,
-			*encoded, (unsigned int)*encoded_size, width, height, comment, comment_len);
+	return 0;
+}
+
+int controller_image_publish_jpeg(image_publish_h publish, const unsigned char *jpeg, unsigned int jpeg_size,
+	unsigned int width, unsigned int height, const char *comment, unsigned int comment_len,
+	const unsigned char *segment, unsigned int segment_size)
+{
+	unsigned char app1[EXIF_APP1_SIZE_MAX];
+	unsigned int app1_size = 0;
+	struct iovec iov[4];
+	int iov_count = 0;
+
+	retv_if(!publish, -1);
+	retv_if(!jpeg, -1);
+	retv_if(jpeg_size <= 2, -1);
+
+	if (comment && comment_len
+		&& exif_build_app1_with_comment(width, height, comment, comment_len, app1, &app1_size)) {
+		_W("Failed to build exif, publish without it");
+		app1_size = 0;
+	}
+
+	/* SOI, APP1, the segment, then the rest of the JPEG */
+	iov[iov_count].iov_base = (void *)jpeg;
+	iov[iov_count++].iov_len = 2;
+	if (app1_size) {
+		iov[iov_count].iov_base = app1;
+		iov[iov_count++].iov_len = app1_size;
+	}
+	if (segment && segment_size) {
+		iov[iov_count].iov_base = (void *)segment;
+		iov[iov_count++].iov_len = segment_size;
+	}
+	iov[iov_count].iov_base = (void *)(jpeg + 2);
+	iov[iov_count++].iov_len = jpeg_size - 2;
 
-	return error_code;
+	return image_publish_write(publish, iov, iov_count);
 }
 
-int controller_image_read_image_file(const char *path,
+int controller_image_read_image_file(controller_image_h image, const char *path,
 	unsigned long *width, unsigned long *height, unsigned char *buffer, unsigned long long *size)
 {
-	int error_code = image_util_decode_set_input_path(decode_h, path);
+	retv_if(!image, -1);
+
+	int error_code = image_util_decode_set_input_path(image->decode_h, path);
 	if (error_code != IMAGE_UTIL_ERROR_NONE) {
 		_E("image_util_decode_set_input_path [%s] [%s]", path, get_error_message(error_code));
 		return -1;
 	}
 
-	error_code = image_util_decode_set_output_buffer(decode_h, &buffer);
+	error_code = image_util_decode_set_output_buffer(image->decode_h, &buffer);
 	if (error_code != IMAGE_UTIL_ERROR_NONE) {
 		_E("image_util_decode_set_output_buffer [%s]", get_error_message(error_code));
 		return -1;
 	}
 
-	error_code = image_util_decode_set_colorspace(decode_h, IMAGE_UTIL_COLORSPACE_RGBA8888);
+	error_code = image_util_decode_set_colorspace(image->decode_h, IMAGE_UTIL_COLORSPACE_RGBA8888);
 	if (error_code != IMAGE_UTIL_ERROR_NONE) {
 		_E("image_util_decode_set_colorspace [%s]", get_error_message(error_code));
 		return -1;
 	}
 
-	error_code = image_util_decode_set_jpeg_downscale(decode_h, IMAGE_UTIL_DOWNSCALE_1_1);
+	error_code = image_util_decode_set_jpeg_downscale(image->decode_h, IMAGE_UTIL_DOWNSCALE_1_1);
 	if (error_code != IMAGE_UTIL_ERROR_NONE) {
 		_E("image_util_decode_set_jpeg_downscale [%s]", get_error_message(error_code));
 		return -1;
 	}
 
-	error_code = image_util_decode_run(decode_h, width, height, size);
+	error_code = image_util_decode_run(image->decode_h, width, height, size);
 	if (error_code != IMAGE_UTIL_ERROR_NONE) {
 		_E("image_util_decode_run [%s]", get_error_message(error_code));
 		return -1;
@@ -16,22 +16,77 @@
 
 #include <glib.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <app_common.h>
 #include <mv_common.h>
 #include <mv_surveillance.h>
+#include <mv_face.h>
 #include "controller.h"
 #include "controller_mv.h"
+#include "controller_config.h"
+#include "image_pyramid.h"
+#include "motion_detector.h"
+#include "motion_mask.h"
+#include "scene_change.h"
+#include "region_classifier.h"
+#include "region_tracker.h"
 #include "log.h"
 
-#define VIDEO_STREAM_ID 0
 #define THRESHOLD_SIZE_REGION 100
+#define MOVEMENT_THRESHOLD_DEFAULT 50
+/* nothing is reported for this long after the whole scene changed */
+#define SCENE_CHANGE_HOLD_MS 2000
+/* ms of detection per second, 100 is a tenth of a core */
+#define CLASSIFY_BUDGET_DEFAULT 100
+/* a region seen this many times is an alert, once per track */
+#define TRACK_CONFIRM_HITS 5
+/* a track not seen for this long has left */
+#define TRACK_TIMEOUT_MS 1000
 
 struct __mv_data {
+	int video_stream_id;
 	mv_surveillance_event_trigger_h mv_trigger_handle;
+	/* set when the native detector is used instead of mv_surveillance */
+	motion_detector_h detector;
+	/* results of either engine, largest first */
+	region_set_s regions;
+	/* mv_surveillance rectangles, grown when an event has more */
+	mv_rectangle_s *rectangles;
+	size_t rectangles_size;
+	/* where the native background model is kept across restarts */
+	char *model_path;
+	/* CONFIG_KEY_MV_ROI and CONFIG_KEY_MV_EXCLUDE, NULL for the whole frame */
+	motion_mask_h mask;
+	/* global lighting and camera shake, NULL when CONFIG_KEY_MV_GLOBAL_CHANGE is off */
+	scene_change_h scene;
+	long long int hold_until;
+	unsigned long long int suppressed;
+	/* faces in motion regions, NULL when CONFIG_KEY_MV_CLASSIFY is off */
+	region_classifier_h classifier;
+	region_class_e classes[REGION_SET_MAX];
+	region_tracker_h tracker;
+	/* levels of the frame being pushed, NULL outside of controller_mv_push_frame() */
+	const image_pyramid_s *frame_pyramid;
+	mv_source_h face_source;
+	unsigned char *crop_buffer;
+	unsigned int crop_buffer_size;
 	movement_detected_cb movement_detected_cb;
 	void *movement_detected_cb_data;
-};
 
-static struct __mv_data *mv_data = NULL;
+	/* configured pyramid level, -1 for automatic */
+	int level_config;
+	image_pyramid_s pyramid;
+
+	/* analysis level and its size for the pushed frames, results are relative to it */
+	unsigned int level;
+	unsigned int width;
+	unsigned int height;
+
+	/* Only used when the analysis level has row padding, reused across frames */
+	unsigned char *pack_buffer;
+	unsigned int pack_buffer_size;
+};
 
 static const char *__mv_err_to_str(mv_error_e err)
 {
@@ -84,98 +139,421 @@ static const char *__mv_err_to_str(mv_error_e err)
 	return err_str;
 }
 
-static void __movement_detected_event_cb(mv_surveillance_event_trigger_h trigger, mv_source_h source, int video_stream_id, mv_surveillance_result_h event_result, void *data)
+static long long int __get_monotonic_ms(void)
+{
+	struct timespec time_s;
+
+	clock_gettime(CLOCK_MONOTONIC, &time_s);
+
+	return time_s.tv_sec * 1000LL + time_s.tv_nsec / 1000000;
+}
+
+static void __face_detected_cb(mv_source_h source, mv_engine_config_h engine_cfg,
+	mv_rectangle_s *faces_locations, int number_of_faces, void *user_data)
 {
+	int *found = user_data;
+
+	*found = number_of_faces > 0;
+}
+
+/* region_classifier_detect_cb of the face detector, the crop is packed for media vision */
+static int __detect_face(const image_luma_s *crop, void *user_data)
+{
+	struct __mv_data *mv_data = user_data;
+	unsigned int size = crop->width * crop->height;
+	unsigned int row = 0;
+	int found = 0;
 	int ret = 0;
-	int result[MV_RESULT_LENGTH_MAX] = {0, };
+
+	if (mv_data->crop_buffer_size < size) {
+		unsigned char *crop_buffer = realloc(mv_data->crop_buffer, size);
+		retvm_if(!crop_buffer, -1, "Failed to allocate %u bytes", size);
+		mv_data->crop_buffer = crop_buffer;
+		mv_data->crop_buffer_size = size;
+	}
+
+	for (row = 0; row < crop->height; row++)
+		memcpy(mv_data->crop_buffer + row * crop->width, crop->data + row * crop->stride, crop->width);
+
+	mv_source_clear(mv_data->face_source);
+	ret = mv_source_fill_by_buffer(mv_data->face_source, mv_data->crop_buffer, size,
+		crop->width, crop->height, MEDIA_VISION_COLORSPACE_Y800);
+	retvm_if(ret, -1, "failed to fill face source - [%s]", __mv_err_to_str(ret));
+
+	/* the callback is called before mv_face_detect() returns */
+	ret = mv_face_detect(mv_data->face_source, NULL, __face_detected_cb, &found);
+	retvm_if(ret, -1, "failed to mv_face_detect - [%s]", __mv_err_to_str(ret));
+
+	return found;
+}
+
+/*
+ * Reports the regions of the analysis level large enough to count, areas
+ * are in full frame pixels. With a classifier, the reported regions are
+ * classified as well.
+ */
+static void __report_regions(struct __mv_data *mv_data)
+{
+	const region_set_s *regions = &mv_data->regions;
+	region_set_s reported;
+	region_track_info_s tracks[REGION_SET_MAX];
+	controller_mv_event_s event;
+	int *result = event.result;
 	int result_count = 0;
-	int result_index = 0;
 	int valid_area_sum = 0;
-	int i;
+	unsigned int i = 0;
+
+	/* the engines still learn the new scene, but it is not motion */
+	if (mv_data->hold_until && __get_monotonic_ms() < mv_data->hold_until) {
+		mv_data->suppressed++;
+		return;
+	}
+
+	for (i = 0; i < regions->count && result_count < MV_RESULT_COUNT_MAX; i++) {
+		int area = (regions->width[i] * regions->height[i]) << (2 * mv_data->level);
+		int *zone = &result[result_count * 4];
+
+		if (area < THRESHOLD_SIZE_REGION)
+			continue;
+
+		reported.x[result_count] = regions->x[i];
+		reported.y[result_count] = regions->y[i];
+		reported.width[result_count] = regions->width[i];
+		reported.height[result_count] = regions->height[i];
+
+		zone[0] = regions->x[i] * 99 / mv_data->width;
+		zone[1] = regions->y[i] * 99 / mv_data->height;
+		zone[2] = regions->width[i] * 99 / mv_data->width;
+		zone[3] = regions->height[i] * 99 / mv_data->height;
+
+		event.region[result_count * 4] = regions->x[i] << mv_data->level;
+		event.region[result_count * 4 + 1] = regions->y[i] << mv_data->level;
+		event.region[result_count * 4 + 2] = regions->width[i] << mv_data->level;
+		event.region[result_count * 4 + 3] = regions->height[i] << mv_data->level;
+		event.region_area[result_count] = area;
+
+		result_count++;
+		valid_area_sum += area;
+	}
+	reported.count = result_count;
+
+	event.area_sum = valid_area_sum;
+	event.result_count = result_count;
+	event.object_count = -1;
+	if (mv_data->classifier && mv_data->frame_pyramid)
+		event.object_count = region_classifier_run(mv_data->classifier, mv_data->frame_pyramid,
+			mv_data->level, &reported, mv_data->classes);
+
+	/* without a classifier every track counts, with one only tracks that showed a face */
+	event.entered = region_tracker_update(mv_data->tracker, &reported,
+		event.object_count >= 0 ? mv_data->classes : NULL, __get_monotonic_ms(), tracks);
+	if (event.entered < 0)
+		event.entered = 0;
+
+	event.entered_id = 0;
+	for (i = 0; i < (unsigned int)result_count; i++) {
+		event.track_id[i] = tracks[i].id;
+		event.track_age[i] = tracks[i].age;
+		if (tracks[i].entered && !event.entered_id)
+			event.entered_id = tracks[i].id;
+	}
+
+	mv_data->movement_detected_cb(&event, mv_data->movement_detected_cb_data);
+}
+
+static void __movement_detected_event_cb(mv_surveillance_event_trigger_h trigger, mv_source_h source, int video_stream_id, mv_surveillance_result_h event_result, void *data)
+{
+	int ret = 0;
+	size_t i = 0;
 	size_t move_regions_num = 0;
-	mv_rectangle_s *regions = NULL;
+	struct __mv_data *mv_data = data;
 
 	ret_if(!trigger);
 	ret_if(!event_result);
 	ret_if(!mv_data);
+	ret_if(!mv_data->width || !mv_data->height);
 
 	ret = mv_surveillance_get_result_value(event_result, MV_SURVEILLANCE_MOVEMENT_NUMBER_OF_REGIONS, &move_regions_num);
 	retm_if(ret, "failed to mv_surveillance_get_result_value for %s - [%s]", MV_SURVEILLANCE_MOVEMENT_NUMBER_OF_REGIONS, __mv_err_to_str(ret));
 
-	regions = malloc(sizeof(mv_rectangle_s) * move_regions_num);
-	ret = mv_surveillance_get_result_value(event_result, MV_SURVEILLANCE_MOVEMENT_REGIONS, regions);
-	retm_if(ret, "failed to mv_surveillance_get_result_value for %s - [%s]", MV_SURVEILLANCE_MOVEMENT_REGIONS, __mv_err_to_str(ret));
-
-	for (i = 0; i < move_regions_num; i++) {
-		// _D("region[%u] - position[%d x %d], witdh[%d], height[%d]", i, regions[i].point.x, regions[i].point.y, regions[i].width, regions[i].height);
-		// _D("region[%u] - area[%d]", i, regions[i].width * regions[i].height);
+	region_set_clear(&mv_data->regions);
 
-		if (regions[i].width * regions[i].height < THRESHOLD_SIZE_REGION || result_count >= MV_RESULT_COUNT_MAX)
-			continue;
+	if (move_regions_num) {
+		if (mv_data->rectangles_size < move_regions_num) {
+			mv_rectangle_s *rectangles = realloc(mv_data->rectangles, sizeof(mv_rectangle_s) * move_regions_num);
+			retm_if(!rectangles, "Failed to allocate %zu regions", move_regions_num);
+			mv_data->rectangles = rectangles;
+			mv_data->rectangles_size = move_regions_num;
+		}
 
-		result[result_index] = regions[i].point.x * 99 / IMAGE_WIDTH;
-		result[result_index + 1] = regions[i].point.y * 99 / IMAGE_HEIGHT;
-		result[result_index + 2] = regions[i].width * 99 / IMAGE_WIDTH;
-		result[result_index + 3] = regions[i].height * 99 / IMAGE_HEIGHT;
+		ret = mv_surveillance_get_result_value(event_result, MV_SURVEILLANCE_MOVEMENT_REGIONS, mv_data->rectangles);
+		retm_if(ret, "failed to mv_surveillance_get_result_value for %s - [%s]", MV_SURVEILLANCE_MOVEMENT_REGIONS, __mv_err_to_str(ret));
+	}
 
-		result_count++;
-		result_index = result_count * 4;
+	for (i = 0; i < move_regions_num; i++) {
+		const mv_rectangle_s *rectangle = &mv_data->rectangles[i];
 
-		valid_area_sum += regions[i].width * regions[i].height;
+		// _D("region[%zu] - position[%d x %d], witdh[%d], height[%d]", i, rectangle->point.x, rectangle->point.y, rectangle->width, rectangle->height);
+		region_set_insert(&mv_data->regions, rectangle->point.x, rectangle->point.y,
+			rectangle->width, rectangle->height, rectangle->width * rectangle->height);
 	}
-	free(regions);
 
-	mv_data->movement_detected_cb(valid_area_sum, result, result_count, mv_data->movement_detected_cb_data);
+	__report_regions(mv_data);
 }
 
-void controller_mv_push_source(mv_source_h source)
+static void __detect_native(struct __mv_data *mv_data, const image_luma_s *luma)
 {
+	if (motion_detector_process(mv_data->detector, luma, &mv_data->regions) <= 0)
+		return;
+
+	__report_regions(mv_data);
+}
+
+static void __detect_surveillance(struct __mv_data *mv_data, const image_luma_s *luma)
+{
+	mv_source_h source = NULL;
+	const unsigned char *buffer = luma->data;
+	unsigned int row = 0;
 	int ret = 0;
-	ret_if(!source);
+	bool masked = false;
+
+	/* mv_surveillance has no exclusion, masked out pixels are given a constant value instead */
+	if (mv_data->mask && !motion_mask_compile(mv_data->mask, luma->width, luma->height))
+		masked = true;
+
+	if (luma->stride != luma->width || masked) {
+		unsigned int size = luma->width * luma->height;
+
+		if (mv_data->pack_buffer_size < size) {
+			unsigned char *pack_buffer = realloc(mv_data->pack_buffer, size);
+			retm_if(!pack_buffer, "Failed to allocate %u bytes", size);
+			mv_data->pack_buffer = pack_buffer;
+			mv_data->pack_buffer_size = size;
+		}
+
+		for (row = 0; row < luma->height; row++) {
+			unsigned char *dst = mv_data->pack_buffer + row * luma->width;
+			const unsigned char *src = luma->data + row * luma->stride;
+			const unsigned short *spans = NULL;
+			unsigned int count = 0;
+			unsigned int x = 0;
+			unsigned int i = 0;
+
+			if (!masked) {
+				memcpy(dst, src, luma->width);
+				continue;
+			}
+
+			count = motion_mask_get_spans(mv_data->mask, row, &spans);
+			for (i = 0; i < count; i++) {
+				memset(dst + x, 0, spans[2 * i] - x);
+				memcpy(dst + spans[2 * i], src + spans[2 * i], spans[2 * i + 1] - spans[2 * i]);
+				x = spans[2 * i + 1];
+			}
+			memset(dst + x, 0, luma->width - x);
+		}
+		buffer = mv_data->pack_buffer;
+	}
 
-	ret = mv_surveillance_push_source(source, VIDEO_STREAM_ID);
+	ret = mv_create_source(&source);
+	retm_if(ret, "failed to mv_create_source - [%s]", __mv_err_to_str(ret));
+
+	ret = mv_source_fill_by_buffer(source, (unsigned char *)buffer,
+			luma->width * luma->height, luma->width, luma->height, MEDIA_VISION_COLORSPACE_Y800);
+	if (ret) {
+		_E("failed to fill source - %d", ret);
+		mv_destroy_source(source);
+		return;
+	}
+
+	ret = mv_surveillance_push_source(source, mv_data->video_stream_id);
 	if (ret)
 		_E("failed to mv_surveillance_push_source() - [%s]", __mv_err_to_str(ret));
 
 	mv_destroy_source(source);
 }
 
-mv_source_h controller_mv_create_source(
-		unsigned char *buffer, unsigned int size,
-		unsigned int width, unsigned int height, mv_colorspace_e colorspace)
+static unsigned int __get_level(struct __mv_data *mv, const image_frame_view_s *view)
 {
-	mv_source_h source = NULL;
+	unsigned int level = 0;
+
+	if (mv->level_config >= 0)
+		return mv->level_config;
+
+	while (level < IMAGE_PYRAMID_LEVEL_MAX && (view->width >> (level + 1)) >= MV_ANALYSIS_WIDTH_MIN)
+		level++;
+
+	return level;
+}
+
+/*
+ * Returns true when the frame is not worth analysing: the lighting changed
+ * or the camera moved, which would make most of the frame foreground.
+ */
+static bool __check_scene_change(struct __mv_data *mv, const image_luma_s *luma)
+{
+	scene_change_info_s info;
+	scene_change_e change = SCENE_CHANGE_NONE;
+	long long int now = 0;
+
+	if (!mv->scene)
+		return false;
+
+	change = scene_change_update(mv->scene, luma);
+	if (change == SCENE_CHANGE_NONE)
+		return false;
+
+	now = __get_monotonic_ms();
+	if (now >= mv->hold_until) {
+		scene_change_get_info(mv->scene, &info);
+		if (change == SCENE_CHANGE_LIGHTING)
+			_I("[stream %d] lighting change, mean %u -> %u, gain %u%% in %u cells, histogram %u%% off, %llu reports suppressed so far",
+				mv->video_stream_id, info.previous_mean, info.mean, info.gain, info.gain_cells,
+				info.histogram_reshape, mv->suppressed);
+		else
+			_I("[stream %d] camera shake, shift %d,%d, %llu reports suppressed so far",
+				mv->video_stream_id, info.shift_x, info.shift_y, mv->suppressed);
+	}
+	mv->hold_until = now + SCENE_CHANGE_HOLD_MS;
+
+	/* the old background is of no use under the new light, a shaken frame is not learnt */
+	if (mv->detector && change == SCENE_CHANGE_LIGHTING)
+		motion_detector_reset(mv->detector);
+
+	return true;
+}
+
+int controller_mv_push_frame(controller_mv_h mv, const image_frame_view_s *view)
+{
+	const image_luma_s *luma = NULL;
+	unsigned int level = 0;
 	int ret = 0;
 
-	retv_if(!buffer, NULL);
+	retv_if(!mv, -1);
+	retv_if(!view, -1);
 
-	ret = mv_create_source(&source);
-	retvm_if(ret, NULL, "failed to mv_create_source - [%s]", __mv_err_to_str(ret));
+	ret = image_pyramid_build(&mv->pyramid, view, __get_level(mv, view));
+	retv_if(ret, -1);
 
-	ret = mv_source_fill_by_buffer(source, buffer, size, width, height, colorspace);
-	if (ret) {
-		_E("failed to fill source - %d", ret);
+	level = mv->pyramid.levels - 1;
+	luma = &mv->pyramid.level[level];
+
+	if (mv->level != level || mv->width != luma->width)
+		_I("[stream %d] motion analysis at level %u, %ux%u", mv->video_stream_id, level, luma->width, luma->height);
+
+	mv->level = level;
+	mv->width = luma->width;
+	mv->height = luma->height;
+
+	if (__check_scene_change(mv, luma))
+		return 0;
+
+	/* Both engines report from within this call */
+	mv->frame_pyramid = &mv->pyramid;
+	if (mv->detector)
+		__detect_native(mv, luma);
+	else
+		__detect_surveillance(mv, luma);
+	mv->frame_pyramid = NULL;
+
+	return 0;
+}
+
+int controller_mv_reload_mask(controller_mv_h mv)
+{
+	motion_mask_h mask = NULL;
+	char *roi = NULL;
+	char *exclude = NULL;
+
+	retv_if(!mv, -1);
+
+	roi = controller_config_get_stream_string(mv->video_stream_id, CONFIG_KEY_MV_ROI, NULL);
+	exclude = controller_config_get_stream_string(mv->video_stream_id, CONFIG_KEY_MV_EXCLUDE, NULL);
+
+	mask = motion_mask_create(roi, exclude);
+	if (mask)
+		_I("[stream %d] motion mask roi [%s] exclude [%s]", mv->video_stream_id, roi ? roi : "", exclude ? exclude : "");
+	else if ((roi && *roi) || (exclude && *exclude))
+		_E("[stream %d] invalid motion mask, the whole frame is analysed", mv->video_stream_id);
+	free(roi);
+	free(exclude);
+
+	if (mv->detector)
+		motion_detector_set_mask(mv->detector, mask);
+	motion_mask_destroy(mv->mask);
+	mv->mask = mask;
+
+	return 0;
+}
 
-		if (source)
-			mv_destroy_source(source);
+static char *__get_model_path(int stream_id)
+{
+	char *data_path = NULL;
+	char *path = NULL;
+
+	data_path = app_get_data_path();
+	retv_if(!data_path, NULL);
+
+	path = g_strdup_printf("%sbackground_%d.bin", data_path, stream_id);
+	free(data_path);
+
+	return path;
+}
 
-		return NULL;
+static int __create_classifier(struct __mv_data *mv_data)
+{
+	char *classify = NULL;
+	int budget = 0;
+	int ret = 0;
+
+	classify = controller_config_get_stream_string(mv_data->video_stream_id, CONFIG_KEY_MV_CLASSIFY, "off");
+	if (!classify || strcmp(classify, "face")) {
+		free(classify);
+		return 0;
 	}
 
-	return source;
+	budget = controller_config_get_stream_int(mv_data->video_stream_id,
+		CONFIG_KEY_MV_CLASSIFY_BUDGET, CLASSIFY_BUDGET_DEFAULT);
+	if (budget < 1)
+		budget = 1;
+
+	free(classify);
+
+	ret = mv_create_source(&mv_data->face_source);
+	retvm_if(ret, -1, "failed to mv_create_source - [%s]", __mv_err_to_str(ret));
+
+	mv_data->classifier = region_classifier_create(__detect_face, mv_data, budget);
+	retv_if(!mv_data->classifier, -1);
+
+	_I("[stream %d] faces are looked for in motion regions, %d ms/s", mv_data->video_stream_id, budget);
+
+	return 0;
 }
 
-int controller_mv_set_movement_detection_event_cb(movement_detected_cb movement_detected_cb, void *user_data)
+static void __destroy_classifier(struct __mv_data *mv_data)
+{
+	if (mv_data->classifier)
+		region_classifier_destroy(mv_data->classifier);
+	if (mv_data->face_source)
+		mv_destroy_source(mv_data->face_source);
+	free(mv_data->crop_buffer);
+}
+
+int controller_mv_set_movement_detection_event_cb(int stream_id,
+	movement_detected_cb movement_detected_cb, void *user_data, controller_mv_h *mv)
 {
 	int ret = 0;
+	int threshold = 0;
+	char *engine = NULL;
 	mv_engine_config_h engine_cfg = NULL;
+	struct __mv_data *mv_data = NULL;
 
-	if (movement_detected_cb == NULL)
+	if (movement_detected_cb == NULL || mv == NULL)
 		return -1;
 
-	if (mv_data != NULL) {
-		mv_data->movement_detected_cb = movement_detected_cb;
-		mv_data->movement_detected_cb_data = user_data;
+	if (*mv != NULL) {
+		(*mv)->movement_detected_cb = movement_detected_cb;
+		(*mv)->movement_detected_cb_data = user_data;
 		return 0;
 	}
 
@@ -185,6 +563,44 @@ int controller_mv_set_movement_detection_event_cb(movement_detected_cb movement_
 		return -1;
 	}
 	memset(mv_data, 0, sizeof(struct __mv_data));
+	mv_data->video_stream_id = stream_id;
+	mv_data->level_config = controller_config_get_stream_int(stream_id, CONFIG_KEY_MV_LEVEL, -1);
+	if (mv_data->level_config > IMAGE_PYRAMID_LEVEL_MAX)
+		mv_data->level_config = IMAGE_PYRAMID_LEVEL_MAX;
+
+	controller_mv_reload_mask(mv_data);
+
+	if (controller_config_get_stream_int(stream_id, CONFIG_KEY_MV_GLOBAL_CHANGE, 1))
+		mv_data->scene = scene_change_create();
+
+	if (__create_classifier(mv_data))
+		goto ERROR;
+
+	mv_data->tracker = region_tracker_create(TRACK_CONFIRM_HITS, TRACK_TIMEOUT_MS);
+	if (!mv_data->tracker)
+		goto ERROR;
+
+	/* 10 is default value of mv_surveillance [0 ~ 255] */
+	threshold = controller_config_get_stream_int(stream_id, CONFIG_KEY_MV_THRESHOLD, MOVEMENT_THRESHOLD_DEFAULT);
+
+	engine = controller_config_get_stream_string(stream_id, CONFIG_KEY_MV_ENGINE, "surveillance");
+	if (engine && !strcmp(engine, "native")) {
+		free(engine);
+
+		mv_data->detector = motion_detector_create(threshold);
+		if (!mv_data->detector)
+			goto ERROR;
+
+		motion_detector_set_mask(mv_data->detector, mv_data->mask);
+
+		mv_data->model_path = __get_model_path(stream_id);
+		if (mv_data->model_path)
+			motion_detector_load(mv_data->detector, mv_data->model_path);
+
+		_I("[stream %d] native motion detector, threshold %d", stream_id, threshold);
+		goto DONE;
+	}
+	free(engine);
 
 	ret = mv_create_engine_config(&engine_cfg);
 	if (ret) {
@@ -192,7 +608,7 @@ int controller_mv_set_movement_detection_event_cb(movement_detected_cb movement_
 		goto ERROR;
 	}
 
-	mv_engine_config_set_int_attribute(engine_cfg, MV_SURVEILLANCE_MOVEMENT_DETECTION_THRESHOLD, 50); /* 10 is default value [0 ~ 255] */
+	mv_engine_config_set_int_attribute(engine_cfg, MV_SURVEILLANCE_MOVEMENT_DETECTION_THRESHOLD, threshold);
 
 	ret = mv_surveillance_event_trigger_create(MV_SURVEILLANCE_EVENT_TYPE_MOVEMENT_DETECTED, &mv_data->mv_trigger_handle);
 	if (ret) {
@@ -200,7 +616,7 @@ int controller_mv_set_movement_detection_event_cb(movement_detected_cb movement_
 		goto ERROR;
 	}
 
-	ret = mv_surveillance_subscribe_event_trigger(mv_data->mv_trigger_handle, VIDEO_STREAM_ID, engine_cfg, __movement_detected_event_cb, mv_data);
+	ret = mv_surveillance_subscribe_event_trigger(mv_data->mv_trigger_handle, mv_data->video_stream_id, engine_cfg, __movement_detected_event_cb, mv_data);
 
 	if (ret) {
 		_E("failed to subscribe %s - %s", MV_SURVEILLANCE_EVENT_TYPE_MOVEMENT_DETECTED, __mv_err_to_str(ret));
@@ -210,8 +626,10 @@ int controller_mv_set_movement_detection_event_cb(movement_detected_cb movement_
 	if (engine_cfg)
 		mv_destroy_engine_config(engine_cfg);
 
+DONE:
 	mv_data->movement_detected_cb = movement_detected_cb;
 	mv_data->movement_detected_cb_data = user_data;
+	*mv = mv_data;
 
 	return 0;
 
@@ -222,20 +640,78 @@ ERROR:
 	if (mv_data->mv_trigger_handle)
 		mv_surveillance_event_trigger_destroy(mv_data->mv_trigger_handle);
 
+	motion_detector_destroy(mv_data->detector);
+	motion_mask_destroy(mv_data->mask);
+	scene_change_destroy(mv_data->scene);
+	__destroy_classifier(mv_data);
+	region_tracker_destroy(mv_data->tracker);
+	g_free(mv_data->model_path);
 	free(mv_data);
-	mv_data = NULL;
 
 	return -1;
 }
 
-void controller_mv_unset_movement_detection_event_cb(void)
+void controller_mv_set_worker_pool(controller_mv_h mv, worker_pool_h pool)
+{
+	ret_if(!mv);
+
+	if (mv->detector)
+		motion_detector_set_pool(mv->detector, pool);
+}
+
+int controller_mv_get_detector_stats(controller_mv_h mv, motion_detector_stats_s *stats)
 {
-	if (mv_data == NULL)
+	retv_if(!mv, -1);
+	retv_if(!stats, -1);
+
+	if (!mv->detector)
+		return -1;
+
+	motion_detector_get_stats(mv->detector, stats);
+
+	return 0;
+}
+
+int controller_mv_get_classifier_stats(controller_mv_h mv, region_classifier_stats_s *stats)
+{
+	retv_if(!mv, -1);
+	retv_if(!stats, -1);
+
+	if (!mv->classifier)
+		return -1;
+
+	region_classifier_get_stats(mv->classifier, stats);
+
+	return 0;
+}
+
+unsigned int controller_mv_get_track_count(controller_mv_h mv)
+{
+	retv_if(!mv, 0);
+
+	return region_tracker_get_count(mv->tracker, __get_monotonic_ms());
+}
+
+void controller_mv_unset_movement_detection_event_cb(controller_mv_h mv)
+{
+	if (mv == NULL)
 		return;
 
-	if (mv_data->mv_trigger_handle)
-		mv_surveillance_event_trigger_destroy(mv_data->mv_trigger_handle);
+	if (mv->mv_trigger_handle) {
+		mv_surveillance_unsubscribe_event_trigger(mv->mv_trigger_handle, mv->video_stream_id);
+		mv_surveillance_event_trigger_destroy(mv->mv_trigger_handle);
+	}
 
-	free(mv_data);
-	mv_data = NULL;
+	if (mv->detector && mv->model_path)
+		motion_detector_save(mv->detector, mv->model_path);
+	motion_detector_destroy(mv->detector);
+	motion_mask_destroy(mv->mask);
+	scene_change_destroy(mv->scene);
+	__destroy_classifier(mv);
+	region_tracker_destroy(mv->tracker);
+	g_free(mv->model_path);
+	free(mv->rectangles);
+	image_pyramid_release(&mv->pyramid);
+	free(mv->pack_buffer);
+	free(mv);
 }
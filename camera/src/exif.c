@@ -18,14 +18,53 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <stdbool.h>
+#include <pthread.h>
 #include <libexif/exif-loader.h>
 #include <libexif/exif-utils.h>
 #include <libexif/exif-data.h>
 #include "log.h"
+#include "exif.h"
 
 #define ASCII_COMMENT_HEADER "ASCII\0\0\0"
 // #define CHECK_EXIF_BEFOR_CREATE
 
+/*
+ * Only the dimensions and the comment change from frame to frame, so the
+ * APP1 data is saved by libexif once per comment length, with a zeroed
+ * comment, and patched for each frame. The result is the same bytes libexif
+ * gives. Comments take a few lengths, one per region count, so the last
+ * used ones are kept. Longer comments go through libexif.
+ */
+#define TEMPLATE_COMMENT_MAX 1024
+#define TEMPLATE_CACHE_SIZE 8
+#define TEMPLATE_SIZE_MAX (EXIF_APP1_SIZE_MAX - APP1_HEADER_SIZE)
+#define APP1_HEADER_SIZE 4 // marker and length
+#define EXIF_HEADER_SIZE 6 // "Exif\0\0" before the TIFF header
+#define TIFF_TAG_EXIF_IFD_POINTER 0x8769
+#define TIFF_TYPE_SHORT 3
+#define TIFF_TYPE_LONG 4
+#define TIFF_TYPE_UNDEFINED 7
+
+typedef struct exif_template_s {
+	unsigned char data[TEMPLATE_SIZE_MAX];
+	unsigned int size;
+	/* from the start of data */
+	unsigned int width_offset;
+	unsigned int height_offset;
+	unsigned int dimension_size; // 2 for SHORT, 4 for LONG
+	unsigned int comment_offset; // after the ASCII header
+	unsigned int comment_len;
+	unsigned long long last_used;
+	bool ready;
+} exif_template_s;
+
+static exif_template_s exif_templates[TEMPLATE_CACHE_SIZE];
+static unsigned long long exif_template_uses;
+static pthread_mutex_t exif_template_mutex = PTHREAD_MUTEX_INITIALIZER;
+/* exif data is built apart from the JPEG it goes to */
+static const unsigned char soi_only_jpg[] = { 0xff, 0xd8 };
+
 static int check_exif_from_data(const unsigned char *img, unsigned int size)
 {
 #ifdef CHECK_EXIF_BEFOR_CREATE
@@ -196,110 +235,236 @@ create_exif_data(const unsigned char *jpg_data, unsigned int jpg_size,
 	return 0;
 }
 
-static int
-save_jpeg_file(const char *output_file,
-		const unsigned char *jpg_data, unsigned int jpg_size)
+static inline unsigned int get_intel_short(const unsigned char *p)
 {
-	FILE *fp = NULL;
-	retv_if(!output_file, -1);
-	retv_if(!jpg_data, -1);
-	retv_if(jpg_size <= 2, -1);
+	return p[0] | (p[1] << 8);
+}
+
+static inline unsigned int get_intel_long(const unsigned char *p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int)p[3] << 24);
+}
+
+static inline void set_intel_value(unsigned char *p, unsigned int value, unsigned int size)
+{
+	unsigned int i = 0;
+
+	for (i = 0; i < size; i++)
+		p[i] = (value >> (8 * i)) & 0xFF;
+}
+
+/* 12 byte entry of tag in the IFD at ifd_offset of the TIFF data */
+static const unsigned char *
+find_ifd_entry(const unsigned char *tiff, unsigned int tiff_size,
+		unsigned int ifd_offset, unsigned int tag)
+{
+	const unsigned char *entry = NULL;
+	unsigned int count = 0;
+	unsigned int i = 0;
 
-	fp = fopen(output_file, "wb");
-	retv_if(!fp, -1);
+	retv_if(ifd_offset + 2 > tiff_size, NULL);
 
-	if (1 != fwrite(jpg_data, jpg_size, 1, fp)) {
-		_E("failed to write jpg data");
-		fclose(fp);
+	count = get_intel_short(tiff + ifd_offset);
+	retv_if(ifd_offset + 2 + count * 12 > tiff_size, NULL);
+
+	for (i = 0; i < count; i++) {
+		entry = tiff + ifd_offset + 2 + i * 12;
+		if (get_intel_short(entry) == tag)
+			return entry;
+	}
+
+	return NULL;
+}
+
+static int
+find_dimension_slot(exif_template_s *tmpl, const unsigned char *tiff, unsigned int tiff_size,
+		unsigned int exif_ifd, unsigned int tag, unsigned int *offset)
+{
+	const unsigned char *entry = NULL;
+	unsigned int size = 0;
+
+	entry = find_ifd_entry(tiff, tiff_size, exif_ifd, tag);
+	retv_if(!entry, -1);
+	retv_if(get_intel_long(entry + 4) != 1, -1);
+
+	switch (get_intel_short(entry + 2)) {
+	case TIFF_TYPE_SHORT:
+		size = 2;
+		break;
+	case TIFF_TYPE_LONG:
+		size = 4;
+		break;
+	default:
 		return -1;
 	}
 
-	fflush(fp);
-	fclose(fp);
+	retv_if(tmpl->dimension_size && tmpl->dimension_size != size, -1);
+	tmpl->dimension_size = size;
+	*offset = entry + 8 - tmpl->data; // values up to 4 bytes are kept in the entry
+
+	return 0;
+}
+
+/* Finds where the dimensions and the comment are in the saved data */
+static int
+locate_template_slots(exif_template_s *tmpl)
+{
+	const unsigned char *tiff = tmpl->data + EXIF_HEADER_SIZE;
+	unsigned int tiff_size = tmpl->size - EXIF_HEADER_SIZE;
+	const unsigned char *entry = NULL;
+	unsigned int exif_ifd = 0;
+	unsigned int comment_data = 0;
+
+	retv_if(tmpl->size < EXIF_HEADER_SIZE + 8, -1);
+	retv_if(memcmp(tiff, "II", 2) || get_intel_short(tiff + 2) != 42, -1);
+
+	entry = find_ifd_entry(tiff, tiff_size, get_intel_long(tiff + 4), TIFF_TAG_EXIF_IFD_POINTER);
+	retv_if(!entry, -1);
+	exif_ifd = get_intel_long(entry + 8);
 
-	_D("file saved [%s]", output_file);
+	retv_if(find_dimension_slot(tmpl, tiff, tiff_size, exif_ifd,
+		EXIF_TAG_PIXEL_X_DIMENSION, &tmpl->width_offset), -1);
+	retv_if(find_dimension_slot(tmpl, tiff, tiff_size, exif_ifd,
+		EXIF_TAG_PIXEL_Y_DIMENSION, &tmpl->height_offset), -1);
+
+	entry = find_ifd_entry(tiff, tiff_size, exif_ifd, EXIF_TAG_USER_COMMENT);
+	retv_if(!entry, -1);
+	retv_if(get_intel_short(entry + 2) != TIFF_TYPE_UNDEFINED, -1);
+	retv_if(get_intel_long(entry + 4) != sizeof(ASCII_COMMENT_HEADER) - 1 + tmpl->comment_len, -1);
+
+	comment_data = get_intel_long(entry + 8);
+	retv_if(comment_data + get_intel_long(entry + 4) > tiff_size, -1);
+
+	tmpl->comment_offset = EXIF_HEADER_SIZE + comment_data + sizeof(ASCII_COMMENT_HEADER) - 1;
 
 	return 0;
 }
 
 static int
-save_jpeg_file_with_exif(const char *output_file,
-		const unsigned char *jpg_data, unsigned int jpg_size,
-		unsigned char *exif_data, unsigned int exif_size)
+build_exif_template(exif_template_s *tmpl, unsigned int comment_len)
 {
-	FILE *fp = NULL;
-	const unsigned char exif_header[] = { 0xff, 0xd8, 0xff, 0xe1 }; // FFD8 -SOI Maker, FFE1 - APP1 Maker
-	const unsigned short exif_header_length = 4;
-	const unsigned short jpg_offset = 2; // SOI maker offset
-	unsigned short exif_length = 0;
+	unsigned char *data = NULL;
+	unsigned int size = 0;
+	char *comment = NULL;
 
-	((unsigned char *)&exif_length)[0] = (exif_size + 2) >> 8;
-	((unsigned char *)&exif_length)[1] = (exif_size + 2) & 0x00ff;
+	memset(tmpl, 0, sizeof(exif_template_s));
+	tmpl->comment_len = comment_len;
 
-	retv_if(!output_file, -1);
-	retv_if(!jpg_data, -1);
-	retv_if(!exif_data, -1);
-	retv_if(jpg_size <= 2, -1);
-	retv_if(exif_size == 0, -1);
+	comment = calloc(1, comment_len);
+	retv_if(!comment, -1);
 
-	fp = fopen(output_file, "wb");
-	retv_if(!fp, -1);
+	if (create_exif_data(soi_only_jpg, sizeof(soi_only_jpg), 0, 0,
+			comment, comment_len, &data, &size)) {
+		free(comment);
+		return -1;
+	}
+	free(comment);
 
-	if (1 != fwrite(exif_header, exif_header_length, 1, fp)) {
-		_E("failed to write exif header");
-		goto ERROR;
+	if (size > TEMPLATE_SIZE_MAX) {
+		_E("exif template is too big [%u]", size);
+		free(data);
+		return -1;
 	}
 
-	if (1 != fwrite(&exif_length, sizeof(exif_length), 1, fp)) {
-		_E("failed to write exif legth");
-		goto ERROR;
+	memcpy(tmpl->data, data, size);
+	tmpl->size = size;
+	free(data);
+
+	if (locate_template_slots(tmpl)) {
+		_E("failed to find the slots of the exif template, use libexif for this file");
+		return -1;
 	}
 
-	if (1 != fwrite(exif_data, exif_size, 1, fp)) {
-		_E("failed to write exif");
-		goto ERROR;
+	tmpl->ready = true;
+
+	return 0;
+}
+
+/* Template of comment_len, built in place of the least recently used one */
+static exif_template_s *
+get_exif_template(unsigned int comment_len)
+{
+	exif_template_s *oldest = &exif_templates[0];
+	unsigned int i = 0;
+
+	for (i = 0; i < TEMPLATE_CACHE_SIZE; i++) {
+		exif_template_s *tmpl = &exif_templates[i];
+
+		if (tmpl->ready && tmpl->comment_len == comment_len) {
+			tmpl->last_used = ++exif_template_uses;
+			return tmpl;
+		}
+		if (tmpl->last_used < oldest->last_used)
+			oldest = tmpl;
 	}
 
-	if (1 != fwrite(jpg_data + jpg_offset, jpg_size - jpg_offset, 1, fp)) {
-		_E("failed to write jpg data");
-		goto ERROR;
+	if (build_exif_template(oldest, comment_len))
+		return NULL;
+	oldest->last_used = ++exif_template_uses;
+
+	return oldest;
+}
+
+/* Template with this frame's values in app1, which holds TEMPLATE_SIZE_MAX bytes */
+static int
+patch_exif_template(unsigned char *app1, unsigned int jpg_width, unsigned int jpg_height,
+		const char *comment, unsigned int comment_len, unsigned int *app1_size)
+{
+	const exif_template_s *tmpl = NULL;
+
+	if (comment_len > TEMPLATE_COMMENT_MAX)
+		return -1;
+
+	pthread_mutex_lock(&exif_template_mutex);
+	tmpl = get_exif_template(comment_len);
+	if (!tmpl) {
+		pthread_mutex_unlock(&exif_template_mutex);
+		return -1;
 	}
 
-	fflush(fp);
-	fclose(fp);
+	/* the comment is zeroed in the template */
+	memcpy(app1, tmpl->data, tmpl->size);
+	set_intel_value(app1 + tmpl->width_offset, jpg_width, tmpl->dimension_size);
+	set_intel_value(app1 + tmpl->height_offset, jpg_height, tmpl->dimension_size);
+	memcpy(app1 + tmpl->comment_offset, comment, comment_len);
+	*app1_size = tmpl->size;
+	pthread_mutex_unlock(&exif_template_mutex);
 
 	return 0;
-ERROR:
-	fclose(fp);
-	unlink(output_file);
-	_E(" failed to save file - [%s]", output_file);
-	return -1;
 }
 
-int exif_write_jpg_file_with_comment(const char *output_file,
-		const unsigned char *jpg_data, unsigned int jpg_size,
-		unsigned int jpg_width, unsigned int jpg_height,
-		const char *comment, unsigned int comment_len)
+int exif_build_app1_with_comment(unsigned int jpg_width, unsigned int jpg_height,
+		const char *comment, unsigned int comment_len,
+		unsigned char *app1, unsigned int *app1_size)
 {
-	int ret = 0;
-	unsigned char *exif_data  = NULL;
+	unsigned char *exif_data = NULL;
 	unsigned int exif_size = 0;
 
-	if (!comment || (comment_len ==  0)) {
-		_W("There is no comment");
-		return save_jpeg_file(output_file, jpg_data, jpg_size);
+	retv_if(!comment, -1);
+	retv_if(comment_len == 0, -1);
+	retv_if(!app1, -1);
+	retv_if(!app1_size, -1);
+
+	if (patch_exif_template(app1 + APP1_HEADER_SIZE, jpg_width, jpg_height,
+			comment, comment_len, &exif_size)) {
+		if (create_exif_data(soi_only_jpg, sizeof(soi_only_jpg), jpg_width, jpg_height,
+				comment, comment_len, &exif_data, &exif_size))
+			return -1;
+
+		if (exif_size > TEMPLATE_SIZE_MAX) {
+			_E("exif data is too big [%u]", exif_size);
+			free(exif_data);
+			return -1;
+		}
+		memcpy(app1 + APP1_HEADER_SIZE, exif_data, exif_size);
+		free(exif_data);
 	}
 
-	ret = create_exif_data(jpg_data, jpg_size, jpg_width, jpg_height,
-			comment, comment_len, &exif_data, &exif_size);
-	if (ret) {
-		_E("failed to create_exif_data(), save jpg data only");
-		return save_jpeg_file(output_file, jpg_data, jpg_size);
-	}
-
-	ret = save_jpeg_file_with_exif(
-			output_file, jpg_data, jpg_size, exif_data, exif_size);
+	app1[0] = 0xff; // APP1 marker
+	app1[1] = 0xe1;
+	app1[2] = (exif_size + 2) >> 8; // length counts itself
+	app1[3] = (exif_size + 2) & 0xff;
+	*app1_size = exif_size + APP1_HEADER_SIZE;
 
-	free(exif_data);
-	return ret;
+	return 0;
 }
@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+#include <camera.h>
+
+#include "log.h"
+#include "frame_pool.h"
+
+#define FRAME_POOL_ALIGN 64
+
+struct __frame_pool_s {
+	pthread_mutex_t mutex;
+
+	image_buffer_data_s *frames;
+	unsigned char *payload;
+	image_buffer_data_s **free_list;
+	unsigned int free_count;
+
+	unsigned int frame_count;
+	unsigned int frame_size;
+
+	unsigned int high_water_mark;
+	unsigned long long acquired;
+	unsigned long long exhausted;
+
+	bool destroyed;
+};
+
+static void __frame_pool_free(frame_pool_s *pool)
+{
+	pthread_mutex_destroy(&pool->mutex);
+	free(pool->free_list);
+	free(pool->payload);
+	free(pool->frames);
+	free(pool);
+}
+
+frame_pool_s *frame_pool_create(unsigned int frame_count, unsigned int frame_size)
+{
+	frame_pool_s *pool = NULL;
+	unsigned int slot_size = 0;
+	unsigned int i = 0;
+
+	retv_if(frame_count == 0, NULL);
+	retv_if(frame_size == 0, NULL);
+
+	pool = calloc(1, sizeof(frame_pool_s));
+	retvm_if(!pool, NULL, "Failed to allocate frame pool");
+
+	slot_size = (frame_size + FRAME_POOL_ALIGN - 1) & ~(FRAME_POOL_ALIGN - 1);
+
+	pool->frames = calloc(frame_count, sizeof(image_buffer_data_s));
+	pool->free_list = calloc(frame_count, sizeof(image_buffer_data_s *));
+	if (posix_memalign((void **)&pool->payload, FRAME_POOL_ALIGN, (size_t)slot_size * frame_count))
+		pool->payload = NULL;
+
+	if (!pool->frames || !pool->free_list || !pool->payload) {
+		_E("Failed to allocate %u frames of %u bytes", frame_count, frame_size);
+		free(pool->free_list);
+		free(pool->payload);
+		free(pool->frames);
+		free(pool);
+		return NULL;
+	}
+
+	pthread_mutex_init(&pool->mutex, NULL);
+	pool->frame_count = frame_count;
+	pool->frame_size = slot_size;
+
+	for (i = 0; i < frame_count; i++) {
+		pool->frames[i].buffer = pool->payload + (size_t)slot_size * i;
+		pool->frames[i].pool = pool;
+		pool->free_list[i] = &pool->frames[i];
+	}
+	pool->free_count = frame_count;
+
+	_I("Frame pool created : %u frames x %u bytes", frame_count, slot_size);
+
+	return pool;
+}
+
+void frame_pool_destroy(frame_pool_s *pool)
+{
+	bool idle = false;
+
+	ret_if(!pool);
+
+	pthread_mutex_lock(&pool->mutex);
+	pool->destroyed = true;
+	idle = (pool->free_count == pool->frame_count);
+	pthread_mutex_unlock(&pool->mutex);
+
+	/* Otherwise the last frame_pool_unref() frees it */
+	if (idle)
+		__frame_pool_free(pool);
+}
+
+unsigned int frame_pool_get_frame_size(frame_pool_s *pool)
+{
+	retv_if(!pool, 0);
+
+	return pool->frame_size;
+}
+
+void frame_pool_get_stats(frame_pool_s *pool, frame_pool_stats_s *stats)
+{
+	ret_if(!stats);
+
+	memset(stats, 0, sizeof(frame_pool_stats_s));
+	ret_if(!pool);
+
+	pthread_mutex_lock(&pool->mutex);
+	stats->frame_count = pool->frame_count;
+	stats->frame_size = pool->frame_size;
+	stats->in_use = pool->frame_count - pool->free_count;
+	stats->high_water_mark = pool->high_water_mark;
+	stats->acquired = pool->acquired;
+	stats->exhausted = pool->exhausted;
+	pthread_mutex_unlock(&pool->mutex);
+}
+
+image_buffer_data_s *frame_pool_acquire(frame_pool_s *pool)
+{
+	image_buffer_data_s *frame = NULL;
+	unsigned int in_use = 0;
+
+	retv_if(!pool, NULL);
+
+	pthread_mutex_lock(&pool->mutex);
+	if (pool->free_count == 0 || pool->destroyed) {
+		pool->exhausted++;
+		pthread_mutex_unlock(&pool->mutex);
+		return NULL;
+	}
+
+	frame = pool->free_list[--pool->free_count];
+	pool->acquired++;
+
+	in_use = pool->frame_count - pool->free_count;
+	if (in_use > pool->high_water_mark)
+		pool->high_water_mark = in_use;
+	pthread_mutex_unlock(&pool->mutex);
+
+	frame->buffer_size = 0;
+	frame->image_width = 0;
+	frame->image_height = 0;
+	frame->format = CAMERA_PIXEL_FORMAT_INVALID;
+	frame->user_data = NULL;
+	__atomic_store_n(&frame->ref_count, 1, __ATOMIC_RELEASE);
+
+	return frame;
+}
+
+image_buffer_data_s *frame_pool_ref(image_buffer_data_s *frame)
+{
+	retv_if(!frame, NULL);
+
+	__atomic_add_fetch(&frame->ref_count, 1, __ATOMIC_RELAXED);
+
+	return frame;
+}
+
+void frame_pool_unref(image_buffer_data_s *frame)
+{
+	frame_pool_s *pool = NULL;
+	bool release_pool = false;
+
+	ret_if(!frame);
+
+	if (__atomic_sub_fetch(&frame->ref_count, 1, __ATOMIC_ACQ_REL) != 0)
+		return;
+
+	pool = frame->pool;
+	pthread_mutex_lock(&pool->mutex);
+	pool->free_list[pool->free_count++] = frame;
+	release_pool = pool->destroyed && (pool->free_count == pool->frame_count);
+	pthread_mutex_unlock(&pool->mutex);
+
+	if (release_pool)
+		__frame_pool_free(pool);
+}
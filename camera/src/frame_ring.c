@@ -0,0 +1,224 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <Ecore.h>
+#include <camera.h>
+
+#include "log.h"
+#include "frame_pool.h"
+#include "frame_ring.h"
+
+struct __frame_ring_s {
+	image_buffer_data_s **slots;
+	unsigned int depth;
+
+	/* written by the producer only */
+	unsigned long long head;
+	/* touched by the consumer only */
+	unsigned long long tail;
+	unsigned long long last_sequence;
+	unsigned long long reported_overwritten;
+
+	int wakeup_pending;
+	int event_fd;
+	Ecore_Fd_Handler *fd_handler;
+
+	frame_ring_consume_cb consume_cb;
+	void *consume_cb_data;
+
+	unsigned long long pushed;
+	unsigned long long consumed;
+	unsigned long long overwritten;
+	unsigned long long dropped;
+	unsigned long long wakeups;
+	unsigned int max_batch;
+};
+
+static unsigned int __frame_ring_drain(frame_ring_s *ring)
+{
+	unsigned long long head = 0;
+	unsigned int batch = 0;
+
+	head = __atomic_load_n(&ring->head, __ATOMIC_SEQ_CST);
+
+	/* The producer lapped us, older slots already hold newer frames */
+	if (head - ring->tail > ring->depth)
+		ring->tail = head - ring->depth;
+
+	while (ring->tail != head) {
+		image_buffer_data_s *frame = NULL;
+		unsigned int index = ring->tail % ring->depth;
+
+		ring->tail++;
+
+		frame = __atomic_exchange_n(&ring->slots[index], NULL, __ATOMIC_ACQ_REL);
+		if (!frame)
+			continue;
+
+		/* A slot refilled while we were draining can hand us a newer
+		 * frame ahead of older ones, keep delivery monotonic */
+		if (frame->sequence <= ring->last_sequence) {
+			__atomic_add_fetch(&ring->dropped, 1, __ATOMIC_RELAXED);
+			frame_pool_unref(frame);
+			continue;
+		}
+
+		ring->last_sequence = frame->sequence;
+		__atomic_add_fetch(&ring->consumed, 1, __ATOMIC_RELAXED);
+		batch++;
+
+		ring->consume_cb(frame, ring->consume_cb_data);
+	}
+
+	return batch;
+}
+
+static Eina_Bool __frame_ring_wakeup_cb(void *data, Ecore_Fd_Handler *fd_handler)
+{
+	frame_ring_s *ring = data;
+	uint64_t count = 0;
+	unsigned long long overwritten = 0;
+	unsigned int batch = 0;
+
+	if (read(ring->event_fd, &count, sizeof(count)) != sizeof(count))
+		_D("Spurious frame ring wakeup");
+
+	/* Re-arm before draining so a frame pushed meanwhile wakes us again */
+	__atomic_store_n(&ring->wakeup_pending, 0, __ATOMIC_SEQ_CST);
+
+	batch = __frame_ring_drain(ring);
+	if (batch > ring->max_batch)
+		ring->max_batch = batch;
+
+	overwritten = __atomic_load_n(&ring->overwritten, __ATOMIC_RELAXED);
+	if (overwritten != ring->reported_overwritten) {
+		_W("Main loop fell behind : overwritten[%llu] dropped[%llu] batch[%u]",
+			overwritten, __atomic_load_n(&ring->dropped, __ATOMIC_RELAXED), batch);
+		ring->reported_overwritten = overwritten;
+	}
+
+	return ECORE_CALLBACK_RENEW;
+}
+
+frame_ring_s *frame_ring_create(unsigned int depth, frame_ring_consume_cb consume_cb, void *user_data)
+{
+	frame_ring_s *ring = NULL;
+
+	retv_if(depth == 0, NULL);
+	retv_if(!consume_cb, NULL);
+
+	ring = calloc(1, sizeof(frame_ring_s));
+	retvm_if(!ring, NULL, "Failed to allocate frame ring");
+	ring->event_fd = -1;
+
+	ring->slots = calloc(depth, sizeof(image_buffer_data_s *));
+	if (!ring->slots) {
+		_E("Failed to allocate frame ring slots");
+		goto ERROR;
+	}
+
+	ring->event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (ring->event_fd < 0) {
+		_E("Failed to create eventfd");
+		goto ERROR;
+	}
+
+	ring->fd_handler = ecore_main_fd_handler_add(ring->event_fd, ECORE_FD_READ,
+		__frame_ring_wakeup_cb, ring, NULL, NULL);
+	if (!ring->fd_handler) {
+		_E("Failed to add fd handler");
+		goto ERROR;
+	}
+
+	ring->depth = depth;
+	ring->consume_cb = consume_cb;
+	ring->consume_cb_data = user_data;
+
+	return ring;
+
+ERROR:
+	if (ring->event_fd >= 0)
+		close(ring->event_fd);
+	free(ring->slots);
+	free(ring);
+	return NULL;
+}
+
+void frame_ring_destroy(frame_ring_s *ring)
+{
+	unsigned int i = 0;
+
+	ret_if(!ring);
+
+	if (ring->fd_handler)
+		ecore_main_fd_handler_del(ring->fd_handler);
+	close(ring->event_fd);
+
+	for (i = 0; i < ring->depth; i++) {
+		if (ring->slots[i])
+			frame_pool_unref(ring->slots[i]);
+	}
+
+	free(ring->slots);
+	free(ring);
+}
+
+void frame_ring_push(frame_ring_s *ring, image_buffer_data_s *frame)
+{
+	image_buffer_data_s *old = NULL;
+	unsigned long long head = 0;
+	uint64_t one = 1;
+
+	ret_if(!ring);
+	ret_if(!frame);
+
+	head = ring->head;
+	old = __atomic_exchange_n(&ring->slots[head % ring->depth], frame, __ATOMIC_ACQ_REL);
+	__atomic_store_n(&ring->head, head + 1, __ATOMIC_SEQ_CST);
+	__atomic_add_fetch(&ring->pushed, 1, __ATOMIC_RELAXED);
+
+	if (old) {
+		__atomic_add_fetch(&ring->overwritten, 1, __ATOMIC_RELAXED);
+		frame_pool_unref(old);
+	}
+
+	if (__atomic_exchange_n(&ring->wakeup_pending, 1, __ATOMIC_SEQ_CST) == 0) {
+		__atomic_add_fetch(&ring->wakeups, 1, __ATOMIC_RELAXED);
+		if (write(ring->event_fd, &one, sizeof(one)) != sizeof(one))
+			_E("Failed to wake up main loop");
+	}
+}
+
+void frame_ring_get_stats(frame_ring_s *ring, frame_ring_stats_s *stats)
+{
+	ret_if(!stats);
+
+	memset(stats, 0, sizeof(frame_ring_stats_s));
+	ret_if(!ring);
+
+	stats->depth = ring->depth;
+	stats->pushed = __atomic_load_n(&ring->pushed, __ATOMIC_RELAXED);
+	stats->consumed = __atomic_load_n(&ring->consumed, __ATOMIC_RELAXED);
+	stats->overwritten = __atomic_load_n(&ring->overwritten, __ATOMIC_RELAXED);
+	stats->dropped = __atomic_load_n(&ring->dropped, __ATOMIC_RELAXED);
+	stats->wakeups = __atomic_load_n(&ring->wakeups, __ATOMIC_RELAXED);
+	stats->max_batch = ring->max_batch;
+}
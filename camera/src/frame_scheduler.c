@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "log.h"
+#include "frame_scheduler.h"
+
+#define FPS_WINDOW_MS 1000
+
+struct __frame_scheduler_s {
+	pthread_mutex_t mutex;
+	frame_scheduler_config_s config;
+
+	frame_scheduler_state_e state;
+	unsigned int backoff;
+	long long int last_motion_time;
+	long long int last_saturation_time;
+	long long int last_backoff_time;
+	long long int last_delivered_time;
+
+	long long int window_start_time;
+	unsigned int window_delivered;
+	double effective_fps;
+
+	unsigned long long offered;
+	unsigned long long delivered;
+	unsigned long long motion_events;
+	unsigned long long saturation_events;
+	unsigned long long state_changes;
+};
+
+static long long int __get_monotonic_ms(void)
+{
+	struct timespec time_s;
+
+	clock_gettime(CLOCK_MONOTONIC, &time_s);
+
+	return time_s.tv_sec * 1000LL + time_s.tv_nsec / 1000000;
+}
+
+static unsigned int __get_interval(frame_scheduler_s *scheduler)
+{
+	unsigned int interval = scheduler->state == FRAME_SCHEDULER_ACTIVE ?
+		scheduler->config.active_interval : scheduler->config.idle_interval;
+
+	return interval << scheduler->backoff;
+}
+
+frame_scheduler_s *frame_scheduler_create(const frame_scheduler_config_s *config)
+{
+	frame_scheduler_s *scheduler = NULL;
+
+	retv_if(!config, NULL);
+
+	scheduler = calloc(1, sizeof(frame_scheduler_s));
+	retvm_if(!scheduler, NULL, "Failed to allocate frame scheduler");
+
+	scheduler->config = *config;
+	if (scheduler->config.idle_interval < scheduler->config.active_interval)
+		scheduler->config.idle_interval = scheduler->config.active_interval;
+	if (scheduler->config.backoff_max > 8)
+		scheduler->config.backoff_max = 8;
+
+	/* Start active, the detector needs a few frames to settle anyway */
+	scheduler->state = FRAME_SCHEDULER_ACTIVE;
+	scheduler->last_motion_time = __get_monotonic_ms();
+	scheduler->window_start_time = scheduler->last_motion_time;
+
+	pthread_mutex_init(&scheduler->mutex, NULL);
+
+	return scheduler;
+}
+
+void frame_scheduler_destroy(frame_scheduler_s *scheduler)
+{
+	ret_if(!scheduler);
+
+	pthread_mutex_destroy(&scheduler->mutex);
+	free(scheduler);
+}
+
+bool frame_scheduler_should_deliver(frame_scheduler_s *scheduler, long long int now_ms)
+{
+	frame_scheduler_state_e state;
+	bool deliver = false;
+
+	retv_if(!scheduler, true);
+
+	pthread_mutex_lock(&scheduler->mutex);
+
+	scheduler->offered++;
+
+	if (scheduler->backoff
+		&& now_ms - scheduler->last_saturation_time >= scheduler->config.backoff_recover
+		&& now_ms - scheduler->last_backoff_time >= scheduler->config.backoff_recover) {
+		scheduler->backoff--;
+		scheduler->last_backoff_time = now_ms;
+		_I("Frame scheduler backoff eased to x%u", 1U << scheduler->backoff);
+	}
+
+	state = now_ms - scheduler->last_motion_time < scheduler->config.idle_timeout ?
+		FRAME_SCHEDULER_ACTIVE : FRAME_SCHEDULER_IDLE;
+	if (state != scheduler->state) {
+		scheduler->state = state;
+		scheduler->state_changes++;
+		_I("Frame scheduler %s, interval %u ms",
+			state == FRAME_SCHEDULER_ACTIVE ? "active" : "idle", __get_interval(scheduler));
+	}
+
+	if (now_ms - scheduler->last_delivered_time >= __get_interval(scheduler)) {
+		deliver = true;
+		scheduler->last_delivered_time = now_ms;
+		scheduler->delivered++;
+		scheduler->window_delivered++;
+	}
+
+	if (now_ms - scheduler->window_start_time >= FPS_WINDOW_MS) {
+		scheduler->effective_fps = scheduler->window_delivered * 1000.0
+			/ (now_ms - scheduler->window_start_time);
+		scheduler->window_start_time = now_ms;
+		scheduler->window_delivered = 0;
+	}
+
+	pthread_mutex_unlock(&scheduler->mutex);
+
+	return deliver;
+}
+
+void frame_scheduler_notify_motion(frame_scheduler_s *scheduler)
+{
+	ret_if(!scheduler);
+
+	pthread_mutex_lock(&scheduler->mutex);
+	scheduler->last_motion_time = __get_monotonic_ms();
+	scheduler->motion_events++;
+	pthread_mutex_unlock(&scheduler->mutex);
+}
+
+void frame_scheduler_notify_saturated(frame_scheduler_s *scheduler)
+{
+	long long int now = __get_monotonic_ms();
+
+	ret_if(!scheduler);
+
+	pthread_mutex_lock(&scheduler->mutex);
+
+	scheduler->saturation_events++;
+
+	/* One doubling per interval, a burst of reports for the same frame counts once */
+	if (scheduler->backoff < scheduler->config.backoff_max
+		&& now - scheduler->last_backoff_time >= __get_interval(scheduler)) {
+		scheduler->backoff++;
+		scheduler->last_backoff_time = now;
+		_I("Frame scheduler backoff x%u, interval %u ms",
+			1U << scheduler->backoff, __get_interval(scheduler));
+	}
+	scheduler->last_saturation_time = now;
+
+	pthread_mutex_unlock(&scheduler->mutex);
+}
+
+void frame_scheduler_get_stats(frame_scheduler_s *scheduler, frame_scheduler_stats_s *stats)
+{
+	ret_if(!scheduler);
+	ret_if(!stats);
+
+	pthread_mutex_lock(&scheduler->mutex);
+	stats->state = scheduler->state;
+	stats->backoff = scheduler->backoff;
+	stats->interval = __get_interval(scheduler);
+	stats->effective_fps = scheduler->effective_fps;
+	stats->offered = scheduler->offered;
+	stats->delivered = scheduler->delivered;
+	stats->motion_events = scheduler->motion_events;
+	stats->saturation_events = scheduler->saturation_events;
+	stats->state_changes = scheduler->state_changes;
+	pthread_mutex_unlock(&scheduler->mutex);
+}
@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "log.h"
+#include "image_convert.h"
+#include "image_convert_internal.h"
+#include "frame_signature.h"
+
+#define BLOCK_PIXELS (FRAME_SIGNATURE_BLOCK * FRAME_SIGNATURE_BLOCK)
+
+struct __frame_signature_s {
+	const image_convert_kernels_s *kernels;
+
+	/* block sums, columns x rows of them, of the reference and the current frame */
+	unsigned int *reference;
+	unsigned int *current;
+	unsigned int columns;
+	unsigned int rows;
+	bool has_reference;
+
+	/* luma of frames without a Y plane */
+	unsigned char *scratch;
+	unsigned int scratch_size;
+
+	frame_signature_stats_s stats;
+	unsigned long long int total_usec;
+};
+
+static unsigned long long int __get_usec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static bool __has_luma_plane(camera_pixel_format_e format)
+{
+	switch (format) {
+	case CAMERA_PIXEL_FORMAT_NV12:
+	case CAMERA_PIXEL_FORMAT_NV21:
+	case CAMERA_PIXEL_FORMAT_I420:
+	case CAMERA_PIXEL_FORMAT_YV12:
+	case CAMERA_PIXEL_FORMAT_422P:
+		return true;
+	default:
+		return false;
+	}
+}
+
+frame_signature_h frame_signature_create(void)
+{
+	struct __frame_signature_s *signature = NULL;
+
+	signature = calloc(1, sizeof(struct __frame_signature_s));
+	retvm_if(!signature, NULL, "Failed to allocate frame signature");
+
+	signature->kernels = image_convert_get_kernels();
+
+	return signature;
+}
+
+void frame_signature_destroy(frame_signature_h signature)
+{
+	ret_if(!signature);
+
+	free(signature->reference);
+	free(signature->current);
+	free(signature->scratch);
+	free(signature);
+}
+
+static int __resize(struct __frame_signature_s *signature, unsigned int columns, unsigned int rows)
+{
+	unsigned int *reference = NULL;
+	unsigned int *current = NULL;
+
+	if (signature->columns == columns && signature->rows == rows)
+		return 0;
+
+	reference = calloc(columns * rows, sizeof(unsigned int));
+	current = calloc(columns * rows, sizeof(unsigned int));
+	if (!reference || !current) {
+		_E("Failed to allocate %u signature blocks", columns * rows);
+		free(reference);
+		free(current);
+		return -1;
+	}
+
+	free(signature->reference);
+	free(signature->current);
+	signature->reference = reference;
+	signature->current = current;
+	signature->columns = columns;
+	signature->rows = rows;
+	signature->has_reference = false;
+
+	return 0;
+}
+
+/* Largest difference of a block mean, the sums are of BLOCK_PIXELS each */
+static unsigned int __get_difference(const unsigned int *a, const unsigned int *b, unsigned int count)
+{
+	unsigned int max = 0;
+	unsigned int i = 0;
+
+	for (i = 0; i < count; i++) {
+		unsigned int diff = a[i] > b[i] ? a[i] - b[i] : b[i] - a[i];
+
+		if (diff > max)
+			max = diff;
+	}
+
+	return (max + BLOCK_PIXELS / 2) / BLOCK_PIXELS;
+}
+
+int frame_signature_update(frame_signature_h signature, const image_frame_view_s *view, unsigned int threshold)
+{
+	const unsigned char *luma = NULL;
+	unsigned int stride = 0;
+	unsigned int *sums = NULL;
+	unsigned int *swap = NULL;
+	unsigned int difference = 0;
+	unsigned int row = 0;
+	unsigned long long int start = 0;
+	int ret = 0;
+
+	retv_if(!signature, -1);
+	retv_if(!view, -1);
+
+	start = __get_usec();
+
+	/* the right and bottom edges that do not fill a block are left out */
+	retv_if(__resize(signature, view->width / FRAME_SIGNATURE_BLOCK,
+		view->height / FRAME_SIGNATURE_BLOCK), -1);
+	retv_if(!signature->columns || !signature->rows, -1);
+
+	if (__has_luma_plane(view->format)) {
+		luma = view->planes[0].data;
+		stride = view->planes[0].stride;
+	} else {
+		luma = image_convert_get_frame(view, IMAGE_CONVERT_LUMA, &signature->scratch, &signature->scratch_size);
+		retv_if(!luma, -1);
+		stride = view->width;
+	}
+
+	memset(signature->current, 0, signature->columns * signature->rows * sizeof(unsigned int));
+	for (row = 0; row < signature->rows * FRAME_SIGNATURE_BLOCK; row++) {
+		sums = signature->current + (row / FRAME_SIGNATURE_BLOCK) * signature->columns;
+		signature->kernels->sum_blocks(luma + row * stride, sums, signature->columns);
+	}
+
+	if (signature->has_reference) {
+		difference = __get_difference(signature->reference, signature->current,
+			signature->columns * signature->rows);
+		ret = difference <= threshold;
+	}
+
+	if (!ret) {
+		swap = signature->reference;
+		signature->reference = signature->current;
+		signature->current = swap;
+		signature->has_reference = true;
+	}
+
+	signature->stats.frames++;
+	if (ret)
+		signature->stats.unchanged++;
+	signature->stats.difference = difference;
+	signature->total_usec += __get_usec() - start;
+
+	return ret;
+}
+
+void frame_signature_reset(frame_signature_h signature)
+{
+	ret_if(!signature);
+
+	signature->has_reference = false;
+}
+
+void frame_signature_get_stats(frame_signature_h signature, frame_signature_stats_s *stats)
+{
+	ret_if(!signature);
+	ret_if(!stats);
+
+	*stats = signature->stats;
+	stats->average_usec = signature->stats.frames ? signature->total_usec / signature->stats.frames : 0;
+}
@@ -0,0 +1,614 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <pthread.h>
+
+#include "log.h"
+#include "image_convert.h"
+#include "image_convert_internal.h"
+
+/* Chroma samples per pass through the stack row buffers */
+#define CONVERT_CHUNK 512
+#define SELF_CHECK_LENGTH 301
+
+static const image_convert_kernels_s *kernels = &image_convert_scalar_kernels;
+static pthread_once_t kernels_once = PTHREAD_ONCE_INIT;
+
+void image_convert_scalar_extract_bytes(const unsigned char *src, unsigned char *dst, unsigned int count, unsigned int offset)
+{
+	unsigned int i = 0;
+
+	for (i = 0; i < count; i++)
+		dst[i] = src[2 * i + offset];
+}
+
+void image_convert_scalar_average_rows(const unsigned char *a, const unsigned char *b, unsigned char *dst, unsigned int count)
+{
+	unsigned int i = 0;
+
+	for (i = 0; i < count; i++)
+		dst[i] = (a[i] + b[i] + 1) >> 1;
+}
+
+void image_convert_scalar_split_uv(const unsigned char *uv, unsigned char *u, unsigned char *v, unsigned int count)
+{
+	unsigned int i = 0;
+
+	for (i = 0; i < count; i++) {
+		u[i] = uv[2 * i];
+		v[i] = uv[2 * i + 1];
+	}
+}
+
+void image_convert_scalar_merge_uv(const unsigned char *u, const unsigned char *v, unsigned char *uv, unsigned int count)
+{
+	unsigned int i = 0;
+
+	for (i = 0; i < count; i++) {
+		uv[2 * i] = u[i];
+		uv[2 * i + 1] = v[i];
+	}
+}
+
+static inline unsigned char __rgb_to_y(int r, int g, int b)
+{
+	return ((66 * r + 129 * g + 25 * b + 128) >> 8) + 16;
+}
+
+static inline unsigned char __rgb_to_u(int r, int g, int b)
+{
+	return ((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128;
+}
+
+static inline unsigned char __rgb_to_v(int r, int g, int b)
+{
+	return ((112 * r - 94 * g - 18 * b + 128) >> 8) + 128;
+}
+
+void image_convert_scalar_rgba_to_y(const unsigned char *src, unsigned char *y, unsigned int count)
+{
+	unsigned int i = 0;
+
+	for (i = 0; i < count; i++)
+		y[i] = __rgb_to_y(src[4 * i], src[4 * i + 1], src[4 * i + 2]);
+}
+
+void image_convert_scalar_downscale_2x(const unsigned char *row0, const unsigned char *row1, unsigned char *dst, unsigned int count)
+{
+	unsigned int i = 0;
+
+	for (i = 0; i < count; i++)
+		dst[i] = (row0[2 * i] + row0[2 * i + 1] + row1[2 * i] + row1[2 * i + 1] + 2) >> 2;
+}
+
+void image_convert_scalar_update_background(const unsigned char *cur, short *mean, short *dev, unsigned char *mask,
+	unsigned int count, short min_diff)
+{
+	unsigned int i = 0;
+
+	for (i = 0; i < count; i++) {
+		int diff = (cur[i] << MOTION_MODEL_FRAC_BITS) - mean[i];
+		int abs_diff = abs(diff);
+		int limit = 3 * dev[i];
+
+		if (limit > SHRT_MAX)
+			limit = SHRT_MAX;
+		if (limit < min_diff)
+			limit = min_diff;
+
+		if (abs_diff > limit) {
+			mask[i] = 255;
+			mean[i] += diff >> MOTION_MODEL_FOREGROUND_RATE_SHIFT;
+		} else {
+			mask[i] = 0;
+			mean[i] += diff >> MOTION_MODEL_RATE_SHIFT;
+			dev[i] += (abs_diff - dev[i]) >> MOTION_MODEL_RATE_SHIFT;
+		}
+	}
+}
+
+void image_convert_scalar_morph_3x3(const unsigned char *r0, const unsigned char *r1, const unsigned char *r2,
+	unsigned char *dst, unsigned int from, unsigned int to, unsigned int count, bool dilate)
+{
+	unsigned int i = 0;
+	unsigned int x = 0;
+
+	for (i = from; i < to; i++) {
+		unsigned int left = i ? i - 1 : 0;
+		unsigned int right = i + 1 < count ? i + 1 : i;
+		unsigned char v = r0[i];
+
+		for (x = left; x <= right; x++) {
+			const unsigned char c[3] = { r0[x], r1[x], r2[x] };
+			unsigned int j = 0;
+
+			for (j = 0; j < 3; j++) {
+				if (dilate ? c[j] > v : c[j] < v)
+					v = c[j];
+			}
+		}
+		dst[i] = v;
+	}
+}
+
+void image_convert_scalar_sum_blocks(const unsigned char *src, unsigned int *sums, unsigned int count)
+{
+	unsigned int i = 0;
+	unsigned int j = 0;
+
+	for (i = 0; i < count; i++, src += 16) {
+		unsigned int sum = 0;
+
+		for (j = 0; j < 16; j++)
+			sum += src[j];
+		sums[i] += sum;
+	}
+}
+
+static void __scalar_erode_3x3(const unsigned char *r0, const unsigned char *r1, const unsigned char *r2,
+	unsigned char *dst, unsigned int count)
+{
+	image_convert_scalar_morph_3x3(r0, r1, r2, dst, 0, count, count, false);
+}
+
+static void __scalar_dilate_3x3(const unsigned char *r0, const unsigned char *r1, const unsigned char *r2,
+	unsigned char *dst, unsigned int count)
+{
+	image_convert_scalar_morph_3x3(r0, r1, r2, dst, 0, count, count, true);
+}
+
+const image_convert_kernels_s image_convert_scalar_kernels = {
+	.name = "scalar",
+	.extract_bytes = image_convert_scalar_extract_bytes,
+	.average_rows = image_convert_scalar_average_rows,
+	.split_uv = image_convert_scalar_split_uv,
+	.merge_uv = image_convert_scalar_merge_uv,
+	.rgba_to_y = image_convert_scalar_rgba_to_y,
+	.downscale_2x = image_convert_scalar_downscale_2x,
+	.update_background = image_convert_scalar_update_background,
+	.erode_3x3 = __scalar_erode_3x3,
+	.dilate_3x3 = __scalar_dilate_3x3,
+	.sum_blocks = image_convert_scalar_sum_blocks,
+};
+
+/* Compares every kernel with the scalar one on odd lengths and offsets */
+static int __self_check(const image_convert_kernels_s *candidate)
+{
+	static const unsigned int lengths[] = { 1, 7, 15, 16, 17, 31, 32, 33, 63, 65, 100, SELF_CHECK_LENGTH };
+	static const unsigned char thresholds[] = { 0, 12, 50, 255 };
+	short mean[SELF_CHECK_LENGTH], expected_mean[SELF_CHECK_LENGTH];
+	short dev[SELF_CHECK_LENGTH], expected_dev[SELF_CHECK_LENGTH];
+	unsigned char src[4 * SELF_CHECK_LENGTH + 1];
+	unsigned char src2[SELF_CHECK_LENGTH + 1];
+	unsigned char expected[2 * SELF_CHECK_LENGTH];
+	unsigned char expected2[SELF_CHECK_LENGTH];
+	unsigned char result[2 * SELF_CHECK_LENGTH];
+	unsigned char result2[SELF_CHECK_LENGTH];
+	unsigned int sums[SELF_CHECK_LENGTH / 4], expected_sums[SELF_CHECK_LENGTH / 4];
+	unsigned int seed = 0x12345678;
+	unsigned int i = 0;
+	unsigned int n = 0;
+	unsigned int t = 0;
+
+	for (i = 0; i < sizeof(src); i++) {
+		seed = seed * 1103515245 + 12345;
+		src[i] = seed >> 16;
+	}
+	for (i = 0; i < sizeof(src2); i++) {
+		seed = seed * 1103515245 + 12345;
+		src2[i] = seed >> 16;
+	}
+
+	for (i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+		n = lengths[i];
+
+		/* +1 keeps the loads unaligned */
+		image_convert_scalar_extract_bytes(src + 1, expected, n, 1);
+		candidate->extract_bytes(src + 1, result, n, 1);
+		retvm_if(memcmp(expected, result, n), -1, "%s extract_bytes differs at %u", candidate->name, n);
+
+		image_convert_scalar_extract_bytes(src, expected, n, 0);
+		candidate->extract_bytes(src, result, n, 0);
+		retvm_if(memcmp(expected, result, n), -1, "%s extract_bytes differs at %u", candidate->name, n);
+
+		image_convert_scalar_average_rows(src + 1, src2 + 1, expected, n);
+		candidate->average_rows(src + 1, src2 + 1, result, n);
+		retvm_if(memcmp(expected, result, n), -1, "%s average_rows differs at %u", candidate->name, n);
+
+		image_convert_scalar_split_uv(src + 1, expected, expected2, n);
+		candidate->split_uv(src + 1, result, result2, n);
+		retvm_if(memcmp(expected, result, n) || memcmp(expected2, result2, n), -1,
+			"%s split_uv differs at %u", candidate->name, n);
+
+		image_convert_scalar_merge_uv(src + 1, src2 + 1, expected, n);
+		candidate->merge_uv(src + 1, src2 + 1, result, n);
+		retvm_if(memcmp(expected, result, 2 * n), -1, "%s merge_uv differs at %u", candidate->name, n);
+
+		image_convert_scalar_rgba_to_y(src + 1, expected, n);
+		candidate->rgba_to_y(src + 1, result, n);
+		retvm_if(memcmp(expected, result, n), -1, "%s rgba_to_y differs at %u", candidate->name, n);
+
+		image_convert_scalar_downscale_2x(src + 1, src + 2 * n + 1, expected, n);
+		candidate->downscale_2x(src + 1, src + 2 * n + 1, result, n);
+		retvm_if(memcmp(expected, result, n), -1, "%s downscale_2x differs at %u", candidate->name, n);
+
+		/* model values stay within 0 ~ 255 << MOTION_MODEL_FRAC_BITS */
+		for (t = 0; t < sizeof(thresholds) / sizeof(thresholds[0]); t++) {
+			short min_diff = thresholds[t] << MOTION_MODEL_FRAC_BITS;
+			unsigned int j = 0;
+
+			for (j = 0; j < n; j++) {
+				mean[j] = expected_mean[j] = ((src[j] << 8) | src2[j]) % (256 << MOTION_MODEL_FRAC_BITS);
+				dev[j] = expected_dev[j] = ((src2[j] << 8) | src[j + 1]) % (256 << MOTION_MODEL_FRAC_BITS) >> t;
+			}
+
+			image_convert_scalar_update_background(src2 + 1, expected_mean, expected_dev, expected, n, min_diff);
+			candidate->update_background(src2 + 1, mean, dev, result, n, min_diff);
+			retvm_if(memcmp(expected, result, n) || memcmp(expected_mean, mean, n * sizeof(short))
+				|| memcmp(expected_dev, dev, n * sizeof(short)), -1,
+				"%s update_background differs at %u", candidate->name, n);
+		}
+
+		__scalar_erode_3x3(src + 1, src2 + 1, src + n + 1, expected, n);
+		candidate->erode_3x3(src + 1, src2 + 1, src + n + 1, result, n);
+		retvm_if(memcmp(expected, result, n), -1, "%s erode_3x3 differs at %u", candidate->name, n);
+
+		__scalar_dilate_3x3(src + 1, src2 + 1, src + n + 1, expected, n);
+		candidate->dilate_3x3(src + 1, src2 + 1, src + n + 1, result, n);
+		retvm_if(memcmp(expected, result, n), -1, "%s dilate_3x3 differs at %u", candidate->name, n);
+
+		/* n / 4 blocks of 16 stay within src, sums start out non zero */
+		for (t = 0; t < n / 4; t++)
+			sums[t] = expected_sums[t] = src2[t] * 1000;
+		image_convert_scalar_sum_blocks(src + 1, expected_sums, n / 4);
+		candidate->sum_blocks(src + 1, sums, n / 4);
+		retvm_if(memcmp(expected_sums, sums, n / 4 * sizeof(unsigned int)), -1,
+			"%s sum_blocks differs at %u", candidate->name, n);
+	}
+
+	return 0;
+}
+
+static void __select_kernels(void)
+{
+	const image_convert_kernels_s *candidates[3] = { NULL, };
+	unsigned int count = 0;
+	unsigned int i = 0;
+
+#ifdef IMAGE_CONVERT_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		candidates[count++] = &image_convert_avx2_kernels;
+	if (__builtin_cpu_supports("sse2"))
+		candidates[count++] = &image_convert_sse2_kernels;
+#endif
+#ifdef IMAGE_CONVERT_NEON
+	if (image_convert_neon_is_available())
+		candidates[count++] = &image_convert_neon_kernels;
+#endif
+
+	for (i = 0; i < count; i++) {
+		if (!__self_check(candidates[i])) {
+			kernels = candidates[i];
+			break;
+		}
+		_E("%s kernels do not match the scalar ones, not used", candidates[i]->name);
+	}
+
+	_I("Colorspace conversion uses %s kernels", kernels->name);
+}
+
+static const image_convert_kernels_s *__get_kernels(void)
+{
+	pthread_once(&kernels_once, __select_kernels);
+
+	return kernels;
+}
+
+const image_convert_kernels_s *image_convert_get_kernels(void)
+{
+	return __get_kernels();
+}
+
+const char *image_convert_get_kernel_name(void)
+{
+	return __get_kernels()->name;
+}
+
+bool image_convert_is_supported(camera_pixel_format_e format)
+{
+	switch (format) {
+	case CAMERA_PIXEL_FORMAT_NV12:
+	case CAMERA_PIXEL_FORMAT_NV21:
+	case CAMERA_PIXEL_FORMAT_I420:
+	case CAMERA_PIXEL_FORMAT_YV12:
+	case CAMERA_PIXEL_FORMAT_422P:
+	case CAMERA_PIXEL_FORMAT_YUYV:
+	case CAMERA_PIXEL_FORMAT_UYVY:
+	case CAMERA_PIXEL_FORMAT_RGB565:
+	case CAMERA_PIXEL_FORMAT_RGB888:
+	case CAMERA_PIXEL_FORMAT_RGBA:
+		return true;
+	default:
+		return false;
+	}
+}
+
+unsigned int image_convert_get_size(image_convert_target_e target, unsigned int width, unsigned int height)
+{
+	if (target == IMAGE_CONVERT_LUMA)
+		return width * height;
+
+	return width * height + 2 * ((width + 1) / 2) * ((height + 1) / 2);
+}
+
+static inline const unsigned char *__row(const image_frame_view_s *src, unsigned int plane, unsigned int row)
+{
+	return src->planes[plane].data + (size_t)src->planes[plane].stride * row;
+}
+
+static inline void __get_rgb(camera_pixel_format_e format, const unsigned char *row,
+	unsigned int x, int *r, int *g, int *b)
+{
+	unsigned int pixel = 0;
+
+	switch (format) {
+	case CAMERA_PIXEL_FORMAT_RGB565:
+		pixel = row[2 * x] | (row[2 * x + 1] << 8);
+		*r = (pixel >> 11) & 0x1F;
+		*g = (pixel >> 5) & 0x3F;
+		*b = pixel & 0x1F;
+		*r = (*r << 3) | (*r >> 2);
+		*g = (*g << 2) | (*g >> 4);
+		*b = (*b << 3) | (*b >> 2);
+		break;
+	case CAMERA_PIXEL_FORMAT_RGB888:
+		*r = row[3 * x];
+		*g = row[3 * x + 1];
+		*b = row[3 * x + 2];
+		break;
+	default:
+		*r = row[4 * x];
+		*g = row[4 * x + 1];
+		*b = row[4 * x + 2];
+		break;
+	}
+}
+
+static void __convert_luma(const image_convert_kernels_s *k, const image_frame_view_s *src, unsigned char *y)
+{
+	unsigned int width = src->width;
+	unsigned int row = 0;
+	unsigned int x = 0;
+	int r, g, b;
+
+	for (row = 0; row < src->height; row++, y += width) {
+		const unsigned char *line = __row(src, 0, row);
+
+		switch (src->format) {
+		case CAMERA_PIXEL_FORMAT_YUYV:
+			k->extract_bytes(line, y, width, 0);
+			break;
+		case CAMERA_PIXEL_FORMAT_UYVY:
+			k->extract_bytes(line, y, width, 1);
+			break;
+		case CAMERA_PIXEL_FORMAT_RGBA:
+			k->rgba_to_y(line, y, width);
+			break;
+		case CAMERA_PIXEL_FORMAT_RGB565:
+		case CAMERA_PIXEL_FORMAT_RGB888:
+			for (x = 0; x < width; x++) {
+				__get_rgb(src->format, line, x, &r, &g, &b);
+				y[x] = __rgb_to_y(r, g, b);
+			}
+			break;
+		default:
+			memcpy(y, line, width);
+			break;
+		}
+	}
+}
+
+typedef struct {
+	image_convert_target_e target;
+	unsigned char *u; // I420
+	unsigned char *v;
+	unsigned char *uv; // NV12
+} chroma_row_s;
+
+/* Writes count interleaved chroma pairs at chroma column x */
+static void __put_uv(const image_convert_kernels_s *k, chroma_row_s *out,
+	const unsigned char *uv, unsigned int x, unsigned int count, bool swap)
+{
+	unsigned char u[CONVERT_CHUNK];
+	unsigned char v[CONVERT_CHUNK];
+
+	if (out->target == IMAGE_CONVERT_I420) {
+		if (swap)
+			k->split_uv(uv, out->v + x, out->u + x, count);
+		else
+			k->split_uv(uv, out->u + x, out->v + x, count);
+	} else if (!swap) {
+		memcpy(out->uv + 2 * x, uv, 2 * count);
+	} else {
+		k->split_uv(uv, v, u, count);
+		k->merge_uv(u, v, out->uv + 2 * x, count);
+	}
+}
+
+/* Writes count U and V samples at chroma column x */
+static void __put_planes(const image_convert_kernels_s *k, chroma_row_s *out,
+	const unsigned char *u, const unsigned char *v, unsigned int x, unsigned int count)
+{
+	if (out->target == IMAGE_CONVERT_I420) {
+		memcpy(out->u + x, u, count);
+		memcpy(out->v + x, v, count);
+	} else {
+		k->merge_uv(u, v, out->uv + 2 * x, count);
+	}
+}
+
+/*
+ * Chroma row row of the output from source rows 2 * row and the next one.
+ * An odd last row is paired with itself, and an odd last column of packed
+ * 4:2:2 and RGB input is taken from its one pixel.
+ */
+static void __convert_chroma_row(const image_convert_kernels_s *k, const image_frame_view_s *src,
+	unsigned int row, chroma_row_s *out)
+{
+	unsigned int chroma_width = (src->width + 1) / 2;
+	unsigned int pairs = src->width / 2; // chroma columns of two source pixels
+	unsigned int row0 = 2 * row;
+	unsigned int row1 = row0 + 1 < src->height ? row0 + 1 : row0;
+	unsigned char temp0[2 * CONVERT_CHUNK];
+	unsigned char temp1[2 * CONVERT_CHUNK];
+	unsigned char temp2[2 * CONVERT_CHUNK];
+	unsigned int x = 0;
+	unsigned int count = 0;
+	unsigned int i = 0;
+	int r, g, b;
+
+	for (x = 0; x < chroma_width; x += count) {
+		count = chroma_width - x < CONVERT_CHUNK ? chroma_width - x : CONVERT_CHUNK;
+		if (x + count > pairs && x < pairs)
+			count = pairs - x;
+
+		switch (src->format) {
+		case CAMERA_PIXEL_FORMAT_NV12:
+		case CAMERA_PIXEL_FORMAT_NV21:
+			__put_uv(k, out, __row(src, 1, row) + 2 * x, x, count,
+				src->format == CAMERA_PIXEL_FORMAT_NV21);
+			break;
+		case CAMERA_PIXEL_FORMAT_I420:
+			__put_planes(k, out, __row(src, 1, row) + x, __row(src, 2, row) + x, x, count);
+			break;
+		case CAMERA_PIXEL_FORMAT_YV12:
+			__put_planes(k, out, __row(src, 2, row) + x, __row(src, 1, row) + x, x, count);
+			break;
+		case CAMERA_PIXEL_FORMAT_422P:
+			k->average_rows(__row(src, 1, row0) + x, __row(src, 1, row1) + x, temp0, count);
+			k->average_rows(__row(src, 2, row0) + x, __row(src, 2, row1) + x, temp1, count);
+			__put_planes(k, out, temp0, temp1, x, count);
+			break;
+		case CAMERA_PIXEL_FORMAT_YUYV:
+		case CAMERA_PIXEL_FORMAT_UYVY:
+			/* chroma bytes of two pixels are one UV pair, in both layouts */
+			i = src->format == CAMERA_PIXEL_FORMAT_YUYV ? 1 : 0;
+			if (x == pairs) {
+				/* the last pixel of an odd row only has U, V is the one before it */
+				temp2[0] = (__row(src, 0, row0)[4 * x + i] + __row(src, 0, row1)[4 * x + i] + 1) >> 1;
+				temp2[1] = x ? (__row(src, 0, row0)[4 * x - 2 + i] + __row(src, 0, row1)[4 * x - 2 + i] + 1) >> 1 : 128;
+				__put_uv(k, out, temp2, x, count, false);
+				break;
+			}
+			k->extract_bytes(__row(src, 0, row0) + 4 * x, temp0, 2 * count, i);
+			k->extract_bytes(__row(src, 0, row1) + 4 * x, temp1, 2 * count, i);
+			k->average_rows(temp0, temp1, temp2, 2 * count);
+			__put_uv(k, out, temp2, x, count, false);
+			break;
+		default:
+			/* RGB, 2x2 box average */
+			for (i = 0; i < count; i++) {
+				int rs = 0, gs = 0, bs = 0;
+				unsigned int dx = 0;
+				unsigned int dy = 0;
+
+				for (dy = 0; dy < 2; dy++) {
+					for (dx = 0; dx < 2; dx++) {
+						unsigned int column = 2 * (x + i) + (x + i < pairs ? dx : 0);
+
+						__get_rgb(src->format, __row(src, 0, dy ? row1 : row0), column, &r, &g, &b);
+						rs += r;
+						gs += g;
+						bs += b;
+					}
+				}
+				temp2[2 * i] = __rgb_to_u((rs + 2) >> 2, (gs + 2) >> 2, (bs + 2) >> 2);
+				temp2[2 * i + 1] = __rgb_to_v((rs + 2) >> 2, (gs + 2) >> 2, (bs + 2) >> 2);
+			}
+			__put_uv(k, out, temp2, x, count, false);
+			break;
+		}
+	}
+}
+
+int image_convert_frame(const image_frame_view_s *src, image_convert_target_e target,
+	unsigned char *dst, unsigned int dst_size)
+{
+	const image_convert_kernels_s *k = __get_kernels();
+	unsigned int chroma_width = 0;
+	unsigned int chroma_height = 0;
+	unsigned int row = 0;
+	chroma_row_s out;
+
+	retv_if(!src, -1);
+	retv_if(!dst, -1);
+	retvm_if(!image_convert_is_supported(src->format), -1, "unsupported format : %d", src->format);
+	retv_if(dst_size < image_convert_get_size(target, src->width, src->height), -1);
+
+	__convert_luma(k, src, dst);
+	if (target == IMAGE_CONVERT_LUMA)
+		return 0;
+
+	chroma_width = (src->width + 1) / 2;
+	chroma_height = (src->height + 1) / 2;
+
+	memset(&out, 0, sizeof(out));
+	out.target = target;
+	out.u = dst + src->width * src->height;
+	out.v = out.u + chroma_width * chroma_height;
+	out.uv = out.u;
+
+	for (row = 0; row < chroma_height; row++) {
+		__convert_chroma_row(k, src, row, &out);
+		out.u += chroma_width;
+		out.v += chroma_width;
+		out.uv += 2 * chroma_width;
+	}
+
+	return 0;
+}
+
+const unsigned char *image_convert_get_frame(const image_frame_view_s *src, image_convert_target_e target,
+	unsigned char **scratch, unsigned int *scratch_size)
+{
+	unsigned int size = 0;
+
+	retv_if(!src, NULL);
+	retv_if(!scratch, NULL);
+	retv_if(!scratch_size, NULL);
+
+	if (image_frame_view_is_packed(src)
+		&& ((target == IMAGE_CONVERT_I420 && src->format == CAMERA_PIXEL_FORMAT_I420)
+			|| (target == IMAGE_CONVERT_NV12 && src->format == CAMERA_PIXEL_FORMAT_NV12)))
+		return src->planes[0].data;
+
+	size = image_convert_get_size(target, src->width, src->height);
+	if (*scratch_size < size) {
+		unsigned char *buffer = realloc(*scratch, size);
+		retvm_if(!buffer, NULL, "Failed to allocate %u bytes", size);
+		*scratch = buffer;
+		*scratch_size = size;
+	}
+
+	if (image_convert_frame(src, target, *scratch, *scratch_size))
+		return NULL;
+
+	return *scratch;
+}
@@ -0,0 +1,231 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "image_convert_internal.h"
+
+#ifdef IMAGE_CONVERT_NEON
+
+#include <arm_neon.h>
+#if !defined(__aarch64__)
+#include <sys/auxv.h>
+#ifndef HWCAP_NEON
+#define HWCAP_NEON (1 << 12)
+#endif
+#endif
+
+bool image_convert_neon_is_available(void)
+{
+#if defined(__aarch64__)
+	return true;
+#else
+	/* armv7 builds may run on a core without NEON */
+	return (getauxval(AT_HWCAP) & HWCAP_NEON) != 0;
+#endif
+}
+
+static void __neon_extract_bytes(const unsigned char *src, unsigned char *dst,
+	unsigned int count, unsigned int offset)
+{
+	unsigned int i = 0;
+
+	for (; i + 16 <= count; i += 16) {
+		uint8x16x2_t pairs = vld2q_u8(src + 2 * i);
+
+		vst1q_u8(dst + i, offset ? pairs.val[1] : pairs.val[0]);
+	}
+
+	image_convert_scalar_extract_bytes(src + 2 * i, dst + i, count - i, offset);
+}
+
+static void __neon_average_rows(const unsigned char *a, const unsigned char *b,
+	unsigned char *dst, unsigned int count)
+{
+	unsigned int i = 0;
+
+	for (; i + 16 <= count; i += 16)
+		vst1q_u8(dst + i, vrhaddq_u8(vld1q_u8(a + i), vld1q_u8(b + i)));
+
+	image_convert_scalar_average_rows(a + i, b + i, dst + i, count - i);
+}
+
+static void __neon_split_uv(const unsigned char *uv, unsigned char *u,
+	unsigned char *v, unsigned int count)
+{
+	unsigned int i = 0;
+
+	for (; i + 16 <= count; i += 16) {
+		uint8x16x2_t pairs = vld2q_u8(uv + 2 * i);
+
+		vst1q_u8(u + i, pairs.val[0]);
+		vst1q_u8(v + i, pairs.val[1]);
+	}
+
+	image_convert_scalar_split_uv(uv + 2 * i, u + i, v + i, count - i);
+}
+
+static void __neon_merge_uv(const unsigned char *u, const unsigned char *v,
+	unsigned char *uv, unsigned int count)
+{
+	unsigned int i = 0;
+
+	for (; i + 16 <= count; i += 16) {
+		uint8x16x2_t pairs;
+
+		pairs.val[0] = vld1q_u8(u + i);
+		pairs.val[1] = vld1q_u8(v + i);
+		vst2q_u8(uv + 2 * i, pairs);
+	}
+
+	image_convert_scalar_merge_uv(u + i, v + i, uv + 2 * i, count - i);
+}
+
+static void __neon_rgba_to_y(const unsigned char *src, unsigned char *y, unsigned int count)
+{
+	const uint8x8_t coef_r = vdup_n_u8(66);
+	const uint8x8_t coef_g = vdup_n_u8(129);
+	const uint8x8_t coef_b = vdup_n_u8(25);
+	unsigned int i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		uint8x8x4_t rgba = vld4_u8(src + 4 * i);
+		uint16x8_t sum = vmull_u8(rgba.val[0], coef_r);
+
+		sum = vmlal_u8(sum, rgba.val[1], coef_g);
+		sum = vmlal_u8(sum, rgba.val[2], coef_b);
+		sum = vaddq_u16(sum, vdupq_n_u16(128));
+		vst1_u8(y + i, vadd_u8(vshrn_n_u16(sum, 8), vdup_n_u8(16)));
+	}
+
+	image_convert_scalar_rgba_to_y(src + 4 * i, y + i, count - i);
+}
+
+static void __neon_downscale_2x(const unsigned char *row0, const unsigned char *row1,
+	unsigned char *dst, unsigned int count)
+{
+	unsigned int i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		uint16x8_t sum = vpaddlq_u8(vld1q_u8(row0 + 2 * i));
+
+		sum = vpadalq_u8(sum, vld1q_u8(row1 + 2 * i));
+		vst1_u8(dst + i, vrshrn_n_u16(sum, 2));
+	}
+
+	image_convert_scalar_downscale_2x(row0 + 2 * i, row1 + 2 * i, dst + i, count - i);
+}
+
+static void __neon_update_background(const unsigned char *cur, short *mean, short *dev,
+	unsigned char *mask, unsigned int count, short min_diff)
+{
+	const int16x8_t limit_min = vdupq_n_s16(min_diff);
+	unsigned int i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		int16x8_t c = vreinterpretq_s16_u16(vshll_n_u8(vld1_u8(cur + i), MOTION_MODEL_FRAC_BITS));
+		int16x8_t m = vld1q_s16(mean + i);
+		int16x8_t d = vld1q_s16(dev + i);
+		int16x8_t diff = vsubq_s16(c, m);
+		int16x8_t abs_diff = vabsq_s16(diff);
+		/* 3 dev saturates at SHRT_MAX like the scalar clamp */
+		int16x8_t limit = vmaxq_s16(vqaddq_s16(d, vqaddq_s16(d, d)), limit_min);
+		uint16x8_t fg = vcgtq_s16(abs_diff, limit);
+		int16x8_t step = vbslq_s16(fg, vshrq_n_s16(diff, MOTION_MODEL_FOREGROUND_RATE_SHIFT),
+			vshrq_n_s16(diff, MOTION_MODEL_RATE_SHIFT));
+		int16x8_t dev_step = vshrq_n_s16(vsubq_s16(abs_diff, d), MOTION_MODEL_RATE_SHIFT);
+
+		vst1q_s16(mean + i, vaddq_s16(m, step));
+		vst1q_s16(dev + i, vaddq_s16(d, vbicq_s16(dev_step, vreinterpretq_s16_u16(fg))));
+		vst1_u8(mask + i, vmovn_u16(fg));
+	}
+
+	image_convert_scalar_update_background(cur + i, mean + i, dev + i, mask + i, count - i, min_diff);
+}
+
+static void __neon_morph_3x3(const unsigned char *r0, const unsigned char *r1,
+	const unsigned char *r2, unsigned char *dst, unsigned int count, bool dilate)
+{
+	unsigned int i = 1;
+	unsigned int j = 0;
+
+	if (count < 18) {
+		image_convert_scalar_morph_3x3(r0, r1, r2, dst, 0, count, count, dilate);
+		return;
+	}
+
+	/* column 0 has no left neighbour */
+	image_convert_scalar_morph_3x3(r0, r1, r2, dst, 0, 1, count, dilate);
+
+	for (; i + 17 <= count; i += 16) {
+		uint8x16_t column[3];
+		uint8x16_t v;
+
+		for (j = 0; j < 3; j++) {
+			uint8x16_t a = vld1q_u8(r0 + i - 1 + j);
+			uint8x16_t b = vld1q_u8(r1 + i - 1 + j);
+			uint8x16_t c = vld1q_u8(r2 + i - 1 + j);
+
+			column[j] = dilate ? vmaxq_u8(vmaxq_u8(a, b), c) : vminq_u8(vminq_u8(a, b), c);
+		}
+
+		if (dilate)
+			v = vmaxq_u8(vmaxq_u8(column[0], column[1]), column[2]);
+		else
+			v = vminq_u8(vminq_u8(column[0], column[1]), column[2]);
+		vst1q_u8(dst + i, v);
+	}
+
+	image_convert_scalar_morph_3x3(r0, r1, r2, dst, i, count, count, dilate);
+}
+
+static void __neon_erode_3x3(const unsigned char *r0, const unsigned char *r1,
+	const unsigned char *r2, unsigned char *dst, unsigned int count)
+{
+	__neon_morph_3x3(r0, r1, r2, dst, count, false);
+}
+
+static void __neon_dilate_3x3(const unsigned char *r0, const unsigned char *r1,
+	const unsigned char *r2, unsigned char *dst, unsigned int count)
+{
+	__neon_morph_3x3(r0, r1, r2, dst, count, true);
+}
+
+static void __neon_sum_blocks(const unsigned char *src, unsigned int *sums, unsigned int count)
+{
+	unsigned int i = 0;
+
+	for (; i < count; i++) {
+		uint32x4_t quad = vpaddlq_u16(vpaddlq_u8(vld1q_u8(src + 16 * i)));
+		uint32x2_t pair = vadd_u32(vget_low_u32(quad), vget_high_u32(quad));
+
+		sums[i] += vget_lane_u32(vpadd_u32(pair, pair), 0);
+	}
+}
+
+const image_convert_kernels_s image_convert_neon_kernels = {
+	.name = "neon",
+	.extract_bytes = __neon_extract_bytes,
+	.average_rows = __neon_average_rows,
+	.split_uv = __neon_split_uv,
+	.merge_uv = __neon_merge_uv,
+	.rgba_to_y = __neon_rgba_to_y,
+	.downscale_2x = __neon_downscale_2x,
+	.update_background = __neon_update_background,
+	.erode_3x3 = __neon_erode_3x3,
+	.dilate_3x3 = __neon_dilate_3x3,
+	.sum_blocks = __neon_sum_blocks,
+};
+
+#endif /* IMAGE_CONVERT_NEON */
@@ -0,0 +1,518 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "image_convert_internal.h"
+
+#ifdef IMAGE_CONVERT_X86
+
+#include <immintrin.h>
+
+/*
+ * Built with target attributes so the rest of the app keeps the baseline
+ * ISA, image_convert only calls these after checking the CPU.
+ */
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+
+static TARGET_SSE2 void __sse2_extract_bytes(const unsigned char *src, unsigned char *dst,
+	unsigned int count, unsigned int offset)
+{
+	const __m128i mask = _mm_set1_epi16(0x00FF);
+	unsigned int i = 0;
+
+	for (; i + 16 <= count; i += 16) {
+		__m128i a = _mm_loadu_si128((const __m128i *)(src + 2 * i));
+		__m128i b = _mm_loadu_si128((const __m128i *)(src + 2 * i + 16));
+
+		if (offset) {
+			a = _mm_srli_epi16(a, 8);
+			b = _mm_srli_epi16(b, 8);
+		} else {
+			a = _mm_and_si128(a, mask);
+			b = _mm_and_si128(b, mask);
+		}
+		_mm_storeu_si128((__m128i *)(dst + i), _mm_packus_epi16(a, b));
+	}
+
+	image_convert_scalar_extract_bytes(src + 2 * i, dst + i, count - i, offset);
+}
+
+static TARGET_SSE2 void __sse2_average_rows(const unsigned char *a, const unsigned char *b,
+	unsigned char *dst, unsigned int count)
+{
+	unsigned int i = 0;
+
+	for (; i + 16 <= count; i += 16) {
+		__m128i va = _mm_loadu_si128((const __m128i *)(a + i));
+		__m128i vb = _mm_loadu_si128((const __m128i *)(b + i));
+
+		_mm_storeu_si128((__m128i *)(dst + i), _mm_avg_epu8(va, vb));
+	}
+
+	image_convert_scalar_average_rows(a + i, b + i, dst + i, count - i);
+}
+
+static TARGET_SSE2 void __sse2_split_uv(const unsigned char *uv, unsigned char *u,
+	unsigned char *v, unsigned int count)
+{
+	const __m128i mask = _mm_set1_epi16(0x00FF);
+	unsigned int i = 0;
+
+	for (; i + 16 <= count; i += 16) {
+		__m128i a = _mm_loadu_si128((const __m128i *)(uv + 2 * i));
+		__m128i b = _mm_loadu_si128((const __m128i *)(uv + 2 * i + 16));
+
+		_mm_storeu_si128((__m128i *)(u + i),
+			_mm_packus_epi16(_mm_and_si128(a, mask), _mm_and_si128(b, mask)));
+		_mm_storeu_si128((__m128i *)(v + i),
+			_mm_packus_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8)));
+	}
+
+	image_convert_scalar_split_uv(uv + 2 * i, u + i, v + i, count - i);
+}
+
+static TARGET_SSE2 void __sse2_merge_uv(const unsigned char *u, const unsigned char *v,
+	unsigned char *uv, unsigned int count)
+{
+	unsigned int i = 0;
+
+	for (; i + 16 <= count; i += 16) {
+		__m128i vu = _mm_loadu_si128((const __m128i *)(u + i));
+		__m128i vv = _mm_loadu_si128((const __m128i *)(v + i));
+
+		_mm_storeu_si128((__m128i *)(uv + 2 * i), _mm_unpacklo_epi8(vu, vv));
+		_mm_storeu_si128((__m128i *)(uv + 2 * i + 16), _mm_unpackhi_epi8(vu, vv));
+	}
+
+	image_convert_scalar_merge_uv(u + i, v + i, uv + 2 * i, count - i);
+}
+
+/* Y = ((66 R + 129 G + 25 B + 128) >> 8) + 16, the sum fits unsigned 16 bit */
+static TARGET_SSE2 __m128i __sse2_luma(__m128i r, __m128i g, __m128i b)
+{
+	__m128i y = _mm_mullo_epi16(r, _mm_set1_epi16(66));
+
+	y = _mm_add_epi16(y, _mm_mullo_epi16(g, _mm_set1_epi16(129)));
+	y = _mm_add_epi16(y, _mm_mullo_epi16(b, _mm_set1_epi16(25)));
+	y = _mm_add_epi16(y, _mm_set1_epi16(128));
+
+	return _mm_add_epi16(_mm_srli_epi16(y, 8), _mm_set1_epi16(16));
+}
+
+static TARGET_SSE2 void __sse2_rgba_to_y(const unsigned char *src, unsigned char *y, unsigned int count)
+{
+	const __m128i mask = _mm_set1_epi32(0xFF);
+	unsigned int i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		__m128i a = _mm_loadu_si128((const __m128i *)(src + 4 * i));
+		__m128i b = _mm_loadu_si128((const __m128i *)(src + 4 * i + 16));
+		__m128i vr = _mm_packs_epi32(_mm_and_si128(a, mask), _mm_and_si128(b, mask));
+		__m128i vg = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(a, 8), mask),
+			_mm_and_si128(_mm_srli_epi32(b, 8), mask));
+		__m128i vb = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(a, 16), mask),
+			_mm_and_si128(_mm_srli_epi32(b, 16), mask));
+		__m128i vy = __sse2_luma(vr, vg, vb);
+
+		_mm_storel_epi64((__m128i *)(y + i), _mm_packus_epi16(vy, vy));
+	}
+
+	image_convert_scalar_rgba_to_y(src + 4 * i, y + i, count - i);
+}
+
+/* Adjacent byte pairs summed into 16 bit lanes */
+static TARGET_SSE2 __m128i __sse2_pair_sum(__m128i v)
+{
+	return _mm_add_epi16(_mm_and_si128(v, _mm_set1_epi16(0x00FF)), _mm_srli_epi16(v, 8));
+}
+
+static TARGET_SSE2 void __sse2_downscale_2x(const unsigned char *row0, const unsigned char *row1,
+	unsigned char *dst, unsigned int count)
+{
+	const __m128i round = _mm_set1_epi16(2);
+	unsigned int i = 0;
+
+	for (; i + 16 <= count; i += 16) {
+		__m128i lo = _mm_add_epi16(__sse2_pair_sum(_mm_loadu_si128((const __m128i *)(row0 + 2 * i))),
+			__sse2_pair_sum(_mm_loadu_si128((const __m128i *)(row1 + 2 * i))));
+		__m128i hi = _mm_add_epi16(__sse2_pair_sum(_mm_loadu_si128((const __m128i *)(row0 + 2 * i + 16))),
+			__sse2_pair_sum(_mm_loadu_si128((const __m128i *)(row1 + 2 * i + 16))));
+
+		lo = _mm_srli_epi16(_mm_add_epi16(lo, round), 2);
+		hi = _mm_srli_epi16(_mm_add_epi16(hi, round), 2);
+		_mm_storeu_si128((__m128i *)(dst + i), _mm_packus_epi16(lo, hi));
+	}
+
+	image_convert_scalar_downscale_2x(row0 + 2 * i, row1 + 2 * i, dst + i, count - i);
+}
+
+static TARGET_SSE2 void __sse2_update_background(const unsigned char *cur, short *mean, short *dev,
+	unsigned char *mask, unsigned int count, short min_diff)
+{
+	const __m128i limit_min = _mm_set1_epi16(min_diff);
+	unsigned int i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		__m128i c = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(cur + i)), _mm_setzero_si128());
+		__m128i m = _mm_loadu_si128((const __m128i *)(mean + i));
+		__m128i d = _mm_loadu_si128((const __m128i *)(dev + i));
+		__m128i diff = _mm_sub_epi16(_mm_slli_epi16(c, MOTION_MODEL_FRAC_BITS), m);
+		__m128i abs_diff = _mm_max_epi16(diff, _mm_sub_epi16(_mm_setzero_si128(), diff));
+		/* 3 dev saturates at SHRT_MAX like the scalar clamp */
+		__m128i limit = _mm_max_epi16(_mm_adds_epi16(d, _mm_adds_epi16(d, d)), limit_min);
+		__m128i fg = _mm_cmpgt_epi16(abs_diff, limit);
+		__m128i step = _mm_or_si128(_mm_and_si128(fg, _mm_srai_epi16(diff, MOTION_MODEL_FOREGROUND_RATE_SHIFT)),
+			_mm_andnot_si128(fg, _mm_srai_epi16(diff, MOTION_MODEL_RATE_SHIFT)));
+
+		d = _mm_add_epi16(d, _mm_andnot_si128(fg, _mm_srai_epi16(_mm_sub_epi16(abs_diff, d), MOTION_MODEL_RATE_SHIFT)));
+		_mm_storeu_si128((__m128i *)(mean + i), _mm_add_epi16(m, step));
+		_mm_storeu_si128((__m128i *)(dev + i), d);
+		_mm_storel_epi64((__m128i *)(mask + i), _mm_packs_epi16(fg, fg));
+	}
+
+	image_convert_scalar_update_background(cur + i, mean + i, dev + i, mask + i, count - i, min_diff);
+}
+
+static TARGET_SSE2 __m128i __sse2_column(const unsigned char *r0, const unsigned char *r1,
+	const unsigned char *r2, unsigned int i, bool dilate)
+{
+	__m128i a = _mm_loadu_si128((const __m128i *)(r0 + i));
+	__m128i b = _mm_loadu_si128((const __m128i *)(r1 + i));
+	__m128i c = _mm_loadu_si128((const __m128i *)(r2 + i));
+
+	if (dilate)
+		return _mm_max_epu8(_mm_max_epu8(a, b), c);
+	return _mm_min_epu8(_mm_min_epu8(a, b), c);
+}
+
+static TARGET_SSE2 void __sse2_morph_3x3(const unsigned char *r0, const unsigned char *r1,
+	const unsigned char *r2, unsigned char *dst, unsigned int count, bool dilate)
+{
+	unsigned int i = 1;
+
+	if (count < 18) {
+		image_convert_scalar_morph_3x3(r0, r1, r2, dst, 0, count, count, dilate);
+		return;
+	}
+
+	/* column 0 has no left neighbour */
+	image_convert_scalar_morph_3x3(r0, r1, r2, dst, 0, 1, count, dilate);
+
+	for (; i + 17 <= count; i += 16) {
+		__m128i left = __sse2_column(r0, r1, r2, i - 1, dilate);
+		__m128i center = __sse2_column(r0, r1, r2, i, dilate);
+		__m128i right = __sse2_column(r0, r1, r2, i + 1, dilate);
+		__m128i v;
+
+		if (dilate)
+			v = _mm_max_epu8(_mm_max_epu8(left, center), right);
+		else
+			v = _mm_min_epu8(_mm_min_epu8(left, center), right);
+		_mm_storeu_si128((__m128i *)(dst + i), v);
+	}
+
+	image_convert_scalar_morph_3x3(r0, r1, r2, dst, i, count, count, dilate);
+}
+
+static TARGET_SSE2 void __sse2_erode_3x3(const unsigned char *r0, const unsigned char *r1,
+	const unsigned char *r2, unsigned char *dst, unsigned int count)
+{
+	__sse2_morph_3x3(r0, r1, r2, dst, count, false);
+}
+
+static TARGET_SSE2 void __sse2_dilate_3x3(const unsigned char *r0, const unsigned char *r1,
+	const unsigned char *r2, unsigned char *dst, unsigned int count)
+{
+	__sse2_morph_3x3(r0, r1, r2, dst, count, true);
+}
+
+/* SAD against zero sums each 8 bytes into a 64 bit lane */
+static TARGET_SSE2 void __sse2_sum_blocks(const unsigned char *src, unsigned int *sums, unsigned int count)
+{
+	const __m128i zero = _mm_setzero_si128();
+	unsigned int i = 0;
+
+	for (; i < count; i++) {
+		__m128i sad = _mm_sad_epu8(_mm_loadu_si128((const __m128i *)(src + 16 * i)), zero);
+
+		sums[i] += _mm_cvtsi128_si32(_mm_add_epi32(sad, _mm_unpackhi_epi64(sad, sad)));
+	}
+}
+
+const image_convert_kernels_s image_convert_sse2_kernels = {
+	.name = "sse2",
+	.extract_bytes = __sse2_extract_bytes,
+	.average_rows = __sse2_average_rows,
+	.split_uv = __sse2_split_uv,
+	.merge_uv = __sse2_merge_uv,
+	.rgba_to_y = __sse2_rgba_to_y,
+	.downscale_2x = __sse2_downscale_2x,
+	.update_background = __sse2_update_background,
+	.erode_3x3 = __sse2_erode_3x3,
+	.dilate_3x3 = __sse2_dilate_3x3,
+	.sum_blocks = __sse2_sum_blocks,
+};
+
+/*
+ * AVX2 packs and unpacks work within 128 bit lanes, the 64 bit permutes
+ * (0xD8 : 0, 2, 1, 3) put the halves back in row order.
+ */
+static TARGET_AVX2 void __avx2_extract_bytes(const unsigned char *src, unsigned char *dst,
+	unsigned int count, unsigned int offset)
+{
+	const __m256i mask = _mm256_set1_epi16(0x00FF);
+	unsigned int i = 0;
+
+	for (; i + 32 <= count; i += 32) {
+		__m256i a = _mm256_loadu_si256((const __m256i *)(src + 2 * i));
+		__m256i b = _mm256_loadu_si256((const __m256i *)(src + 2 * i + 32));
+
+		if (offset) {
+			a = _mm256_srli_epi16(a, 8);
+			b = _mm256_srli_epi16(b, 8);
+		} else {
+			a = _mm256_and_si256(a, mask);
+			b = _mm256_and_si256(b, mask);
+		}
+		_mm256_storeu_si256((__m256i *)(dst + i),
+			_mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8));
+	}
+
+	image_convert_scalar_extract_bytes(src + 2 * i, dst + i, count - i, offset);
+}
+
+static TARGET_AVX2 void __avx2_average_rows(const unsigned char *a, const unsigned char *b,
+	unsigned char *dst, unsigned int count)
+{
+	unsigned int i = 0;
+
+	for (; i + 32 <= count; i += 32) {
+		__m256i va = _mm256_loadu_si256((const __m256i *)(a + i));
+		__m256i vb = _mm256_loadu_si256((const __m256i *)(b + i));
+
+		_mm256_storeu_si256((__m256i *)(dst + i), _mm256_avg_epu8(va, vb));
+	}
+
+	image_convert_scalar_average_rows(a + i, b + i, dst + i, count - i);
+}
+
+static TARGET_AVX2 void __avx2_split_uv(const unsigned char *uv, unsigned char *u,
+	unsigned char *v, unsigned int count)
+{
+	const __m256i mask = _mm256_set1_epi16(0x00FF);
+	unsigned int i = 0;
+
+	for (; i + 32 <= count; i += 32) {
+		__m256i a = _mm256_loadu_si256((const __m256i *)(uv + 2 * i));
+		__m256i b = _mm256_loadu_si256((const __m256i *)(uv + 2 * i + 32));
+		__m256i vu = _mm256_packus_epi16(_mm256_and_si256(a, mask), _mm256_and_si256(b, mask));
+		__m256i vv = _mm256_packus_epi16(_mm256_srli_epi16(a, 8), _mm256_srli_epi16(b, 8));
+
+		_mm256_storeu_si256((__m256i *)(u + i), _mm256_permute4x64_epi64(vu, 0xD8));
+		_mm256_storeu_si256((__m256i *)(v + i), _mm256_permute4x64_epi64(vv, 0xD8));
+	}
+
+	image_convert_scalar_split_uv(uv + 2 * i, u + i, v + i, count - i);
+}
+
+static TARGET_AVX2 void __avx2_merge_uv(const unsigned char *u, const unsigned char *v,
+	unsigned char *uv, unsigned int count)
+{
+	unsigned int i = 0;
+
+	for (; i + 32 <= count; i += 32) {
+		__m256i vu = _mm256_loadu_si256((const __m256i *)(u + i));
+		__m256i vv = _mm256_loadu_si256((const __m256i *)(v + i));
+		__m256i lo = _mm256_unpacklo_epi8(vu, vv);
+		__m256i hi = _mm256_unpackhi_epi8(vu, vv);
+
+		_mm256_storeu_si256((__m256i *)(uv + 2 * i), _mm256_permute2x128_si256(lo, hi, 0x20));
+		_mm256_storeu_si256((__m256i *)(uv + 2 * i + 32), _mm256_permute2x128_si256(lo, hi, 0x31));
+	}
+
+	image_convert_scalar_merge_uv(u + i, v + i, uv + 2 * i, count - i);
+}
+
+static TARGET_AVX2 __m256i __avx2_channel(__m256i a, __m256i b, int shift)
+{
+	const __m256i mask = _mm256_set1_epi32(0xFF);
+
+	return _mm256_packs_epi32(_mm256_and_si256(_mm256_srli_epi32(a, shift), mask),
+		_mm256_and_si256(_mm256_srli_epi32(b, shift), mask));
+}
+
+static TARGET_AVX2 void __avx2_rgba_to_y(const unsigned char *src, unsigned char *y, unsigned int count)
+{
+	unsigned int i = 0;
+
+	for (; i + 16 <= count; i += 16) {
+		__m256i a = _mm256_loadu_si256((const __m256i *)(src + 4 * i));
+		__m256i b = _mm256_loadu_si256((const __m256i *)(src + 4 * i + 32));
+		__m256i vy = _mm256_mullo_epi16(__avx2_channel(a, b, 0), _mm256_set1_epi16(66));
+
+		vy = _mm256_add_epi16(vy, _mm256_mullo_epi16(__avx2_channel(a, b, 8), _mm256_set1_epi16(129)));
+		vy = _mm256_add_epi16(vy, _mm256_mullo_epi16(__avx2_channel(a, b, 16), _mm256_set1_epi16(25)));
+		vy = _mm256_add_epi16(vy, _mm256_set1_epi16(128));
+		vy = _mm256_add_epi16(_mm256_srli_epi16(vy, 8), _mm256_set1_epi16(16));
+
+		vy = _mm256_permute4x64_epi64(vy, 0xD8);
+		vy = _mm256_permute4x64_epi64(_mm256_packus_epi16(vy, vy), 0xD8);
+		_mm_storeu_si128((__m128i *)(y + i), _mm256_castsi256_si128(vy));
+	}
+
+	image_convert_scalar_rgba_to_y(src + 4 * i, y + i, count - i);
+}
+
+static TARGET_AVX2 __m256i __avx2_pair_sum(__m256i v)
+{
+	return _mm256_add_epi16(_mm256_and_si256(v, _mm256_set1_epi16(0x00FF)), _mm256_srli_epi16(v, 8));
+}
+
+static TARGET_AVX2 void __avx2_downscale_2x(const unsigned char *row0, const unsigned char *row1,
+	unsigned char *dst, unsigned int count)
+{
+	const __m256i round = _mm256_set1_epi16(2);
+	unsigned int i = 0;
+
+	for (; i + 32 <= count; i += 32) {
+		__m256i lo = _mm256_add_epi16(__avx2_pair_sum(_mm256_loadu_si256((const __m256i *)(row0 + 2 * i))),
+			__avx2_pair_sum(_mm256_loadu_si256((const __m256i *)(row1 + 2 * i))));
+		__m256i hi = _mm256_add_epi16(__avx2_pair_sum(_mm256_loadu_si256((const __m256i *)(row0 + 2 * i + 32))),
+			__avx2_pair_sum(_mm256_loadu_si256((const __m256i *)(row1 + 2 * i + 32))));
+
+		lo = _mm256_srli_epi16(_mm256_add_epi16(lo, round), 2);
+		hi = _mm256_srli_epi16(_mm256_add_epi16(hi, round), 2);
+		_mm256_storeu_si256((__m256i *)(dst + i),
+			_mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), 0xD8));
+	}
+
+	image_convert_scalar_downscale_2x(row0 + 2 * i, row1 + 2 * i, dst + i, count - i);
+}
+
+static TARGET_AVX2 void __avx2_update_background(const unsigned char *cur, short *mean, short *dev,
+	unsigned char *mask, unsigned int count, short min_diff)
+{
+	const __m256i limit_min = _mm256_set1_epi16(min_diff);
+	unsigned int i = 0;
+
+	for (; i + 16 <= count; i += 16) {
+		__m256i c = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(cur + i)));
+		__m256i m = _mm256_loadu_si256((const __m256i *)(mean + i));
+		__m256i d = _mm256_loadu_si256((const __m256i *)(dev + i));
+		__m256i diff = _mm256_sub_epi16(_mm256_slli_epi16(c, MOTION_MODEL_FRAC_BITS), m);
+		__m256i abs_diff = _mm256_abs_epi16(diff);
+		/* 3 dev saturates at SHRT_MAX like the scalar clamp */
+		__m256i limit = _mm256_max_epi16(_mm256_adds_epi16(d, _mm256_adds_epi16(d, d)), limit_min);
+		__m256i fg = _mm256_cmpgt_epi16(abs_diff, limit);
+		__m256i step = _mm256_blendv_epi8(_mm256_srai_epi16(diff, MOTION_MODEL_RATE_SHIFT),
+			_mm256_srai_epi16(diff, MOTION_MODEL_FOREGROUND_RATE_SHIFT), fg);
+
+		d = _mm256_add_epi16(d, _mm256_andnot_si256(fg, _mm256_srai_epi16(_mm256_sub_epi16(abs_diff, d), MOTION_MODEL_RATE_SHIFT)));
+		_mm256_storeu_si256((__m256i *)(mean + i), _mm256_add_epi16(m, step));
+		_mm256_storeu_si256((__m256i *)(dev + i), d);
+		_mm_storeu_si128((__m128i *)(mask + i),
+			_mm256_castsi256_si128(_mm256_permute4x64_epi64(_mm256_packs_epi16(fg, fg), 0xD8)));
+	}
+
+	image_convert_scalar_update_background(cur + i, mean + i, dev + i, mask + i, count - i, min_diff);
+}
+
+static TARGET_AVX2 __m256i __avx2_column(const unsigned char *r0, const unsigned char *r1,
+	const unsigned char *r2, unsigned int i, bool dilate)
+{
+	__m256i a = _mm256_loadu_si256((const __m256i *)(r0 + i));
+	__m256i b = _mm256_loadu_si256((const __m256i *)(r1 + i));
+	__m256i c = _mm256_loadu_si256((const __m256i *)(r2 + i));
+
+	if (dilate)
+		return _mm256_max_epu8(_mm256_max_epu8(a, b), c);
+	return _mm256_min_epu8(_mm256_min_epu8(a, b), c);
+}
+
+static TARGET_AVX2 void __avx2_morph_3x3(const unsigned char *r0, const unsigned char *r1,
+	const unsigned char *r2, unsigned char *dst, unsigned int count, bool dilate)
+{
+	unsigned int i = 1;
+
+	if (count < 34) {
+		image_convert_scalar_morph_3x3(r0, r1, r2, dst, 0, count, count, dilate);
+		return;
+	}
+
+	/* column 0 has no left neighbour */
+	image_convert_scalar_morph_3x3(r0, r1, r2, dst, 0, 1, count, dilate);
+
+	for (; i + 33 <= count; i += 32) {
+		__m256i left = __avx2_column(r0, r1, r2, i - 1, dilate);
+		__m256i center = __avx2_column(r0, r1, r2, i, dilate);
+		__m256i right = __avx2_column(r0, r1, r2, i + 1, dilate);
+		__m256i v;
+
+		if (dilate)
+			v = _mm256_max_epu8(_mm256_max_epu8(left, center), right);
+		else
+			v = _mm256_min_epu8(_mm256_min_epu8(left, center), right);
+		_mm256_storeu_si256((__m256i *)(dst + i), v);
+	}
+
+	image_convert_scalar_morph_3x3(r0, r1, r2, dst, i, count, count, dilate);
+}
+
+static TARGET_AVX2 void __avx2_erode_3x3(const unsigned char *r0, const unsigned char *r1,
+	const unsigned char *r2, unsigned char *dst, unsigned int count)
+{
+	__avx2_morph_3x3(r0, r1, r2, dst, count, false);
+}
+
+static TARGET_AVX2 void __avx2_dilate_3x3(const unsigned char *r0, const unsigned char *r1,
+	const unsigned char *r2, unsigned char *dst, unsigned int count)
+{
+	__avx2_morph_3x3(r0, r1, r2, dst, count, true);
+}
+
+static TARGET_AVX2 void __avx2_sum_blocks(const unsigned char *src, unsigned int *sums, unsigned int count)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	unsigned int i = 0;
+
+	/* two blocks a load, each lane holds one of them */
+	for (; i + 2 <= count; i += 2) {
+		__m256i sad = _mm256_sad_epu8(_mm256_loadu_si256((const __m256i *)(src + 16 * i)), zero);
+		__m128i lo = _mm256_castsi256_si128(sad);
+		__m128i hi = _mm256_extracti128_si256(sad, 1);
+
+		sums[i] += _mm_cvtsi128_si32(_mm_add_epi32(lo, _mm_unpackhi_epi64(lo, lo)));
+		sums[i + 1] += _mm_cvtsi128_si32(_mm_add_epi32(hi, _mm_unpackhi_epi64(hi, hi)));
+	}
+
+	image_convert_scalar_sum_blocks(src + 16 * i, sums + i, count - i);
+}
+
+const image_convert_kernels_s image_convert_avx2_kernels = {
+	.name = "avx2",
+	.extract_bytes = __avx2_extract_bytes,
+	.average_rows = __avx2_average_rows,
+	.split_uv = __avx2_split_uv,
+	.merge_uv = __avx2_merge_uv,
+	.rgba_to_y = __avx2_rgba_to_y,
+	.downscale_2x = __avx2_downscale_2x,
+	.update_background = __avx2_update_background,
+	.erode_3x3 = __avx2_erode_3x3,
+	.dilate_3x3 = __avx2_dilate_3x3,
+	.sum_blocks = __avx2_sum_blocks,
+};
+
+#endif /* IMAGE_CONVERT_X86 */
@@ -0,0 +1,252 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "log.h"
+#include "image_frame.h"
+
+unsigned int image_frame_get_plane_count(camera_pixel_format_e format)
+{
+	switch (format) {
+	case CAMERA_PIXEL_FORMAT_NV12:
+	case CAMERA_PIXEL_FORMAT_NV12T:
+	case CAMERA_PIXEL_FORMAT_NV16:
+	case CAMERA_PIXEL_FORMAT_NV21:
+		return 2;
+	case CAMERA_PIXEL_FORMAT_422P:
+	case CAMERA_PIXEL_FORMAT_I420:
+	case CAMERA_PIXEL_FORMAT_YV12:
+		return 3;
+	default:
+		return 1;
+	}
+}
+
+int image_frame_get_plane_geometry(camera_pixel_format_e format,
+	unsigned int width, unsigned int height, unsigned int index,
+	unsigned int *row_bytes, unsigned int *rows)
+{
+	unsigned int bytes = 0;
+	unsigned int lines = 0;
+
+	retv_if(!row_bytes, -1);
+	retv_if(!rows, -1);
+	retv_if(index >= image_frame_get_plane_count(format), -1);
+
+	switch (format) {
+	case CAMERA_PIXEL_FORMAT_NV12:
+	case CAMERA_PIXEL_FORMAT_NV12T:
+	case CAMERA_PIXEL_FORMAT_NV21:
+		/* a UV pair per two pixels, rounded up on odd widths */
+		bytes = index ? 2 * ((width + 1) / 2) : width;
+		lines = index ? (height + 1) / 2 : height;
+		break;
+	case CAMERA_PIXEL_FORMAT_NV16:
+		bytes = index ? 2 * ((width + 1) / 2) : width;
+		lines = height;
+		break;
+	case CAMERA_PIXEL_FORMAT_I420:
+	case CAMERA_PIXEL_FORMAT_YV12:
+		bytes = index ? (width + 1) / 2 : width;
+		lines = index ? (height + 1) / 2 : height;
+		break;
+	case CAMERA_PIXEL_FORMAT_422P:
+		bytes = index ? (width + 1) / 2 : width;
+		lines = height;
+		break;
+	case CAMERA_PIXEL_FORMAT_YUYV:
+	case CAMERA_PIXEL_FORMAT_UYVY:
+	case CAMERA_PIXEL_FORMAT_RGB565:
+		bytes = width * 2;
+		lines = height;
+		break;
+	case CAMERA_PIXEL_FORMAT_RGB888:
+		bytes = width * 3;
+		lines = height;
+		break;
+	case CAMERA_PIXEL_FORMAT_RGBA:
+	case CAMERA_PIXEL_FORMAT_ARGB:
+		bytes = width * 4;
+		lines = height;
+		break;
+	default:
+		_E("unsupported format : %d", format);
+		return -1;
+	}
+
+	*row_bytes = bytes;
+	*rows = lines;
+
+	return 0;
+}
+
+int image_frame_view_init(image_frame_view_s *view, camera_pixel_format_e format,
+	unsigned int width, unsigned int height, unsigned char *base,
+	unsigned int num_planes, const unsigned int offsets[], const unsigned int plane_sizes[],
+	const unsigned int strides[])
+{
+	unsigned int count = 0;
+	unsigned int offset = 0;
+	unsigned int i = 0;
+
+	retv_if(!view, -1);
+	retv_if(!base, -1);
+	retv_if(num_planes == 0 || num_planes > IMAGE_PLANE_MAX, -1);
+	retv_if(width == 0 || height == 0, -1);
+
+	memset(view, 0, sizeof(image_frame_view_s));
+	view->format = format;
+	view->width = width;
+	view->height = height;
+
+	count = image_frame_get_plane_count(format);
+	if (num_planes != count && num_planes != 1) {
+		_E("format %d can not have %u planes", format, num_planes);
+		return -1;
+	}
+
+	offset = offsets[0];
+	for (i = 0; i < count; i++) {
+		image_plane_s *plane = &view->planes[i];
+		unsigned int row_bytes = 0;
+		unsigned int rows = 0;
+
+		if (image_frame_get_plane_geometry(format, width, height, i, &row_bytes, &rows))
+			return -1;
+
+		if (num_planes == count)
+			offset = offsets[i];
+
+		plane->offset = offset;
+		plane->data = base + offset;
+		plane->width = row_bytes;
+		plane->height = rows;
+		plane->stride = row_bytes;
+
+		if (num_planes == count && strides && strides[i]) {
+			retvm_if(strides[i] < row_bytes, -1, "plane[%u] stride %u is below its %u bytes",
+				i, strides[i], row_bytes);
+			plane->stride = strides[i];
+		} else if (num_planes == count && plane_sizes[i] % rows == 0 && plane_sizes[i] / rows > row_bytes) {
+			/* Padded rows, anything else is padding at the end of the plane */
+			plane->stride = plane_sizes[i] / rows;
+		}
+
+		retvm_if(num_planes == count && plane_sizes[i] < plane->stride * (rows - 1) + row_bytes, -1,
+			"plane[%u] is too small : %u", i, plane_sizes[i]);
+
+		offset += plane->stride * rows;
+	}
+
+	retvm_if(num_planes == 1 && plane_sizes[0] < offset - offsets[0], -1,
+		"frame is too small : %u", plane_sizes[0]);
+
+	view->num_planes = count;
+
+	return 0;
+}
+
+bool image_frame_view_is_packed(const image_frame_view_s *view)
+{
+	unsigned int i = 0;
+
+	retv_if(!view, false);
+
+	for (i = 0; i < view->num_planes; i++) {
+		const image_plane_s *plane = &view->planes[i];
+
+		if (plane->stride != plane->width)
+			return false;
+
+		if (i > 0) {
+			const image_plane_s *prev = &view->planes[i - 1];
+			if (plane->data != prev->data + prev->width * prev->height)
+				return false;
+		}
+	}
+
+	return true;
+}
+
+unsigned int image_frame_view_get_packed_size(const image_frame_view_s *view)
+{
+	unsigned int size = 0;
+	unsigned int i = 0;
+
+	retv_if(!view, 0);
+
+	for (i = 0; i < view->num_planes; i++)
+		size += view->planes[i].width * view->planes[i].height;
+
+	return size;
+}
+
+int image_frame_view_pack(const image_frame_view_s *view, unsigned char *dst, unsigned int dst_size)
+{
+	unsigned int i = 0;
+	unsigned int y = 0;
+
+	retv_if(!view, -1);
+	retv_if(!dst, -1);
+	retv_if(dst_size < image_frame_view_get_packed_size(view), -1);
+
+	for (i = 0; i < view->num_planes; i++) {
+		const image_plane_s *plane = &view->planes[i];
+
+		if (plane->stride == plane->width) {
+			memcpy(dst, plane->data, plane->width * plane->height);
+			dst += plane->width * plane->height;
+			continue;
+		}
+
+		for (y = 0; y < plane->height; y++) {
+			memcpy(dst, plane->data + plane->stride * y, plane->width);
+			dst += plane->width;
+		}
+	}
+
+	return 0;
+}
+
+const unsigned char *image_frame_view_get_packed(const image_frame_view_s *view,
+	unsigned char **scratch, unsigned int *scratch_size)
+{
+	unsigned int size = 0;
+
+	retv_if(!view, NULL);
+	retv_if(view->num_planes == 0, NULL);
+
+	if (image_frame_view_is_packed(view))
+		return view->planes[0].data;
+
+	retv_if(!scratch, NULL);
+	retv_if(!scratch_size, NULL);
+
+	size = image_frame_view_get_packed_size(view);
+	if (*scratch_size < size) {
+		unsigned char *buffer = realloc(*scratch, size);
+		retvm_if(!buffer, NULL, "Failed to allocate packing buffer");
+		*scratch = buffer;
+		*scratch_size = size;
+	}
+
+	if (image_frame_view_pack(view, *scratch, *scratch_size))
+		return NULL;
+
+	return *scratch;
+}
@@ -0,0 +1,274 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // O_TMPFILE
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#include "log.h"
+#include "image_publish.h"
+
+#define IMAGE_PUBLISH_IOV_MAX 8
+#define IMAGE_PUBLISH_PATH_MAX 256
+
+struct __image_publish_s {
+	int dir_fd;
+	char *dir;
+	char *name;
+	char *temp_name;
+	image_publish_sync_e sync;
+	bool tmpfile; // cleared when the file system has no O_TMPFILE
+
+	pthread_mutex_t mutex; // stats only
+	image_publish_stats_s stats;
+	unsigned long long int total_usec;
+};
+
+static unsigned long long int __get_usec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+image_publish_h image_publish_create(const char *dir, const char *name, const char *temp_name,
+	image_publish_sync_e sync)
+{
+	struct __image_publish_s *publish = NULL;
+
+	retv_if(!dir, NULL);
+	retv_if(!name, NULL);
+	retv_if(!temp_name, NULL);
+
+	publish = calloc(1, sizeof(struct __image_publish_s));
+	retvm_if(!publish, NULL, "Failed to allocate image publish");
+
+	publish->dir_fd = open(dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (publish->dir_fd < 0) {
+		_E("Failed to open [%s] : %s", dir, strerror(errno));
+		free(publish);
+		return NULL;
+	}
+
+	publish->dir = strdup(dir);
+	publish->name = strdup(name);
+	publish->temp_name = strdup(temp_name);
+	publish->sync = sync;
+	publish->tmpfile = true;
+	publish->stats.tmpfile = true;
+	pthread_mutex_init(&publish->mutex, NULL);
+
+	if (!publish->dir || !publish->name || !publish->temp_name) {
+		image_publish_destroy(publish);
+		return NULL;
+	}
+
+	return publish;
+}
+
+void image_publish_destroy(image_publish_h publish)
+{
+	ret_if(!publish);
+
+	close(publish->dir_fd);
+	pthread_mutex_destroy(&publish->mutex);
+	free(publish->dir);
+	free(publish->name);
+	free(publish->temp_name);
+	free(publish);
+}
+
+/* writev() until every byte is written */
+static int __write_all(int fd, const struct iovec *iov, int iov_count)
+{
+	struct iovec rest[IMAGE_PUBLISH_IOV_MAX];
+	struct iovec *current = rest;
+	ssize_t written = 0;
+
+	memcpy(rest, iov, iov_count * sizeof(struct iovec));
+
+	while (iov_count > 0) {
+		written = writev(fd, current, iov_count);
+		if (written < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+
+		while (iov_count > 0 && (size_t)written >= current->iov_len) {
+			written -= current->iov_len;
+			current++;
+			iov_count--;
+		}
+		if (iov_count > 0) {
+			current->iov_base = (char *)current->iov_base + written;
+			current->iov_len -= written;
+		}
+	}
+
+	return 0;
+}
+
+/* An unnamed file in the directory, or -1 where O_TMPFILE is not supported */
+static int __open_tmpfile(struct __image_publish_s *publish)
+{
+	int fd = -1;
+
+	if (!publish->tmpfile)
+		return -1;
+
+	fd = openat(publish->dir_fd, ".", O_TMPFILE | O_WRONLY | O_CLOEXEC, 0644);
+	if (fd < 0 && (errno == EOPNOTSUPP || errno == EISDIR || errno == EINVAL)) {
+		_W("No O_TMPFILE in [%s], write files as [%s]", publish->dir, publish->temp_name);
+		publish->tmpfile = false;
+	}
+
+	return fd;
+}
+
+/* Names the complete unnamed file as temp_name, so it can be renamed over name */
+static int __link_tmpfile(struct __image_publish_s *publish, int fd)
+{
+	char proc_path[IMAGE_PUBLISH_PATH_MAX];
+
+	snprintf(proc_path, sizeof(proc_path), "/proc/self/fd/%d", fd);
+
+	/* left over from a writer that stopped in between */
+	if (unlinkat(publish->dir_fd, publish->temp_name, 0) && errno != ENOENT)
+		return -1;
+
+	return linkat(AT_FDCWD, proc_path, publish->dir_fd, publish->temp_name, AT_SYMLINK_FOLLOW);
+}
+
+int image_publish_write(image_publish_h publish, const struct iovec *iov, int iov_count)
+{
+	unsigned long long int start = __get_usec();
+	unsigned long long int bytes = 0;
+	unsigned int elapsed = 0;
+	bool tmpfile = false;
+	int fd = -1;
+	int i = 0;
+
+	retv_if(!publish, -1);
+	retv_if(!iov, -1);
+	retv_if(iov_count < 1 || iov_count > IMAGE_PUBLISH_IOV_MAX, -1);
+
+	for (i = 0; i < iov_count; i++)
+		bytes += iov[i].iov_len;
+
+	fd = __open_tmpfile(publish);
+	tmpfile = fd >= 0;
+	if (!tmpfile) {
+		fd = openat(publish->dir_fd, publish->temp_name, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+		goto_if(fd < 0, ERROR);
+	}
+
+	goto_if(__write_all(fd, iov, iov_count), ERROR);
+
+	if (publish->sync != IMAGE_PUBLISH_SYNC_NONE)
+		goto_if(fdatasync(fd), ERROR);
+
+	if (tmpfile)
+		goto_if(__link_tmpfile(publish, fd), ERROR);
+
+	goto_if(renameat(publish->dir_fd, publish->temp_name, publish->dir_fd, publish->name), ERROR);
+
+	/* the rename itself is only durable with the directory */
+	if (publish->sync == IMAGE_PUBLISH_SYNC_FULL)
+		goto_if(fsync(publish->dir_fd), ERROR);
+
+	close(fd);
+
+	elapsed = __get_usec() - start;
+
+	pthread_mutex_lock(&publish->mutex);
+	publish->stats.published++;
+	publish->stats.bytes += bytes;
+	publish->total_usec += elapsed;
+	publish->stats.average_usec = publish->total_usec / publish->stats.published;
+	if (elapsed > publish->stats.max_usec)
+		publish->stats.max_usec = elapsed;
+	publish->stats.tmpfile = publish->tmpfile;
+	pthread_mutex_unlock(&publish->mutex);
+
+	return 0;
+
+ERROR:
+	_E("Failed to publish [%s/%s] : %s", publish->dir, publish->name, strerror(errno));
+	if (fd >= 0)
+		close(fd);
+	if (!tmpfile)
+		unlinkat(publish->dir_fd, publish->temp_name, 0);
+
+	pthread_mutex_lock(&publish->mutex);
+	publish->stats.failed++;
+	pthread_mutex_unlock(&publish->mutex);
+
+	return -1;
+}
+
+int image_publish_link(image_publish_h publish, const char *link_path)
+{
+	char target[IMAGE_PUBLISH_PATH_MAX];
+	char current[IMAGE_PUBLISH_PATH_MAX];
+	ssize_t length = 0;
+
+	retv_if(!publish, -1);
+	retv_if(!link_path, -1);
+
+	snprintf(target, sizeof(target), "%s/%s", publish->dir, publish->name);
+
+	length = readlink(link_path, current, sizeof(current) - 1);
+	if (length >= 0) {
+		current[length] = '\0';
+		if (!strcmp(current, target))
+			return 0;
+	}
+
+	/* a file left from publishing in place, or a link elsewhere */
+	if (unlink(link_path) && errno != ENOENT) {
+		_E("Failed to remove [%s] : %s", link_path, strerror(errno));
+		return -1;
+	}
+
+	if (symlink(target, link_path)) {
+		_E("Failed to link [%s] to [%s] : %s", link_path, target, strerror(errno));
+		return -1;
+	}
+
+	return 0;
+}
+
+void image_publish_get_stats(image_publish_h publish, image_publish_stats_s *stats)
+{
+	ret_if(!publish);
+	ret_if(!stats);
+
+	pthread_mutex_lock(&publish->mutex);
+	*stats = publish->stats;
+	pthread_mutex_unlock(&publish->mutex);
+}
@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "log.h"
+#include "image_pyramid.h"
+#include "image_convert.h"
+#include "image_convert_internal.h"
+
+#define PYRAMID_LEVEL_SIZE_MIN 8
+
+static bool __has_luma_plane(camera_pixel_format_e format)
+{
+	switch (format) {
+	case CAMERA_PIXEL_FORMAT_NV12:
+	case CAMERA_PIXEL_FORMAT_NV21:
+	case CAMERA_PIXEL_FORMAT_I420:
+	case CAMERA_PIXEL_FORMAT_YV12:
+	case CAMERA_PIXEL_FORMAT_422P:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static int __reserve(image_pyramid_s *pyramid, unsigned int size)
+{
+	unsigned char *buffer = NULL;
+
+	if (pyramid->buffer_size >= size)
+		return 0;
+
+	buffer = realloc(pyramid->buffer, size);
+	retvm_if(!buffer, -1, "Failed to allocate %u bytes", size);
+
+	pyramid->buffer = buffer;
+	pyramid->buffer_size = size;
+
+	return 0;
+}
+
+int image_pyramid_build(image_pyramid_s *pyramid, const image_frame_view_s *view, unsigned int top_level)
+{
+	const image_convert_kernels_s *k = image_convert_get_kernels();
+	bool has_luma = false;
+	unsigned int size = 0;
+	unsigned int levels = 0;
+	unsigned int offset = 0;
+	unsigned int row = 0;
+	unsigned int i = 0;
+	image_luma_s *l0, *l1, *l2;
+
+	retv_if(!pyramid, -1);
+	retv_if(!view, -1);
+
+	if (top_level > IMAGE_PYRAMID_LEVEL_MAX)
+		top_level = IMAGE_PYRAMID_LEVEL_MAX;
+
+	/* Do not go below a useful size */
+	while (top_level && ((view->width >> top_level) < PYRAMID_LEVEL_SIZE_MIN
+		|| (view->height >> top_level) < PYRAMID_LEVEL_SIZE_MIN))
+		top_level--;
+	levels = top_level + 1;
+
+	has_luma = __has_luma_plane(view->format);
+	if (!has_luma)
+		size += view->width * view->height;
+	for (i = 1; i < levels; i++)
+		size += (view->width >> i) * (view->height >> i);
+
+	if (size && __reserve(pyramid, size))
+		return -1;
+
+	l0 = &pyramid->level[0];
+	if (has_luma) {
+		l0->data = view->planes[0].data;
+		l0->stride = view->planes[0].stride;
+	} else {
+		if (image_convert_frame(view, IMAGE_CONVERT_LUMA, pyramid->buffer, pyramid->buffer_size))
+			return -1;
+		l0->data = pyramid->buffer;
+		l0->stride = view->width;
+		offset = view->width * view->height;
+	}
+	l0->width = view->width;
+	l0->height = view->height;
+
+	for (i = 1; i < levels; i++) {
+		image_luma_s *level = &pyramid->level[i];
+
+		level->width = view->width >> i;
+		level->height = view->height >> i;
+		level->stride = level->width;
+		level->data = pyramid->buffer + offset;
+		offset += level->width * level->height;
+	}
+	pyramid->levels = levels;
+
+	if (levels < 2)
+		return 0;
+
+	/* Each level 2 row is made as soon as its two level 1 rows exist,
+	 * while they are still in cache */
+	l1 = &pyramid->level[1];
+	l2 = levels > 2 ? &pyramid->level[2] : NULL;
+
+	for (row = 0; row < l1->height; row++) {
+		unsigned char *dst = (unsigned char *)l1->data + row * l1->stride;
+
+		k->downscale_2x(l0->data + (size_t)(2 * row) * l0->stride,
+			l0->data + (size_t)(2 * row + 1) * l0->stride, dst, l1->width);
+
+		if (l2 && (row & 1) && row / 2 < l2->height)
+			k->downscale_2x(dst - l1->stride, dst,
+				(unsigned char *)l2->data + (row / 2) * l2->stride, l2->width);
+	}
+
+	return 0;
+}
+
+void image_pyramid_release(image_pyramid_s *pyramid)
+{
+	ret_if(!pyramid);
+
+	free(pyramid->buffer);
+	memset(pyramid, 0, sizeof(image_pyramid_s));
+}
@@ -0,0 +1,305 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "log.h"
+#include "jpeg_ring.h"
+
+#define JPEG_RING_READ_TRIES 3
+
+struct __jpeg_ring_s {
+	int fd;
+	unsigned char *map;
+	size_t map_size;
+	jpeg_ring_header_s *header;
+	unsigned int sequence; // of the last written frame, the writer is a single thread
+	unsigned long long int written;
+	unsigned long long int skipped;
+};
+
+struct __jpeg_ring_reader_s {
+	int fd;
+	unsigned char *map;
+	size_t map_size;
+	jpeg_ring_header_s *header;
+};
+
+static inline jpeg_ring_slot_s *__get_slot(unsigned char *map, const jpeg_ring_header_s *header,
+	unsigned int sequence)
+{
+	return (jpeg_ring_slot_s *)(map + sizeof(jpeg_ring_header_s)
+		+ (size_t)((sequence - 1) % header->slot_count) * header->slot_size);
+}
+
+jpeg_ring_h jpeg_ring_create(const char *path, unsigned int slot_count, unsigned int slot_size)
+{
+	struct __jpeg_ring_s *ring = NULL;
+
+	retv_if(!path, NULL);
+	retv_if(!slot_count, NULL);
+	retvm_if(slot_size <= sizeof(jpeg_ring_slot_s), NULL, "Slot size %u is too small", slot_size);
+
+	ring = calloc(1, sizeof(struct __jpeg_ring_s));
+	retvm_if(!ring, NULL, "Failed to allocate jpeg ring");
+	ring->fd = -1;
+
+	/* slot data starts at a word boundary */
+	slot_size = (slot_size + 7) & ~7U;
+	ring->map_size = sizeof(jpeg_ring_header_s) + (size_t)slot_count * slot_size;
+
+	/* readers still mapping a previous ring keep it, they see it closed */
+	unlink(path);
+	ring->fd = open(path, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+	goto_if(ring->fd < 0, ERROR);
+
+	if (ftruncate(ring->fd, ring->map_size) < 0) {
+		_E("Failed to size %s to %zu", path, ring->map_size);
+		goto ERROR;
+	}
+
+	ring->map = mmap(NULL, ring->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, ring->fd, 0);
+	if (ring->map == MAP_FAILED) {
+		ring->map = NULL;
+		_E("Failed to map %s", path);
+		goto ERROR;
+	}
+
+	ring->header = (jpeg_ring_header_s *)ring->map;
+	ring->header->version = JPEG_RING_VERSION;
+	ring->header->slot_count = slot_count;
+	ring->header->slot_size = slot_size;
+	ring->header->open = 1;
+	/* the magic tells readers the header is complete */
+	__atomic_store_n(&ring->header->magic, JPEG_RING_MAGIC, __ATOMIC_RELEASE);
+
+	_I("Jpeg ring %s : %u slots of %u bytes", path, slot_count, slot_size);
+
+	return ring;
+
+ERROR:
+	if (ring->fd >= 0) {
+		close(ring->fd);
+		unlink(path);
+	} else {
+		_E("Failed to create %s", path);
+	}
+	free(ring);
+	return NULL;
+}
+
+void jpeg_ring_destroy(jpeg_ring_h ring)
+{
+	ret_if(!ring);
+
+	if (ring->header)
+		__atomic_store_n(&ring->header->open, 0, __ATOMIC_RELEASE);
+	if (ring->map)
+		munmap(ring->map, ring->map_size);
+	if (ring->fd >= 0)
+		close(ring->fd);
+	free(ring);
+}
+
+int jpeg_ring_write(jpeg_ring_h ring, const unsigned char *jpeg, unsigned int size,
+	unsigned int width, unsigned int height, const unsigned char *meta, unsigned int meta_size)
+{
+	jpeg_ring_slot_s *slot = NULL;
+	unsigned int sequence = 0;
+	unsigned int lock = 0;
+	struct timespec ts;
+
+	retv_if(!ring, -1);
+	retv_if(!jpeg, -1);
+
+	if (size > ring->header->slot_size - sizeof(jpeg_ring_slot_s)) {
+		ring->skipped++;
+		return -1;
+	}
+
+	if (!meta)
+		meta_size = 0;
+	else if (meta_size > JPEG_RING_META_MAX)
+		meta_size = JPEG_RING_META_MAX;
+
+	/* 0 means no frame in head, skip it when wrapping */
+	sequence = ring->sequence + 1;
+	if (!sequence)
+		sequence = 1;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+
+	slot = __get_slot(ring->map, ring->header, sequence);
+	lock = slot->lock;
+	__atomic_store_n(&slot->lock, lock + 1, __ATOMIC_RELAXED);
+	/* readers seeing any of the writes below also see the odd lock */
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	slot->sequence = sequence;
+	slot->timestamp_sec = ts.tv_sec;
+	slot->timestamp_msec = ts.tv_nsec / 1000000;
+	slot->width = width;
+	slot->height = height;
+	slot->size = size;
+	slot->meta_size = meta_size;
+	if (meta_size)
+		memcpy(slot->meta, meta, meta_size);
+	memcpy((unsigned char *)slot + sizeof(jpeg_ring_slot_s), jpeg, size);
+
+	__atomic_store_n(&slot->lock, lock + 2, __ATOMIC_RELEASE);
+	__atomic_store_n(&ring->header->head, sequence, __ATOMIC_RELEASE);
+
+	ring->sequence = sequence;
+	ring->written++;
+
+	return 0;
+}
+
+void jpeg_ring_get_stats(jpeg_ring_h ring, jpeg_ring_stats_s *stats)
+{
+	ret_if(!ring);
+	ret_if(!stats);
+
+	stats->written = ring->written;
+	stats->skipped = ring->skipped;
+	stats->head = ring->sequence;
+}
+
+jpeg_ring_reader_h jpeg_ring_reader_open(const char *path)
+{
+	struct __jpeg_ring_reader_s *reader = NULL;
+	jpeg_ring_header_s header;
+	struct stat st;
+
+	retv_if(!path, NULL);
+
+	reader = calloc(1, sizeof(struct __jpeg_ring_reader_s));
+	retvm_if(!reader, NULL, "Failed to allocate jpeg ring reader");
+
+	reader->fd = open(path, O_RDONLY | O_CLOEXEC);
+	goto_if(reader->fd < 0, ERROR);
+
+	goto_if(fstat(reader->fd, &st) < 0, ERROR);
+	goto_if(st.st_size < (off_t)sizeof(jpeg_ring_header_s), ERROR);
+	goto_if(pread(reader->fd, &header, sizeof(header), 0) != sizeof(header), ERROR);
+
+	goto_if(header.magic != JPEG_RING_MAGIC, ERROR);
+	if (header.version != JPEG_RING_VERSION) {
+		_E("Jpeg ring %s has version %u, not %u", path, header.version, JPEG_RING_VERSION);
+		goto ERROR;
+	}
+	goto_if(!header.open, ERROR);
+	goto_if(!header.slot_count, ERROR);
+	goto_if(header.slot_size <= sizeof(jpeg_ring_slot_s), ERROR);
+
+	reader->map_size = sizeof(jpeg_ring_header_s) + (size_t)header.slot_count * header.slot_size;
+	goto_if(st.st_size < (off_t)reader->map_size, ERROR);
+
+	reader->map = mmap(NULL, reader->map_size, PROT_READ, MAP_SHARED, reader->fd, 0);
+	if (reader->map == MAP_FAILED) {
+		reader->map = NULL;
+		_E("Failed to map %s", path);
+		goto ERROR;
+	}
+	reader->header = (jpeg_ring_header_s *)reader->map;
+
+	return reader;
+
+ERROR:
+	jpeg_ring_reader_close(reader);
+	return NULL;
+}
+
+void jpeg_ring_reader_close(jpeg_ring_reader_h reader)
+{
+	ret_if(!reader);
+
+	if (reader->map)
+		munmap(reader->map, reader->map_size);
+	if (reader->fd >= 0)
+		close(reader->fd);
+	free(reader);
+}
+
+int jpeg_ring_reader_read(jpeg_ring_reader_h reader, unsigned int last_sequence,
+	jpeg_ring_frame_s *frame, unsigned char *jpeg, unsigned int jpeg_size)
+{
+	const jpeg_ring_header_s *header = NULL;
+	const jpeg_ring_slot_s *slot = NULL;
+	unsigned int head = 0;
+	unsigned int lock = 0;
+	unsigned int size = 0;
+	unsigned int meta_size = 0;
+	int i = 0;
+
+	retv_if(!reader, -1);
+	retv_if(!frame, -1);
+	retv_if(!jpeg, -1);
+
+	header = reader->header;
+	retv_if(!__atomic_load_n(&header->open, __ATOMIC_ACQUIRE), -1);
+
+	for (i = 0; i < JPEG_RING_READ_TRIES; i++) {
+		head = __atomic_load_n(&header->head, __ATOMIC_ACQUIRE);
+		if (!head || head == last_sequence)
+			return 0;
+
+		slot = __get_slot(reader->map, header, head);
+		lock = __atomic_load_n(&slot->lock, __ATOMIC_ACQUIRE);
+		if (lock & 1)
+			continue;
+
+		/* the writer may change any of it from here, checked with lock below */
+		size = slot->size;
+		meta_size = slot->meta_size;
+		if (size > header->slot_size - sizeof(jpeg_ring_slot_s) || meta_size > JPEG_RING_META_MAX)
+			continue;
+
+		frame->sequence = slot->sequence;
+		frame->timestamp_sec = slot->timestamp_sec;
+		frame->timestamp_msec = slot->timestamp_msec;
+		frame->width = slot->width;
+		frame->height = slot->height;
+		frame->size = size;
+		frame->meta_size = meta_size;
+		memcpy(frame->meta, slot->meta, meta_size);
+		if (size <= jpeg_size)
+			memcpy(jpeg, (const unsigned char *)slot + sizeof(jpeg_ring_slot_s), size);
+
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if (__atomic_load_n(&slot->lock, __ATOMIC_RELAXED) != lock)
+			continue;
+
+		/* a wrapped writer may have put a newer frame there, still whole */
+		if (frame->sequence == last_sequence)
+			return 0;
+		if (size > jpeg_size) {
+			_E("Frame %u of %u bytes does not fit %u", frame->sequence, size, jpeg_size);
+			return -1;
+		}
+
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <stdlib.h>
+
+#include "log.h"
+#include "latest_slot.h"
+
+/*
+ * A stalled reader holds at most one entry, and the current item holds
+ * another, so this is how many readers can be in latest_slot_get() at once
+ */
+#define LATEST_SLOT_ENTRIES 16
+/* the reader count of an entry never wraps in the low 56 bits */
+#define CURRENT_INDEX_SHIFT 56
+#define CURRENT_READERS_MASK ((1ULL << CURRENT_INDEX_SHIFT) - 1)
+
+typedef struct __latest_entry_s {
+	void *item;
+	/*
+	 * Readers done with the entry count down, the producer adds how many
+	 * entered when it replaces the entry, and whoever brings it to 0 drops
+	 * the slot's reference to item
+	 */
+	long long pending;
+	int busy;
+} latest_entry_s;
+
+struct __latest_slot_s {
+	/* index of the current entry and the readers that entered it */
+	unsigned long long current;
+	latest_entry_s entries[LATEST_SLOT_ENTRIES];
+	latest_slot_ref_cb ref;
+	latest_slot_unref_cb unref;
+};
+
+latest_data_s *latest_data_new(void *data, unsigned long long size)
+{
+	latest_data_s *latest = NULL;
+
+	retv_if(!data, NULL);
+
+	latest = calloc(1, sizeof(latest_data_s));
+	if (!latest) {
+		_E("Failed to allocate latest data");
+		free(data);
+		return NULL;
+	}
+
+	latest->data = data;
+	latest->size = size;
+	latest->refcount = 1;
+
+	return latest;
+}
+
+latest_data_s *latest_data_ref(latest_data_s *latest)
+{
+	retv_if(!latest, NULL);
+
+	__atomic_add_fetch(&latest->refcount, 1, __ATOMIC_RELAXED);
+
+	return latest;
+}
+
+void latest_data_unref(latest_data_s *latest)
+{
+	ret_if(!latest);
+
+	if (__atomic_sub_fetch(&latest->refcount, 1, __ATOMIC_ACQ_REL))
+		return;
+
+	free(latest->data);
+	free(latest);
+}
+
+latest_slot_h latest_slot_create(latest_slot_ref_cb ref, latest_slot_unref_cb unref)
+{
+	struct __latest_slot_s *slot = NULL;
+
+	retv_if(!ref, NULL);
+	retv_if(!unref, NULL);
+
+	slot = calloc(1, sizeof(struct __latest_slot_s));
+	retvm_if(!slot, NULL, "Failed to allocate latest slot");
+
+	slot->ref = ref;
+	slot->unref = unref;
+	/* entry 0 is current and empty */
+	slot->entries[0].busy = 1;
+
+	return slot;
+}
+
+static void *__data_ref(void *item)
+{
+	return latest_data_ref(item);
+}
+
+static void __data_unref(void *item)
+{
+	latest_data_unref(item);
+}
+
+latest_slot_h latest_slot_create_data(void)
+{
+	return latest_slot_create(__data_ref, __data_unref);
+}
+
+static void __entry_release(latest_slot_h slot, latest_entry_s *entry, long long count)
+{
+	if (__atomic_add_fetch(&entry->pending, count, __ATOMIC_ACQ_REL))
+		return;
+
+	if (entry->item)
+		slot->unref(entry->item);
+	__atomic_store_n(&entry->busy, 0, __ATOMIC_RELEASE);
+}
+
+void latest_slot_destroy(latest_slot_h slot)
+{
+	latest_entry_s *entry = NULL;
+
+	ret_if(!slot);
+
+	entry = &slot->entries[slot->current >> CURRENT_INDEX_SHIFT];
+	if (entry->item)
+		slot->unref(entry->item);
+	free(slot);
+}
+
+void latest_slot_publish(latest_slot_h slot, void *item)
+{
+	unsigned long long old = 0;
+	unsigned int current = 0;
+	unsigned int index = 0;
+	latest_entry_s *entry = NULL;
+
+	ret_if(!slot);
+
+	current = __atomic_load_n(&slot->current, __ATOMIC_RELAXED) >> CURRENT_INDEX_SHIFT;
+	for (index = 0; index < LATEST_SLOT_ENTRIES; index++) {
+		if (index != current && !__atomic_load_n(&slot->entries[index].busy, __ATOMIC_ACQUIRE))
+			break;
+	}
+	if (index == LATEST_SLOT_ENTRIES) {
+		_E("Latest slot has more than %d readers, item dropped", LATEST_SLOT_ENTRIES - 1);
+		if (item)
+			slot->unref(item);
+		return;
+	}
+
+	entry = &slot->entries[index];
+	entry->item = item;
+	entry->pending = 0;
+	entry->busy = 1;
+
+	/* Readers that entered the old entry are counted in the same swap */
+	old = __atomic_exchange_n(&slot->current,
+		(unsigned long long)index << CURRENT_INDEX_SHIFT, __ATOMIC_ACQ_REL);
+	__entry_release(slot, &slot->entries[old >> CURRENT_INDEX_SHIFT], (long long)(old & CURRENT_READERS_MASK));
+}
+
+void *latest_slot_get(latest_slot_h slot)
+{
+	unsigned long long current = 0;
+	latest_entry_s *entry = NULL;
+	void *item = NULL;
+
+	retv_if(!slot, NULL);
+
+	current = __atomic_add_fetch(&slot->current, 1, __ATOMIC_ACQUIRE);
+	entry = &slot->entries[current >> CURRENT_INDEX_SHIFT];
+	if (entry->item)
+		item = slot->ref(entry->item);
+	__entry_release(slot, entry, -1);
+
+	return item;
+}
@@ -0,0 +1,669 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "log.h"
+#include "motion_detector.h"
+#include "motion_mask.h"
+#include "worker_pool.h"
+#include "image_convert_internal.h"
+
+/* Foreground is grouped in 8x8 blocks before regions are made */
+#define BLOCK_SHIFT 3
+#define BLOCK_SIZE (1 << BLOCK_SHIFT)
+/* a block needs a quarter of its pixels in the foreground */
+#define BLOCK_FILL_MIN (BLOCK_SIZE * BLOCK_SIZE / 4)
+/* groups of blocks up to one block apart are one region */
+#define REGION_MERGE_GAP 1
+/* horizontal tiles a frame is split in, each a whole number of block rows */
+#define TILE_MAX WORKER_POOL_THREAD_MAX
+
+#define MODEL_FILE_MAGIC 0x4d444d42 // "MDMB"
+#define MODEL_FILE_VERSION 1
+#define MODEL_AGE_MAX (60 * 60)
+
+typedef struct __model_file_header_s {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t width;
+	uint32_t height;
+	int64_t saved_time;
+} model_file_header_s;
+
+typedef enum {
+	TILE_PHASE_SUBTRACT,
+	TILE_PHASE_ERODE,
+	TILE_PHASE_DILATE,
+	TILE_PHASE_CARRY,
+} tile_phase_e;
+
+struct __motion_detector_s {
+	short min_diff;
+	const image_convert_kernels_s *kernels;
+
+	unsigned int width;
+	unsigned int height;
+	bool has_background;
+	/* analysed spans, not owned, NULL for the whole frame */
+	motion_mask_h mask_spans;
+
+	/*
+	 * Model rows are 2 * width shorts, the means then the deviations of the
+	 * row, so one frame row reads and writes one contiguous span.
+	 */
+	short *model;
+	unsigned char *mask;
+	unsigned char *eroded;
+	/* (width + 1) x (height + 1), row and column 0 stay zero */
+	unsigned int *integral;
+
+	/* 1 for blocks with enough foreground, the mask regions are made of */
+	unsigned int blocks_width;
+	unsigned int blocks_height;
+	unsigned char *block_state;
+	region_extract_h extract;
+
+	/*
+	 * Tiles are rows tile_start[i] ~ tile_start[i + 1] - 1, run on the pool
+	 * one phase at a time, so a phase may read the rows of its neighbours
+	 * that the previous phase wrote.
+	 */
+	worker_pool_h pool;
+	unsigned int tile_count;
+	unsigned int tile_start[TILE_MAX + 1];
+	/* per tile, the integral row above it, (width + 1) each */
+	unsigned int *carry;
+
+	/* phase and frame of the current pool run */
+	tile_phase_e phase;
+	const image_luma_s *luma;
+
+	unsigned long long int frames;
+	unsigned long long int total_usec;
+	unsigned int max_usec;
+
+	/* one allocation reused while the size holds */
+	void *storage;
+};
+
+static void __split_tiles(struct __motion_detector_s *detector)
+{
+	unsigned int tiles = worker_pool_get_threads(detector->pool);
+	unsigned int blocks_per_tile = 0;
+	unsigned int i = 0;
+
+	if (tiles > TILE_MAX)
+		tiles = TILE_MAX;
+	if (tiles > detector->blocks_height)
+		tiles = detector->blocks_height;
+	if (!tiles)
+		tiles = 1;
+
+	/* tiles hold whole blocks, so no block is split between two of them */
+	blocks_per_tile = (detector->blocks_height + tiles - 1) / tiles;
+	tiles = (detector->blocks_height + blocks_per_tile - 1) / blocks_per_tile;
+	if (!tiles)
+		tiles = 1;
+
+	for (i = 0; i < tiles; i++)
+		detector->tile_start[i] = (i * blocks_per_tile) << BLOCK_SHIFT;
+	detector->tile_start[tiles] = detector->height;
+	detector->tile_count = tiles;
+}
+
+static int __resize(struct __motion_detector_s *detector, unsigned int width, unsigned int height)
+{
+	unsigned int pixels = width * height;
+	unsigned int integral_size = (width + 1) * (height + 1) * sizeof(unsigned int);
+	unsigned int blocks_width = (width + BLOCK_SIZE - 1) >> BLOCK_SHIFT;
+	unsigned int blocks_height = (height + BLOCK_SIZE - 1) >> BLOCK_SHIFT;
+	unsigned int blocks = blocks_width * blocks_height;
+	unsigned int carry_size = (width + 1) * TILE_MAX * sizeof(unsigned int);
+	unsigned char *storage = NULL;
+
+	/* widest types first, they need the alignment */
+	storage = calloc(1, integral_size + carry_size + 2 * pixels * sizeof(short) + blocks + 2 * pixels);
+	retvm_if(!storage, -1, "Failed to allocate detector buffers for %ux%u", width, height);
+
+	free(detector->storage);
+	detector->storage = storage;
+
+	detector->integral = (unsigned int *)storage;
+	storage += integral_size;
+	detector->carry = (unsigned int *)storage;
+	storage += carry_size;
+	detector->model = (short *)storage;
+	storage += 2 * pixels * sizeof(short);
+	detector->block_state = storage;
+	storage += blocks;
+	detector->mask = storage;
+	detector->eroded = detector->mask + pixels;
+
+	detector->width = width;
+	detector->height = height;
+	detector->blocks_width = blocks_width;
+	detector->blocks_height = blocks_height;
+	detector->has_background = false;
+	__split_tiles(detector);
+
+	_I("Motion detector at %ux%u, %ux%u blocks", width, height, blocks_width, blocks_height);
+
+	return 0;
+}
+
+static unsigned long long int __get_usec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+/* The first frame is the mean, deviations start at 0 so min_diff rules until they are learnt */
+static void __seed_background(struct __motion_detector_s *detector, const image_luma_s *luma)
+{
+	unsigned int width = detector->width;
+	unsigned int row = 0;
+	unsigned int x = 0;
+
+	for (row = 0; row < detector->height; row++) {
+		const unsigned char *cur = luma->data + row * luma->stride;
+		short *mean = detector->model + 2 * row * width;
+
+		for (x = 0; x < width; x++)
+			mean[x] = cur[x] << MOTION_MODEL_FRAC_BITS;
+		memset(mean + width, 0, width * sizeof(short));
+	}
+
+	detector->has_background = true;
+}
+
+static void __subtract_background(struct __motion_detector_s *detector, const image_luma_s *luma,
+	unsigned int from, unsigned int to)
+{
+	const image_convert_kernels_s *k = detector->kernels;
+	unsigned int width = detector->width;
+	unsigned int row = 0;
+	unsigned int i = 0;
+
+	for (row = from; row < to; row++) {
+		const unsigned char *cur = luma->data + row * luma->stride;
+		short *mean = detector->model + 2 * row * width;
+		unsigned char *mask = detector->mask + row * width;
+		const unsigned short *spans = NULL;
+		unsigned int count = 0;
+
+		if (!detector->mask_spans) {
+			k->update_background(cur, mean, mean + width, mask, width, detector->min_diff);
+			continue;
+		}
+
+		/* masked out pixels are never read, their mask bytes stay 0 */
+		count = motion_mask_get_spans(detector->mask_spans, row, &spans);
+		for (i = 0; i < count; i++) {
+			unsigned int start = spans[2 * i];
+			unsigned int length = spans[2 * i + 1] - start;
+
+			k->update_background(cur + start, mean + start, mean + width + start,
+				mask + start, length, detector->min_diff);
+		}
+	}
+}
+
+/*
+ * Opening (erode then dilate) drops noise pixels and thin edges but keeps
+ * blobs. Rows read one row on each side, so all rows must be eroded before
+ * any is dilated.
+ */
+static void __erode_mask(struct __motion_detector_s *detector, unsigned int from, unsigned int to)
+{
+	const image_convert_kernels_s *k = detector->kernels;
+	const unsigned char *src = detector->mask;
+	unsigned int width = detector->width;
+	unsigned int last = detector->height - 1;
+	unsigned int row = 0;
+
+	for (row = from; row < to; row++)
+		k->erode_3x3(src + (row ? row - 1 : 0) * width, src + row * width,
+			src + (row < last ? row + 1 : last) * width, detector->eroded + row * width, width);
+}
+
+static void __dilate_mask(struct __motion_detector_s *detector, unsigned int from, unsigned int to)
+{
+	const image_convert_kernels_s *k = detector->kernels;
+	const unsigned char *src = detector->eroded;
+	unsigned int width = detector->width;
+	unsigned int last = detector->height - 1;
+	unsigned int row = 0;
+
+	for (row = from; row < to; row++)
+		k->dilate_3x3(src + (row ? row - 1 : 0) * width, src + row * width,
+			src + (row < last ? row + 1 : last) * width, detector->mask + row * width, width);
+}
+
+/* The opening can grow foreground into masked out pixels, clear them again */
+static void __clear_masked(struct __motion_detector_s *detector, unsigned int from, unsigned int to)
+{
+	unsigned int row = 0;
+	unsigned int i = 0;
+
+	for (row = from; row < to; row++) {
+		unsigned char *mask = detector->mask + row * detector->width;
+		const unsigned short *spans = NULL;
+		unsigned int count = motion_mask_get_spans(detector->mask_spans, row, &spans);
+		unsigned int x = 0;
+
+		for (i = 0; i < count; i++) {
+			memset(mask + x, 0, spans[2 * i] - x);
+			x = spans[2 * i + 1];
+		}
+		memset(mask + x, 0, detector->width - x);
+	}
+}
+
+/*
+ * The integral rows of a tile as if the tile were the top of the frame.
+ * __carry_integral() adds the rows above it afterwards, integer sums do
+ * not depend on the order, so the result is the same as in one pass.
+ */
+static void __build_integral(struct __motion_detector_s *detector, unsigned int from, unsigned int to)
+{
+	unsigned int stride = detector->width + 1;
+	unsigned int row = 0;
+	unsigned int x = 0;
+
+	for (row = from; row < to; row++) {
+		const unsigned char *mask = detector->mask + row * detector->width;
+		const unsigned int *above = detector->integral + row * stride;
+		unsigned int *sum = detector->integral + (row + 1) * stride;
+		unsigned int row_sum = 0;
+
+		if (row == from) {
+			for (x = 0; x < detector->width; x++) {
+				row_sum += mask[x] & 1;
+				sum[x + 1] = row_sum;
+			}
+			continue;
+		}
+
+		for (x = 0; x < detector->width; x++) {
+			row_sum += mask[x] & 1;
+			sum[x + 1] = above[x + 1] + row_sum;
+		}
+	}
+}
+
+/* The carry of a tile is the integral row above it, made from the last rows of the tiles above */
+static void __compute_carry(struct __motion_detector_s *detector)
+{
+	unsigned int stride = detector->width + 1;
+	unsigned int i = 0;
+	unsigned int x = 0;
+
+	memset(detector->carry, 0, stride * sizeof(unsigned int));
+
+	for (i = 1; i < detector->tile_count; i++) {
+		const unsigned int *above = detector->carry + (i - 1) * stride;
+		const unsigned int *last = detector->integral + detector->tile_start[i] * stride;
+		unsigned int *carry = detector->carry + i * stride;
+
+		for (x = 0; x < stride; x++)
+			carry[x] = above[x] + last[x];
+	}
+}
+
+static void __carry_integral(struct __motion_detector_s *detector, unsigned int tile)
+{
+	unsigned int stride = detector->width + 1;
+	const unsigned int *carry = detector->carry + tile * stride;
+	unsigned int row = 0;
+	unsigned int x = 0;
+
+	if (!tile)
+		return;
+
+	for (row = detector->tile_start[tile]; row < detector->tile_start[tile + 1]; row++) {
+		unsigned int *sum = detector->integral + (row + 1) * stride;
+
+		for (x = 1; x < stride; x++)
+			sum[x] += carry[x];
+	}
+}
+
+static void __tile_job(unsigned int index, void *user_data)
+{
+	struct __motion_detector_s *detector = user_data;
+	unsigned int from = detector->tile_start[index];
+	unsigned int to = detector->tile_start[index + 1];
+
+	switch (detector->phase) {
+	case TILE_PHASE_SUBTRACT:
+		__subtract_background(detector, detector->luma, from, to);
+		break;
+	case TILE_PHASE_ERODE:
+		__erode_mask(detector, from, to);
+		break;
+	case TILE_PHASE_DILATE:
+		__dilate_mask(detector, from, to);
+		if (detector->mask_spans)
+			__clear_masked(detector, from, to);
+		__build_integral(detector, from, to);
+		break;
+	case TILE_PHASE_CARRY:
+		__carry_integral(detector, index);
+		break;
+	}
+}
+
+static void __run_phase(struct __motion_detector_s *detector, tile_phase_e phase)
+{
+	detector->phase = phase;
+	worker_pool_run(detector->pool, detector->tile_count, __tile_job, detector);
+}
+
+unsigned int motion_detector_get_foreground(motion_detector_h detector,
+	unsigned int x, unsigned int y, unsigned int width, unsigned int height)
+{
+	const unsigned int *sum = NULL;
+	unsigned int stride = 0;
+	unsigned int x1, y1;
+
+	retv_if(!detector, 0);
+	retv_if(!detector->has_background, 0);
+
+	if (x >= detector->width || y >= detector->height)
+		return 0;
+
+	x1 = width > detector->width - x ? detector->width : x + width;
+	y1 = height > detector->height - y ? detector->height : y + height;
+
+	sum = detector->integral;
+	stride = detector->width + 1;
+
+	return sum[y1 * stride + x1] - sum[y * stride + x1] - sum[y1 * stride + x] + sum[y * stride + x];
+}
+
+static void __mark_blocks(struct __motion_detector_s *detector)
+{
+	unsigned int bx, by;
+
+	for (by = 0; by < detector->blocks_height; by++) {
+		unsigned char *state = detector->block_state + by * detector->blocks_width;
+
+		for (bx = 0; bx < detector->blocks_width; bx++) {
+			unsigned int fill = motion_detector_get_foreground(detector,
+				bx << BLOCK_SHIFT, by << BLOCK_SHIFT, BLOCK_SIZE, BLOCK_SIZE);
+
+			state[bx] = fill >= BLOCK_FILL_MIN;
+		}
+	}
+}
+
+/* Regions of active blocks, scaled to pixels */
+static int __extract_regions(struct __motion_detector_s *detector, region_set_s *regions)
+{
+	unsigned int i = 0;
+	int count = 0;
+
+	count = region_extract_run(detector->extract, detector->block_state,
+		detector->blocks_width, detector->blocks_height, REGION_MERGE_GAP, regions);
+	retv_if(count < 0, -1);
+
+	/* blocks at the right and bottom edges may be partial */
+	for (i = 0; i < regions->count; i++) {
+		unsigned int x = regions->x[i] << BLOCK_SHIFT;
+		unsigned int y = regions->y[i] << BLOCK_SHIFT;
+		unsigned int width = regions->width[i] << BLOCK_SHIFT;
+		unsigned int height = regions->height[i] << BLOCK_SHIFT;
+
+		if (x + width > detector->width)
+			width = detector->width - x;
+		if (y + height > detector->height)
+			height = detector->height - y;
+
+		regions->x[i] = x;
+		regions->y[i] = y;
+		regions->width[i] = width;
+		regions->height[i] = height;
+		regions->pixels[i] = motion_detector_get_foreground(detector, x, y, width, height);
+	}
+
+	return count;
+}
+
+int motion_detector_process(motion_detector_h detector, const image_luma_s *luma, region_set_s *regions)
+{
+	unsigned long long int start = 0;
+	unsigned int elapsed = 0;
+	int count = 0;
+
+	retv_if(!detector, -1);
+	retv_if(!luma, -1);
+	retv_if(!luma->data || !luma->width || !luma->height, -1);
+	retv_if(!regions, -1);
+
+	region_set_clear(regions);
+
+	if (luma->width != detector->width || luma->height != detector->height) {
+		if (__resize(detector, luma->width, luma->height))
+			return -1;
+	}
+
+	if (detector->mask_spans && motion_mask_compile(detector->mask_spans, luma->width, luma->height)) {
+		_E("Motion mask not used");
+		detector->mask_spans = NULL;
+	}
+
+	if (!detector->has_background) {
+		__seed_background(detector, luma);
+		return 0;
+	}
+
+	start = __get_usec();
+
+	/* each phase needs the rows the previous one wrote around its tile */
+	detector->luma = luma;
+	__run_phase(detector, TILE_PHASE_SUBTRACT);
+	__run_phase(detector, TILE_PHASE_ERODE);
+	__run_phase(detector, TILE_PHASE_DILATE);
+	detector->luma = NULL;
+	if (detector->tile_count > 1) {
+		__compute_carry(detector);
+		__run_phase(detector, TILE_PHASE_CARRY);
+	}
+
+	/* labelling the joined block mask also merges regions across tiles */
+	__mark_blocks(detector);
+	count = __extract_regions(detector, regions);
+
+	elapsed = __get_usec() - start;
+	detector->frames++;
+	detector->total_usec += elapsed;
+	if (elapsed > detector->max_usec)
+		detector->max_usec = elapsed;
+
+	return count;
+}
+
+void motion_detector_set_pool(motion_detector_h detector, worker_pool_h pool)
+{
+	ret_if(!detector);
+
+	detector->pool = pool;
+	if (detector->width)
+		__split_tiles(detector);
+}
+
+void motion_detector_get_stats(motion_detector_h detector, motion_detector_stats_s *stats)
+{
+	ret_if(!detector);
+	ret_if(!stats);
+
+	stats->frames = detector->frames;
+	stats->average_usec = detector->frames ? detector->total_usec / detector->frames : 0;
+	stats->max_usec = detector->max_usec;
+	stats->tiles = detector->tile_count;
+}
+
+void motion_detector_reset(motion_detector_h detector)
+{
+	ret_if(!detector);
+
+	detector->has_background = false;
+}
+
+void motion_detector_set_mask(motion_detector_h detector, motion_mask_h mask)
+{
+	ret_if(!detector);
+
+	if (detector->mask_spans == mask)
+		return;
+
+	/* pixels that were masked out have a stale model */
+	detector->mask_spans = mask;
+	detector->has_background = false;
+}
+
+int motion_detector_save(motion_detector_h detector, const char *path)
+{
+	model_file_header_s header = { 0, };
+	char *temp_path = NULL;
+	size_t count = 0;
+	FILE *fp = NULL;
+
+	retv_if(!detector, -1);
+	retv_if(!path, -1);
+
+	if (!detector->has_background)
+		return 0;
+
+	header.magic = MODEL_FILE_MAGIC;
+	header.version = MODEL_FILE_VERSION;
+	header.width = detector->width;
+	header.height = detector->height;
+	header.saved_time = time(NULL);
+	count = 2 * (size_t)detector->width * detector->height;
+
+	/* A crash while writing must not leave a truncated model behind */
+	temp_path = malloc(strlen(path) + sizeof(".tmp"));
+	retv_if(!temp_path, -1);
+	sprintf(temp_path, "%s.tmp", path);
+
+	fp = fopen(temp_path, "wb");
+	goto_if(!fp, ERROR);
+
+	goto_if(fwrite(&header, sizeof(header), 1, fp) != 1, ERROR);
+	goto_if(fwrite(detector->model, sizeof(short), count, fp) != count, ERROR);
+	goto_if(fclose(fp), ERROR);
+	fp = NULL;
+
+	goto_if(rename(temp_path, path), ERROR);
+	free(temp_path);
+
+	_D("Saved %ux%u background model to %s", detector->width, detector->height, path);
+
+	return 0;
+
+ERROR:
+	_E("Failed to save background model to %s", path);
+	if (fp)
+		fclose(fp);
+	unlink(temp_path);
+	free(temp_path);
+
+	return -1;
+}
+
+int motion_detector_load(motion_detector_h detector, const char *path)
+{
+	model_file_header_s header = { 0, };
+	long long int age = 0;
+	size_t count = 0;
+	FILE *fp = NULL;
+
+	retv_if(!detector, -1);
+	retv_if(!path, -1);
+
+	fp = fopen(path, "rb");
+	if (!fp)
+		return -1;
+
+	goto_if(fread(&header, sizeof(header), 1, fp) != 1, ERROR);
+	goto_if(header.magic != MODEL_FILE_MAGIC || header.version != MODEL_FILE_VERSION, ERROR);
+	goto_if(!header.width || !header.height || header.width > 8192 || header.height > 8192, ERROR);
+
+	age = (long long int)time(NULL) - header.saved_time;
+	if (age < 0 || age > MODEL_AGE_MAX) {
+		_I("Background model in %s is %lld s old, not used", path, age);
+		fclose(fp);
+		return -1;
+	}
+
+	goto_if(__resize(detector, header.width, header.height), ERROR);
+
+	count = 2 * (size_t)header.width * header.height;
+	goto_if(fread(detector->model, sizeof(short), count, fp) != count, ERROR);
+	fclose(fp);
+
+	detector->has_background = true;
+	_I("Loaded %ux%u background model, %lld s old", header.width, header.height, age);
+
+	return 0;
+
+ERROR:
+	_E("Invalid background model in %s", path);
+	fclose(fp);
+	detector->has_background = false;
+
+	return -1;
+}
+
+motion_detector_h motion_detector_create(unsigned int threshold)
+{
+	struct __motion_detector_s *detector = NULL;
+
+	detector = calloc(1, sizeof(struct __motion_detector_s));
+	retvm_if(!detector, NULL, "Failed to allocate motion detector");
+
+	if (threshold > 255)
+		threshold = 255;
+	detector->min_diff = threshold << MOTION_MODEL_FRAC_BITS;
+	detector->kernels = image_convert_get_kernels();
+
+	detector->extract = region_extract_create();
+	if (!detector->extract) {
+		free(detector);
+		return NULL;
+	}
+
+	return detector;
+}
+
+void motion_detector_destroy(motion_detector_h detector)
+{
+	ret_if(!detector);
+
+	region_extract_destroy(detector->extract);
+	free(detector->storage);
+	free(detector);
+}
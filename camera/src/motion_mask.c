@@ -0,0 +1,268 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "log.h"
+#include "motion_mask.h"
+
+#define POLYGON_MAX 8
+#define POLYGON_POINT_MAX 16
+#define MASK_SIZE_MAX 4096
+
+typedef struct __polygon_s {
+	unsigned int count;
+	float x[POLYGON_POINT_MAX];
+	float y[POLYGON_POINT_MAX];
+} polygon_s;
+
+struct __motion_mask_s {
+	polygon_s roi[POLYGON_MAX];
+	unsigned int roi_count;
+	polygon_s exclude[POLYGON_MAX];
+	unsigned int exclude_count;
+
+	/* compiled size, spans of row y are spans[2 * row_start[y]] ~ spans[2 * row_start[y + 1]] */
+	unsigned int width;
+	unsigned int height;
+	unsigned int *row_start;
+	unsigned short *spans;
+	unsigned long long analysed;
+};
+
+static int __parse_polygons(const char *text, polygon_s *polygons, unsigned int *count)
+{
+	const char *p = text;
+
+	*count = 0;
+	if (!text)
+		return 0;
+
+	while (*p) {
+		polygon_s *polygon = NULL;
+
+		while (*p == ' ' || *p == ';')
+			p++;
+		if (!*p)
+			break;
+
+		retvm_if(*count >= POLYGON_MAX, -1, "More than %d polygons in [%s]", POLYGON_MAX, text);
+		polygon = &polygons[(*count)++];
+		polygon->count = 0;
+
+		while (*p && *p != ';') {
+			char *end = NULL;
+			float x, y;
+
+			x = strtof(p, &end);
+			retvm_if(end == p || *end != ',', -1, "Bad point at [%s]", p);
+			p = end + 1;
+			y = strtof(p, &end);
+			retvm_if(end == p, -1, "Bad point at [%s]", p);
+			p = end;
+
+			retvm_if(polygon->count >= POLYGON_POINT_MAX, -1, "More than %d points in a polygon", POLYGON_POINT_MAX);
+			polygon->x[polygon->count] = x;
+			polygon->y[polygon->count] = y;
+			polygon->count++;
+
+			while (*p == ' ')
+				p++;
+		}
+
+		retvm_if(polygon->count < 3, -1, "A polygon needs 3 points or more in [%s]", text);
+	}
+
+	return 0;
+}
+
+static int __ceil(float value)
+{
+	int i = (int)value;
+
+	return value > i ? i + 1 : i;
+}
+
+/* Sets line[] to value for the pixels of the row whose centers are inside the polygon, even-odd rule */
+static void __fill_row(const polygon_s *polygon, float py, unsigned int width, unsigned char *line, unsigned char value)
+{
+	float crossings[POLYGON_POINT_MAX];
+	unsigned int count = 0;
+	unsigned int i, j;
+
+	for (i = 0; i < polygon->count; i++) {
+		float x0 = polygon->x[i];
+		float y0 = polygon->y[i];
+		float x1 = polygon->x[(i + 1) % polygon->count];
+		float y1 = polygon->y[(i + 1) % polygon->count];
+
+		if ((y0 <= py && py < y1) || (y1 <= py && py < y0))
+			crossings[count++] = x0 + (py - y0) * (x1 - x0) / (y1 - y0);
+	}
+
+	/* at most POLYGON_POINT_MAX, insertion sort */
+	for (i = 1; i < count; i++) {
+		float x = crossings[i];
+
+		for (j = i; j > 0 && crossings[j - 1] > x; j--)
+			crossings[j] = crossings[j - 1];
+		crossings[j] = x;
+	}
+
+	/* pixel x is inside when start <= x + 0.5 < end */
+	for (i = 0; i + 1 < count; i += 2) {
+		int first = __ceil(crossings[i] * width / 100.0f - 0.5f);
+		int end = __ceil(crossings[i + 1] * width / 100.0f - 0.5f);
+		int x;
+
+		if (first < 0)
+			first = 0;
+		if (end > (int)width)
+			end = width;
+		for (x = first; x < end; x++)
+			line[x] = value;
+	}
+}
+
+int motion_mask_compile(motion_mask_h mask, unsigned int width, unsigned int height)
+{
+	unsigned char *line = NULL;
+	unsigned short *spans = NULL;
+	unsigned int *row_start = NULL;
+	unsigned int span_count = 0;
+	unsigned int span_capacity = 0;
+	unsigned int row, x, i;
+
+	retv_if(!mask, -1);
+	retv_if(!width || !height || width > MASK_SIZE_MAX || height > MASK_SIZE_MAX, -1);
+
+	if (mask->width == width && mask->height == height)
+		return 0;
+
+	line = malloc(width);
+	row_start = malloc((height + 1) * sizeof(unsigned int));
+	goto_if(!line || !row_start, ERROR);
+
+	mask->analysed = 0;
+
+	for (row = 0; row < height; row++) {
+		float py = (row + 0.5f) * 100.0f / height;
+
+		memset(line, mask->roi_count ? 0 : 1, width);
+		for (i = 0; i < mask->roi_count; i++)
+			__fill_row(&mask->roi[i], py, width, line, 1);
+		for (i = 0; i < mask->exclude_count; i++)
+			__fill_row(&mask->exclude[i], py, width, line, 0);
+
+		row_start[row] = span_count;
+		for (x = 0; x < width; x++) {
+			unsigned int start = x;
+
+			if (!line[x])
+				continue;
+			while (x < width && line[x])
+				x++;
+
+			if (span_count == span_capacity) {
+				unsigned short *grown = NULL;
+
+				span_capacity = span_capacity ? 2 * span_capacity : height;
+				grown = realloc(spans, 2 * span_capacity * sizeof(unsigned short));
+				goto_if(!grown, ERROR);
+				spans = grown;
+			}
+			spans[2 * span_count] = start;
+			spans[2 * span_count + 1] = x;
+			span_count++;
+			mask->analysed += x - start;
+		}
+	}
+	row_start[height] = span_count;
+	free(line);
+
+	free(mask->row_start);
+	free(mask->spans);
+	mask->row_start = row_start;
+	mask->spans = spans;
+	mask->width = width;
+	mask->height = height;
+
+	_I("Motion mask at %ux%u, %u spans, %u%% analysed", width, height, span_count, motion_mask_get_coverage(mask));
+
+	return 0;
+
+ERROR:
+	_E("Failed to compile motion mask for %ux%u", width, height);
+	free(line);
+	free(row_start);
+	free(spans);
+
+	return -1;
+}
+
+unsigned int motion_mask_get_spans(motion_mask_h mask, unsigned int row, const unsigned short **spans)
+{
+	retv_if(!mask, 0);
+	retv_if(!spans, 0);
+	retv_if(row >= mask->height, 0);
+
+	*spans = mask->spans + 2 * mask->row_start[row];
+
+	return mask->row_start[row + 1] - mask->row_start[row];
+}
+
+unsigned int motion_mask_get_coverage(motion_mask_h mask)
+{
+	retv_if(!mask, 100);
+
+	if (!mask->width || !mask->height)
+		return 100;
+
+	return mask->analysed * 100 / ((unsigned long long)mask->width * mask->height);
+}
+
+motion_mask_h motion_mask_create(const char *roi, const char *exclude)
+{
+	struct __motion_mask_s *mask = NULL;
+
+	mask = calloc(1, sizeof(struct __motion_mask_s));
+	retvm_if(!mask, NULL, "Failed to allocate motion mask");
+
+	goto_if(__parse_polygons(roi, mask->roi, &mask->roi_count), ERROR);
+	goto_if(__parse_polygons(exclude, mask->exclude, &mask->exclude_count), ERROR);
+
+	if (!mask->roi_count && !mask->exclude_count) {
+		free(mask);
+		return NULL;
+	}
+
+	return mask;
+
+ERROR:
+	free(mask);
+
+	return NULL;
+}
+
+void motion_mask_destroy(motion_mask_h mask)
+{
+	ret_if(!mask);
+
+	free(mask->row_start);
+	free(mask->spans);
+	free(mask);
+}
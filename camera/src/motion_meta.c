@@ -0,0 +1,234 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <stdio.h>
+#include <string.h>
+
+#include "log.h"
+#include "motion_meta.h"
+
+#define MOTION_META_MAGIC "MVMD"
+#define MOTION_META_MAGIC_SIZE 4
+/* Track ages of the ASCII form are in 0.1 s, up to 9999 */
+#define ASCII_TRACK_AGE_UNIT_MS 100
+#define ASCII_TRACK_AGE_MAX 9999
+
+static inline void __put_u16(unsigned char *p, unsigned int value)
+{
+	p[0] = value;
+	p[1] = value >> 8;
+}
+
+static inline void __put_u32(unsigned char *p, unsigned int value)
+{
+	p[0] = value;
+	p[1] = value >> 8;
+	p[2] = value >> 16;
+	p[3] = value >> 24;
+}
+
+static inline unsigned int __get_u16(const unsigned char *p)
+{
+	return p[0] | (p[1] << 8);
+}
+
+static inline unsigned int __get_u32(const unsigned char *p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int)p[3] << 24);
+}
+
+/* Sizes are u16 in the record */
+static inline unsigned int __clamp_u16(unsigned int value)
+{
+	return value > 0xffff ? 0xffff : value;
+}
+
+int motion_meta_encode(const motion_meta_s *meta, unsigned char *buffer, unsigned int size)
+{
+	unsigned char *p = NULL;
+	unsigned int count = 0;
+	unsigned int i = 0;
+
+	retv_if(!meta, -1);
+	retv_if(!buffer, -1);
+
+	count = meta->region_count < MOTION_META_REGION_MAX ? meta->region_count : MOTION_META_REGION_MAX;
+	retv_if(size < MOTION_META_HEADER_SIZE + count * MOTION_META_REGION_SIZE, -1);
+
+	memcpy(buffer, MOTION_META_MAGIC, MOTION_META_MAGIC_SIZE);
+	__put_u16(buffer + 4, MOTION_META_VERSION);
+	__put_u16(buffer + 6, MOTION_META_HEADER_SIZE);
+	__put_u16(buffer + 8, MOTION_META_REGION_SIZE);
+	__put_u16(buffer + 10, count);
+	__put_u32(buffer + 12, meta->sequence);
+	__put_u32(buffer + 16, meta->timestamp);
+	__put_u32(buffer + 20, meta->timestamp >> 32);
+	__put_u16(buffer + 24, __clamp_u16(meta->frame_width));
+	__put_u16(buffer + 26, __clamp_u16(meta->frame_height));
+	__put_u32(buffer + 28, meta->area_sum);
+	buffer[32] = meta->event;
+	buffer[33] = meta->object_count < 0 ? 0xff : (meta->object_count > 127 ? 127 : meta->object_count);
+	__put_u16(buffer + 34, 0);
+	__put_u32(buffer + 36, meta->entered_id);
+
+	p = buffer + MOTION_META_HEADER_SIZE;
+	for (i = 0; i < count; i++, p += MOTION_META_REGION_SIZE) {
+		const motion_meta_region_s *region = &meta->regions[i];
+
+		__put_u16(p, __clamp_u16(region->x));
+		__put_u16(p + 2, __clamp_u16(region->y));
+		__put_u16(p + 4, __clamp_u16(region->width));
+		__put_u16(p + 6, __clamp_u16(region->height));
+		__put_u32(p + 8, region->area);
+		__put_u32(p + 12, region->track_id);
+		__put_u32(p + 16, region->track_age);
+	}
+
+	return p - buffer;
+}
+
+int motion_meta_encode_segment(const motion_meta_s *meta, unsigned char *buffer, unsigned int size)
+{
+	int record_size = 0;
+
+	retv_if(!buffer, -1);
+	retv_if(size < 4, -1);
+
+	record_size = motion_meta_encode(meta, buffer + 4, size - 4);
+	retv_if(record_size < 0, -1);
+
+	/* the segment length counts itself, not the marker */
+	buffer[0] = 0xff;
+	buffer[1] = MOTION_META_APP_MARKER;
+	buffer[2] = (record_size + 2) >> 8;
+	buffer[3] = record_size + 2;
+
+	return record_size + 4;
+}
+
+int motion_meta_decode(const unsigned char *buffer, unsigned int size, motion_meta_s *meta)
+{
+	const unsigned char *p = NULL;
+	unsigned int header_size = 0;
+	unsigned int region_size = 0;
+	unsigned int count = 0;
+	unsigned int i = 0;
+
+	retv_if(!buffer, -1);
+	retv_if(!meta, -1);
+	retv_if(size < MOTION_META_HEADER_SIZE, -1);
+	retv_if(memcmp(buffer, MOTION_META_MAGIC, MOTION_META_MAGIC_SIZE), -1);
+
+	header_size = __get_u16(buffer + 6);
+	region_size = __get_u16(buffer + 8);
+	count = __get_u16(buffer + 10);
+	retvm_if(header_size < MOTION_META_HEADER_SIZE || region_size < MOTION_META_REGION_SIZE, -1,
+		"Motion meta version %u has a header of %u and regions of %u bytes",
+		__get_u16(buffer + 4), header_size, region_size);
+	retv_if(size < header_size + (unsigned long long)count * region_size, -1);
+
+	memset(meta, 0, sizeof(motion_meta_s));
+	meta->sequence = __get_u32(buffer + 12);
+	meta->timestamp = __get_u32(buffer + 16) | ((unsigned long long int)__get_u32(buffer + 20) << 32);
+	meta->frame_width = __get_u16(buffer + 24);
+	meta->frame_height = __get_u16(buffer + 26);
+	meta->area_sum = __get_u32(buffer + 28);
+	meta->event = buffer[32];
+	meta->object_count = (signed char)buffer[33];
+	meta->entered_id = __get_u32(buffer + 36);
+
+	/* regions beyond what this version holds are left out */
+	meta->region_count = count < MOTION_META_REGION_MAX ? count : MOTION_META_REGION_MAX;
+	p = buffer + header_size;
+	for (i = 0; i < meta->region_count; i++, p += region_size) {
+		motion_meta_region_s *region = &meta->regions[i];
+
+		region->x = __get_u16(p);
+		region->y = __get_u16(p + 2);
+		region->width = __get_u16(p + 4);
+		region->height = __get_u16(p + 6);
+		region->area = __get_u32(p + 8);
+		region->track_id = __get_u32(p + 12);
+		region->track_age = __get_u32(p + 16);
+	}
+
+	return 0;
+}
+
+int motion_meta_decode_jpeg(const unsigned char *jpeg, unsigned int size, motion_meta_s *meta)
+{
+	unsigned int offset = 2;
+	unsigned int length = 0;
+
+	retv_if(!jpeg, -1);
+	retv_if(size < 4 || jpeg[0] != 0xff || jpeg[1] != 0xd8, -1);
+
+	/* APPn and other header segments come before the scan */
+	while (offset + 4 <= size && jpeg[offset] == 0xff && jpeg[offset + 1] != 0xda) {
+		length = (jpeg[offset + 2] << 8) | jpeg[offset + 3];
+		if (length < 2 || offset + 2 + length > size)
+			break;
+
+		if (jpeg[offset + 1] == MOTION_META_APP_MARKER
+			&& !motion_meta_decode(jpeg + offset + 4, length - 2, meta))
+			return 0;
+
+		offset += 2 + length;
+	}
+
+	return -1;
+}
+
+int motion_meta_to_ascii(const motion_meta_s *meta, char *text, unsigned int size)
+{
+	unsigned int length = 0;
+	unsigned int zone_count = 0;
+	unsigned int i = 0;
+
+	retv_if(!meta, -1);
+	retv_if(!text, -1);
+	retv_if(size < 3, -1);
+
+	/* a frame without motion is only its event */
+	if (meta->event == MOTION_META_EVENT_NONE || !meta->frame_width || !meta->frame_height) {
+		memcpy(text, "00", 3);
+		return 2;
+	}
+
+	retv_if(size < 5, -1);
+	length = snprintf(text, size, "%02d%02u", meta->event == MOTION_META_EVENT_ENTERED,
+		meta->region_count % 100);
+
+	for (i = 0; i < meta->region_count && size - length > 8; i++) {
+		const motion_meta_region_s *region = &meta->regions[i];
+
+		length += snprintf(text + length, size - length, "%02u%02u%02u%02u",
+			region->x * 99 / meta->frame_width, region->y * 99 / meta->frame_height,
+			region->width * 99 / meta->frame_width, region->height * 99 / meta->frame_height);
+		zone_count++;
+	}
+
+	/* then the track id and age of each zone, readers of the zones only stop before them */
+	for (i = 0; i < zone_count && size - length > 8; i++) {
+		unsigned int age = meta->regions[i].track_age / ASCII_TRACK_AGE_UNIT_MS;
+
+		length += snprintf(text + length, size - length, "%04u%04u",
+			meta->regions[i].track_id % 10000, age > ASCII_TRACK_AGE_MAX ? ASCII_TRACK_AGE_MAX : age);
+	}
+
+	return length;
+}
@@ -0,0 +1,268 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "log.h"
+#include "region_classifier.h"
+
+/* results of regions that overlap by half are reused for a while */
+#define CACHE_MAX 16
+#define CACHE_TTL_MS 1500
+#define CACHE_IOU_MIN 50
+
+typedef struct __cache_entry_s {
+	unsigned int x;
+	unsigned int y;
+	unsigned int width;
+	unsigned int height;
+	region_class_e class;
+	long long int time; // 0 for a free entry
+} cache_entry_s;
+
+struct __region_classifier_s {
+	region_classifier_detect_cb detect;
+	void *user_data;
+
+	/* usec the detector may still use, refilled by budget_ms each second up to one second worth */
+	long long int budget_usec;
+	long long int tokens;
+	long long int last_refill;
+
+	cache_entry_s cache[CACHE_MAX];
+
+	region_classifier_stats_s stats;
+	unsigned long long int total_usec;
+};
+
+static long long int __get_usec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+/* Overlap in percent of the union */
+static unsigned int __get_iou(const cache_entry_s *entry, unsigned int x, unsigned int y,
+	unsigned int width, unsigned int height)
+{
+	unsigned int x0 = entry->x > x ? entry->x : x;
+	unsigned int y0 = entry->y > y ? entry->y : y;
+	unsigned int x1 = entry->x + entry->width < x + width ? entry->x + entry->width : x + width;
+	unsigned int y1 = entry->y + entry->height < y + height ? entry->y + entry->height : y + height;
+	unsigned long long int overlap = 0;
+	unsigned long long int total = 0;
+
+	if (x1 <= x0 || y1 <= y0)
+		return 0;
+
+	overlap = (unsigned long long int)(x1 - x0) * (y1 - y0);
+	total = (unsigned long long int)entry->width * entry->height + (unsigned long long int)width * height - overlap;
+
+	return overlap * 100 / total;
+}
+
+static cache_entry_s *__find_cached(struct __region_classifier_s *classifier, long long int now,
+	unsigned int x, unsigned int y, unsigned int width, unsigned int height)
+{
+	cache_entry_s *best = NULL;
+	unsigned int best_iou = CACHE_IOU_MIN - 1;
+	unsigned int i = 0;
+
+	for (i = 0; i < CACHE_MAX; i++) {
+		cache_entry_s *entry = &classifier->cache[i];
+		unsigned int iou = 0;
+
+		if (!entry->time || now - entry->time > CACHE_TTL_MS * 1000LL)
+			continue;
+
+		iou = __get_iou(entry, x, y, width, height);
+		if (iou > best_iou) {
+			best_iou = iou;
+			best = entry;
+		}
+	}
+
+	return best;
+}
+
+static void __cache(struct __region_classifier_s *classifier, long long int now,
+	unsigned int x, unsigned int y, unsigned int width, unsigned int height, region_class_e class)
+{
+	cache_entry_s *entry = &classifier->cache[0];
+	unsigned int i = 0;
+
+	/* the oldest entry, free ones are 0 */
+	for (i = 1; i < CACHE_MAX; i++) {
+		if (classifier->cache[i].time < entry->time)
+			entry = &classifier->cache[i];
+	}
+
+	entry->x = x;
+	entry->y = y;
+	entry->width = width;
+	entry->height = height;
+	entry->class = class;
+	entry->time = now;
+}
+
+static void __refill(struct __region_classifier_s *classifier, long long int now)
+{
+	long long int elapsed = now - classifier->last_refill;
+
+	classifier->last_refill = now;
+	if (elapsed <= 0)
+		return;
+
+	classifier->tokens += elapsed * classifier->budget_usec / 1000000;
+	if (classifier->tokens > classifier->budget_usec)
+		classifier->tokens = classifier->budget_usec;
+}
+
+static region_class_e __classify(struct __region_classifier_s *classifier, const image_pyramid_s *pyramid,
+	unsigned int x, unsigned int y, unsigned int width, unsigned int height)
+{
+	const image_luma_s *frame = &pyramid->level[0];
+	unsigned int margin_x = width >> REGION_CLASSIFIER_CROP_MARGIN_SHIFT;
+	unsigned int margin_y = height >> REGION_CLASSIFIER_CROP_MARGIN_SHIFT;
+	unsigned int x1 = x + width + margin_x;
+	unsigned int y1 = y + height + margin_y;
+	unsigned int level = 0;
+	image_luma_s crop;
+	long long int start = 0;
+	long long int elapsed = 0;
+	int ret = 0;
+
+	x = x > margin_x ? x - margin_x : 0;
+	y = y > margin_y ? y - margin_y : 0;
+	if (x1 > frame->width)
+		x1 = frame->width;
+	if (y1 > frame->height)
+		y1 = frame->height;
+	if (x1 < x + REGION_CLASSIFIER_CROP_SIZE_MIN || y1 < y + REGION_CLASSIFIER_CROP_SIZE_MIN)
+		return REGION_CLASS_NONE;
+
+	width = x1 - x;
+	height = y1 - y;
+	while (level + 1 < pyramid->levels
+		&& (width >> (level + 1)) >= REGION_CLASSIFIER_CROP_DETAIL_MIN
+		&& (height >> (level + 1)) >= REGION_CLASSIFIER_CROP_DETAIL_MIN)
+		level++;
+
+	frame = &pyramid->level[level];
+	crop.width = width >> level;
+	crop.height = height >> level;
+	crop.stride = frame->stride;
+	crop.data = frame->data + (size_t)(y >> level) * frame->stride + (x >> level);
+
+	start = __get_usec();
+	ret = classifier->detect(&crop, classifier->user_data);
+	elapsed = __get_usec() - start;
+
+	classifier->tokens -= elapsed;
+	classifier->total_usec += elapsed;
+	classifier->stats.runs++;
+
+	if (ret < 0)
+		return REGION_CLASS_UNKNOWN;
+
+	return ret ? REGION_CLASS_OBJECT : REGION_CLASS_NONE;
+}
+
+int region_classifier_run(region_classifier_h classifier, const image_pyramid_s *pyramid,
+	unsigned int level, const region_set_s *regions, region_class_e classes[REGION_SET_MAX])
+{
+	long long int now = 0;
+	unsigned int i = 0;
+	int objects = 0;
+
+	retv_if(!classifier, -1);
+	retv_if(!pyramid || !pyramid->levels, -1);
+	retv_if(level >= pyramid->levels, -1);
+	retv_if(!regions, -1);
+	retv_if(!classes, -1);
+
+	now = __get_usec();
+	__refill(classifier, now);
+
+	for (i = 0; i < regions->count; i++) {
+		unsigned int x = regions->x[i] << level;
+		unsigned int y = regions->y[i] << level;
+		unsigned int width = regions->width[i] << level;
+		unsigned int height = regions->height[i] << level;
+		cache_entry_s *entry = __find_cached(classifier, now, x, y, width, height);
+
+		if (entry) {
+			classes[i] = entry->class;
+			classifier->stats.cached++;
+		} else if (classifier->tokens <= 0) {
+			/* largest regions come first, so they get the budget */
+			classes[i] = REGION_CLASS_UNKNOWN;
+			classifier->stats.skipped++;
+			continue;
+		} else {
+			classes[i] = __classify(classifier, pyramid, x, y, width, height);
+			if (classes[i] != REGION_CLASS_UNKNOWN)
+				__cache(classifier, now, x, y, width, height, classes[i]);
+		}
+
+		if (classes[i] == REGION_CLASS_OBJECT)
+			objects++;
+	}
+
+	return objects;
+}
+
+void region_classifier_get_stats(region_classifier_h classifier, region_classifier_stats_s *stats)
+{
+	ret_if(!classifier);
+	ret_if(!stats);
+
+	*stats = classifier->stats;
+	stats->average_usec = classifier->stats.runs ? classifier->total_usec / classifier->stats.runs : 0;
+}
+
+region_classifier_h region_classifier_create(region_classifier_detect_cb detect, void *user_data, unsigned int budget_ms)
+{
+	struct __region_classifier_s *classifier = NULL;
+
+	retv_if(!detect, NULL);
+
+	classifier = calloc(1, sizeof(struct __region_classifier_s));
+	retvm_if(!classifier, NULL, "Failed to allocate region classifier");
+
+	if (budget_ms > 1000)
+		budget_ms = 1000;
+
+	classifier->detect = detect;
+	classifier->user_data = user_data;
+	classifier->budget_usec = budget_ms * 1000LL;
+	classifier->tokens = classifier->budget_usec;
+	classifier->last_refill = __get_usec();
+
+	return classifier;
+}
+
+void region_classifier_destroy(region_classifier_h classifier)
+{
+	ret_if(!classifier);
+
+	free(classifier);
+}
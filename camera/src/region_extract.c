@@ -0,0 +1,356 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "log.h"
+#include "region_extract.h"
+
+/* Components kept for the merge, the smallest beyond it are dropped */
+#define CANDIDATE_MAX 64
+#define MERGE_PASSES 3
+
+typedef struct __box_s {
+	unsigned int min_x;
+	unsigned int min_y;
+	unsigned int max_x;
+	unsigned int max_y;
+	unsigned int pixels;
+} box_s;
+
+struct __region_extract_s {
+	/* provisional labels, index 0 is the background */
+	unsigned int *parent;
+	box_s *boxes;
+	unsigned int label_capacity;
+
+	/* labels of the previous and the current row */
+	unsigned int *rows;
+	unsigned int row_capacity;
+
+	box_s candidates[CANDIDATE_MAX];
+	unsigned int candidate_count;
+};
+
+void region_set_clear(region_set_s *set)
+{
+	ret_if(!set);
+
+	set->count = 0;
+}
+
+void region_set_insert(region_set_s *set, unsigned int x, unsigned int y,
+	unsigned int width, unsigned int height, unsigned int pixels)
+{
+	unsigned int i = 0;
+
+	ret_if(!set);
+
+	if (set->count == REGION_SET_MAX && pixels <= set->pixels[REGION_SET_MAX - 1])
+		return;
+
+	i = set->count < REGION_SET_MAX ? set->count++ : REGION_SET_MAX - 1;
+	for (; i > 0 && set->pixels[i - 1] < pixels; i--) {
+		set->x[i] = set->x[i - 1];
+		set->y[i] = set->y[i - 1];
+		set->width[i] = set->width[i - 1];
+		set->height[i] = set->height[i - 1];
+		set->pixels[i] = set->pixels[i - 1];
+	}
+
+	set->x[i] = x;
+	set->y[i] = y;
+	set->width[i] = width;
+	set->height[i] = height;
+	set->pixels[i] = pixels;
+}
+
+static unsigned int __find(unsigned int *parent, unsigned int label)
+{
+	unsigned int root = label;
+
+	while (parent[root] != root)
+		root = parent[root];
+
+	/* path compression */
+	while (parent[label] != root) {
+		unsigned int next = parent[label];
+
+		parent[label] = root;
+		label = next;
+	}
+
+	return root;
+}
+
+/* The smaller root wins, so roots never point forward */
+static unsigned int __union(unsigned int *parent, unsigned int a, unsigned int b)
+{
+	a = __find(parent, a);
+	b = __find(parent, b);
+
+	if (a < b) {
+		parent[b] = a;
+		return a;
+	}
+	parent[a] = b;
+
+	return b;
+}
+
+static int __reserve(struct __region_extract_s *extract, unsigned int width, unsigned int height)
+{
+	/*
+	 * A cell only takes a new label when none of its scanned neighbours has
+	 * one, so no two new labels touch and at most every other cell of every
+	 * other row gets one
+	 */
+	unsigned int labels = ((width + 1) / 2) * ((height + 1) / 2) + 1;
+	unsigned int *parent = NULL;
+	box_s *boxes = NULL;
+
+	if (extract->row_capacity < width) {
+		unsigned int *rows = realloc(extract->rows, 2 * width * sizeof(unsigned int));
+		retvm_if(!rows, -1, "Failed to allocate label rows for %u cells", width);
+
+		extract->rows = rows;
+		extract->row_capacity = width;
+	}
+
+	if (extract->label_capacity < labels) {
+		parent = realloc(extract->parent, labels * sizeof(unsigned int));
+		retvm_if(!parent, -1, "Failed to allocate %u labels", labels);
+		extract->parent = parent;
+
+		boxes = realloc(extract->boxes, labels * sizeof(box_s));
+		retvm_if(!boxes, -1, "Failed to allocate %u boxes", labels);
+		extract->boxes = boxes;
+
+		extract->label_capacity = labels;
+	}
+
+	return 0;
+}
+
+static unsigned int __label(struct __region_extract_s *extract, const unsigned char *mask,
+	unsigned int width, unsigned int height)
+{
+	unsigned int *parent = extract->parent;
+	box_s *boxes = extract->boxes;
+	unsigned int *above = extract->rows;
+	unsigned int *current = extract->rows + width;
+	unsigned int next = 1;
+	unsigned int x, y;
+
+	memset(above, 0, width * sizeof(unsigned int));
+
+	for (y = 0; y < height; y++) {
+		const unsigned char *row = mask + y * width;
+		unsigned int *swap = NULL;
+
+		for (x = 0; x < width; x++) {
+			unsigned int neighbours[4];
+			unsigned int label = 0;
+			unsigned int i = 0;
+			box_s *box = NULL;
+
+			if (!row[x]) {
+				current[x] = 0;
+				continue;
+			}
+
+			neighbours[0] = x ? current[x - 1] : 0;
+			neighbours[1] = x ? above[x - 1] : 0;
+			neighbours[2] = above[x];
+			neighbours[3] = x + 1 < width ? above[x + 1] : 0;
+
+			for (i = 0; i < 4; i++) {
+				if (!neighbours[i] || neighbours[i] == label)
+					continue;
+				label = label ? __union(parent, label, neighbours[i]) : neighbours[i];
+			}
+
+			if (!label) {
+				label = next++;
+				parent[label] = label;
+				box = &boxes[label];
+				box->min_x = box->max_x = x;
+				box->min_y = box->max_y = y;
+				box->pixels = 0;
+			}
+
+			/* counted on the label it got, folded into the root at the end */
+			box = &boxes[label];
+			if (x < box->min_x)
+				box->min_x = x;
+			if (x > box->max_x)
+				box->max_x = x;
+			box->max_y = y;
+			box->pixels++;
+
+			current[x] = label;
+		}
+
+		swap = above;
+		above = current;
+		current = swap;
+	}
+
+	return next;
+}
+
+static void __add_candidate(struct __region_extract_s *extract, const box_s *box)
+{
+	box_s *candidates = extract->candidates;
+	unsigned int i = 0;
+
+	if (extract->candidate_count == CANDIDATE_MAX && box->pixels <= candidates[CANDIDATE_MAX - 1].pixels)
+		return;
+
+	i = extract->candidate_count < CANDIDATE_MAX ? extract->candidate_count++ : CANDIDATE_MAX - 1;
+	for (; i > 0 && candidates[i - 1].pixels < box->pixels; i--)
+		candidates[i] = candidates[i - 1];
+	candidates[i] = *box;
+}
+
+static void __collect_components(struct __region_extract_s *extract, unsigned int labels)
+{
+	unsigned int *parent = extract->parent;
+	box_s *boxes = extract->boxes;
+	unsigned int label = 0;
+
+	/* Every provisional label is folded into its root */
+	for (label = labels - 1; label > 0; label--) {
+		unsigned int root = __find(parent, label);
+		box_s *box = &boxes[root];
+		box_s *member = &boxes[label];
+
+		if (root == label)
+			continue;
+
+		if (member->min_x < box->min_x)
+			box->min_x = member->min_x;
+		if (member->max_x > box->max_x)
+			box->max_x = member->max_x;
+		if (member->min_y < box->min_y)
+			box->min_y = member->min_y;
+		if (member->max_y > box->max_y)
+			box->max_y = member->max_y;
+		box->pixels += member->pixels;
+	}
+
+	extract->candidate_count = 0;
+	for (label = 1; label < labels; label++) {
+		if (parent[label] == label)
+			__add_candidate(extract, &boxes[label]);
+	}
+}
+
+static bool __is_near(const box_s *a, const box_s *b, unsigned int gap)
+{
+	return a->min_x <= b->max_x + gap + 1 && b->min_x <= a->max_x + gap + 1
+		&& a->min_y <= b->max_y + gap + 1 && b->min_y <= a->max_y + gap + 1;
+}
+
+static void __merge_candidates(struct __region_extract_s *extract, unsigned int gap)
+{
+	box_s *candidates = extract->candidates;
+	unsigned int pass = 0;
+	unsigned int i, j;
+
+	for (pass = 0; pass < MERGE_PASSES; pass++) {
+		bool merged = false;
+
+		for (i = 0; i < extract->candidate_count; i++) {
+			for (j = i + 1; j < extract->candidate_count; j++) {
+				box_s *a = &candidates[i];
+				box_s *b = &candidates[j];
+
+				if (!__is_near(a, b, gap))
+					continue;
+
+				if (b->min_x < a->min_x)
+					a->min_x = b->min_x;
+				if (b->max_x > a->max_x)
+					a->max_x = b->max_x;
+				if (b->min_y < a->min_y)
+					a->min_y = b->min_y;
+				if (b->max_y > a->max_y)
+					a->max_y = b->max_y;
+				a->pixels += b->pixels;
+
+				candidates[j--] = candidates[--extract->candidate_count];
+				merged = true;
+			}
+		}
+
+		if (!merged)
+			break;
+	}
+}
+
+int region_extract_run(region_extract_h extract, const unsigned char *mask,
+	unsigned int width, unsigned int height, unsigned int gap, region_set_s *set)
+{
+	unsigned int labels = 0;
+	unsigned int i = 0;
+
+	retv_if(!extract, -1);
+	retv_if(!mask, -1);
+	retv_if(!set, -1);
+
+	region_set_clear(set);
+	if (!width || !height)
+		return 0;
+
+	if (__reserve(extract, width, height))
+		return -1;
+
+	labels = __label(extract, mask, width, height);
+	__collect_components(extract, labels);
+	__merge_candidates(extract, gap);
+
+	for (i = 0; i < extract->candidate_count; i++) {
+		const box_s *box = &extract->candidates[i];
+
+		region_set_insert(set, box->min_x, box->min_y,
+			box->max_x - box->min_x + 1, box->max_y - box->min_y + 1, box->pixels);
+	}
+
+	return set->count;
+}
+
+region_extract_h region_extract_create(void)
+{
+	struct __region_extract_s *extract = NULL;
+
+	extract = calloc(1, sizeof(struct __region_extract_s));
+	retvm_if(!extract, NULL, "Failed to allocate region extraction");
+
+	return extract;
+}
+
+void region_extract_destroy(region_extract_h extract)
+{
+	ret_if(!extract);
+
+	free(extract->parent);
+	free(extract->boxes);
+	free(extract->rows);
+	free(extract);
+}
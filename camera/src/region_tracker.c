@@ -0,0 +1,276 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "log.h"
+#include "region_tracker.h"
+
+/* overlap in percent of the union for a region to continue a track */
+#define TRACK_IOU_MIN 10
+
+typedef struct __track_s {
+	unsigned int id; // 0 for a free slot
+	unsigned int x;
+	unsigned int y;
+	unsigned int width;
+	unsigned int height;
+	long long int first_seen;
+	long long int last_seen;
+	unsigned int hits;
+	bool object;
+	bool entered;
+} track_s;
+
+struct __region_tracker_s {
+	unsigned int confirm_hits;
+	unsigned int timeout_ms;
+	unsigned int next_id;
+	track_s tracks[REGION_TRACK_MAX];
+};
+
+static unsigned int __get_iou(const track_s *track, const region_set_s *regions, unsigned int i)
+{
+	unsigned int x0 = track->x > regions->x[i] ? track->x : regions->x[i];
+	unsigned int y0 = track->y > regions->y[i] ? track->y : regions->y[i];
+	unsigned int x1 = track->x + track->width;
+	unsigned int y1 = track->y + track->height;
+	unsigned long long int overlap = 0;
+	unsigned long long int total = 0;
+
+	if (x1 > regions->x[i] + regions->width[i])
+		x1 = regions->x[i] + regions->width[i];
+	if (y1 > regions->y[i] + regions->height[i])
+		y1 = regions->y[i] + regions->height[i];
+	if (x1 <= x0 || y1 <= y0)
+		return 0;
+
+	overlap = (unsigned long long int)(x1 - x0) * (y1 - y0);
+	total = (unsigned long long int)track->width * track->height
+		+ (unsigned long long int)regions->width[i] * regions->height[i] - overlap;
+
+	return overlap * 100 / total;
+}
+
+/*
+ * Squared distance of the centers, in half pixels, or -1 when the region
+ * is further than the larger side of the track
+ */
+static long long int __get_distance(const track_s *track, const region_set_s *regions, unsigned int i)
+{
+	long long int dx = (long long int)(2 * track->x + track->width) - (2 * regions->x[i] + regions->width[i]);
+	long long int dy = (long long int)(2 * track->y + track->height) - (2 * regions->y[i] + regions->height[i]);
+	long long int reach = 2 * (track->width > track->height ? track->width : track->height);
+
+	if (dx * dx + dy * dy > reach * reach)
+		return -1;
+
+	return dx * dx + dy * dy;
+}
+
+static void __continue_track(track_s *track, const region_set_s *regions, unsigned int i, long long int now)
+{
+	track->x = regions->x[i];
+	track->y = regions->y[i];
+	track->width = regions->width[i];
+	track->height = regions->height[i];
+	track->last_seen = now;
+	track->hits++;
+}
+
+/* Takes a free slot, or the one seen longest ago that is not used by this update */
+static track_s *__start_track(struct __region_tracker_s *tracker, bool taken[REGION_TRACK_MAX],
+	const region_set_s *regions, unsigned int i, long long int now)
+{
+	track_s *track = NULL;
+	unsigned int t = 0;
+	unsigned int slot = 0;
+
+	for (t = 0; t < REGION_TRACK_MAX; t++) {
+		if (taken[t])
+			continue;
+		if (!tracker->tracks[t].id) {
+			track = &tracker->tracks[t];
+			slot = t;
+			break;
+		}
+		if (!track || tracker->tracks[t].last_seen < track->last_seen) {
+			track = &tracker->tracks[t];
+			slot = t;
+		}
+	}
+
+	if (!track)
+		return NULL;
+
+	memset(track, 0, sizeof(track_s));
+	if (++tracker->next_id == 0)
+		tracker->next_id = 1;
+	track->id = tracker->next_id;
+	track->first_seen = now;
+	taken[slot] = true;
+	__continue_track(track, regions, i, now);
+
+	return track;
+}
+
+int region_tracker_update(region_tracker_h tracker, const region_set_s *regions,
+	const region_class_e *classes, long long int now_ms, region_track_info_s info[REGION_SET_MAX])
+{
+	track_s *matched[REGION_SET_MAX] = { NULL, };
+	bool taken[REGION_TRACK_MAX] = { false, };
+	unsigned int i = 0;
+	unsigned int t = 0;
+	int entered = 0;
+
+	retv_if(!tracker, -1);
+	retv_if(!regions, -1);
+	retv_if(!info, -1);
+
+	for (t = 0; t < REGION_TRACK_MAX; t++) {
+		track_s *track = &tracker->tracks[t];
+
+		if (track->id && now_ms - track->last_seen > tracker->timeout_ms)
+			track->id = 0;
+	}
+
+	/* best overlapping pairs first, then the nearest of what is left */
+	for (;;) {
+		unsigned int best_iou = TRACK_IOU_MIN - 1;
+		unsigned int best_i = 0;
+		unsigned int best_t = 0;
+
+		for (i = 0; i < regions->count; i++) {
+			if (matched[i])
+				continue;
+			for (t = 0; t < REGION_TRACK_MAX; t++) {
+				unsigned int iou = 0;
+
+				if (!tracker->tracks[t].id || taken[t])
+					continue;
+				iou = __get_iou(&tracker->tracks[t], regions, i);
+				if (iou > best_iou) {
+					best_iou = iou;
+					best_i = i;
+					best_t = t;
+				}
+			}
+		}
+
+		if (best_iou < TRACK_IOU_MIN)
+			break;
+		matched[best_i] = &tracker->tracks[best_t];
+		taken[best_t] = true;
+	}
+
+	for (;;) {
+		long long int best_distance = -1;
+		unsigned int best_i = 0;
+		unsigned int best_t = 0;
+
+		for (i = 0; i < regions->count; i++) {
+			if (matched[i])
+				continue;
+			for (t = 0; t < REGION_TRACK_MAX; t++) {
+				long long int distance = 0;
+
+				if (!tracker->tracks[t].id || taken[t])
+					continue;
+				distance = __get_distance(&tracker->tracks[t], regions, i);
+				if (distance >= 0 && (best_distance < 0 || distance < best_distance)) {
+					best_distance = distance;
+					best_i = i;
+					best_t = t;
+				}
+			}
+		}
+
+		if (best_distance < 0)
+			break;
+		matched[best_i] = &tracker->tracks[best_t];
+		taken[best_t] = true;
+	}
+
+	for (i = 0; i < regions->count; i++) {
+		if (matched[i])
+			__continue_track(matched[i], regions, i, now_ms);
+	}
+
+	for (i = 0; i < regions->count; i++) {
+		track_s *track = matched[i];
+
+		if (!track)
+			track = __start_track(tracker, taken, regions, i, now_ms);
+		if (!track) {
+			/* more regions than tracks, the smallest go untracked */
+			memset(&info[i], 0, sizeof(region_track_info_s));
+			continue;
+		}
+
+		if (classes && classes[i] == REGION_CLASS_OBJECT)
+			track->object = true;
+
+		info[i].id = track->id;
+		info[i].age = now_ms - track->first_seen;
+		info[i].entered = false;
+
+		if (!track->entered && track->hits >= tracker->confirm_hits && (!classes || track->object)) {
+			track->entered = true;
+			info[i].entered = true;
+			entered++;
+		}
+	}
+
+	return entered;
+}
+
+unsigned int region_tracker_get_count(region_tracker_h tracker, long long int now_ms)
+{
+	unsigned int count = 0;
+	unsigned int t = 0;
+
+	retv_if(!tracker, 0);
+
+	for (t = 0; t < REGION_TRACK_MAX; t++) {
+		const track_s *track = &tracker->tracks[t];
+
+		if (track->id && now_ms - track->last_seen <= tracker->timeout_ms)
+			count++;
+	}
+
+	return count;
+}
+
+region_tracker_h region_tracker_create(unsigned int confirm_hits, unsigned int timeout_ms)
+{
+	struct __region_tracker_s *tracker = NULL;
+
+	tracker = calloc(1, sizeof(struct __region_tracker_s));
+	retvm_if(!tracker, NULL, "Failed to allocate region tracker");
+
+	tracker->confirm_hits = confirm_hits ? confirm_hits : 1;
+	tracker->timeout_ms = timeout_ms;
+
+	return tracker;
+}
+
+void region_tracker_destroy(region_tracker_h tracker)
+{
+	ret_if(!tracker);
+
+	free(tracker);
+}
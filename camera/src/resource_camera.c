@@ -21,23 +21,11 @@
 #include "log.h"
 #include "controller.h"
 #include "resource_camera.h"
+#include "resource_camera_internal.h"
+#include "controller_config.h"
 
-struct __camera_data {
-	camera_h cam_handle;
+#define FRAME_PLANE_ALIGN 64
 
-	void *captured_file;
-	unsigned int image_size;
-
-	preview_image_buffer_created_cb preview_image_buffer_created_cb;
-	void *preview_image_buffer_created_cb_data;
-
-	capture_completed_cb capture_completed_cb;
-	void *capture_completed_cb_data;
-
-	bool is_af_enabled;
-};
-
-static struct __camera_data *g_camera_data = NULL;
 
 static const char * __cam_err_to_str(camera_error_e err)
 {
@@ -131,85 +119,111 @@ static long long int __get_monotonic_ms(void)
 	return ret_time;
 }
 
-static image_buffer_data_s *__make_preview_image_buffer_data(camera_preview_data_s *frame)
+static unsigned int __get_preview_planes(camera_preview_data_s *frame,
+	unsigned char *planes[], unsigned int sizes[])
 {
-	unsigned char *buffer = NULL;
-	unsigned int buffer_size = 0;
-
-	image_buffer_data_s *image_buffer = malloc(sizeof(image_buffer_data_s));
-	if (image_buffer == NULL) {
-		_E("Failed to allocate image buffer data");
-		goto ERROR;
-	}
-
 	switch (frame->num_of_planes) {
 	case 1:
-		buffer_size = frame->data.single_plane.size;
-		buffer = malloc(buffer_size);
-		if (!buffer) {
-			_E("failed to malloc buffer");
-			goto ERROR;
-		}
-		memcpy(buffer, frame->data.single_plane.yuv, buffer_size);
+		planes[0] = frame->data.single_plane.yuv;
+		sizes[0] = frame->data.single_plane.size;
 		break;
 	case 2:
-		{
-			unsigned char *buffer2 = NULL;
-			buffer_size =
-				frame->data.double_plane.y_size + frame->data.double_plane.uv_size;
-			buffer = malloc(buffer_size);
-			if (!buffer) {
-				_E("failed to malloc buffer");
-				goto ERROR;
-			}
-			buffer2 = buffer + frame->data.double_plane.y_size;
-			memcpy(buffer,
-				frame->data.double_plane.y, frame->data.double_plane.y_size);
-			memcpy(buffer2,
-				frame->data.double_plane.uv, frame->data.double_plane.uv_size);
-		}
+		planes[0] = frame->data.double_plane.y;
+		planes[1] = frame->data.double_plane.uv;
+		sizes[0] = frame->data.double_plane.y_size;
+		sizes[1] = frame->data.double_plane.uv_size;
 		break;
 	case 3:
-		{
-			unsigned char *buffer2 = NULL;
-			unsigned char *buffer3 = NULL;
-			buffer_size = frame->data.triple_plane.y_size
-						+ frame->data.triple_plane.u_size
-						+ frame->data.triple_plane.v_size;
-			buffer = malloc(buffer_size);
-			if (!buffer) {
-				_E("failed to malloc buffer");
-				goto ERROR;
-			}
-			buffer2 = buffer + frame->data.triple_plane.y_size;
-			buffer3 = buffer2 + frame->data.triple_plane.u_size;
-			memcpy(buffer,
-				frame->data.triple_plane.y, frame->data.triple_plane.y_size);
-			memcpy(buffer2,
-				frame->data.triple_plane.u, frame->data.triple_plane.u_size);
-			memcpy(buffer3,
-				frame->data.triple_plane.v, frame->data.triple_plane.v_size);
-		}
+		planes[0] = frame->data.triple_plane.y;
+		planes[1] = frame->data.triple_plane.u;
+		planes[2] = frame->data.triple_plane.v;
+		sizes[0] = frame->data.triple_plane.y_size;
+		sizes[1] = frame->data.triple_plane.u_size;
+		sizes[2] = frame->data.triple_plane.v_size;
 		break;
 	default:
 		_E("unhandled num of planes : %d", frame->num_of_planes);
-		goto ERROR;
-		break;
+		return 0;
+	}
+
+	return frame->num_of_planes;
+}
+
+static unsigned int __get_preview_frame_size(unsigned int num_planes,
+	const unsigned int sizes[], unsigned int offsets[])
+{
+	unsigned int size = 0;
+	unsigned int i = 0;
+
+	/* Every plane starts on its own cache line */
+	for (i = 0; i < num_planes; i++) {
+		offsets[i] = size;
+		size += (sizes[i] + FRAME_PLANE_ALIGN - 1) & ~(FRAME_PLANE_ALIGN - 1);
+	}
+
+	return size;
+}
+
+static frame_pool_s *__get_frame_pool(struct __camera_data *camera_data, unsigned int frame_size)
+{
+	/* Sized from the first frame, so the plane layout of the configured
+	 * resolution is taken into account. A larger frame means the preview
+	 * resolution changed, and the old pool is retired once it drains. */
+	if (camera_data->frame_pool
+		&& frame_pool_get_frame_size(camera_data->frame_pool) >= frame_size)
+		return camera_data->frame_pool;
+
+	frame_pool_destroy(camera_data->frame_pool);
+	camera_data->frame_pool = frame_pool_create(CAMERA_FRAME_POOL_SIZE(camera_data->frame_ring_depth), frame_size);
+
+	return camera_data->frame_pool;
+}
+
+static image_buffer_data_s *__make_preview_image_buffer_data(struct __camera_data *camera_data, camera_preview_data_s *frame)
+{
+	frame_pool_s *pool = NULL;
+	unsigned char *planes[IMAGE_PLANE_MAX] = { NULL, };
+	unsigned int sizes[IMAGE_PLANE_MAX] = { 0, };
+	unsigned int offsets[IMAGE_PLANE_MAX] = { 0, };
+	unsigned int num_planes = 0;
+	unsigned int buffer_size = 0;
+	unsigned int i = 0;
+
+	num_planes = __get_preview_planes(frame, planes, sizes);
+	retv_if(num_planes == 0, NULL);
+
+	buffer_size = __get_preview_frame_size(num_planes, sizes, offsets);
+
+	pool = __get_frame_pool(camera_data, buffer_size);
+	retvm_if(!pool, NULL, "Failed to get frame pool");
+
+	image_buffer_data_s *image_buffer = frame_pool_acquire(pool);
+	if (image_buffer == NULL) {
+		_D("Frame pool exhausted, drop frame");
+		return NULL;
+	}
+
+	/* The camera buffer is only valid during the callback, so this is the
+	 * one copy a frame gets. Planes keep their own layout, consumers
+	 * that need a packed frame go through image_frame_view_get_packed() */
+	for (i = 0; i < num_planes; i++)
+		memcpy(image_buffer->buffer + offsets[i], planes[i], sizes[i]);
+
+	/* camera_preview_data_s reports no stride, it is derived from the plane sizes */
+	if (image_frame_view_init(&image_buffer->view, frame->format,
+			frame->width, frame->height, image_buffer->buffer,
+			num_planes, offsets, sizes, NULL)) {
+		_E("Failed to describe frame, format[%d] planes[%u]", frame->format, num_planes);
+		frame_pool_unref(image_buffer);
+		return NULL;
 	}
 
 	image_buffer->image_width = frame->width;
 	image_buffer->image_height = frame->height;
 	image_buffer->buffer_size = buffer_size;
-	image_buffer->buffer = buffer;
 	image_buffer->format = frame->format;
 
 	return image_buffer;
-
-ERROR:
-	free(buffer);
-	free(image_buffer);
-
-	return NULL;
 }
 
 static bool __camera_attr_supported_af_mode_cb(camera_attr_af_mode_e mode, void *user_data)
@@ -241,17 +255,21 @@ static void __capturing_cb(camera_image_data_s *image, camera_image_data_s *post
 
 	memcpy(camera_data->captured_file, image->data, image->size);
 	camera_data->image_size = image->size;
+	camera_data->captured_width = image->width;
+	camera_data->captured_height = image->height;
 
 	return;
 }
 
 static void __completed_cb(void *user_data)
 {
+	camera_state_e state;
 	int ret = 0;
 	struct __camera_data *camera_data = user_data;
 
-	if (camera_data->capture_completed_cb)
-		camera_data->capture_completed_cb(camera_data->captured_file, camera_data->image_size, camera_data->capture_completed_cb_data);
+	if (camera_data->capture_completed_cb && camera_data->captured_file)
+		camera_data->capture_completed_cb(camera_data->captured_file, camera_data->image_size,
+			camera_data->captured_width, camera_data->captured_height, camera_data->capture_completed_cb_data);
 
 	camera_data->capture_completed_cb = NULL;
 	free(camera_data->captured_file);
@@ -262,6 +280,13 @@ static void __completed_cb(void *user_data)
 		return;
 	}
 
+	/* With zero shutter lag the preview never stopped */
+	ret = camera_get_state(camera_data->cam_handle, &state);
+	if (ret == CAMERA_ERROR_NONE && state == CAMERA_STATE_PREVIEW)
+		return;
+
+	__atomic_store_n(&camera_data->capture_done, true, __ATOMIC_RELEASE);
+
 	ret = camera_start_preview(camera_data->cam_handle);
 	if (ret != CAMERA_ERROR_NONE) {
 		_E("Failed to start preview [%s]", __cam_err_to_str(ret));
@@ -271,125 +296,187 @@ static void __completed_cb(void *user_data)
     return;
 }
 
-static void __start_capture(void *user_data)
+static int __start_capture(void *user_data)
 {
 	int ret = 0;
 	struct __camera_data *camera_data = user_data;
 
+	if (camera_data->capture_pauses_preview) {
+		__atomic_store_n(&camera_data->capture_done, false, __ATOMIC_RELAXED);
+		__atomic_store_n(&camera_data->capture_started_ms, __get_monotonic_ms(), __ATOMIC_RELEASE);
+	}
+
 	ret = camera_start_capture(camera_data->cam_handle, __capturing_cb, __completed_cb, camera_data);
 	if (ret != CAMERA_ERROR_NONE) {
 		_E("Failed to start capturing [%s]", __cam_err_to_str(ret));
-		return;
+		__atomic_store_n(&camera_data->capture_started_ms, 0, __ATOMIC_RELAXED);
+		return -1;
 	}
+
+	return 0;
 }
 
-static void __camera_preview_cb(camera_preview_data_s *frame, void *user_data)
+/* The first preview frame after a capture that paused the preview ends the gap */
+static void __measure_capture_gap(struct __camera_data *camera_data)
 {
-	struct __camera_data *camera_data = user_data;
-	static long long int last = 0;
-	long long int now = __get_monotonic_ms();
+	long long int started = __atomic_load_n(&camera_data->capture_started_ms, __ATOMIC_ACQUIRE);
+	unsigned int gap = 0;
+
+	if (!started || !__atomic_load_n(&camera_data->capture_done, __ATOMIC_ACQUIRE))
+		return;
+
+	__atomic_store_n(&camera_data->capture_started_ms, 0, __ATOMIC_RELAXED);
+	gap = __get_monotonic_ms() - started;
+
+	__atomic_add_fetch(&camera_data->capture_gap_total_ms, gap, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&camera_data->capture_gaps, 1, __ATOMIC_RELAXED);
+	if (gap > __atomic_load_n(&camera_data->capture_gap_max_ms, __ATOMIC_RELAXED))
+		__atomic_store_n(&camera_data->capture_gap_max_ms, gap, __ATOMIC_RELAXED);
+
+	_D("Camera[%d] preview was stopped %u ms for a capture", camera_data->stream_id, gap);
+}
+
+void resource_camera_deliver_preview(struct __camera_data *camera_data,
+	camera_preview_data_s *frame, bool paced)
+{
+	__measure_capture_gap(camera_data);
 
-	if (now - last < CAMERA_PREVIEW_INTERVAL_MIN)
+	if (paced && !frame_scheduler_should_deliver(camera_data->frame_scheduler, __get_monotonic_ms()))
 		return;
 
-	image_buffer_data_s *image_buffer_data = __make_preview_image_buffer_data(frame);
+	/* The main loop has not taken the previous frames yet */
+	if (paced && resource_camera_is_backlogged(camera_data))
+		frame_scheduler_notify_saturated(camera_data->frame_scheduler);
+
+	image_buffer_data_s *image_buffer_data = __make_preview_image_buffer_data(camera_data, frame);
 	if (image_buffer_data == NULL) {
-		_E("Failed to create mv source");
+		frame_scheduler_notify_saturated(camera_data->frame_scheduler);
 		return;
 	}
+
 	image_buffer_data->user_data = camera_data->preview_image_buffer_created_cb_data;
+	image_buffer_data->stream_id = camera_data->stream_id;
+	image_buffer_data->sequence = ++camera_data->frame_sequence;
 
-	ecore_main_loop_thread_safe_call_async(camera_data->preview_image_buffer_created_cb, image_buffer_data);
-	last = now;
+	frame_ring_push(camera_data->frame_ring, image_buffer_data);
 }
 
-int resource_camera_init(preview_image_buffer_created_cb preview_image_buffer_created_cb, void *user_data)
+bool resource_camera_is_backlogged(struct __camera_data *camera_data)
 {
-	int ret = CAMERA_ERROR_NONE;
+	frame_ring_stats_s stats;
+	unsigned long long pending = 0;
 
-	if (preview_image_buffer_created_cb == NULL)
-		return -1;
+	frame_ring_get_stats(camera_data->frame_ring, &stats);
+	pending = stats.pushed - stats.consumed - stats.overwritten - stats.dropped;
 
-	g_camera_data = malloc(sizeof(struct __camera_data));
-	if (g_camera_data == NULL) {
-		_E("Failed to allocate Camera data");
-		return -1;
-	}
-	memset(g_camera_data, 0, sizeof(struct __camera_data));
+	return pending >= stats.depth;
+}
+
+static void __camera_preview_cb(camera_preview_data_s *frame, void *user_data)
+{
+	resource_camera_deliver_preview(user_data, frame, true);
+}
+
+static void __frame_ring_consume_cb(image_buffer_data_s *frame, void *user_data)
+{
+	struct __camera_data *camera_data = user_data;
+
+	camera_data->preview_image_buffer_created_cb(frame);
 
-	ret = camera_create(CAMERA_DEVICE_CAMERA0, &(g_camera_data->cam_handle));
+	if (camera_data->source_ops->frame_consumed)
+		camera_data->source_ops->frame_consumed(camera_data);
+}
+
+static int __device_open(struct __camera_data *camera_data)
+{
+	int ret = CAMERA_ERROR_NONE;
+
+	ret = camera_create(CAMERA_DEVICE_CAMERA0 + camera_data->stream_id, &(camera_data->cam_handle));
 	if (ret != CAMERA_ERROR_NONE) {
 		_E("Failed to create camera [%s]", __cam_err_to_str(ret));
 		goto ERROR;
 	}
 
-	ret = camera_attr_set_image_quality(g_camera_data->cam_handle, CAMERA_IMAGE_QUALITY);
+	ret = camera_attr_set_image_quality(camera_data->cam_handle, CAMERA_IMAGE_QUALITY);
 	if (ret != CAMERA_ERROR_NONE) {
 		_E("Failed to set image quality [%s]", __cam_err_to_str(ret));
 		goto ERROR;
 	}
 
-	ret = camera_set_preview_resolution(g_camera_data->cam_handle, IMAGE_WIDTH, IMAGE_HEIGHT);
+	ret = camera_set_preview_resolution(camera_data->cam_handle,
+		camera_data->preview_width, camera_data->preview_height);
 	if (ret != CAMERA_ERROR_NONE) {
-		_E("Failed to set preview resolution [%s]", __cam_err_to_str(ret));
+		_E("Failed to set preview resolution %ux%u [%s]",
+			camera_data->preview_width, camera_data->preview_height, __cam_err_to_str(ret));
 		goto ERROR;
 	}
 
-	ret = camera_set_capture_resolution(g_camera_data->cam_handle, IMAGE_WIDTH, IMAGE_HEIGHT);
+	if (camera_data->capture_width) {
+		ret = camera_set_capture_resolution(camera_data->cam_handle,
+			camera_data->capture_width, camera_data->capture_height);
+	} else {
+		ret = camera_set_capture_resolution(camera_data->cam_handle,
+			camera_data->preview_width, camera_data->preview_height);
+	}
 	if (ret != CAMERA_ERROR_NONE) {
-		_E("Failed to set capture resolution [%s]", __cam_err_to_str(ret));
+		_E("Failed to set capture resolution %ux%u [%s]",
+			camera_data->capture_width, camera_data->capture_height, __cam_err_to_str(ret));
 		goto ERROR;
 	}
 
-	ret = camera_set_capture_format(g_camera_data->cam_handle, CAMERA_PIXEL_FORMAT_JPEG);
+	ret = camera_set_capture_format(camera_data->cam_handle, CAMERA_PIXEL_FORMAT_JPEG);
 	if (ret != CAMERA_ERROR_NONE) {
 		_E("Failed to set capture format [%s]", __cam_err_to_str(ret));
 		goto ERROR;
 	}
 
-	ret = camera_set_state_changed_cb(g_camera_data->cam_handle, __print_camera_state, NULL);
+	ret = camera_set_state_changed_cb(camera_data->cam_handle, __print_camera_state, NULL);
 	if (ret != CAMERA_ERROR_NONE) {
 		_E("Failed to set state changed callback [%s]", __cam_err_to_str(ret));
 		goto ERROR;
 	}
 
-	ret = camera_set_preview_cb(g_camera_data->cam_handle, __camera_preview_cb, g_camera_data);
+	ret = camera_set_preview_cb(camera_data->cam_handle, __camera_preview_cb, camera_data);
 	if (ret != CAMERA_ERROR_NONE) {
 		_E("Failed to set preview callback [%s]", __cam_err_to_str(ret));
 		goto ERROR;
 	}
 
-	ret = camera_attr_foreach_supported_af_mode(g_camera_data->cam_handle, __camera_attr_supported_af_mode_cb, g_camera_data);
+	ret = camera_attr_foreach_supported_af_mode(camera_data->cam_handle, __camera_attr_supported_af_mode_cb, camera_data);
 	if (ret != CAMERA_ERROR_NONE) {
 		_E("Failed to set auto focus attribute check callback [%s]", __cam_err_to_str(ret));
 		goto ERROR;
 	}
 
-	g_camera_data->preview_image_buffer_created_cb = preview_image_buffer_created_cb;
-	g_camera_data->preview_image_buffer_created_cb_data = user_data;
+	camera_data->capture_pauses_preview = !camera_is_supported_zero_shutter_lag(camera_data->cam_handle);
+	_I("Camera[%d] %s", camera_data->stream_id, camera_data->capture_pauses_preview ?
+		"stops the preview to capture" : "captures with zero shutter lag");
 
 	return 0;
 
 ERROR:
-	if (g_camera_data->cam_handle)
-		camera_destroy(g_camera_data->cam_handle);
+	if (camera_data->cam_handle)
+		camera_destroy(camera_data->cam_handle);
+	camera_data->cam_handle = NULL;
 
-	free(g_camera_data);
-	g_camera_data = NULL;
 	return -1;
 }
 
-int resource_camera_start_preview(void)
+static void __device_close(struct __camera_data *camera_data)
+{
+	camera_unset_preview_cb(camera_data->cam_handle);
+	camera_stop_preview(camera_data->cam_handle);
+
+	camera_destroy(camera_data->cam_handle);
+	camera_data->cam_handle = NULL;
+}
+
+static int __device_start_preview(struct __camera_data *camera_data)
 {
 	camera_state_e state;
 	int ret = CAMERA_ERROR_NONE;
 
-	if (g_camera_data == NULL) {
-		_I("Camera is not initialized");
-		return -1;
-	}
-
-	ret = camera_get_state(g_camera_data->cam_handle, &state);
+	ret = camera_get_state(camera_data->cam_handle, &state);
 	if (ret != CAMERA_ERROR_NONE) {
 		_E("Failed to get camera state [%s]", __cam_err_to_str(ret));
 		return -1;
@@ -401,7 +488,7 @@ int resource_camera_start_preview(void)
 	}
 
 	if (state != CAMERA_STATE_PREVIEW) {
-		ret = camera_start_preview(g_camera_data->cam_handle);
+		ret = camera_start_preview(camera_data->cam_handle);
 		if (ret != CAMERA_ERROR_NONE) {
 			_E("Failed to start preview [%s]", __cam_err_to_str(ret));
 			return -1;
@@ -411,17 +498,12 @@ int resource_camera_start_preview(void)
 	return 0;
 }
 
-int resource_camera_capture(capture_completed_cb capture_completed_cb, void *user_data)
+static int __device_capture(struct __camera_data *camera_data)
 {
 	camera_state_e state;
 	int ret = CAMERA_ERROR_NONE;
 
-	if (g_camera_data == NULL) {
-		_I("Camera is not initialized");
-		return -1;
-	}
-
-	ret = camera_get_state(g_camera_data->cam_handle, &state);
+	ret = camera_get_state(camera_data->cam_handle, &state);
 	if (ret != CAMERA_ERROR_NONE) {
 		_E("Failed to get camera state [%s]", __cam_err_to_str(ret));
 		return -1;
@@ -434,33 +516,22 @@ int resource_camera_capture(capture_completed_cb capture_completed_cb, void *use
 
 	if (state != CAMERA_STATE_PREVIEW) {
 		_I("Preview is not started [%d]", state);
-		ret = camera_start_preview(g_camera_data->cam_handle);
+		ret = camera_start_preview(camera_data->cam_handle);
 		if (ret != CAMERA_ERROR_NONE) {
 			_E("Failed to start preview [%s]", __cam_err_to_str(ret));
 			return -1;
 		}
 	}
 
-	__start_capture(g_camera_data);
-
-	g_camera_data->capture_completed_cb = capture_completed_cb;
-	g_camera_data->capture_completed_cb_data = user_data;
-
-	return 0;
+	return __start_capture(camera_data);
 }
 
-
-int resource_camera_stop_preview(void)
+static int __device_stop_preview(struct __camera_data *camera_data)
 {
 	camera_state_e state;
 	int ret = CAMERA_ERROR_NONE;
 
-	if (g_camera_data == NULL) {
-		_I("Camera is not initialized");
-		return -1;
-	}
-
-	ret = camera_get_state(g_camera_data->cam_handle, &state);
+	ret = camera_get_state(camera_data->cam_handle, &state);
 	if (ret != CAMERA_ERROR_NONE) {
 		_E("Failed to get camera state [%s]", __cam_err_to_str(ret));
 		return -1;
@@ -472,7 +543,7 @@ int resource_camera_stop_preview(void)
 	}
 
 	if (state == CAMERA_STATE_PREVIEW) {
-		ret = camera_stop_preview(g_camera_data->cam_handle);
+		ret = camera_stop_preview(camera_data->cam_handle);
 		if (ret != CAMERA_ERROR_NONE) {
 			_E("Failed to stop preview [%s]", __cam_err_to_str(ret));
 			return -1;
@@ -482,21 +553,335 @@ int resource_camera_stop_preview(void)
 	return 0;
 }
 
+const camera_source_ops_s camera_source_device_ops = {
+	.name = "device",
+	.open = __device_open,
+	.close = __device_close,
+	.start_preview = __device_start_preview,
+	.stop_preview = __device_stop_preview,
+	.capture = __device_capture,
+};
+
+static const camera_source_ops_s *__get_source_ops(int stream_id)
+{
+	const camera_source_ops_s *ops = &camera_source_device_ops;
+	char *source = controller_config_get_stream_string(stream_id, CONFIG_KEY_CAMERA_SOURCE, camera_source_device_ops.name);
+
+	if (source && !strcmp(source, camera_source_replay_ops.name))
+		ops = &camera_source_replay_ops;
+	else if (source && strcmp(source, camera_source_device_ops.name))
+		_W("Unknown camera source [%s], use device", source);
+
+	free(source);
+
+	return ops;
+}
+
+static frame_scheduler_s *__create_frame_scheduler(int stream_id)
+{
+	frame_scheduler_config_s config;
+	int active_interval = 0;
+	int idle_interval = 0;
+	int idle_timeout = 0;
+
+	active_interval = controller_config_get_stream_int(stream_id,
+		CONFIG_KEY_RATE_ACTIVE_INTERVAL, CAMERA_PREVIEW_INTERVAL_MIN);
+	idle_interval = controller_config_get_stream_int(stream_id,
+		CONFIG_KEY_RATE_IDLE_INTERVAL, CAMERA_PREVIEW_IDLE_INTERVAL);
+	idle_timeout = controller_config_get_stream_int(stream_id,
+		CONFIG_KEY_RATE_IDLE_TIMEOUT, CAMERA_PREVIEW_IDLE_TIMEOUT);
+
+	config.active_interval = active_interval > 0 ? active_interval : CAMERA_PREVIEW_INTERVAL_MIN;
+	config.idle_interval = idle_interval > 0 ? idle_interval : CAMERA_PREVIEW_IDLE_INTERVAL;
+	config.idle_timeout = idle_timeout > 0 ? idle_timeout : CAMERA_PREVIEW_IDLE_TIMEOUT;
+	config.backoff_max = CAMERA_PREVIEW_BACKOFF_MAX;
+	config.backoff_recover = CAMERA_PREVIEW_BACKOFF_RECOVER;
+
+	_I("Camera[%d] preview interval %u ms, idle %u ms after %u ms without motion",
+		stream_id, config.active_interval, config.idle_interval, config.idle_timeout);
+
+	return frame_scheduler_create(&config);
+}
+
+int resource_camera_init(int stream_id, preview_image_buffer_created_cb preview_image_buffer_created_cb,
+	void *user_data, resource_camera_h *camera)
+{
+	struct __camera_data *camera_data = NULL;
+	int width = 0;
+	int height = 0;
+	int ring_depth = 0;
+
+	if (preview_image_buffer_created_cb == NULL || camera == NULL)
+		return -1;
+
+	camera_data = malloc(sizeof(struct __camera_data));
+	if (camera_data == NULL) {
+		_E("Failed to allocate Camera data");
+		return -1;
+	}
+	memset(camera_data, 0, sizeof(struct __camera_data));
+	camera_data->stream_id = stream_id;
+
+	ring_depth = controller_config_get_stream_int(stream_id,
+		CONFIG_KEY_FRAME_RING_DEPTH, CAMERA_FRAME_RING_DEPTH_DEFAULT);
+	if (ring_depth < 1 || ring_depth > CAMERA_FRAME_RING_DEPTH_MAX) {
+		_W("Camera[%d] frame ring depth %d out of 1 ~ %d, clamped",
+			stream_id, ring_depth, CAMERA_FRAME_RING_DEPTH_MAX);
+		ring_depth = ring_depth < 1 ? 1 : CAMERA_FRAME_RING_DEPTH_MAX;
+	}
+	camera_data->frame_ring_depth = ring_depth;
+
+	camera_data->frame_ring = frame_ring_create(camera_data->frame_ring_depth,
+		__frame_ring_consume_cb, camera_data);
+	if (camera_data->frame_ring == NULL) {
+		_E("Failed to create frame ring");
+		goto ERROR;
+	}
+
+	camera_data->preview_image_buffer_created_cb = preview_image_buffer_created_cb;
+	camera_data->preview_image_buffer_created_cb_data = user_data;
+
+	width = controller_config_get_stream_int(stream_id, CONFIG_KEY_PREVIEW_WIDTH, IMAGE_WIDTH);
+	height = controller_config_get_stream_int(stream_id, CONFIG_KEY_PREVIEW_HEIGHT, IMAGE_HEIGHT);
+	if (width <= 0 || height <= 0) {
+		_W("Camera[%d] invalid preview resolution %dx%d, use default", stream_id, width, height);
+		width = IMAGE_WIDTH;
+		height = IMAGE_HEIGHT;
+	}
+	camera_data->preview_width = width;
+	camera_data->preview_height = height;
+
+	width = controller_config_get_stream_int(stream_id, CONFIG_KEY_CAPTURE_WIDTH, 0);
+	height = controller_config_get_stream_int(stream_id, CONFIG_KEY_CAPTURE_HEIGHT, 0);
+	if (width > 0 && height > 0) {
+		camera_data->capture_width = width;
+		camera_data->capture_height = height;
+	}
+
+	camera_data->frame_scheduler = __create_frame_scheduler(stream_id);
+	if (camera_data->frame_scheduler == NULL) {
+		_E("Failed to create frame scheduler");
+		goto ERROR;
+	}
+
+	camera_data->source_ops = __get_source_ops(stream_id);
+	_I("Camera[%d] source : %s, preview %ux%u, capture %ux%u", stream_id, camera_data->source_ops->name,
+		camera_data->preview_width, camera_data->preview_height,
+		camera_data->capture_width, camera_data->capture_height);
+
+	if (camera_data->source_ops->open(camera_data)) {
+		_E("Failed to open %s camera source", camera_data->source_ops->name);
+		goto ERROR;
+	}
+
+	*camera = camera_data;
+
+	return 0;
+
+ERROR:
+	frame_scheduler_destroy(camera_data->frame_scheduler);
+	frame_ring_destroy(camera_data->frame_ring);
+	free(camera_data);
+	return -1;
+}
+
+int resource_camera_start_preview(resource_camera_h camera)
+{
+	if (camera == NULL) {
+		_I("Camera is not initialized");
+		return -1;
+	}
+
+	return camera->source_ops->start_preview(camera);
+}
+
+int resource_camera_capture(resource_camera_h camera, capture_completed_cb capture_completed_cb, void *user_data)
+{
+	if (camera == NULL) {
+		_I("Camera is not initialized");
+		return -1;
+	}
+
+	camera->capture_completed_cb = capture_completed_cb;
+	camera->capture_completed_cb_data = user_data;
+
+	if (camera->source_ops->capture(camera)) {
+		camera->capture_completed_cb = NULL;
+		camera->capture_completed_cb_data = NULL;
+		return -1;
+	}
+
+	return 0;
+}
+
+void resource_camera_get_preview_resolution(resource_camera_h camera, unsigned int *width, unsigned int *height)
+{
+	ret_if(!camera);
+
+	if (width)
+		*width = camera->preview_width;
+	if (height)
+		*height = camera->preview_height;
+}
+
+int resource_camera_get_capture_resolution(resource_camera_h camera, unsigned int *width, unsigned int *height)
+{
+	retv_if(!camera, -1);
+
+	if (!camera->capture_width)
+		return -1;
+
+	if (width)
+		*width = camera->capture_width;
+	if (height)
+		*height = camera->capture_height;
+
+	return 0;
+}
+
+bool resource_camera_capture_pauses_preview(resource_camera_h camera)
+{
+	retv_if(!camera, false);
+
+	return camera->capture_pauses_preview;
+}
+
+int resource_camera_stop_preview(resource_camera_h camera)
+{
+	if (camera == NULL) {
+		_I("Camera is not initialized");
+		return -1;
+	}
+
+	return camera->source_ops->stop_preview(camera);
+}
+
 
-void resource_camera_close(void)
+void resource_camera_close(resource_camera_h camera)
 {
-	if (g_camera_data == NULL)
+	if (camera == NULL)
 		return;
 
-	camera_unset_preview_cb(g_camera_data->cam_handle);
-	camera_stop_preview(g_camera_data->cam_handle);
+	camera->source_ops->close(camera);
 
-	camera_destroy(g_camera_data->cam_handle);
-	g_camera_data->cam_handle = NULL;
+	free(camera->captured_file);
+	camera->captured_file = NULL;
 
-	free(g_camera_data->captured_file);
-	g_camera_data->captured_file = NULL;
+	if (camera->frame_ring) {
+		frame_ring_stats_s stats;
+
+		frame_ring_get_stats(camera->frame_ring, &stats);
+		_I("Camera[%d] frame ring : pushed[%llu] consumed[%llu] overwritten[%llu] dropped[%llu] wakeups[%llu] max batch[%u]",
+			camera->stream_id, stats.pushed, stats.consumed, stats.overwritten, stats.dropped, stats.wakeups, stats.max_batch);
+
+		frame_ring_destroy(camera->frame_ring);
+		camera->frame_ring = NULL;
+	}
+
+	if (camera->frame_pool) {
+		frame_pool_stats_s stats;
+
+		frame_pool_get_stats(camera->frame_pool, &stats);
+		_I("Camera[%d] frame pool : acquired[%llu] exhausted[%llu] high water mark[%u/%u]",
+			camera->stream_id, stats.acquired, stats.exhausted, stats.high_water_mark, stats.frame_count);
+
+		frame_pool_destroy(camera->frame_pool);
+		camera->frame_pool = NULL;
+	}
+
+	if (camera->capture_gaps) {
+		_I("Camera[%d] preview stopped by %llu captures : %llu ms avg, %u ms max",
+			camera->stream_id, camera->capture_gaps,
+			camera->capture_gap_total_ms / camera->capture_gaps, camera->capture_gap_max_ms);
+	}
+
+	if (camera->frame_scheduler) {
+		frame_scheduler_stats_s stats;
+
+		frame_scheduler_get_stats(camera->frame_scheduler, &stats);
+		_I("Camera[%d] frame scheduler : offered[%llu] delivered[%llu] motion[%llu] saturation[%llu] state changes[%llu]",
+			camera->stream_id, stats.offered, stats.delivered, stats.motion_events,
+			stats.saturation_events, stats.state_changes);
+
+		frame_scheduler_destroy(camera->frame_scheduler);
+		camera->frame_scheduler = NULL;
+	}
+
+	free(camera);
+}
+
+int resource_camera_get_frame_pool_stats(resource_camera_h camera, frame_pool_stats_s *stats)
+{
+	retv_if(!stats, -1);
+
+	if (camera == NULL) {
+		_I("Camera is not initialized");
+		return -1;
+	}
+
+	frame_pool_get_stats(camera->frame_pool, stats);
+
+	return 0;
+}
+
+int resource_camera_get_frame_ring_stats(resource_camera_h camera, frame_ring_stats_s *stats)
+{
+	retv_if(!stats, -1);
+
+	if (camera == NULL) {
+		_I("Camera is not initialized");
+		return -1;
+	}
+
+	frame_ring_get_stats(camera->frame_ring, stats);
+
+	return 0;
+}
+
+int resource_camera_get_frame_scheduler_stats(resource_camera_h camera, frame_scheduler_stats_s *stats)
+{
+	retv_if(!stats, -1);
+
+	if (camera == NULL) {
+		_I("Camera is not initialized");
+		return -1;
+	}
+
+	frame_scheduler_get_stats(camera->frame_scheduler, stats);
+
+	return 0;
+}
+
+int resource_camera_get_capture_stats(resource_camera_h camera, camera_capture_stats_s *stats)
+{
+	unsigned long long gaps = 0;
+
+	retv_if(!stats, -1);
+
+	if (camera == NULL) {
+		_I("Camera is not initialized");
+		return -1;
+	}
+
+	gaps = __atomic_load_n(&camera->capture_gaps, __ATOMIC_RELAXED);
+	stats->pauses_preview = camera->capture_pauses_preview;
+	stats->gaps = gaps;
+	stats->gap_average_ms = gaps ? __atomic_load_n(&camera->capture_gap_total_ms, __ATOMIC_RELAXED) / gaps : 0;
+	stats->gap_max_ms = __atomic_load_n(&camera->capture_gap_max_ms, __ATOMIC_RELAXED);
+
+	return 0;
+}
+
+void resource_camera_notify_motion(resource_camera_h camera)
+{
+	ret_if(!camera);
+
+	frame_scheduler_notify_motion(camera->frame_scheduler);
+}
+
+void resource_camera_notify_saturated(resource_camera_h camera)
+{
+	ret_if(!camera);
 
-	free(g_camera_data);
-	g_camera_data = NULL;
+	frame_scheduler_notify_saturated(camera->frame_scheduler);
 }
@@ -0,0 +1,644 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <glib.h>
+#include <tizen.h>
+#include <image_util.h>
+
+#include "log.h"
+#include "controller.h"
+#include "controller_config.h"
+#include "resource_camera_internal.h"
+
+#define REPLAY_DEFAULT_FPS 15
+/* a frame dropped by the ring is not reported, so the wait is bounded */
+#define REPLAY_BACKLOG_WAIT_MAX_MS 100
+#define REPLAY_JPEG_GAP_MAX_MS 1000
+
+typedef enum {
+	REPLAY_FORMAT_NV12,
+	REPLAY_FORMAT_I420,
+	REPLAY_FORMAT_YUYV,
+	REPLAY_FORMAT_JPEG,
+} replay_format_e;
+
+typedef enum {
+	REPLAY_PACING_REALTIME, // camera-like : frame timestamps and the preview interval gate
+	REPLAY_PACING_FAST, // as fast as the pipeline consumes frames
+	REPLAY_PACING_FIXED, // exactly camera.replay.fps
+} replay_pacing_e;
+
+struct __replay_data {
+	char *path;
+	replay_format_e format;
+	replay_pacing_e pacing;
+	unsigned int width;
+	unsigned int height;
+	unsigned int fps;
+	bool loop;
+
+	pthread_t thread;
+	bool thread_created;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	bool previewing;
+	bool quit;
+
+	/* raw file */
+	int fd;
+	unsigned char *frame_buffer;
+	unsigned int frame_size;
+	unsigned long long frame_index;
+
+	/* JPEG directory */
+	struct dirent **entries;
+	int entry_count;
+	int entry_index;
+	char *current_jpeg;
+	image_util_decode_h decode_h;
+	/* JPEG files are decoded at 1/2^downscale to get near the preview size */
+	unsigned int downscale;
+	unsigned int preview_width;
+	unsigned int preview_height;
+	unsigned int jpeg_width;
+	unsigned int jpeg_height;
+	long long int last_mtime_ms;
+};
+
+static long long int __timespec_to_ms(const struct timespec *ts)
+{
+	return ts->tv_sec * 1000LL + ts->tv_nsec / 1000000;
+}
+
+static long long int __get_monotonic_ms(void)
+{
+	struct timespec time_s;
+
+	clock_gettime(CLOCK_MONOTONIC, &time_s);
+
+	return __timespec_to_ms(&time_s);
+}
+
+static replay_format_e __get_format(const char *path, const char *name)
+{
+	struct stat st;
+	const char *ext = NULL;
+
+	if (name) {
+		if (!strcasecmp(name, "nv12"))
+			return REPLAY_FORMAT_NV12;
+		if (!strcasecmp(name, "i420"))
+			return REPLAY_FORMAT_I420;
+		if (!strcasecmp(name, "yuyv"))
+			return REPLAY_FORMAT_YUYV;
+		if (!strcasecmp(name, "jpeg"))
+			return REPLAY_FORMAT_JPEG;
+		_W("Unknown replay format [%s]", name);
+	}
+
+	if (!stat(path, &st) && S_ISDIR(st.st_mode))
+		return REPLAY_FORMAT_JPEG;
+
+	ext = strrchr(path, '.');
+	if (ext && !strcasecmp(ext, ".nv12"))
+		return REPLAY_FORMAT_NV12;
+	if (ext && !strcasecmp(ext, ".yuyv"))
+		return REPLAY_FORMAT_YUYV;
+
+	return REPLAY_FORMAT_I420;
+}
+
+static replay_pacing_e __get_pacing(const char *name)
+{
+	if (!name || !strcmp(name, "realtime"))
+		return REPLAY_PACING_REALTIME;
+	if (!strcmp(name, "fast"))
+		return REPLAY_PACING_FAST;
+	if (!strcmp(name, "fixed"))
+		return REPLAY_PACING_FIXED;
+
+	_W("Unknown replay pacing [%s], use realtime", name);
+	return REPLAY_PACING_REALTIME;
+}
+
+static int __jpeg_filter(const struct dirent *entry)
+{
+	const char *ext = strrchr(entry->d_name, '.');
+
+	return ext && (!strcasecmp(ext, ".jpg") || !strcasecmp(ext, ".jpeg"));
+}
+
+/* One 4:2:0 chroma plane, odd sizes round up */
+static unsigned int __get_chroma_size(unsigned int width, unsigned int height)
+{
+	return ((width + 1) / 2) * ((height + 1) / 2);
+}
+
+static int __open_raw(struct __replay_data *replay)
+{
+	switch (replay->format) {
+	case REPLAY_FORMAT_NV12:
+	case REPLAY_FORMAT_I420:
+		replay->frame_size = replay->width * replay->height
+			+ 2 * __get_chroma_size(replay->width, replay->height);
+		break;
+	case REPLAY_FORMAT_YUYV:
+		replay->frame_size = replay->width * replay->height * 2;
+		break;
+	default:
+		return -1;
+	}
+
+	replay->fd = open(replay->path, O_RDONLY | O_CLOEXEC);
+	retvm_if(replay->fd < 0, -1, "Failed to open [%s] - %d", replay->path, errno);
+
+	replay->frame_buffer = malloc(replay->frame_size);
+	retvm_if(!replay->frame_buffer, -1, "Failed to allocate replay frame");
+
+	return 0;
+}
+
+static int __open_jpeg(struct __replay_data *replay)
+{
+	int ret = 0;
+
+	replay->entry_count = scandir(replay->path, &replay->entries, __jpeg_filter, alphasort);
+	retvm_if(replay->entry_count <= 0, -1, "No JPEG file in [%s]", replay->path);
+
+	ret = image_util_decode_create(&replay->decode_h);
+	retvm_if(ret != IMAGE_UTIL_ERROR_NONE, -1, "image_util_decode_create [%s]", get_error_message(ret));
+
+	return 0;
+}
+
+/* Returns 1 at the end of the stream */
+static int __read_raw(struct __replay_data *replay, camera_preview_data_s *frame)
+{
+	unsigned int y_size = replay->width * replay->height;
+	unsigned int c_size = __get_chroma_size(replay->width, replay->height);
+	ssize_t len = 0;
+
+	len = pread(replay->fd, replay->frame_buffer, replay->frame_size,
+		(off_t)(replay->frame_index * replay->frame_size));
+	if (len != (ssize_t)replay->frame_size) {
+		if (!replay->loop || replay->frame_index == 0)
+			return 1;
+
+		replay->frame_index = 0;
+		return __read_raw(replay, frame);
+	}
+	replay->frame_index++;
+
+	memset(frame, 0, sizeof(camera_preview_data_s));
+	frame->width = replay->width;
+	frame->height = replay->height;
+
+	switch (replay->format) {
+	case REPLAY_FORMAT_NV12:
+		frame->format = CAMERA_PIXEL_FORMAT_NV12;
+		frame->num_of_planes = 2;
+		frame->data.double_plane.y = replay->frame_buffer;
+		frame->data.double_plane.y_size = y_size;
+		frame->data.double_plane.uv = replay->frame_buffer + y_size;
+		frame->data.double_plane.uv_size = 2 * c_size;
+		break;
+	case REPLAY_FORMAT_I420:
+		frame->format = CAMERA_PIXEL_FORMAT_I420;
+		frame->num_of_planes = 3;
+		frame->data.triple_plane.y = replay->frame_buffer;
+		frame->data.triple_plane.y_size = y_size;
+		frame->data.triple_plane.u = replay->frame_buffer + y_size;
+		frame->data.triple_plane.u_size = c_size;
+		frame->data.triple_plane.v = replay->frame_buffer + y_size + c_size;
+		frame->data.triple_plane.v_size = c_size;
+		break;
+	default:
+		frame->format = CAMERA_PIXEL_FORMAT_YUYV;
+		frame->num_of_planes = 1;
+		frame->data.single_plane.yuv = replay->frame_buffer;
+		frame->data.single_plane.size = replay->frame_size;
+		break;
+	}
+
+	return 0;
+}
+
+static image_util_scale_e __get_jpeg_downscale(unsigned int downscale)
+{
+	switch (downscale) {
+	case 1:
+		return IMAGE_UTIL_DOWNSCALE_1_2;
+	case 2:
+		return IMAGE_UTIL_DOWNSCALE_1_4;
+	case 3:
+		return IMAGE_UTIL_DOWNSCALE_1_8;
+	default:
+		return IMAGE_UTIL_DOWNSCALE_1_1;
+	}
+}
+
+/* Smallest decode that still covers the preview resolution */
+static unsigned int __choose_jpeg_downscale(struct __replay_data *replay,
+	unsigned long width, unsigned long height)
+{
+	unsigned int downscale = 0;
+
+	while (downscale < 3
+		&& (width >> (downscale + 1)) >= replay->preview_width
+		&& (height >> (downscale + 1)) >= replay->preview_height)
+		downscale++;
+
+	if (downscale)
+		_I("Replay decodes %lux%lu JPEG files at 1/%u", width, height, 1U << downscale);
+
+	return downscale;
+}
+
+/* Returns 1 at the end of the stream, *gap_ms gets the file time delta */
+static int __read_jpeg(struct __replay_data *replay, camera_preview_data_s *frame, long long int *gap_ms)
+{
+	unsigned long width = 0;
+	unsigned long height = 0;
+	unsigned long long size = 0;
+	unsigned int y_size = 0;
+	unsigned int c_size = 0;
+	struct stat st;
+	char *path = NULL;
+	int ret = 0;
+
+	if (replay->entry_index >= replay->entry_count) {
+		if (!replay->loop)
+			return 1;
+		replay->entry_index = 0;
+		replay->last_mtime_ms = 0;
+	}
+
+	path = g_strconcat(replay->path, "/", replay->entries[replay->entry_index]->d_name, NULL);
+	replay->entry_index++;
+
+	*gap_ms = 0;
+	if (!stat(path, &st)) {
+		long long int mtime_ms = __timespec_to_ms(&st.st_mtim);
+
+		if (replay->last_mtime_ms && mtime_ms > replay->last_mtime_ms)
+			*gap_ms = mtime_ms - replay->last_mtime_ms;
+		replay->last_mtime_ms = mtime_ms;
+	}
+
+	free(replay->frame_buffer);
+	replay->frame_buffer = NULL;
+
+	ret = image_util_decode_set_input_path(replay->decode_h, path);
+	if (ret == IMAGE_UTIL_ERROR_NONE)
+		ret = image_util_decode_set_colorspace(replay->decode_h, IMAGE_UTIL_COLORSPACE_I420);
+	if (ret == IMAGE_UTIL_ERROR_NONE)
+		ret = image_util_decode_set_jpeg_downscale(replay->decode_h, __get_jpeg_downscale(replay->downscale));
+	if (ret == IMAGE_UTIL_ERROR_NONE)
+		ret = image_util_decode_set_output_buffer(replay->decode_h, &replay->frame_buffer);
+	if (ret == IMAGE_UTIL_ERROR_NONE)
+		ret = image_util_decode_run(replay->decode_h, &width, &height, &size);
+
+	if (ret != IMAGE_UTIL_ERROR_NONE || !replay->frame_buffer) {
+		_E("Failed to decode [%s] - [%s]", path, get_error_message(ret));
+		g_free(path);
+		return -1;
+	}
+
+	pthread_mutex_lock(&replay->mutex);
+	g_free(replay->current_jpeg);
+	replay->current_jpeg = path;
+	replay->jpeg_width = width << replay->downscale;
+	replay->jpeg_height = height << replay->downscale;
+	pthread_mutex_unlock(&replay->mutex);
+
+	/* Footage is expected to keep one size, so pick the scale once */
+	if (replay->downscale == 0)
+		replay->downscale = __choose_jpeg_downscale(replay, width, height);
+
+	y_size = width * height;
+	c_size = __get_chroma_size(width, height);
+
+	memset(frame, 0, sizeof(camera_preview_data_s));
+	frame->format = CAMERA_PIXEL_FORMAT_I420;
+	frame->width = width;
+	frame->height = height;
+	frame->num_of_planes = 3;
+	frame->data.triple_plane.y = replay->frame_buffer;
+	frame->data.triple_plane.y_size = y_size;
+	frame->data.triple_plane.u = replay->frame_buffer + y_size;
+	frame->data.triple_plane.u_size = c_size;
+	frame->data.triple_plane.v = replay->frame_buffer + y_size + c_size;
+	frame->data.triple_plane.v_size = c_size;
+
+	return 0;
+}
+
+/* Sleeps until deadline or until told to stop. Returns false on quit. */
+static bool __wait_until(struct __replay_data *replay, long long int deadline_ms)
+{
+	struct timespec ts;
+	bool quit = false;
+
+	ts.tv_sec = deadline_ms / 1000;
+	ts.tv_nsec = (deadline_ms % 1000) * 1000000;
+
+	pthread_mutex_lock(&replay->mutex);
+	while (!replay->quit && replay->previewing && __get_monotonic_ms() < deadline_ms) {
+		if (pthread_cond_timedwait(&replay->cond, &replay->mutex, &ts) == ETIMEDOUT)
+			break;
+	}
+	quit = replay->quit;
+	pthread_mutex_unlock(&replay->mutex);
+
+	return !quit;
+}
+
+/* Sleeps while the main loop has frames to take. Returns false on quit. */
+static bool __wait_consumed(struct __replay_data *replay, struct __camera_data *camera_data)
+{
+	bool quit = false;
+
+	pthread_mutex_lock(&replay->mutex);
+	while (!replay->quit && replay->previewing && resource_camera_is_backlogged(camera_data)) {
+		struct timespec ts;
+		long long int deadline_ms = __get_monotonic_ms() + REPLAY_BACKLOG_WAIT_MAX_MS;
+
+		ts.tv_sec = deadline_ms / 1000;
+		ts.tv_nsec = (deadline_ms % 1000) * 1000000;
+		pthread_cond_timedwait(&replay->cond, &replay->mutex, &ts);
+	}
+	quit = replay->quit;
+	pthread_mutex_unlock(&replay->mutex);
+
+	return !quit;
+}
+
+static void *__replay_thread(void *data)
+{
+	struct __camera_data *camera_data = data;
+	struct __replay_data *replay = camera_data->source_data;
+	camera_preview_data_s frame;
+	long long int next_ms = 0;
+	unsigned int interval_ms = 1000 / replay->fps;
+	int failed = 0;
+	int ret = 0;
+
+	while (1) {
+		long long int gap_ms = interval_ms;
+
+		pthread_mutex_lock(&replay->mutex);
+		while (!replay->quit && !replay->previewing)
+			pthread_cond_wait(&replay->cond, &replay->mutex);
+		if (replay->quit) {
+			pthread_mutex_unlock(&replay->mutex);
+			break;
+		}
+		pthread_mutex_unlock(&replay->mutex);
+
+		if (replay->format == REPLAY_FORMAT_JPEG) {
+			ret = __read_jpeg(replay, &frame, &gap_ms);
+			if (replay->pacing != REPLAY_PACING_REALTIME || gap_ms <= 0 || gap_ms > REPLAY_JPEG_GAP_MAX_MS)
+				gap_ms = interval_ms;
+		} else {
+			ret = __read_raw(replay, &frame);
+		}
+
+		if (ret > 0) {
+			_I("Replay of [%s] finished", replay->path);
+			break;
+		} else if (ret < 0) {
+			/* A whole pass without one good frame would only spin */
+			if (++failed >= replay->entry_count) {
+				_E("Replay of [%s] stopped, no decodable frame", replay->path);
+				break;
+			}
+			if (!__wait_until(replay, __get_monotonic_ms() + interval_ms))
+				break;
+			continue;
+		}
+		failed = 0;
+
+		if (replay->pacing == REPLAY_PACING_FAST) {
+			if (!__wait_consumed(replay, camera_data))
+				break;
+		} else {
+			/* Absolute schedule, so decoding time does not add drift */
+			long long int now = __get_monotonic_ms();
+
+			next_ms = next_ms ? next_ms + gap_ms : now;
+			if (next_ms < now - REPLAY_JPEG_GAP_MAX_MS)
+				next_ms = now;
+			if (!__wait_until(replay, next_ms))
+				break;
+		}
+
+		resource_camera_deliver_preview(camera_data, &frame, replay->pacing == REPLAY_PACING_REALTIME);
+	}
+
+	return NULL;
+}
+
+static void __replay_close(struct __camera_data *camera_data)
+{
+	struct __replay_data *replay = camera_data->source_data;
+	int i = 0;
+
+	ret_if(!replay);
+
+	if (replay->thread_created) {
+		pthread_mutex_lock(&replay->mutex);
+		replay->quit = true;
+		pthread_cond_broadcast(&replay->cond);
+		pthread_mutex_unlock(&replay->mutex);
+		pthread_join(replay->thread, NULL);
+	}
+
+	if (replay->fd >= 0)
+		close(replay->fd);
+
+	for (i = 0; i < replay->entry_count; i++)
+		free(replay->entries[i]);
+	free(replay->entries);
+
+	if (replay->decode_h)
+		image_util_decode_destroy(replay->decode_h);
+
+	pthread_cond_destroy(&replay->cond);
+	pthread_mutex_destroy(&replay->mutex);
+
+	g_free(replay->current_jpeg);
+	free(replay->frame_buffer);
+	free(replay->path);
+	free(replay);
+
+	camera_data->source_data = NULL;
+}
+
+static int __replay_open(struct __camera_data *camera_data)
+{
+	struct __replay_data *replay = NULL;
+	pthread_condattr_t attr;
+	char *format = NULL;
+	char *pacing = NULL;
+	int fps = 0;
+	int ret = 0;
+
+	replay = calloc(1, sizeof(struct __replay_data));
+	retvm_if(!replay, -1, "Failed to allocate replay data");
+
+	replay->fd = -1;
+	pthread_mutex_init(&replay->mutex, NULL);
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&replay->cond, &attr);
+	pthread_condattr_destroy(&attr);
+	camera_data->source_data = replay;
+
+	replay->path = controller_config_get_stream_string(camera_data->stream_id, CONFIG_KEY_REPLAY_PATH, NULL);
+	goto_if(!replay->path, ERROR);
+
+	format = controller_config_get_stream_string(camera_data->stream_id, CONFIG_KEY_REPLAY_FORMAT, NULL);
+	replay->format = __get_format(replay->path, format);
+	free(format);
+
+	pacing = controller_config_get_stream_string(camera_data->stream_id, CONFIG_KEY_REPLAY_PACING, NULL);
+	replay->pacing = __get_pacing(pacing);
+	free(pacing);
+
+	replay->preview_width = camera_data->preview_width;
+	replay->preview_height = camera_data->preview_height;
+	replay->width = controller_config_get_stream_int(camera_data->stream_id, CONFIG_KEY_REPLAY_WIDTH, camera_data->preview_width);
+	replay->height = controller_config_get_stream_int(camera_data->stream_id, CONFIG_KEY_REPLAY_HEIGHT, camera_data->preview_height);
+	replay->loop = controller_config_get_stream_int(camera_data->stream_id, CONFIG_KEY_REPLAY_LOOP, 1);
+	fps = controller_config_get_stream_int(camera_data->stream_id, CONFIG_KEY_REPLAY_FPS, REPLAY_DEFAULT_FPS);
+	replay->fps = fps > 0 ? fps : REPLAY_DEFAULT_FPS;
+
+	if (replay->format == REPLAY_FORMAT_JPEG)
+		ret = __open_jpeg(replay);
+	else
+		ret = __open_raw(replay);
+	goto_if(ret, ERROR);
+
+	ret = pthread_create(&replay->thread, NULL, __replay_thread, camera_data);
+	goto_if(ret, ERROR);
+	replay->thread_created = true;
+
+	_I("Replay [%s] format[%d] pacing[%d] %ux%u@%u", replay->path,
+		replay->format, replay->pacing, replay->width, replay->height, replay->fps);
+
+	return 0;
+
+ERROR:
+	__replay_close(camera_data);
+	return -1;
+}
+
+static int __replay_set_previewing(struct __camera_data *camera_data, bool previewing)
+{
+	struct __replay_data *replay = camera_data->source_data;
+
+	retv_if(!replay, -1);
+
+	pthread_mutex_lock(&replay->mutex);
+	replay->previewing = previewing;
+	pthread_cond_broadcast(&replay->cond);
+	pthread_mutex_unlock(&replay->mutex);
+
+	return 0;
+}
+
+static int __replay_start_preview(struct __camera_data *camera_data)
+{
+	return __replay_set_previewing(camera_data, true);
+}
+
+static int __replay_stop_preview(struct __camera_data *camera_data)
+{
+	return __replay_set_previewing(camera_data, false);
+}
+
+static void __replay_frame_consumed(struct __camera_data *camera_data)
+{
+	struct __replay_data *replay = camera_data->source_data;
+
+	ret_if(!replay);
+
+	pthread_mutex_lock(&replay->mutex);
+	pthread_cond_broadcast(&replay->cond);
+	pthread_mutex_unlock(&replay->mutex);
+}
+
+static int __replay_capture(struct __camera_data *camera_data)
+{
+	struct __replay_data *replay = camera_data->source_data;
+	gchar *path = NULL;
+	void *image = NULL;
+	unsigned int width = 0;
+	unsigned int height = 0;
+	struct stat st;
+	int fd = -1;
+
+	retv_if(!replay, -1);
+	retvm_if(replay->format != REPLAY_FORMAT_JPEG, -1, "Capture needs a JPEG replay source");
+
+	pthread_mutex_lock(&replay->mutex);
+	path = replay->current_jpeg ? g_strdup(replay->current_jpeg) : NULL;
+	width = replay->jpeg_width;
+	height = replay->jpeg_height;
+	pthread_mutex_unlock(&replay->mutex);
+	retv_if(!path, -1);
+
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	g_free(path);
+	retv_if(fd < 0, -1);
+
+	if (fstat(fd, &st) || st.st_size <= 0 || !(image = malloc(st.st_size))
+		|| read(fd, image, st.st_size) != st.st_size) {
+		_E("Failed to read captured file");
+		free(image);
+		close(fd);
+		return -1;
+	}
+	close(fd);
+
+	if (camera_data->capture_completed_cb)
+		camera_data->capture_completed_cb(image, st.st_size, width, height, camera_data->capture_completed_cb_data);
+	camera_data->capture_completed_cb = NULL;
+	free(image);
+
+	return 0;
+}
+
+const camera_source_ops_s camera_source_replay_ops = {
+	.name = "replay",
+	.open = __replay_open,
+	.close = __replay_close,
+	.start_preview = __replay_start_preview,
+	.stop_preview = __replay_stop_preview,
+	.capture = __replay_capture,
+	.frame_consumed = __replay_frame_consumed,
+};
@@ -0,0 +1,400 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "log.h"
+#include "scene_change.h"
+
+#define HISTOGRAM_SHIFT 3
+#define HISTOGRAM_BINS (256 >> HISTOGRAM_SHIFT)
+
+/* a cell changed when its mean moved this much */
+#define CELL_DIFF_MIN 10
+/* gains are in 1/256 */
+#define GAIN_ONE 256
+/*
+ * Lighting scales every cell by about the same gain: most cells have to
+ * change in the direction of the median gain, each within a quarter of it.
+ * Something large close to the lens changes cells by unrelated ratios.
+ */
+#define LIGHTING_CELLS_MIN (SCENE_CHANGE_CELLS * 3 / 4)
+#define LIGHTING_GAIN_TOLERANCE_SHIFT 2
+/*
+ * and the histogram has to move with the gain instead of changing shape:
+ * the previous histogram stretched by the gain may differ from the current
+ * one by this % of the samples at most, where neither is clipped
+ */
+#define LIGHTING_RESHAPE_MAX 15
+
+/* offsets searched are 1/16 of the projection, within these */
+#define SHIFT_RANGE_MIN 2
+#define SHIFT_RANGE_MAX 16
+/*
+ * A shift must beat no shift by a third, on projections that differ by
+ * more than half a luma level per summed pixel, which sensor noise does not
+ */
+#define SHAKE_SHIFT_MIN 2
+/* the same scene moved keeps its histogram, unlike something large in front of the lens */
+#define SHAKE_HISTOGRAM_DISTANCE_MAX 20
+
+struct __scene_change_s {
+	unsigned int width;
+	unsigned int height;
+	unsigned int rows; // sampled rows
+	bool has_previous;
+	unsigned int current; // 0 or 1, the other set is the previous frame
+
+	unsigned int histogram[2][HISTOGRAM_BINS];
+	unsigned int cells[2][SCENE_CHANGE_CELLS];
+	unsigned int cell_samples[SCENE_CHANGE_CELLS];
+	unsigned int gains[SCENE_CHANGE_CELLS];
+	/* column sums (width) then row sums (rows) of each frame */
+	int *projection[2];
+
+	scene_change_info_s info;
+};
+
+static int __resize(struct __scene_change_s *scene, unsigned int width, unsigned int height)
+{
+	unsigned int rows = (height + 1) / 2;
+	int *projection = NULL;
+
+	projection = realloc(scene->projection[0], 2 * (width + rows) * sizeof(int));
+	retvm_if(!projection, -1, "Failed to allocate projections for %ux%u", width, height);
+
+	scene->projection[0] = projection;
+	scene->projection[1] = projection + width + rows;
+	scene->width = width;
+	scene->height = height;
+	scene->rows = rows;
+	scene->has_previous = false;
+
+	return 0;
+}
+
+/* Histogram, cell sums and projections of every other row */
+static unsigned int __sample(struct __scene_change_s *scene, const image_luma_s *luma)
+{
+	unsigned int *histogram = scene->histogram[scene->current];
+	unsigned int *cells = scene->cells[scene->current];
+	int *columns = scene->projection[scene->current];
+	int *rows = columns + scene->width;
+	unsigned int total = 0;
+	unsigned int row = 0;
+	unsigned int cx = 0;
+	unsigned int x = 0;
+
+	memset(histogram, 0, sizeof(scene->histogram[0]));
+	memset(cells, 0, sizeof(scene->cells[0]));
+	memset(scene->cell_samples, 0, sizeof(scene->cell_samples));
+	memset(columns, 0, scene->width * sizeof(int));
+
+	for (row = 0; row < scene->height; row += 2) {
+		const unsigned char *src = luma->data + row * luma->stride;
+		unsigned int cell = (row * SCENE_CHANGE_GRID / scene->height) * SCENE_CHANGE_GRID;
+		unsigned int row_sum = 0;
+
+		for (cx = 0; cx < SCENE_CHANGE_GRID; cx++) {
+			unsigned int from = cx * scene->width / SCENE_CHANGE_GRID;
+			unsigned int to = (cx + 1) * scene->width / SCENE_CHANGE_GRID;
+			unsigned int cell_sum = 0;
+
+			for (x = from; x < to; x++) {
+				columns[x] += src[x];
+				cell_sum += src[x];
+				histogram[src[x] >> HISTOGRAM_SHIFT]++;
+			}
+
+			cells[cell + cx] += cell_sum;
+			scene->cell_samples[cell + cx] += to - from;
+			row_sum += cell_sum;
+		}
+
+		rows[row / 2] = row_sum;
+		total += row_sum;
+	}
+
+	return total;
+}
+
+/*
+ * Offset of b that best matches a, by mean absolute difference with the
+ * mean of each removed, or 0 when it is not clearly better than none.
+ */
+static int __best_shift(const int *a, const int *b, unsigned int count, unsigned int summed)
+{
+	long long int sum_a = 0;
+	long long int sum_b = 0;
+	int mean_a = 0;
+	int mean_b = 0;
+	int range = count / 16;
+	int shift = 0;
+	int best_shift = 0;
+	unsigned long long int best_cost = 0;
+	unsigned long long int zero_cost = 0;
+	unsigned int i = 0;
+
+	for (i = 0; i < count; i++) {
+		sum_a += a[i];
+		sum_b += b[i];
+	}
+	mean_a = sum_a / count;
+	mean_b = sum_b / count;
+
+	if (range < SHIFT_RANGE_MIN)
+		range = SHIFT_RANGE_MIN;
+	if (range > SHIFT_RANGE_MAX)
+		range = SHIFT_RANGE_MAX;
+	if (range >= (int)count / 2)
+		return 0;
+
+	for (shift = -range; shift <= range; shift++) {
+		unsigned int from = shift < 0 ? -shift : 0;
+		unsigned int to = shift > 0 ? count - shift : count;
+		unsigned long long int cost = 0;
+
+		for (i = from; i < to; i++) {
+			int diff = (a[i] - mean_a) - (b[i + shift] - mean_b);
+
+			cost += diff < 0 ? -diff : diff;
+		}
+		cost /= to - from;
+
+		if (!shift)
+			zero_cost = cost;
+		if (shift == -range || cost < best_cost) {
+			best_cost = cost;
+			best_shift = shift;
+		}
+	}
+
+	if (2 * zero_cost < summed)
+		return 0;
+	if (best_cost * 3 > zero_cost * 2)
+		return 0;
+
+	/* b moved by -shift to become a */
+	return -best_shift;
+}
+
+static int __compare_uint(const void *a, const void *b)
+{
+	unsigned int x = *(const unsigned int *)a;
+	unsigned int y = *(const unsigned int *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+/* Gain of each cell, the median of them, and the cells that changed along with it */
+static unsigned int __cell_gain(struct __scene_change_s *scene, unsigned int *consistent)
+{
+	const unsigned int *cells = scene->cells[scene->current];
+	const unsigned int *previous_cells = scene->cells[scene->current ^ 1];
+	unsigned int sorted[SCENE_CHANGE_CELLS];
+	unsigned int count = 0;
+	unsigned int gain = 0;
+	unsigned int i = 0;
+
+	for (i = 0; i < SCENE_CHANGE_CELLS; i++) {
+		unsigned int samples = scene->cell_samples[i];
+
+		/* +1 level so a black cell does not divide by zero */
+		scene->gains[i] = samples ? (unsigned long long int)(cells[i] + samples) * GAIN_ONE
+			/ (previous_cells[i] + samples) : GAIN_ONE;
+		if (samples)
+			sorted[count++] = scene->gains[i];
+	}
+	*consistent = 0;
+	if (!count)
+		return GAIN_ONE;
+
+	qsort(sorted, count, sizeof(unsigned int), __compare_uint);
+	gain = sorted[count / 2];
+
+	for (i = 0; i < SCENE_CHANGE_CELLS; i++) {
+		unsigned int samples = scene->cell_samples[i];
+		unsigned int tolerance = gain >> LIGHTING_GAIN_TOLERANCE_SHIFT;
+		unsigned int diff = cells[i] > previous_cells[i] ? cells[i] - previous_cells[i] : previous_cells[i] - cells[i];
+
+		if (!samples || diff < CELL_DIFF_MIN * samples)
+			continue;
+		if ((cells[i] > previous_cells[i]) != (gain > GAIN_ONE))
+			continue;
+		if (scene->gains[i] + tolerance < gain || scene->gains[i] > gain + tolerance)
+			continue;
+		(*consistent)++;
+	}
+
+	return gain;
+}
+
+/* Samples of a histogram below value, taking bins as evenly filled */
+static unsigned int __samples_below(const unsigned int *histogram, const unsigned int *below, unsigned int value)
+{
+	unsigned int bin = value >> HISTOGRAM_SHIFT;
+	unsigned int part = value & ((1 << HISTOGRAM_SHIFT) - 1);
+
+	return below[bin] + (histogram[bin] * part >> HISTOGRAM_SHIFT);
+}
+
+/*
+ * Largest difference of the previous histogram stretched by gain from the
+ * current one, in % of the samples: 0 when every level was only scaled.
+ */
+static unsigned int __histogram_reshape(struct __scene_change_s *scene, unsigned int gain, unsigned int samples)
+{
+	const unsigned int *histogram = scene->histogram[scene->current];
+	const unsigned int *previous_histogram = scene->histogram[scene->current ^ 1];
+	unsigned int below[HISTOGRAM_BINS + 1];
+	unsigned int previous_below = 0;
+	unsigned int largest = 0;
+	unsigned int i = 0;
+
+	below[0] = 0;
+	for (i = 0; i < HISTOGRAM_BINS; i++)
+		below[i + 1] = below[i] + histogram[i];
+
+	for (i = 1; i < HISTOGRAM_BINS; i++) {
+		unsigned int value = ((i << HISTOGRAM_SHIFT) * gain + GAIN_ONE / 2) / GAIN_ONE;
+		unsigned int current = 0;
+		unsigned int diff = 0;
+
+		previous_below += previous_histogram[i - 1];
+		/* the first and last bins also hold what was clipped */
+		if (value < (1 << HISTOGRAM_SHIFT) || value >= 256 - (1 << HISTOGRAM_SHIFT))
+			continue;
+
+		current = __samples_below(histogram, below, value);
+		diff = current > previous_below ? current - previous_below : previous_below - current;
+		if (diff > largest)
+			largest = diff;
+	}
+
+	return (unsigned long long int)largest * 100 / samples;
+}
+
+scene_change_e scene_change_update(scene_change_h scene, const image_luma_s *luma)
+{
+	const unsigned int *histogram = NULL;
+	const unsigned int *previous_histogram = NULL;
+	const unsigned int *cells = NULL;
+	const unsigned int *previous_cells = NULL;
+	const int *projection = NULL;
+	const int *previous_projection = NULL;
+	unsigned int samples = 0;
+	unsigned int distance = 0;
+	unsigned int i = 0;
+	scene_change_info_s *info = NULL;
+
+	retv_if(!scene, SCENE_CHANGE_NONE);
+	retv_if(!luma || !luma->data, SCENE_CHANGE_NONE);
+	retv_if(luma->width < SCENE_CHANGE_GRID || luma->height < 2 * SCENE_CHANGE_GRID, SCENE_CHANGE_NONE);
+
+	if (luma->width != scene->width || luma->height != scene->height) {
+		if (__resize(scene, luma->width, luma->height))
+			return SCENE_CHANGE_NONE;
+	}
+
+	info = &scene->info;
+	scene->current ^= 1;
+	samples = scene->width * scene->rows;
+	info->previous_mean = info->mean;
+	info->mean = __sample(scene, luma) / samples;
+	info->changed_cells = 0;
+	info->histogram_distance = 0;
+	info->gain = 100;
+	info->gain_cells = 0;
+	info->histogram_reshape = 0;
+	info->shift_x = 0;
+	info->shift_y = 0;
+
+	if (!scene->has_previous) {
+		scene->has_previous = true;
+		return SCENE_CHANGE_NONE;
+	}
+
+	histogram = scene->histogram[scene->current];
+	previous_histogram = scene->histogram[scene->current ^ 1];
+	cells = scene->cells[scene->current];
+	previous_cells = scene->cells[scene->current ^ 1];
+
+	for (i = 0; i < SCENE_CHANGE_CELLS; i++) {
+		unsigned int diff = cells[i] > previous_cells[i] ? cells[i] - previous_cells[i] : previous_cells[i] - cells[i];
+
+		if (scene->cell_samples[i] && diff >= CELL_DIFF_MIN * scene->cell_samples[i])
+			info->changed_cells++;
+	}
+
+	for (i = 0; i < HISTOGRAM_BINS; i++)
+		distance += histogram[i] > previous_histogram[i] ?
+			histogram[i] - previous_histogram[i] : previous_histogram[i] - histogram[i];
+	/* every moved sample is counted in two bins */
+	info->histogram_distance = (unsigned long long int)distance * 50 / samples;
+
+	if (info->changed_cells >= LIGHTING_CELLS_MIN) {
+		unsigned int gain = __cell_gain(scene, &info->gain_cells);
+
+		info->gain = gain * 100 / GAIN_ONE;
+		info->histogram_reshape = __histogram_reshape(scene, gain, samples);
+		if (info->gain_cells >= LIGHTING_CELLS_MIN && info->histogram_reshape <= LIGHTING_RESHAPE_MAX)
+			return SCENE_CHANGE_LIGHTING;
+	}
+
+	if (info->histogram_distance > SHAKE_HISTOGRAM_DISTANCE_MAX)
+		return SCENE_CHANGE_NONE;
+
+	projection = scene->projection[scene->current];
+	previous_projection = scene->projection[scene->current ^ 1];
+
+	info->shift_x = __best_shift(projection, previous_projection, scene->width, scene->rows);
+	/* rows are sampled every other one */
+	info->shift_y = 2 * __best_shift(projection + scene->width, previous_projection + scene->width,
+		scene->rows, scene->width);
+
+	if (abs(info->shift_x) >= SHAKE_SHIFT_MIN || abs(info->shift_y) >= SHAKE_SHIFT_MIN)
+		return SCENE_CHANGE_SHAKE;
+
+	return SCENE_CHANGE_NONE;
+}
+
+void scene_change_get_info(scene_change_h scene, scene_change_info_s *info)
+{
+	ret_if(!scene);
+	ret_if(!info);
+
+	*info = scene->info;
+}
+
+scene_change_h scene_change_create(void)
+{
+	struct __scene_change_s *scene = NULL;
+
+	scene = calloc(1, sizeof(struct __scene_change_s));
+	retvm_if(!scene, NULL, "Failed to allocate scene change");
+
+	return scene;
+}
+
+void scene_change_destroy(scene_change_h scene)
+{
+	ret_if(!scene);
+
+	free(scene->projection[0]);
+	free(scene);
+}
@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "log.h"
+#include "stage_worker.h"
+
+#define STAGE_WORKER_NAME_MAX 16
+
+struct __stage_worker_s {
+	char name[STAGE_WORKER_NAME_MAX];
+	stage_worker_drop_policy_e policy;
+	stage_worker_job_cb job;
+	stage_worker_drop_cb drop;
+	void *user_data;
+
+	pthread_t thread;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	bool quit;
+
+	/* ring of depth items, head is the oldest */
+	void **items;
+	unsigned int depth;
+	unsigned int head;
+	unsigned int count;
+
+	stage_worker_stats_s stats;
+	unsigned long long int total_usec;
+};
+
+static unsigned long long int __get_usec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static void *__pop(struct __stage_worker_s *worker)
+{
+	void *item = worker->items[worker->head];
+
+	worker->head = (worker->head + 1) % worker->depth;
+	worker->count--;
+
+	return item;
+}
+
+static void *__worker_thread(void *data)
+{
+	struct __stage_worker_s *worker = data;
+
+	pthread_mutex_lock(&worker->mutex);
+	for (;;) {
+		unsigned long long int start = 0;
+		unsigned int elapsed = 0;
+		void *item = NULL;
+
+		while (!worker->quit && !worker->count)
+			pthread_cond_wait(&worker->cond, &worker->mutex);
+		if (worker->quit)
+			break;
+
+		item = __pop(worker);
+		pthread_mutex_unlock(&worker->mutex);
+
+		start = __get_usec();
+		worker->job(item, worker->user_data);
+		elapsed = __get_usec() - start;
+
+		pthread_mutex_lock(&worker->mutex);
+		worker->stats.processed++;
+		worker->total_usec += elapsed;
+		if (elapsed > worker->stats.max_usec)
+			worker->stats.max_usec = elapsed;
+	}
+	pthread_mutex_unlock(&worker->mutex);
+
+	return NULL;
+}
+
+int stage_worker_push(stage_worker_h worker, void *item)
+{
+	void *dropped = NULL;
+
+	retv_if(!worker, -1);
+	retv_if(!item, -1);
+
+	pthread_mutex_lock(&worker->mutex);
+	worker->stats.pushed++;
+
+	if (worker->count == worker->depth) {
+		worker->stats.dropped++;
+		if (worker->policy == STAGE_WORKER_DROP_NEWEST) {
+			pthread_mutex_unlock(&worker->mutex);
+			worker->drop(item, worker->user_data);
+			return 1;
+		}
+		dropped = __pop(worker);
+	}
+
+	worker->items[(worker->head + worker->count) % worker->depth] = item;
+	worker->count++;
+	if (worker->count > worker->stats.depth_max)
+		worker->stats.depth_max = worker->count;
+	pthread_cond_signal(&worker->cond);
+	pthread_mutex_unlock(&worker->mutex);
+
+	if (dropped) {
+		worker->drop(dropped, worker->user_data);
+		return 1;
+	}
+
+	return 0;
+}
+
+void stage_worker_get_stats(stage_worker_h worker, stage_worker_stats_s *stats)
+{
+	ret_if(!worker);
+	ret_if(!stats);
+
+	pthread_mutex_lock(&worker->mutex);
+	*stats = worker->stats;
+	stats->depth = worker->count;
+	stats->average_usec = worker->stats.processed ? worker->total_usec / worker->stats.processed : 0;
+	pthread_mutex_unlock(&worker->mutex);
+}
+
+const char *stage_worker_get_name(stage_worker_h worker)
+{
+	retv_if(!worker, NULL);
+
+	return worker->name;
+}
+
+stage_worker_h stage_worker_create(const char *name, unsigned int depth, stage_worker_drop_policy_e policy,
+	stage_worker_job_cb job, stage_worker_drop_cb drop, void *user_data)
+{
+	struct __stage_worker_s *worker = NULL;
+
+	retv_if(!job, NULL);
+	retv_if(!drop, NULL);
+	retv_if(depth < 1, NULL);
+
+	worker = calloc(1, sizeof(struct __stage_worker_s));
+	retvm_if(!worker, NULL, "Failed to allocate stage worker");
+
+	worker->items = calloc(depth, sizeof(void *));
+	goto_if(!worker->items, ERROR);
+
+	snprintf(worker->name, sizeof(worker->name), "%s", name ? name : "stage");
+	worker->policy = policy;
+	worker->job = job;
+	worker->drop = drop;
+	worker->user_data = user_data;
+	worker->depth = depth;
+
+	pthread_mutex_init(&worker->mutex, NULL);
+	pthread_cond_init(&worker->cond, NULL);
+
+	if (pthread_create(&worker->thread, NULL, __worker_thread, worker)) {
+		pthread_cond_destroy(&worker->cond);
+		pthread_mutex_destroy(&worker->mutex);
+		goto ERROR;
+	}
+
+	return worker;
+
+ERROR:
+	_E("Failed to create %s stage", name ? name : "");
+	free(worker->items);
+	free(worker);
+
+	return NULL;
+}
+
+void stage_worker_destroy(stage_worker_h worker)
+{
+	ret_if(!worker);
+
+	pthread_mutex_lock(&worker->mutex);
+	worker->quit = true;
+	pthread_cond_signal(&worker->cond);
+	pthread_mutex_unlock(&worker->mutex);
+
+	pthread_join(worker->thread, NULL);
+
+	while (worker->count)
+		worker->drop(__pop(worker), worker->user_data);
+
+	pthread_cond_destroy(&worker->cond);
+	pthread_mutex_destroy(&worker->mutex);
+	free(worker->items);
+	free(worker);
+}
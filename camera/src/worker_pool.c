@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "log.h"
+#include "worker_pool.h"
+
+struct __worker_pool_s {
+	pthread_t threads[WORKER_POOL_THREAD_MAX];
+	unsigned int thread_count; // started threads, the caller is not counted
+
+	/* one run at a time */
+	pthread_mutex_t run_mutex;
+
+	pthread_mutex_t mutex;
+	pthread_cond_t start_cond;
+	pthread_cond_t done_cond;
+	unsigned long long generation;
+	bool quit;
+
+	/* current run */
+	worker_pool_job_cb job;
+	void *user_data;
+	unsigned int count;
+	unsigned int next; // atomic
+	unsigned int busy; // workers still in the run, under mutex
+};
+
+/* Takes indexes until there are none left */
+static void __work(struct __worker_pool_s *pool)
+{
+	unsigned int index = 0;
+
+	while ((index = __atomic_fetch_add(&pool->next, 1, __ATOMIC_RELAXED)) < pool->count)
+		pool->job(index, pool->user_data);
+}
+
+static void *__worker_thread(void *data)
+{
+	struct __worker_pool_s *pool = data;
+	unsigned long long seen = 0;
+
+	pthread_mutex_lock(&pool->mutex);
+	for (;;) {
+		while (!pool->quit && pool->generation == seen)
+			pthread_cond_wait(&pool->start_cond, &pool->mutex);
+		if (pool->quit)
+			break;
+		seen = pool->generation;
+		pthread_mutex_unlock(&pool->mutex);
+
+		__work(pool);
+
+		pthread_mutex_lock(&pool->mutex);
+		if (--pool->busy == 0)
+			pthread_cond_signal(&pool->done_cond);
+	}
+	pthread_mutex_unlock(&pool->mutex);
+
+	return NULL;
+}
+
+void worker_pool_run(worker_pool_h pool, unsigned int count, worker_pool_job_cb job, void *user_data)
+{
+	unsigned int index = 0;
+
+	ret_if(!job);
+
+	if (!pool || !pool->thread_count || count < 2) {
+		for (index = 0; index < count; index++)
+			job(index, user_data);
+		return;
+	}
+
+	pthread_mutex_lock(&pool->run_mutex);
+
+	pthread_mutex_lock(&pool->mutex);
+	pool->job = job;
+	pool->user_data = user_data;
+	pool->count = count;
+	__atomic_store_n(&pool->next, 0, __ATOMIC_RELAXED);
+	pool->busy = pool->thread_count;
+	pool->generation++;
+	pthread_cond_broadcast(&pool->start_cond);
+	pthread_mutex_unlock(&pool->mutex);
+
+	__work(pool);
+
+	/* workers may still be finishing their last index */
+	pthread_mutex_lock(&pool->mutex);
+	while (pool->busy)
+		pthread_cond_wait(&pool->done_cond, &pool->mutex);
+	pthread_mutex_unlock(&pool->mutex);
+
+	pthread_mutex_unlock(&pool->run_mutex);
+}
+
+unsigned int worker_pool_get_threads(worker_pool_h pool)
+{
+	return pool ? pool->thread_count + 1 : 1;
+}
+
+worker_pool_h worker_pool_create(unsigned int threads)
+{
+	struct __worker_pool_s *pool = NULL;
+	unsigned int i = 0;
+
+	retv_if(threads < 1, NULL);
+	if (threads > WORKER_POOL_THREAD_MAX)
+		threads = WORKER_POOL_THREAD_MAX;
+
+	pool = calloc(1, sizeof(struct __worker_pool_s));
+	retvm_if(!pool, NULL, "Failed to allocate worker pool");
+
+	pthread_mutex_init(&pool->run_mutex, NULL);
+	pthread_mutex_init(&pool->mutex, NULL);
+	pthread_cond_init(&pool->start_cond, NULL);
+	pthread_cond_init(&pool->done_cond, NULL);
+
+	for (i = 0; i + 1 < threads; i++) {
+		if (pthread_create(&pool->threads[i], NULL, __worker_thread, pool)) {
+			_W("Failed to start worker %u, the pool has %u threads", i, i + 1);
+			break;
+		}
+		pool->thread_count++;
+	}
+
+	_I("Worker pool with %u threads", pool->thread_count + 1);
+
+	return pool;
+}
+
+void worker_pool_destroy(worker_pool_h pool)
+{
+	unsigned int i = 0;
+
+	ret_if(!pool);
+
+	pthread_mutex_lock(&pool->mutex);
+	pool->quit = true;
+	pthread_cond_broadcast(&pool->start_cond);
+	pthread_mutex_unlock(&pool->mutex);
+
+	for (i = 0; i < pool->thread_count; i++)
+		pthread_join(pool->threads[i], NULL);
+
+	pthread_cond_destroy(&pool->done_cond);
+	pthread_cond_destroy(&pool->start_cond);
+	pthread_mutex_destroy(&pool->mutex);
+	pthread_mutex_destroy(&pool->run_mutex);
+	free(pool);
+}
@@ -0,0 +1,454 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host test of image_convert_frame() and image_convert_get_frame() on whole
+ * frames. Every supported source format goes to I420, NV12 and luma, at
+ * even and odd sizes, packed, with padded rows, with padding at the end of
+ * the planes (no stride reported, which must not be guessed from it), with
+ * both and their strides given, and as a single plane, and is compared with
+ * a per pixel reference that reads the source by hand.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "image_convert.h"
+
+#define ROW_PADDING 13
+#define END_PADDING 7 // divides none of the row counts above 1
+#define PADDING_BYTE 0xEE
+
+typedef enum {
+	LAYOUT_PACKED, // planes back to back
+	LAYOUT_PADDED, // ROW_PADDING bytes after every row, planes apart
+	LAYOUT_END_PADDED, // packed rows, END_PADDING bytes after every plane
+	LAYOUT_STRIDED, // padded rows and plane ends, strides given
+	LAYOUT_SINGLE, // planes back to back, given as one plane
+} layout_e;
+
+typedef struct {
+	camera_pixel_format_e format;
+	const char *name;
+} format_s;
+
+static const format_s formats[] = {
+	{ CAMERA_PIXEL_FORMAT_NV12, "NV12" },
+	{ CAMERA_PIXEL_FORMAT_NV21, "NV21" },
+	{ CAMERA_PIXEL_FORMAT_I420, "I420" },
+	{ CAMERA_PIXEL_FORMAT_YV12, "YV12" },
+	{ CAMERA_PIXEL_FORMAT_422P, "422P" },
+	{ CAMERA_PIXEL_FORMAT_YUYV, "YUYV" },
+	{ CAMERA_PIXEL_FORMAT_UYVY, "UYVY" },
+	{ CAMERA_PIXEL_FORMAT_RGB565, "RGB565" },
+	{ CAMERA_PIXEL_FORMAT_RGB888, "RGB888" },
+	{ CAMERA_PIXEL_FORMAT_RGBA, "RGBA" },
+};
+
+static const char *target_names[] = { "I420", "NV12", "luma" };
+static const char *layout_names[] = { "packed", "padded", "end padded", "strided", "single" };
+
+/* 1283 pixels take the chroma rows over more than one chunk */
+static const unsigned int sizes[][2] = {
+	{ 1, 1 }, { 2, 2 }, { 7, 5 }, { 33, 17 }, { 64, 48 }, { 1283, 9 },
+};
+
+#define FORMAT_COUNT (sizeof(formats) / sizeof(formats[0]))
+#define SIZE_COUNT (sizeof(sizes) / sizeof(sizes[0]))
+
+/* A source frame, planes laid out by hand */
+typedef struct {
+	camera_pixel_format_e format;
+	unsigned int width;
+	unsigned int height;
+	unsigned int planes;
+	unsigned char *buffer;
+	unsigned int size;
+	unsigned int offsets[3];
+	unsigned int strides[3];
+	unsigned int plane_sizes[3];
+} source_s;
+
+static unsigned int seed = 0x13579bdf;
+
+static unsigned char __random_byte(void)
+{
+	seed = seed * 1103515245 + 12345;
+	return seed >> 16;
+}
+
+static unsigned int __chroma(unsigned int size)
+{
+	return (size + 1) / 2;
+}
+
+/* Bytes per row and rows of plane i, written out for each format */
+static void __plane_geometry(camera_pixel_format_e format, unsigned int width, unsigned int height,
+	unsigned int i, unsigned int *bytes, unsigned int *rows)
+{
+	*rows = height;
+	switch (format) {
+	case CAMERA_PIXEL_FORMAT_NV12:
+	case CAMERA_PIXEL_FORMAT_NV21:
+		*bytes = i ? 2 * __chroma(width) : width;
+		*rows = i ? __chroma(height) : height;
+		break;
+	case CAMERA_PIXEL_FORMAT_I420:
+	case CAMERA_PIXEL_FORMAT_YV12:
+		*bytes = i ? __chroma(width) : width;
+		*rows = i ? __chroma(height) : height;
+		break;
+	case CAMERA_PIXEL_FORMAT_422P:
+		*bytes = i ? __chroma(width) : width;
+		break;
+	case CAMERA_PIXEL_FORMAT_RGB888:
+		*bytes = 3 * width;
+		break;
+	case CAMERA_PIXEL_FORMAT_RGBA:
+		*bytes = 4 * width;
+		break;
+	default:
+		*bytes = 2 * width;
+		break;
+	}
+}
+
+static unsigned int __plane_count(camera_pixel_format_e format)
+{
+	switch (format) {
+	case CAMERA_PIXEL_FORMAT_NV12:
+	case CAMERA_PIXEL_FORMAT_NV21:
+		return 2;
+	case CAMERA_PIXEL_FORMAT_I420:
+	case CAMERA_PIXEL_FORMAT_YV12:
+	case CAMERA_PIXEL_FORMAT_422P:
+		return 3;
+	default:
+		return 1;
+	}
+}
+
+static int __create_source(source_s *source, camera_pixel_format_e format,
+	unsigned int width, unsigned int height, layout_e layout)
+{
+	unsigned int offset = 0;
+	unsigned int bytes = 0;
+	unsigned int rows = 0;
+	unsigned int count = __plane_count(format);
+	unsigned int i = 0;
+	unsigned int y = 0;
+	unsigned int x = 0;
+
+	memset(source, 0, sizeof(source_s));
+	source->format = format;
+	source->width = width;
+	source->height = height;
+	source->planes = count;
+
+	for (i = 0; i < count; i++) {
+		__plane_geometry(format, width, height, i, &bytes, &rows);
+		source->strides[i] = bytes + (layout == LAYOUT_PADDED || layout == LAYOUT_STRIDED ? ROW_PADDING : 0);
+		source->offsets[i] = offset;
+		source->plane_sizes[i] = source->strides[i] * rows
+			+ (layout == LAYOUT_END_PADDED || layout == LAYOUT_STRIDED ? END_PADDING : 0);
+		offset += source->plane_sizes[i] + (layout == LAYOUT_PADDED ? 64 : 0);
+	}
+	source->size = offset;
+	source->buffer = malloc(offset);
+	if (!source->buffer)
+		return -1;
+
+	memset(source->buffer, PADDING_BYTE, offset);
+	for (i = 0; i < count; i++) {
+		__plane_geometry(format, width, height, i, &bytes, &rows);
+		for (y = 0; y < rows; y++)
+			for (x = 0; x < bytes; x++)
+				source->buffer[source->offsets[i] + y * source->strides[i] + x] = __random_byte();
+	}
+
+	return 0;
+}
+
+static const unsigned char *__source_row(const source_s *source, unsigned int plane, unsigned int y)
+{
+	return source->buffer + source->offsets[plane] + y * source->strides[plane];
+}
+
+static void __reference_rgb(const source_s *source, unsigned int x, unsigned int y, int *r, int *g, int *b)
+{
+	const unsigned char *row = __source_row(source, 0, y);
+	unsigned int pixel = 0;
+
+	switch (source->format) {
+	case CAMERA_PIXEL_FORMAT_RGB565:
+		pixel = row[2 * x] | (row[2 * x + 1] << 8);
+		/* the top bits repeated below, so 31 and 63 become 255 */
+		*r = ((pixel >> 11) & 0x1F) * 8 + ((pixel >> 11) & 0x1F) / 4;
+		*g = ((pixel >> 5) & 0x3F) * 4 + ((pixel >> 5) & 0x3F) / 16;
+		*b = (pixel & 0x1F) * 8 + (pixel & 0x1F) / 4;
+		break;
+	case CAMERA_PIXEL_FORMAT_RGB888:
+		*r = row[3 * x];
+		*g = row[3 * x + 1];
+		*b = row[3 * x + 2];
+		break;
+	default:
+		*r = row[4 * x];
+		*g = row[4 * x + 1];
+		*b = row[4 * x + 2];
+		break;
+	}
+}
+
+static int __is_rgb(camera_pixel_format_e format)
+{
+	return format == CAMERA_PIXEL_FORMAT_RGB565 || format == CAMERA_PIXEL_FORMAT_RGB888
+		|| format == CAMERA_PIXEL_FORMAT_RGBA;
+}
+
+static unsigned char __reference_y(const source_s *source, unsigned int x, unsigned int y)
+{
+	int r, g, b;
+
+	if (source->format == CAMERA_PIXEL_FORMAT_YUYV)
+		return __source_row(source, 0, y)[2 * x];
+	if (source->format == CAMERA_PIXEL_FORMAT_UYVY)
+		return __source_row(source, 0, y)[2 * x + 1];
+	if (!__is_rgb(source->format))
+		return __source_row(source, 0, y)[x];
+
+	__reference_rgb(source, x, y, &r, &g, &b);
+
+	/* BT.601 studio range */
+	return ((66 * r + 129 * g + 25 * b + 128) >> 8) + 16;
+}
+
+/* U and V of chroma sample cx, cy: rows 2 * cy and the next, or itself at an odd end */
+static void __reference_uv(const source_s *source, unsigned int cx, unsigned int cy, unsigned char *u, unsigned char *v)
+{
+	unsigned int y0 = 2 * cy;
+	unsigned int y1 = y0 + 1 < source->height ? y0 + 1 : y0;
+	unsigned int x0 = 2 * cx;
+	unsigned int x1 = x0 + 1 < source->width ? x0 + 1 : x0;
+	int r = 0, g = 0, b = 0;
+	int rs = 0, gs = 0, bs = 0;
+	int uo = 0, vo = 0;
+
+	switch (source->format) {
+	case CAMERA_PIXEL_FORMAT_NV12:
+		*u = __source_row(source, 1, cy)[2 * cx];
+		*v = __source_row(source, 1, cy)[2 * cx + 1];
+		return;
+	case CAMERA_PIXEL_FORMAT_NV21:
+		*v = __source_row(source, 1, cy)[2 * cx];
+		*u = __source_row(source, 1, cy)[2 * cx + 1];
+		return;
+	case CAMERA_PIXEL_FORMAT_I420:
+		*u = __source_row(source, 1, cy)[cx];
+		*v = __source_row(source, 2, cy)[cx];
+		return;
+	case CAMERA_PIXEL_FORMAT_YV12:
+		*v = __source_row(source, 1, cy)[cx];
+		*u = __source_row(source, 2, cy)[cx];
+		return;
+	case CAMERA_PIXEL_FORMAT_422P:
+		*u = (__source_row(source, 1, y0)[cx] + __source_row(source, 1, y1)[cx] + 1) >> 1;
+		*v = (__source_row(source, 2, y0)[cx] + __source_row(source, 2, y1)[cx] + 1) >> 1;
+		return;
+	case CAMERA_PIXEL_FORMAT_YUYV:
+	case CAMERA_PIXEL_FORMAT_UYVY:
+		/* byte offsets in a 4 byte pair of pixels */
+		uo = source->format == CAMERA_PIXEL_FORMAT_YUYV ? 1 : 0;
+		vo = uo + 2;
+		*u = (__source_row(source, 0, y0)[4 * cx + uo] + __source_row(source, 0, y1)[4 * cx + uo] + 1) >> 1;
+		if (x1 > x0) {
+			*v = (__source_row(source, 0, y0)[4 * cx + vo] + __source_row(source, 0, y1)[4 * cx + vo] + 1) >> 1;
+		} else if (cx) {
+			/* the last pixel of an odd row has no V of its own */
+			*v = (__source_row(source, 0, y0)[4 * cx - 4 + vo] + __source_row(source, 0, y1)[4 * cx - 4 + vo] + 1) >> 1;
+		} else {
+			*v = 128;
+		}
+		return;
+	default:
+		break;
+	}
+
+	__reference_rgb(source, x0, y0, &r, &g, &b);
+	rs += r, gs += g, bs += b;
+	__reference_rgb(source, x1, y0, &r, &g, &b);
+	rs += r, gs += g, bs += b;
+	__reference_rgb(source, x0, y1, &r, &g, &b);
+	rs += r, gs += g, bs += b;
+	__reference_rgb(source, x1, y1, &r, &g, &b);
+	rs += r, gs += g, bs += b;
+	r = (rs + 2) >> 2;
+	g = (gs + 2) >> 2;
+	b = (bs + 2) >> 2;
+	*u = ((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128;
+	*v = ((112 * r - 94 * g - 18 * b + 128) >> 8) + 128;
+}
+
+static void __reference_frame(const source_s *source, image_convert_target_e target, unsigned char *dst)
+{
+	unsigned int width = source->width;
+	unsigned int height = source->height;
+	unsigned int chroma_width = __chroma(width);
+	unsigned int chroma_height = __chroma(height);
+	unsigned char *u = dst + width * height;
+	unsigned char *v = u + chroma_width * chroma_height;
+	unsigned int x = 0;
+	unsigned int y = 0;
+
+	for (y = 0; y < height; y++)
+		for (x = 0; x < width; x++)
+			dst[y * width + x] = __reference_y(source, x, y);
+
+	if (target == IMAGE_CONVERT_LUMA)
+		return;
+
+	for (y = 0; y < chroma_height; y++) {
+		for (x = 0; x < chroma_width; x++) {
+			unsigned char cu = 0;
+			unsigned char cv = 0;
+
+			__reference_uv(source, x, y, &cu, &cv);
+			if (target == IMAGE_CONVERT_I420) {
+				u[y * chroma_width + x] = cu;
+				v[y * chroma_width + x] = cv;
+			} else {
+				u[2 * (y * chroma_width + x)] = cu;
+				u[2 * (y * chroma_width + x) + 1] = cv;
+			}
+		}
+	}
+}
+
+static int __init_view(const source_s *source, layout_e layout, image_frame_view_s *view)
+{
+	unsigned int size = source->size;
+
+	if (layout == LAYOUT_SINGLE)
+		return image_frame_view_init(view, source->format, source->width, source->height, source->buffer,
+			1, source->offsets, &size, NULL);
+
+	return image_frame_view_init(view, source->format, source->width, source->height, source->buffer,
+		source->planes, source->offsets, source->plane_sizes,
+		layout == LAYOUT_STRIDED ? source->strides : NULL);
+}
+
+/* One source format, size and layout to every target */
+static int __check_frame(const format_s *format, unsigned int width, unsigned int height, layout_e layout)
+{
+	unsigned char *scratch = NULL;
+	unsigned int scratch_size = 0;
+	image_frame_view_s view;
+	source_s source;
+	int target = 0;
+	int failed = 0;
+
+	/* a single plane is only a different way to pass a multi plane format */
+	if (layout == LAYOUT_SINGLE && __plane_count(format->format) == 1)
+		return 0;
+
+	if (__create_source(&source, format->format, width, height, layout) || __init_view(&source, layout, &view)) {
+		fprintf(stderr, "%s %ux%u %s: can not set up the frame\n", format->name, width, height, layout_names[layout]);
+		free(source.buffer);
+		return 1;
+	}
+
+	for (target = IMAGE_CONVERT_I420; target <= IMAGE_CONVERT_LUMA; target++) {
+		unsigned int size = image_convert_get_size(target, width, height);
+		unsigned char *expected = malloc(size);
+		unsigned char *result = malloc(size + 16);
+		const unsigned char *frame = NULL;
+		bool in_place = false;
+
+		if (!expected || !result) {
+			free(expected);
+			free(result);
+			failed++;
+			break;
+		}
+
+		__reference_frame(&source, target, expected);
+		/* nothing may be written past the size */
+		memset(result, PADDING_BYTE, size + 16);
+
+		if (image_convert_frame(&view, target, result, size) || memcmp(result, expected, size)) {
+			fprintf(stderr, "%s %ux%u %s to %s: image_convert_frame differs\n",
+				format->name, width, height, layout_names[layout], target_names[target]);
+			failed++;
+		} else if (result[size] != PADDING_BYTE) {
+			fprintf(stderr, "%s %ux%u %s to %s: written past the end\n",
+				format->name, width, height, layout_names[layout], target_names[target]);
+			failed++;
+		}
+
+		frame = image_convert_get_frame(&view, target, &scratch, &scratch_size);
+		/* a packed frame already in the target format is used as it is */
+		in_place = (layout == LAYOUT_PACKED || layout == LAYOUT_SINGLE)
+			&& ((format->format == CAMERA_PIXEL_FORMAT_I420 && target == IMAGE_CONVERT_I420)
+				|| (format->format == CAMERA_PIXEL_FORMAT_NV12 && target == IMAGE_CONVERT_NV12));
+		if (!frame || memcmp(frame, expected, size) || (frame == source.buffer) != in_place) {
+			fprintf(stderr, "%s %ux%u %s to %s: image_convert_get_frame differs\n",
+				format->name, width, height, layout_names[layout], target_names[target]);
+			failed++;
+		}
+
+		free(expected);
+		free(result);
+	}
+
+	free(scratch);
+	free(source.buffer);
+
+	return failed;
+}
+
+int main(void)
+{
+	unsigned int checked = 0;
+	unsigned int f = 0;
+	unsigned int s = 0;
+	int layout = 0;
+	int failed = 0;
+
+	for (f = 0; f < FORMAT_COUNT; f++) {
+		int format_failed = 0;
+
+		if (!image_convert_is_supported(formats[f].format)) {
+			fprintf(stderr, "%s is not supported\n", formats[f].name);
+			failed++;
+			continue;
+		}
+
+		for (s = 0; s < SIZE_COUNT; s++) {
+			for (layout = LAYOUT_PACKED; layout <= LAYOUT_SINGLE; layout++) {
+				format_failed += __check_frame(&formats[f], sizes[s][0], sizes[s][1], layout);
+				checked++;
+			}
+		}
+		printf("%-7s to I420, NV12 and luma: %s\n", formats[f].name, format_failed ? "FAILED" : "matches");
+		failed += format_failed;
+	}
+
+	printf("%s, %u frames of %s kernels\n", failed ? "FAILED" : "all frames match the reference",
+		checked, image_convert_get_kernel_name());
+
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host test and benchmark of the EXIF templates. The APP1 segment built
+ * from a template has to be the same bytes as the one libexif builds for
+ * the same dimensions and comment, including comments too long for a
+ * template, which go through libexif. exif.c is included to reach
+ * create_exif_data().
+ */
+
+#include "../src/exif.c"
+
+#include <time.h>
+
+#define BENCH_RUNS 100000
+#define LONG_COMMENT_SIZE 1500
+
+static const unsigned int sizes[][2] = { { 1, 1 }, { 320, 240 }, { 640, 480 }, { 1920, 1080 }, { 4000, 3000 } };
+
+#define SIZE_COUNT (sizeof(sizes) / sizeof(sizes[0]))
+
+static double __get_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* What exif_build_app1_with_comment gave before the templates */
+static int __build_with_libexif(unsigned int width, unsigned int height,
+	const char *comment, unsigned int comment_len, unsigned char *app1, unsigned int *app1_size)
+{
+	unsigned char *data = NULL;
+	unsigned int size = 0;
+
+	if (create_exif_data(soi_only_jpg, sizeof(soi_only_jpg), width, height,
+			comment, comment_len, &data, &size))
+		return -1;
+	if (size > TEMPLATE_SIZE_MAX) {
+		free(data);
+		return -1;
+	}
+
+	app1[0] = 0xff;
+	app1[1] = 0xe1;
+	app1[2] = (size + 2) >> 8;
+	app1[3] = (size + 2) & 0xff;
+	memcpy(app1 + APP1_HEADER_SIZE, data, size);
+	*app1_size = size + APP1_HEADER_SIZE;
+	free(data);
+
+	return 0;
+}
+
+static int __compare(unsigned int width, unsigned int height, const char *comment, unsigned int comment_len)
+{
+	unsigned char app1[EXIF_APP1_SIZE_MAX];
+	unsigned char expected[EXIF_APP1_SIZE_MAX];
+	unsigned int app1_size = 0;
+	unsigned int expected_size = 0;
+
+	if (exif_build_app1_with_comment(width, height, comment, comment_len, app1, &app1_size)
+		|| __build_with_libexif(width, height, comment, comment_len, expected, &expected_size)) {
+		fprintf(stderr, "%ux%u, comment of %u: build failed\n", width, height, comment_len);
+		return 1;
+	}
+
+	if (app1_size != expected_size || memcmp(app1, expected, app1_size)) {
+		fprintf(stderr, "%ux%u, comment of %u: does not match libexif, %u and %u bytes\n",
+			width, height, comment_len, app1_size, expected_size);
+		return 1;
+	}
+
+	return 0;
+}
+
+static void __bench(const char *comment, unsigned int comment_len)
+{
+	unsigned char app1[EXIF_APP1_SIZE_MAX];
+	unsigned int app1_size = 0;
+	double template_ns = 0;
+	double libexif_ns = 0;
+	double start = 0;
+	unsigned int i = 0;
+
+	/* the first call builds the template */
+	exif_build_app1_with_comment(640, 480, comment, comment_len, app1, &app1_size);
+
+	start = __get_ns();
+	for (i = 0; i < BENCH_RUNS; i++)
+		exif_build_app1_with_comment(640 + (i & 1), 480, comment, comment_len, app1, &app1_size);
+	template_ns = (__get_ns() - start) / BENCH_RUNS;
+
+	start = __get_ns();
+	for (i = 0; i < BENCH_RUNS; i++)
+		__build_with_libexif(640 + (i & 1), 480, comment, comment_len, app1, &app1_size);
+	libexif_ns = (__get_ns() - start) / BENCH_RUNS;
+
+	printf("comment of %4u: template %7.0f ns, libexif %7.0f ns per APP1 of %u bytes\n",
+		comment_len, template_ns, libexif_ns, app1_size);
+}
+
+int main(void)
+{
+	static const unsigned int lengths[] = { 1, 2, 16, 28, 100, 1023, TEMPLATE_COMMENT_MAX,
+		TEMPLATE_COMMENT_MAX + 1, LONG_COMMENT_SIZE };
+	char comment[LONG_COMMENT_SIZE];
+	unsigned int s = 0;
+	unsigned int i = 0;
+	unsigned int n = 0;
+	int failed = 0;
+
+	for (i = 0; i < sizeof(comment); i++)
+		comment[i] = '0' + (i * 7 + i / 10) % 10;
+
+	for (s = 0; s < SIZE_COUNT; s++) {
+		for (i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++)
+			failed += __compare(sizes[s][0], sizes[s][1], comment, lengths[i]);
+	}
+
+	/* more lengths than templates kept, twice, so they are rebuilt */
+	for (i = 0; i < 2; i++) {
+		for (n = 1; n <= 4 * TEMPLATE_CACHE_SIZE; n++)
+			failed += __compare(640, 480, comment + n, n);
+	}
+
+	printf("%s\n", failed ? "FAILED" : "templates give the same bytes as libexif");
+
+	__bench("00", 2);
+	__bench(comment, 36);
+	__bench(comment, TEMPLATE_COMMENT_MAX);
+
+	return failed ? 1 : 0;
+}
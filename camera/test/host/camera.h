@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __HOST_CAMERA_H__
+#define __HOST_CAMERA_H__
+
+/* Host stand-in for the Tizen camera API, only the pixel formats */
+typedef enum {
+	CAMERA_PIXEL_FORMAT_INVALID = -1,
+	CAMERA_PIXEL_FORMAT_NV12,
+	CAMERA_PIXEL_FORMAT_NV12T,
+	CAMERA_PIXEL_FORMAT_NV16,
+	CAMERA_PIXEL_FORMAT_NV21,
+	CAMERA_PIXEL_FORMAT_YUYV,
+	CAMERA_PIXEL_FORMAT_UYVY,
+	CAMERA_PIXEL_FORMAT_422P,
+	CAMERA_PIXEL_FORMAT_I420,
+	CAMERA_PIXEL_FORMAT_YV12,
+	CAMERA_PIXEL_FORMAT_RGB565,
+	CAMERA_PIXEL_FORMAT_RGB888,
+	CAMERA_PIXEL_FORMAT_RGBA,
+	CAMERA_PIXEL_FORMAT_ARGB,
+	CAMERA_PIXEL_FORMAT_JPEG,
+	CAMERA_PIXEL_FORMAT_H264,
+	CAMERA_PIXEL_FORMAT_INVZ,
+	CAMERA_PIXEL_FORMAT_MJPEG,
+	CAMERA_PIXEL_FORMAT_VP8,
+	CAMERA_PIXEL_FORMAT_VP9,
+} camera_pixel_format_e;
+
+#endif /* __HOST_CAMERA_H__ */
@@ -0,0 +1,240 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host test of the image_convert row kernels. Every kernel built for and
+ * supported by this CPU is compared with the scalar one on all lengths up
+ * to TEST_LENGTH_MAX and on unaligned buffers, then each one is timed on
+ * 1920 pixel rows and reported in MB/s of input.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "image_convert_internal.h"
+
+#define TEST_LENGTH_MAX 300
+#define TEST_ALIGN_MAX 4
+#define BENCH_WIDTH 1920
+#define BENCH_ROWS 2000
+
+#define BUFFER_SIZE (4 * (TEST_LENGTH_MAX + TEST_ALIGN_MAX) + 64)
+
+typedef struct {
+	unsigned char src[BUFFER_SIZE];
+	unsigned char src2[BUFFER_SIZE];
+	unsigned char src3[BUFFER_SIZE];
+	unsigned char out[BUFFER_SIZE];
+	unsigned char out2[BUFFER_SIZE];
+	short mean[TEST_LENGTH_MAX];
+	short dev[TEST_LENGTH_MAX];
+	unsigned int sums[TEST_LENGTH_MAX];
+} buffers_s;
+
+static unsigned int seed = 0x2468ace1;
+
+static unsigned char __random_byte(void)
+{
+	seed = seed * 1103515245 + 12345;
+	return seed >> 16;
+}
+
+static void __fill(unsigned char *buffer, unsigned int size)
+{
+	unsigned int i = 0;
+
+	for (i = 0; i < size; i++)
+		buffer[i] = __random_byte();
+}
+
+static double __get_sec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Scalar first, then whatever this build and CPU support, NULL terminated */
+static void __get_candidates(const image_convert_kernels_s **candidates)
+{
+	unsigned int count = 0;
+
+	candidates[count++] = &image_convert_scalar_kernels;
+#ifdef IMAGE_CONVERT_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("sse2"))
+		candidates[count++] = &image_convert_sse2_kernels;
+	if (__builtin_cpu_supports("avx2"))
+		candidates[count++] = &image_convert_avx2_kernels;
+#endif
+#ifdef IMAGE_CONVERT_NEON
+	if (image_convert_neon_is_available())
+		candidates[count++] = &image_convert_neon_kernels;
+#endif
+	candidates[count] = NULL;
+}
+
+#define CHECK(expr, what) do { \
+	if (!(expr)) { \
+		fprintf(stderr, "%s %s differs, length %u align %u\n", k->name, what, n, a); \
+		failed++; \
+	} \
+} while (0)
+
+/* Runs kernel k and the scalar one on the same random input */
+static int __check_kernels(const image_convert_kernels_s *k)
+{
+	const image_convert_kernels_s *s = &image_convert_scalar_kernels;
+	static buffers_s expected;
+	static buffers_s result;
+	unsigned int n = 0;
+	unsigned int a = 0;
+	unsigned int i = 0;
+	int failed = 0;
+
+	for (n = 1; n <= TEST_LENGTH_MAX; n++) {
+		for (a = 0; a < TEST_ALIGN_MAX; a++) {
+			__fill(expected.src, BUFFER_SIZE);
+			__fill(expected.src2, BUFFER_SIZE);
+			__fill(expected.src3, BUFFER_SIZE);
+			/* sentinel bytes past the end must stay untouched */
+			memset(expected.out, 0xA5, BUFFER_SIZE);
+			memset(expected.out2, 0x5A, BUFFER_SIZE);
+			result = expected;
+
+			s->extract_bytes(expected.src + a, expected.out, n, a & 1);
+			k->extract_bytes(result.src + a, result.out + a, n, a & 1);
+			CHECK(!memcmp(expected.out, result.out + a, n + 16), "extract_bytes");
+
+			s->average_rows(expected.src + a, expected.src2, expected.out, n);
+			k->average_rows(result.src + a, result.src2, result.out + a, n);
+			CHECK(!memcmp(expected.out, result.out + a, n), "average_rows");
+
+			s->split_uv(expected.src + a, expected.out, expected.out2, n);
+			k->split_uv(result.src + a, result.out + a, result.out2 + a, n);
+			CHECK(!memcmp(expected.out, result.out + a, n) && !memcmp(expected.out2, result.out2 + a, n),
+				"split_uv");
+
+			s->merge_uv(expected.src + a, expected.src2 + 1, expected.out, n);
+			k->merge_uv(result.src + a, result.src2 + 1, result.out + a, n);
+			CHECK(!memcmp(expected.out, result.out + a, 2 * n), "merge_uv");
+
+			s->rgba_to_y(expected.src + a, expected.out, n);
+			k->rgba_to_y(result.src + a, result.out + a, n);
+			CHECK(!memcmp(expected.out, result.out + a, n), "rgba_to_y");
+
+			s->downscale_2x(expected.src + a, expected.src2 + 1, expected.out, n);
+			k->downscale_2x(result.src + a, result.src2 + 1, result.out + a, n);
+			CHECK(!memcmp(expected.out, result.out + a, n), "downscale_2x");
+
+			for (i = 0; i < n; i++) {
+				expected.mean[i] = ((expected.src2[i] << 8) | expected.src3[i]) % (256 << MOTION_MODEL_FRAC_BITS);
+				expected.dev[i] = ((expected.src3[i] << 8) | expected.src[i]) % (256 << MOTION_MODEL_FRAC_BITS) >> (a + 1);
+			}
+			memcpy(result.mean, expected.mean, sizeof(expected.mean));
+			memcpy(result.dev, expected.dev, sizeof(expected.dev));
+			s->update_background(expected.src + a, expected.mean, expected.dev, expected.out, n, (a * 20) << MOTION_MODEL_FRAC_BITS);
+			k->update_background(result.src + a, result.mean, result.dev, result.out + a, n, (a * 20) << MOTION_MODEL_FRAC_BITS);
+			CHECK(!memcmp(expected.out, result.out + a, n)
+				&& !memcmp(expected.mean, result.mean, n * sizeof(short))
+				&& !memcmp(expected.dev, result.dev, n * sizeof(short)), "update_background");
+
+			s->erode_3x3(expected.src + a, expected.src2, expected.src3 + 1, expected.out, n);
+			k->erode_3x3(result.src + a, result.src2, result.src3 + 1, result.out + a, n);
+			CHECK(!memcmp(expected.out, result.out + a, n), "erode_3x3");
+
+			s->dilate_3x3(expected.src + a, expected.src2, expected.src3 + 1, expected.out, n);
+			k->dilate_3x3(result.src + a, result.src2, result.src3 + 1, result.out + a, n);
+			CHECK(!memcmp(expected.out, result.out + a, n), "dilate_3x3");
+
+			/* n / 4 blocks of 16 bytes, sums start out non zero */
+			for (i = 0; i < n / 4; i++)
+				expected.sums[i] = result.sums[i] = expected.src3[i] * 1000;
+			s->sum_blocks(expected.src + a, expected.sums, n / 4);
+			k->sum_blocks(result.src + a, result.sums, n / 4);
+			CHECK(!memcmp(expected.sums, result.sums, n / 4 * sizeof(unsigned int)), "sum_blocks");
+		}
+	}
+
+	return failed;
+}
+
+/* MB/s of input bytes over BENCH_ROWS rows of BENCH_WIDTH pixels */
+#define BENCH(name, bytes, call) do { \
+	double start = __get_sec(); \
+	for (r = 0; r < BENCH_ROWS; r++) \
+		call; \
+	printf("  %-18s %8.0f MB/s\n", name, (double)(bytes) * BENCH_ROWS / (__get_sec() - start) / 1e6); \
+} while (0)
+
+static void __bench_kernels(const image_convert_kernels_s *k)
+{
+	static unsigned char src[4 * BENCH_WIDTH];
+	static unsigned char src2[4 * BENCH_WIDTH];
+	static unsigned char out[2 * BENCH_WIDTH];
+	static unsigned char out2[BENCH_WIDTH];
+	static short mean[BENCH_WIDTH];
+	static short dev[BENCH_WIDTH];
+	static unsigned int sums[BENCH_WIDTH / 16];
+	unsigned int w = BENCH_WIDTH;
+	unsigned int r = 0;
+	unsigned int i = 0;
+
+	__fill(src, sizeof(src));
+	__fill(src2, sizeof(src2));
+	for (i = 0; i < w; i++) {
+		mean[i] = src2[i] << MOTION_MODEL_FRAC_BITS;
+		dev[i] = src[i] << 2;
+	}
+
+	printf("%s\n", k->name);
+	BENCH("extract_bytes", 2 * w, k->extract_bytes(src, out, w, 0));
+	BENCH("average_rows", 2 * w, k->average_rows(src, src2, out, w));
+	BENCH("split_uv", 2 * w, k->split_uv(src, out, out2, w));
+	BENCH("merge_uv", 2 * w, k->merge_uv(src, src2, out, w));
+	BENCH("rgba_to_y", 4 * w, k->rgba_to_y(src, out, w));
+	BENCH("downscale_2x", 4 * w, k->downscale_2x(src, src2, out, w));
+	BENCH("update_background", 5 * w, k->update_background(src, mean, dev, out, w, 12 << MOTION_MODEL_FRAC_BITS));
+	BENCH("erode_3x3", 3 * w, k->erode_3x3(src, src2, src + w, out, w));
+	BENCH("dilate_3x3", 3 * w, k->dilate_3x3(src, src2, src + w, out, w));
+	BENCH("sum_blocks", w, k->sum_blocks(src, sums, w / 16));
+}
+
+int main(void)
+{
+	const image_convert_kernels_s *candidates[5];
+	unsigned int i = 0;
+	int failed = 0;
+
+	__get_candidates(candidates);
+
+	for (i = 1; candidates[i]; i++) {
+		int ret = __check_kernels(candidates[i]);
+
+		printf("%s: %s\n", candidates[i]->name, ret ? "FAILED" : "matches scalar");
+		failed += ret;
+	}
+
+	printf("\nselected at runtime: %s\n\n", image_convert_get_kernels()->name);
+
+	for (i = 0; candidates[i]; i++)
+		__bench_kernels(candidates[i]);
+
+	return failed ? 1 : 0;
+}
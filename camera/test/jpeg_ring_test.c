@@ -0,0 +1,351 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host test of jpeg_ring: a writer thread fills a small ring as fast as it
+ * can while the main thread reads it, and every frame read has to be
+ * whole, the JPEG and metadata bytes being a function of its sequence.
+ * Then slot wraparound, a jpeg buffer too small for the frame and a ring
+ * closed by its writer are checked.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "jpeg_ring.h"
+
+#define SLOT_COUNT 4
+#define FRAME_MAX 4096
+#define SLOT_SIZE (sizeof(jpeg_ring_slot_s) + FRAME_MAX)
+#define TORTURE_WRITES 500000
+
+typedef struct {
+	jpeg_ring_h ring;
+	unsigned int writes;
+	volatile int done;
+} writer_s;
+
+static unsigned int __frame_size(unsigned int sequence)
+{
+	return 1 + (sequence * 2654435761u) % FRAME_MAX;
+}
+
+static unsigned int __meta_size(unsigned int sequence)
+{
+	return sequence % (JPEG_RING_META_MAX + 1);
+}
+
+static unsigned char __byte(unsigned int sequence, unsigned int i)
+{
+	return sequence * 31 + i * 7 + (i >> 8);
+}
+
+static void __fill(unsigned char *buffer, unsigned int size, unsigned int sequence)
+{
+	unsigned int i = 0;
+
+	for (i = 0; i < size; i++)
+		buffer[i] = __byte(sequence, i);
+}
+
+static int __is_whole(const jpeg_ring_frame_s *frame, const unsigned char *jpeg)
+{
+	unsigned int i = 0;
+
+	if (frame->size != __frame_size(frame->sequence) || frame->meta_size != __meta_size(frame->sequence))
+		return 0;
+	if (frame->width != frame->sequence || frame->height != ~frame->sequence)
+		return 0;
+	for (i = 0; i < frame->size; i++)
+		if (jpeg[i] != __byte(frame->sequence, i))
+			return 0;
+	for (i = 0; i < frame->meta_size; i++)
+		if (frame->meta[i] != __byte(~frame->sequence, i))
+			return 0;
+
+	return 1;
+}
+
+static int __write(jpeg_ring_h ring, unsigned int sequence)
+{
+	static unsigned char jpeg[FRAME_MAX];
+	static unsigned char meta[JPEG_RING_META_MAX];
+
+	__fill(jpeg, __frame_size(sequence), sequence);
+	__fill(meta, __meta_size(sequence), ~sequence);
+
+	return jpeg_ring_write(ring, jpeg, __frame_size(sequence), sequence, ~sequence, meta, __meta_size(sequence));
+}
+
+static void *__writer(void *data)
+{
+	writer_s *writer = data;
+	unsigned int sequence = 0;
+
+	for (sequence = 1; sequence <= writer->writes; sequence++)
+		__write(writer->ring, sequence);
+	__atomic_store_n(&writer->done, 1, __ATOMIC_RELEASE);
+
+	return NULL;
+}
+
+/*
+ * Reads the newest frame over and over while a thread writes, so copies
+ * race with the writer. Every frame read has to be whole and not older
+ * than the one before.
+ */
+static int __test_torture(const char *path)
+{
+	static unsigned char jpeg[FRAME_MAX];
+	static jpeg_ring_frame_s frame;
+	jpeg_ring_reader_h reader = NULL;
+	writer_s writer = { NULL, TORTURE_WRITES, 0 };
+	unsigned long long int reads = 0;
+	unsigned long long int frames = 0;
+	unsigned long long int misses = 0;
+	unsigned long long int torn = 0;
+	unsigned int last = 0;
+	pthread_t thread;
+	int failed = 0;
+	int ret = 0;
+
+	writer.ring = jpeg_ring_create(path, SLOT_COUNT, SLOT_SIZE);
+	reader = jpeg_ring_reader_open(path);
+	if (!writer.ring || !reader) {
+		fprintf(stderr, "can not create %s\n", path);
+		jpeg_ring_reader_close(reader);
+		jpeg_ring_destroy(writer.ring);
+		return 1;
+	}
+
+	pthread_create(&thread, NULL, __writer, &writer);
+	while (!__atomic_load_n(&writer.done, __ATOMIC_ACQUIRE)) {
+		ret = jpeg_ring_reader_read(reader, 0, &frame, jpeg, sizeof(jpeg));
+		if (ret < 0) {
+			fprintf(stderr, "torture: read failed\n");
+			failed++;
+			break;
+		}
+		if (!ret) {
+			misses++;
+			continue;
+		}
+		reads++;
+		if (!__is_whole(&frame, jpeg) || frame.sequence < last)
+			torn++;
+		if (frame.sequence != last)
+			frames++;
+		last = frame.sequence;
+	}
+	pthread_join(thread, NULL);
+
+	printf("torture: %u writes, %llu reads of %llu frames, %llu torn, %llu given up on a busy slot\n",
+		writer.writes, reads, frames, torn, misses);
+	if (torn || !reads) {
+		fprintf(stderr, "torture: %llu torn frames of %llu\n", torn, reads);
+		failed++;
+	}
+
+	jpeg_ring_reader_close(reader);
+	jpeg_ring_destroy(writer.ring);
+
+	return failed;
+}
+
+/* Frames past slot_count reuse the slots, the reader always gets the newest */
+static int __test_wraparound(const char *path)
+{
+	static unsigned char jpeg[FRAME_MAX];
+	static jpeg_ring_frame_s frame;
+	jpeg_ring_reader_h reader = NULL;
+	jpeg_ring_stats_s stats;
+	jpeg_ring_h ring = NULL;
+	unsigned int sequence = 0;
+	int failed = 0;
+	int ret = 0;
+
+	ring = jpeg_ring_create(path, SLOT_COUNT, SLOT_SIZE);
+	reader = jpeg_ring_reader_open(path);
+	if (!ring || !reader) {
+		fprintf(stderr, "can not create %s\n", path);
+		jpeg_ring_reader_close(reader);
+		jpeg_ring_destroy(ring);
+		return 1;
+	}
+
+	if (jpeg_ring_reader_read(reader, 0, &frame, jpeg, sizeof(jpeg)) != 0) {
+		fprintf(stderr, "wraparound: a frame before the first write\n");
+		failed++;
+	}
+
+	for (sequence = 1; sequence <= 3 * SLOT_COUNT + 1; sequence++) {
+		__write(ring, sequence);
+		ret = jpeg_ring_reader_read(reader, sequence - 1, &frame, jpeg, sizeof(jpeg));
+		if (ret != 1 || frame.sequence != sequence || !__is_whole(&frame, jpeg)) {
+			fprintf(stderr, "wraparound: frame %u read as %d, sequence %u\n", sequence, ret, frame.sequence);
+			failed++;
+		}
+		/* nothing new since */
+		if (jpeg_ring_reader_read(reader, sequence, &frame, jpeg, sizeof(jpeg)) != 0) {
+			fprintf(stderr, "wraparound: frame %u read twice\n", sequence);
+			failed++;
+		}
+	}
+
+	/* a reader that fell behind a whole lap gets the newest frame, not the one in its old slot */
+	sequence = 3 * SLOT_COUNT + 1;
+	ret = jpeg_ring_reader_read(reader, sequence - SLOT_COUNT, &frame, jpeg, sizeof(jpeg));
+	if (ret != 1 || frame.sequence != sequence) {
+		fprintf(stderr, "wraparound: a reader a lap behind got %u instead of %u\n", frame.sequence, sequence);
+		failed++;
+	}
+
+	jpeg_ring_get_stats(ring, &stats);
+	printf("wraparound: %llu frames over %u slots, head %u\n", stats.written, SLOT_COUNT, stats.head);
+	if (stats.written != sequence || stats.head != sequence || stats.skipped) {
+		fprintf(stderr, "wraparound: stats %llu written, head %u\n", stats.written, stats.head);
+		failed++;
+	}
+
+	jpeg_ring_reader_close(reader);
+	jpeg_ring_destroy(ring);
+
+	return failed;
+}
+
+/* A frame larger than the reader's buffer, or than a slot */
+static int __test_sizes(const char *path)
+{
+	static unsigned char jpeg[FRAME_MAX + 1];
+	static jpeg_ring_frame_s frame;
+	jpeg_ring_reader_h reader = NULL;
+	jpeg_ring_stats_s stats;
+	jpeg_ring_h ring = NULL;
+	unsigned int sequence = 1;
+	unsigned int size = __frame_size(sequence);
+	int failed = 0;
+
+	ring = jpeg_ring_create(path, SLOT_COUNT, SLOT_SIZE);
+	reader = jpeg_ring_reader_open(path);
+	if (!ring || !reader) {
+		fprintf(stderr, "can not create %s\n", path);
+		jpeg_ring_reader_close(reader);
+		jpeg_ring_destroy(ring);
+		return 1;
+	}
+
+	__write(ring, sequence);
+	if (jpeg_ring_reader_read(reader, 0, &frame, jpeg, size - 1) != -1) {
+		fprintf(stderr, "sizes: a %u byte frame went into %u bytes\n", size, size - 1);
+		failed++;
+	}
+	if (jpeg_ring_reader_read(reader, 0, &frame, jpeg, size) != 1 || !__is_whole(&frame, jpeg)) {
+		fprintf(stderr, "sizes: a %u byte frame did not go into %u bytes\n", size, size);
+		failed++;
+	}
+
+	memset(jpeg, 0, sizeof(jpeg));
+	if (jpeg_ring_write(ring, jpeg, FRAME_MAX + 1, 1, 1, NULL, 0) != -1) {
+		fprintf(stderr, "sizes: a frame larger than a slot was written\n");
+		failed++;
+	}
+	jpeg_ring_get_stats(ring, &stats);
+	if (stats.skipped != 1 || stats.head != sequence) {
+		fprintf(stderr, "sizes: %llu skipped, head %u\n", stats.skipped, stats.head);
+		failed++;
+	}
+	printf("sizes: short buffer refused, %llu frame larger than a slot skipped\n", stats.skipped);
+
+	jpeg_ring_reader_close(reader);
+	jpeg_ring_destroy(ring);
+
+	return failed;
+}
+
+/* Readers of a ring its writer closed get -1, and the new ring on open */
+static int __test_closed(const char *path)
+{
+	static unsigned char jpeg[FRAME_MAX];
+	static jpeg_ring_frame_s frame;
+	jpeg_ring_reader_h reader = NULL;
+	jpeg_ring_h ring = NULL;
+	int failed = 0;
+
+	ring = jpeg_ring_create(path, SLOT_COUNT, SLOT_SIZE);
+	reader = jpeg_ring_reader_open(path);
+	if (!ring || !reader) {
+		fprintf(stderr, "can not create %s\n", path);
+		jpeg_ring_reader_close(reader);
+		jpeg_ring_destroy(ring);
+		return 1;
+	}
+	__write(ring, 1);
+	jpeg_ring_destroy(ring);
+
+	if (jpeg_ring_reader_read(reader, 0, &frame, jpeg, sizeof(jpeg)) != -1) {
+		fprintf(stderr, "closed: a closed ring was read\n");
+		failed++;
+	}
+	jpeg_ring_reader_close(reader);
+
+	if (jpeg_ring_reader_open(path)) {
+		fprintf(stderr, "closed: a closed ring was opened\n");
+		failed++;
+	}
+
+	/* the service restarts and creates it again */
+	ring = jpeg_ring_create(path, SLOT_COUNT, SLOT_SIZE);
+	reader = jpeg_ring_reader_open(path);
+	if (!ring || !reader) {
+		fprintf(stderr, "closed: the new ring can not be opened\n");
+		failed++;
+	} else {
+		__write(ring, 1);
+		__write(ring, 2);
+		if (jpeg_ring_reader_read(reader, 0, &frame, jpeg, sizeof(jpeg)) != 1 || frame.sequence != 2) {
+			fprintf(stderr, "closed: the new ring was not read\n");
+			failed++;
+		}
+	}
+	printf("closed: reads of a closed ring fail, the new ring is read\n");
+
+	jpeg_ring_reader_close(reader);
+	jpeg_ring_destroy(ring);
+
+	return failed;
+}
+
+int main(void)
+{
+	char path[64];
+	int failed = 0;
+
+	snprintf(path, sizeof(path), "/tmp/jpeg_ring_test_%d.ring", (int)getpid());
+
+	failed += __test_torture(path);
+	failed += __test_wraparound(path);
+	failed += __test_sizes(path);
+	failed += __test_closed(path);
+
+	unlink(path);
+
+	printf("%s\n", failed ? "FAILED" : "no torn frames");
+
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host test of latest_slot: one producer publishes items as fast as it can
+ * while reader threads take and drop references. Every reference a reader
+ * gets has to be to a live item, no newer item may be followed by an older
+ * one, and once the slot is destroyed every item has been released exactly
+ * once.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "latest_slot.h"
+
+#define PUBLISHES 1000000
+#define READERS 4
+#define ITEM_ALIVE 0x600dc0deu
+#define ITEM_DEAD 0xdeadbeefu
+
+typedef struct {
+	unsigned int magic;
+	unsigned int sequence;
+	int refcount;
+} item_s;
+
+typedef struct {
+	latest_slot_h slot;
+	volatile int *done;
+	unsigned long long reads;
+	unsigned int errors;
+} reader_s;
+
+static int released;
+static int double_released;
+
+static void *__item_ref(void *data)
+{
+	item_s *item = data;
+
+	__atomic_add_fetch(&item->refcount, 1, __ATOMIC_RELAXED);
+
+	return item;
+}
+
+static void __item_unref(void *data)
+{
+	item_s *item = data;
+
+	if (__atomic_sub_fetch(&item->refcount, 1, __ATOMIC_ACQ_REL))
+		return;
+
+	/* Items are never freed, so a second release shows up here */
+	if (item->magic != ITEM_ALIVE)
+		__atomic_add_fetch(&double_released, 1, __ATOMIC_RELAXED);
+	item->magic = ITEM_DEAD;
+	__atomic_add_fetch(&released, 1, __ATOMIC_RELAXED);
+}
+
+static void *__reader(void *data)
+{
+	reader_s *reader = data;
+	unsigned int last = 0;
+
+	while (!*reader->done) {
+		item_s *item = latest_slot_get(reader->slot);
+
+		if (!item)
+			continue;
+
+		if (item->magic != ITEM_ALIVE || item->sequence < last)
+			reader->errors++;
+		last = item->sequence;
+		reader->reads++;
+		__item_unref(item);
+	}
+
+	return NULL;
+}
+
+int main(void)
+{
+	item_s *items = calloc(PUBLISHES, sizeof(item_s));
+	latest_slot_h slot = latest_slot_create(__item_ref, __item_unref);
+	reader_s readers[READERS];
+	pthread_t threads[READERS];
+	volatile int done = 0;
+	unsigned long long reads = 0;
+	unsigned int errors = 0;
+	unsigned int i = 0;
+	int failed = 0;
+
+	if (!items || !slot) {
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+
+	for (i = 0; i < READERS; i++) {
+		readers[i].slot = slot;
+		readers[i].done = &done;
+		readers[i].reads = 0;
+		readers[i].errors = 0;
+		pthread_create(&threads[i], NULL, __reader, &readers[i]);
+	}
+
+	for (i = 0; i < PUBLISHES; i++) {
+		items[i].magic = ITEM_ALIVE;
+		items[i].sequence = i + 1;
+		items[i].refcount = 1;
+		latest_slot_publish(slot, &items[i]);
+	}
+
+	done = 1;
+	for (i = 0; i < READERS; i++) {
+		pthread_join(threads[i], NULL);
+		reads += readers[i].reads;
+		errors += readers[i].errors;
+	}
+
+	/* An emptied slot drops its last item too */
+	latest_slot_publish(slot, NULL);
+	if (released != PUBLISHES) {
+		fprintf(stderr, "%d of %d items released after emptying the slot\n", released, PUBLISHES);
+		failed++;
+	}
+	latest_slot_destroy(slot);
+
+	printf("%d publishes, %llu reads by %d readers\n", PUBLISHES, reads, READERS);
+	if (errors) {
+		fprintf(stderr, "%u reads of a released or older item\n", errors);
+		failed++;
+	}
+	if (double_released) {
+		fprintf(stderr, "%d items released twice\n", double_released);
+		failed++;
+	}
+
+	free(items);
+
+	printf("%s\n", failed ? "FAILED" : "every item released once, never read after");
+
+	return failed ? 1 : 0;
+}
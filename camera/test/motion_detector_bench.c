@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host benchmark of motion_detector on a worker_pool of 1, 2 and 4
+ * threads. Every frame is also checked to give the same regions as the
+ * single thread run.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "motion_detector.h"
+#include "worker_pool.h"
+
+#define BENCH_FRAMES 200
+#define BENCH_BOXES 6
+
+static const unsigned int sizes[][2] = { { 320, 240 }, { 640, 480 }, { 1280, 720 } };
+static const unsigned int threads[] = { 1, 2, 4 };
+
+#define SIZE_COUNT (sizeof(sizes) / sizeof(sizes[0]))
+#define THREAD_COUNT (sizeof(threads) / sizeof(threads[0]))
+
+static double __get_ms(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+/* Sensor noise with a few bright boxes moving across the frame */
+static void __draw_scene(unsigned char *img, unsigned int width, unsigned int height, unsigned int frame)
+{
+	unsigned int i = 0;
+	unsigned int x = 0;
+	unsigned int y = 0;
+
+	srand(frame);
+	for (i = 0; i < width * height; i++)
+		img[i] = 100 + rand() % 12;
+
+	for (i = 0; i < BENCH_BOXES; i++) {
+		unsigned int bx = (i * 97 + frame * 3 * (i + 1)) % width;
+		unsigned int by = (i * 53 + frame * 2) % height;
+		unsigned int bw = width / 32 + i * 9;
+		unsigned int bh = height / 20 + i * 7;
+
+		for (y = by; y < by + bh && y < height; y++)
+			for (x = bx; x < bx + bw && x < width; x++)
+				img[y * width + x] = 230;
+	}
+}
+
+static int __same_regions(const region_set_s *a, int a_count, const region_set_s *b, int b_count)
+{
+	int i = 0;
+
+	if (a_count != b_count)
+		return 0;
+
+	for (i = 0; i < a_count; i++) {
+		if (a->x[i] != b->x[i] || a->y[i] != b->y[i]
+			|| a->width[i] != b->width[i] || a->height[i] != b->height[i]
+			|| a->pixels[i] != b->pixels[i])
+			return 0;
+	}
+
+	return 1;
+}
+
+int main(void)
+{
+	unsigned int s = 0;
+	unsigned int t = 0;
+	unsigned int f = 0;
+	int failed = 0;
+
+	printf("%-10s %8s %12s %10s\n", "size", "threads", "ms/frame", "speedup");
+
+	for (s = 0; s < SIZE_COUNT; s++) {
+		unsigned int width = sizes[s][0];
+		unsigned int height = sizes[s][1];
+		unsigned char *img = malloc(width * height);
+		region_set_s *expected = calloc(BENCH_FRAMES, sizeof(region_set_s));
+		int *expected_count = calloc(BENCH_FRAMES, sizeof(int));
+		image_luma_s luma = { img, width, height, width };
+		double single_ms = 0;
+
+		if (!img || !expected || !expected_count) {
+			fprintf(stderr, "out of memory\n");
+			return 1;
+		}
+
+		for (t = 0; t < THREAD_COUNT; t++) {
+			worker_pool_h pool = threads[t] > 1 ? worker_pool_create(threads[t]) : NULL;
+			motion_detector_h detector = motion_detector_create(20);
+			region_set_s regions;
+			double elapsed = 0;
+			double start = 0;
+			int count = 0;
+
+			motion_detector_set_pool(detector, pool);
+
+			/* The first frame only seeds the background */
+			__draw_scene(img, width, height, 0);
+			motion_detector_process(detector, &luma, &regions);
+
+			for (f = 0; f < BENCH_FRAMES; f++) {
+				__draw_scene(img, width, height, f + 1);
+				start = __get_ms();
+				count = motion_detector_process(detector, &luma, &regions);
+				elapsed += __get_ms() - start;
+
+				if (t == 0) {
+					expected[f] = regions;
+					expected_count[f] = count;
+				} else if (!__same_regions(&expected[f], expected_count[f], &regions, count)) {
+					fprintf(stderr, "%ux%u with %u threads: frame %u differs\n",
+						width, height, threads[t], f);
+					failed++;
+				}
+			}
+
+			if (t == 0)
+				single_ms = elapsed;
+			printf("%4ux%-5u %8u %12.3f %9.2fx\n", width, height, threads[t],
+				elapsed / BENCH_FRAMES, single_ms / elapsed);
+
+			motion_detector_destroy(detector);
+			if (pool)
+				worker_pool_destroy(pool);
+		}
+
+		free(expected_count);
+		free(expected);
+		free(img);
+	}
+
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,337 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host test of motion_meta: 100000 random records go through encode and
+ * decode, and every 100th also through an APP10 segment in a JPEG header,
+ * and must come back the same. The ASCII form is compared byte for byte
+ * with the EXIF comment controller.c wrote before the binary record, and
+ * a record of a later version with a larger header and larger regions is
+ * read by skipping what this version does not know.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "controller.h"
+#include "motion_meta.h"
+
+#define ROUND_TRIPS 100000
+
+static unsigned int seed = 0x2545f491;
+
+static unsigned int __random(void)
+{
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+
+	return seed;
+}
+
+/*
+ * What controller_mv.c gave the old __set_result_info(): zones in 0 ~ 99 of
+ * the analysed level, their track ids and ages
+ */
+typedef struct {
+	int result[MV_RESULT_LENGTH_MAX];
+	int result_count;
+	unsigned int track_id[MV_RESULT_COUNT_MAX];
+	unsigned int track_age[MV_RESULT_COUNT_MAX];
+	int entered;
+} old_event_s;
+
+#define TRACK_AGE_UNIT_MS 100
+#define TRACK_AGE_MAX 9999
+
+/* __set_result_info() of controller.c before the binary record, publishing left out */
+static void __old_set_result_info(const old_event_s *event, int image_result_type, char *image_info)
+{
+	char *current_position;
+	int current_index = 0;
+	int string_count = 0;
+	int zone_count = 0;
+	int i = 0;
+
+	current_position = image_info;
+
+	current_position += snprintf(current_position, IMAGE_INFO_MAX, "%02d", image_result_type);
+	string_count += 2;
+
+	current_position += snprintf(current_position, IMAGE_INFO_MAX - string_count, "%02d", event->result_count);
+	string_count += 2;
+
+	for (i = 0; i < event->result_count; i++) {
+		current_index = i * 4;
+		if (IMAGE_INFO_MAX - string_count < 8)
+			break;
+
+		current_position += snprintf(current_position, IMAGE_INFO_MAX - string_count, "%02d%02d%02d%02d"
+			, event->result[current_index], event->result[current_index + 1]
+			, event->result[current_index + 2], event->result[current_index + 3]);
+		string_count += 8;
+		zone_count++;
+	}
+
+	for (i = 0; i < zone_count; i++) {
+		unsigned int age = event->track_age[i] / TRACK_AGE_UNIT_MS;
+
+		if (IMAGE_INFO_MAX - string_count < 8)
+			break;
+
+		current_position += snprintf(current_position, IMAGE_INFO_MAX - string_count, "%04u%04u",
+			event->track_id[i] % 10000, age > TRACK_AGE_MAX ? TRACK_AGE_MAX : age);
+		string_count += 8;
+	}
+}
+
+static void __random_meta(motion_meta_s *meta, unsigned int region_max)
+{
+	unsigned int i = 0;
+
+	memset(meta, 0, sizeof(motion_meta_s));
+	meta->sequence = __random();
+	meta->timestamp = ((unsigned long long int)__random() << 32) | __random();
+	meta->frame_width = 1 + __random() % 0xffff;
+	meta->frame_height = 1 + __random() % 0xffff;
+	meta->area_sum = __random();
+	meta->event = __random() % 3;
+	meta->object_count = (int)(__random() % 129) - 1;
+	meta->entered_id = __random();
+	meta->region_count = __random() % (region_max + 1);
+	for (i = 0; i < meta->region_count; i++) {
+		motion_meta_region_s *region = &meta->regions[i];
+
+		region->x = __random() % 0x10000;
+		region->y = __random() % 0x10000;
+		region->width = __random() % 0x10000;
+		region->height = __random() % 0x10000;
+		region->area = __random();
+		region->track_id = __random();
+		region->track_age = __random();
+	}
+}
+
+static int __is_same(const motion_meta_s *a, const motion_meta_s *b)
+{
+	unsigned int i = 0;
+
+	if (a->sequence != b->sequence || a->timestamp != b->timestamp
+		|| a->frame_width != b->frame_width || a->frame_height != b->frame_height
+		|| a->area_sum != b->area_sum || a->event != b->event || a->object_count != b->object_count
+		|| a->entered_id != b->entered_id || a->region_count != b->region_count)
+		return 0;
+
+	for (i = 0; i < a->region_count; i++) {
+		if (memcmp(&a->regions[i], &b->regions[i], sizeof(motion_meta_region_s)))
+			return 0;
+	}
+
+	return 1;
+}
+
+/* SOI, an APP0, the segment, then the start of a scan */
+static unsigned int __build_jpeg(const unsigned char *segment, unsigned int segment_size, unsigned char *jpeg)
+{
+	static const unsigned char app0[] = { 0xff, 0xe0, 0x00, 0x07, 'J', 'F', 'I', 'F', 0 };
+	static const unsigned char sos[] = { 0xff, 0xda, 0x00, 0x02, 0xff, 0xd9 };
+	unsigned int size = 0;
+
+	jpeg[size++] = 0xff;
+	jpeg[size++] = 0xd8;
+	memcpy(jpeg + size, app0, sizeof(app0));
+	size += sizeof(app0);
+	memcpy(jpeg + size, segment, segment_size);
+	size += segment_size;
+	memcpy(jpeg + size, sos, sizeof(sos));
+
+	return size + sizeof(sos);
+}
+
+static int __test_round_trip(void)
+{
+	static unsigned char jpeg[MOTION_META_SEGMENT_SIZE_MAX + 32];
+	unsigned char buffer[MOTION_META_SEGMENT_SIZE_MAX];
+	motion_meta_s meta;
+	motion_meta_s decoded;
+	unsigned int i = 0;
+	int failed = 0;
+	int size = 0;
+
+	for (i = 0; i < ROUND_TRIPS && failed < 10; i++) {
+		__random_meta(&meta, MOTION_META_REGION_MAX);
+
+		size = motion_meta_encode(&meta, buffer, sizeof(buffer));
+		if (size != (int)(MOTION_META_HEADER_SIZE + meta.region_count * MOTION_META_REGION_SIZE)
+			|| motion_meta_decode(buffer, size, &decoded) || !__is_same(&meta, &decoded)) {
+			fprintf(stderr, "round trip %u: record differs\n", i);
+			failed++;
+			continue;
+		}
+
+		/* one byte short does not decode, checked on a few as each logs */
+		if (i < 10 && !motion_meta_decode(buffer, size - 1, &decoded)) {
+			fprintf(stderr, "round trip %u: a cut record decoded\n", i);
+			failed++;
+		}
+
+		if (i % 100)
+			continue;
+
+		size = motion_meta_encode_segment(&meta, buffer, sizeof(buffer));
+		if (size < 0 || motion_meta_decode_jpeg(jpeg, __build_jpeg(buffer, size, jpeg), &decoded)
+			|| !__is_same(&meta, &decoded)) {
+			fprintf(stderr, "round trip %u: segment differs\n", i);
+			failed++;
+		}
+	}
+	printf("round trip: %u records, %s\n", i, failed ? "FAILED" : "all the same");
+
+	return failed;
+}
+
+/* Random events as controller_mv.c reports them, on a level of the frame */
+static int __test_ascii(void)
+{
+	char expected[IMAGE_INFO_MAX + 1];
+	char text[IMAGE_INFO_MAX + 1];
+	old_event_s event;
+	motion_meta_s meta;
+	unsigned int i = 0;
+	unsigned int r = 0;
+	int failed = 0;
+	int length = 0;
+
+	for (i = 0; i < ROUND_TRIPS && failed < 10; i++) {
+		unsigned int level = __random() % 3;
+		unsigned int width = 16 + __random() % 1024;
+		unsigned int height = 16 + __random() % 768;
+
+		memset(&meta, 0, sizeof(meta));
+		memset(&event, 0, sizeof(event));
+		meta.frame_width = width << level;
+		meta.frame_height = height << level;
+		meta.region_count = 1 + __random() % MV_RESULT_COUNT_MAX;
+		event.result_count = meta.region_count;
+		event.entered = __random() % 2;
+		meta.event = event.entered ? MOTION_META_EVENT_ENTERED : MOTION_META_EVENT_MOTION;
+
+		for (r = 0; r < meta.region_count; r++) {
+			motion_meta_region_s *region = &meta.regions[r];
+			unsigned int x = __random() % width;
+			unsigned int y = __random() % height;
+			unsigned int w = 1 + __random() % (width - x);
+			unsigned int h = 1 + __random() % (height - y);
+
+			event.result[4 * r] = x * 99 / width;
+			event.result[4 * r + 1] = y * 99 / height;
+			event.result[4 * r + 2] = w * 99 / width;
+			event.result[4 * r + 3] = h * 99 / height;
+			region->x = x << level;
+			region->y = y << level;
+			region->width = w << level;
+			region->height = h << level;
+			/* ids past 9999 and ages past 999.9 s are cut the same way */
+			region->track_id = event.track_id[r] = __random() % 20000;
+			region->track_age = event.track_age[r] = __random() % 1200000;
+		}
+
+		memset(expected, 0, sizeof(expected));
+		__old_set_result_info(&event, event.entered, expected);
+		length = motion_meta_to_ascii(&meta, text, sizeof(text));
+		if (length != (int)strlen(expected) || memcmp(text, expected, length + 1)) {
+			fprintf(stderr, "ascii %u:\n  old %s\n  new %s\n", i, expected, length < 0 ? "" : text);
+			failed++;
+		}
+	}
+
+	/* a frame without motion only had its event */
+	meta.event = MOTION_META_EVENT_NONE;
+	length = motion_meta_to_ascii(&meta, text, sizeof(text));
+	if (length != 2 || strcmp(text, "00")) {
+		fprintf(stderr, "ascii: a frame without motion is %s\n", text);
+		failed++;
+	}
+	printf("ascii: %u events, %s\n", i, failed ? "FAILED" : "the same bytes as before");
+
+	return failed;
+}
+
+/*
+ * A later version with 8 more header bytes and 4 more bytes per region:
+ * known fields are read, the new ones skipped
+ */
+static int __test_later_version(void)
+{
+	unsigned char current[MOTION_META_SIZE_MAX];
+	unsigned char later[MOTION_META_SIZE_MAX + 8 + 4 * MOTION_META_REGION_MAX];
+	unsigned int header_size = MOTION_META_HEADER_SIZE + 8;
+	unsigned int region_size = MOTION_META_REGION_SIZE + 4;
+	motion_meta_s meta;
+	motion_meta_s decoded;
+	unsigned int i = 0;
+	int failed = 0;
+	int size = 0;
+
+	__random_meta(&meta, MOTION_META_REGION_MAX);
+	meta.region_count = 5;
+	size = motion_meta_encode(&meta, current, sizeof(current));
+
+	/* the header and each region, with the new bytes after them */
+	memset(later, 0xA5, sizeof(later));
+	memcpy(later, current, MOTION_META_HEADER_SIZE);
+	later[4] = MOTION_META_VERSION + 1;
+	later[6] = header_size;
+	later[8] = region_size;
+	for (i = 0; i < meta.region_count; i++)
+		memcpy(later + header_size + i * region_size,
+			current + MOTION_META_HEADER_SIZE + i * MOTION_META_REGION_SIZE, MOTION_META_REGION_SIZE);
+	size = header_size + meta.region_count * region_size;
+
+	if (motion_meta_decode(later, size, &decoded) || !__is_same(&meta, &decoded)) {
+		fprintf(stderr, "later version: not read the same\n");
+		failed++;
+	}
+	if (!motion_meta_decode(later, size - 1, &decoded)) {
+		fprintf(stderr, "later version: a cut record decoded\n");
+		failed++;
+	}
+
+	/* a smaller header than this version knows is not trusted */
+	later[6] = MOTION_META_HEADER_SIZE - 4;
+	if (!motion_meta_decode(later, size, &decoded)) {
+		fprintf(stderr, "later version: a short header decoded\n");
+		failed++;
+	}
+	printf("later version: header %u and regions %u bytes, %s\n", header_size, region_size,
+		failed ? "FAILED" : "known fields read");
+
+	return failed;
+}
+
+int main(void)
+{
+	int failed = 0;
+
+	failed += __test_round_trip();
+	failed += __test_ascii();
+	failed += __test_later_version();
+
+	printf("%s\n", failed ? "FAILED" : "motion records are read back as written");
+
+	return failed ? 1 : 0;
+}
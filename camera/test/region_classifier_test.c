@@ -0,0 +1,283 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host test of region_classifier with a stub detector, which finds an
+ * object in a crop when the pixel at its center is dark. It checks the
+ * crop each region is given to the detector with and the level it comes
+ * from, then the result cache and the time budget.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "region_classifier.h"
+#include "image_pyramid.h"
+
+#define FRAME_WIDTH 640
+#define FRAME_HEIGHT 480
+#define BACKGROUND 150
+#define OBJECT 60
+#define SLOW_DETECT_USEC 20000
+
+typedef struct {
+	const char *name;
+	unsigned int x;
+	unsigned int y;
+	unsigned int width;
+	unsigned int height;
+	int dark;
+	region_class_e expected;
+} known_region_s;
+
+/* Regions are laid out apart, so one crop never reaches into another */
+static const known_region_s known_regions[] = {
+	{ "large", 100, 40, 400, 400, 1, REGION_CLASS_OBJECT },
+	{ "object", 20, 20, 40, 80, 1, REGION_CLASS_OBJECT },
+	{ "at the edge", 600, 400, 40, 80, 1, REGION_CLASS_OBJECT },
+	{ "empty", 540, 20, 60, 100, 0, REGION_CLASS_NONE },
+	{ "tiny", 20, 300, 10, 20, 1, REGION_CLASS_NONE },
+};
+
+#define KNOWN_REGION_COUNT (sizeof(known_regions) / sizeof(known_regions[0]))
+
+typedef struct {
+	const image_pyramid_s *pyramid;
+	unsigned int calls;
+	unsigned int level; // of the last crop
+	unsigned int x; // of the last crop, in pixels of its level
+	unsigned int y;
+	unsigned int width;
+	unsigned int height;
+	unsigned int usec;
+} stub_detector_s;
+
+static int __stub_detect(const image_luma_s *crop, void *user_data)
+{
+	stub_detector_s *stub = user_data;
+	const image_luma_s *level = NULL;
+	size_t offset = 0;
+	unsigned int i = 0;
+
+	for (i = 0; i < stub->pyramid->levels; i++) {
+		level = &stub->pyramid->level[i];
+		if (crop->data >= level->data && crop->data < level->data + (size_t)level->stride * level->height)
+			break;
+	}
+	if (i == stub->pyramid->levels || crop->stride != level->stride)
+		return -1;
+
+	offset = crop->data - level->data;
+	stub->calls++;
+	stub->level = i;
+	stub->x = offset % level->stride;
+	stub->y = offset / level->stride;
+	stub->width = crop->width;
+	stub->height = crop->height;
+	if (stub->usec)
+		usleep(stub->usec);
+
+	return crop->data[(crop->height / 2) * crop->stride + crop->width / 2] < (BACKGROUND + OBJECT) / 2;
+}
+
+/* The crop region_classifier.c takes around a region, in full frame pixels */
+static void __expected_crop(const known_region_s *region, unsigned int *x, unsigned int *y,
+	unsigned int *width, unsigned int *height, unsigned int *level)
+{
+	unsigned int margin_x = region->width >> REGION_CLASSIFIER_CROP_MARGIN_SHIFT;
+	unsigned int margin_y = region->height >> REGION_CLASSIFIER_CROP_MARGIN_SHIFT;
+	unsigned int x1 = region->x + region->width + margin_x;
+	unsigned int y1 = region->y + region->height + margin_y;
+
+	*x = region->x > margin_x ? region->x - margin_x : 0;
+	*y = region->y > margin_y ? region->y - margin_y : 0;
+	*width = (x1 < FRAME_WIDTH ? x1 : FRAME_WIDTH) - *x;
+	*height = (y1 < FRAME_HEIGHT ? y1 : FRAME_HEIGHT) - *y;
+
+	*level = 0;
+	while (*level + 1 < IMAGE_PYRAMID_LEVEL_MAX
+		&& (*width >> (*level + 1)) >= REGION_CLASSIFIER_CROP_DETAIL_MIN
+		&& (*height >> (*level + 1)) >= REGION_CLASSIFIER_CROP_DETAIL_MIN)
+		(*level)++;
+}
+
+static int __build_frame(unsigned char *i420, image_pyramid_s *pyramid, region_set_s *regions)
+{
+	unsigned int size = FRAME_WIDTH * FRAME_HEIGHT * 3 / 2;
+	unsigned int offsets[1] = { 0 };
+	image_frame_view_s view;
+	unsigned int i = 0;
+	unsigned int y = 0;
+
+	memset(i420, BACKGROUND, FRAME_WIDTH * FRAME_HEIGHT);
+	memset(i420 + FRAME_WIDTH * FRAME_HEIGHT, 128, FRAME_WIDTH * FRAME_HEIGHT / 2);
+
+	memset(regions, 0, sizeof(region_set_s));
+	for (i = 0; i < KNOWN_REGION_COUNT; i++) {
+		const known_region_s *region = &known_regions[i];
+
+		if (region->dark) {
+			for (y = region->y; y < region->y + region->height; y++)
+				memset(i420 + y * FRAME_WIDTH + region->x, OBJECT, region->width);
+		}
+		regions->x[i] = region->x;
+		regions->y[i] = region->y;
+		regions->width[i] = region->width;
+		regions->height[i] = region->height;
+		regions->pixels[i] = region->width * region->height;
+	}
+	regions->count = KNOWN_REGION_COUNT;
+
+	if (image_frame_view_init(&view, CAMERA_PIXEL_FORMAT_I420, FRAME_WIDTH, FRAME_HEIGHT, i420,
+			1, offsets, &size, NULL))
+		return -1;
+
+	return image_pyramid_build(pyramid, &view, IMAGE_PYRAMID_LEVEL_MAX);
+}
+
+/* Each region on its own, to see the crop the detector was given */
+static int __test_crops(image_pyramid_s *pyramid, const region_set_s *regions)
+{
+	region_class_e classes[REGION_SET_MAX];
+	stub_detector_s stub = { pyramid, };
+	region_classifier_h classifier = NULL;
+	region_set_s single;
+	unsigned int i = 0;
+	int failed = 0;
+
+	classifier = region_classifier_create(__stub_detect, &stub, 1000);
+	for (i = 0; i < KNOWN_REGION_COUNT; i++) {
+		const known_region_s *region = &known_regions[i];
+		unsigned int calls = stub.calls;
+		unsigned int x = 0, y = 0, width = 0, height = 0, level = 0;
+		int small = 0;
+
+		memset(&single, 0, sizeof(region_set_s));
+		single.x[0] = regions->x[i];
+		single.y[0] = regions->y[i];
+		single.width[0] = regions->width[i];
+		single.height[0] = regions->height[i];
+		single.pixels[0] = regions->pixels[i];
+		single.count = 1;
+		region_classifier_run(classifier, pyramid, 0, &single, classes);
+
+		__expected_crop(region, &x, &y, &width, &height, &level);
+		small = width < REGION_CLASSIFIER_CROP_SIZE_MIN || height < REGION_CLASSIFIER_CROP_SIZE_MIN;
+		printf("%-12s %3ux%-3u crop %3ux%-3u at level %u  %s\n", region->name, region->width, region->height,
+			small ? 0 : width >> level, small ? 0 : height >> level, small ? 0 : level,
+			classes[0] == REGION_CLASS_OBJECT ? "object" : classes[0] == REGION_CLASS_NONE ? "none" : "unknown");
+
+		if (classes[0] != region->expected) {
+			fprintf(stderr, "%s: wrong class\n", region->name);
+			failed++;
+		}
+		if (small) {
+			if (stub.calls != calls) {
+				fprintf(stderr, "%s: a crop under %u pixels reached the detector\n", region->name,
+					REGION_CLASSIFIER_CROP_SIZE_MIN);
+				failed++;
+			}
+			continue;
+		}
+		if (stub.calls != calls + 1 || stub.level != level || stub.x != x >> level || stub.y != y >> level
+			|| stub.width != width >> level || stub.height != height >> level) {
+			fprintf(stderr, "%s: crop %ux%u at %u,%u of level %u instead of %ux%u at %u,%u of level %u\n",
+				region->name, stub.width, stub.height, stub.x, stub.y, stub.level,
+				width >> level, height >> level, x >> level, y >> level, level);
+			failed++;
+		}
+	}
+	region_classifier_destroy(classifier);
+
+	return failed;
+}
+
+/* The same regions again are answered from the cache */
+static int __test_cache(image_pyramid_s *pyramid, const region_set_s *regions)
+{
+	region_class_e classes[REGION_SET_MAX];
+	stub_detector_s stub = { pyramid, };
+	region_classifier_stats_s stats;
+	region_classifier_h classifier = NULL;
+	unsigned long long int runs = 0;
+	int objects = 0;
+	int failed = 0;
+
+	classifier = region_classifier_create(__stub_detect, &stub, 1000);
+	objects = region_classifier_run(classifier, pyramid, 0, regions, classes);
+	region_classifier_get_stats(classifier, &stats);
+	runs = stats.runs;
+
+	region_classifier_run(classifier, pyramid, 0, regions, classes);
+	region_classifier_get_stats(classifier, &stats);
+	printf("%d objects, runs %llu, cached %llu\n", objects, stats.runs, stats.cached);
+	if (objects != 3 || stats.runs != runs || stats.cached != KNOWN_REGION_COUNT || stats.skipped) {
+		fprintf(stderr, "second pass was not answered from the cache\n");
+		failed++;
+	}
+	region_classifier_destroy(classifier);
+
+	return failed;
+}
+
+/* A slow detector on a 10 ms/s budget only gets to the first region */
+static int __test_budget(image_pyramid_s *pyramid, const region_set_s *regions)
+{
+	region_class_e classes[REGION_SET_MAX];
+	stub_detector_s stub = { pyramid, };
+	region_classifier_stats_s stats;
+	region_classifier_h classifier = NULL;
+	int failed = 0;
+
+	stub.usec = SLOW_DETECT_USEC;
+	classifier = region_classifier_create(__stub_detect, &stub, 10);
+	region_classifier_run(classifier, pyramid, 0, regions, classes);
+	region_classifier_get_stats(classifier, &stats);
+	printf("slow detector: runs %llu, skipped %llu\n", stats.runs, stats.skipped);
+	if (stats.runs != 1 || classes[0] != REGION_CLASS_OBJECT || classes[1] != REGION_CLASS_UNKNOWN
+		|| stats.skipped != KNOWN_REGION_COUNT - 1) {
+		fprintf(stderr, "the budget was not kept\n");
+		failed++;
+	}
+	region_classifier_destroy(classifier);
+
+	return failed;
+}
+
+int main(void)
+{
+	static unsigned char i420[FRAME_WIDTH * FRAME_HEIGHT * 3 / 2];
+	image_pyramid_s pyramid = { 0, };
+	region_set_s regions;
+	int failed = 0;
+
+	if (__build_frame(i420, &pyramid, &regions)) {
+		fprintf(stderr, "can not build the frame pyramid\n");
+		return 1;
+	}
+
+	failed += __test_crops(&pyramid, &regions);
+	failed += __test_cache(&pyramid, &regions);
+	failed += __test_budget(&pyramid, &regions);
+
+	image_pyramid_release(&pyramid);
+
+	printf("%s\n", failed ? "FAILED" : "crops, cache and budget are right");
+
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host test of region_extract on the worst 640x480 masks: a checkerboard
+ * (one component, every cell unions with its diagonals), isolated dots
+ * (the most labels a mask can take), a comb whose teeth are joined on the
+ * last row (the longest union chains), 50% noise and a full mask. Each is
+ * checked for its regions and timed, and the slowest run of each has to
+ * stay within REGION_EXTRACT_VGA_LATENCY_US of region_extract.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "region_extract.h"
+
+#define MASK_WIDTH 640
+#define MASK_HEIGHT 480
+#define MASK_GAP 2
+#define RUNS 50
+
+typedef void (*draw_fn)(unsigned char *mask, unsigned int width, unsigned int height);
+
+static double __get_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000.0 + ts.tv_nsec / 1000.0;
+}
+
+static void __draw_checkerboard(unsigned char *mask, unsigned int width, unsigned int height)
+{
+	unsigned int x, y;
+
+	for (y = 0; y < height; y++)
+		for (x = 0; x < width; x++)
+			mask[y * width + x] = (x + y) & 1;
+}
+
+static void __draw_dots(unsigned char *mask, unsigned int width, unsigned int height)
+{
+	unsigned int x, y;
+
+	for (y = 0; y < height; y++)
+		for (x = 0; x < width; x++)
+			mask[y * width + x] = !(x & 1) && !(y & 1);
+}
+
+static void __draw_comb(unsigned char *mask, unsigned int width, unsigned int height)
+{
+	unsigned int x, y;
+
+	for (y = 0; y < height; y++)
+		for (x = 0; x < width; x++)
+			mask[y * width + x] = !(x & 1) || y == height - 1;
+}
+
+static void __draw_noise(unsigned char *mask, unsigned int width, unsigned int height)
+{
+	unsigned int seed = 12345;
+	unsigned int i = 0;
+
+	for (i = 0; i < width * height; i++) {
+		seed = seed * 1103515245 + 12345;
+		mask[i] = (seed >> 16) & 1;
+	}
+}
+
+static void __draw_full(unsigned char *mask, unsigned int width, unsigned int height)
+{
+	memset(mask, 1, width * height);
+}
+
+static int __check_one(const char *name, const region_set_s *set, int count,
+	unsigned int width, unsigned int height, unsigned int pixels)
+{
+	if (count != 1 || set->x[0] != 0 || set->y[0] != 0
+		|| set->width[0] != width || set->height[0] != height || set->pixels[0] != pixels) {
+		fprintf(stderr, "%s: %d regions, first %ux%u+%u+%u of %u pixels\n", name, count,
+			set->width[0], set->height[0], set->x[0], set->y[0], set->pixels[0]);
+		return 1;
+	}
+
+	return 0;
+}
+
+static int __check_regions(const char *name, const region_set_s *set, int count)
+{
+	unsigned int cells = MASK_WIDTH * MASK_HEIGHT;
+
+	if (!strcmp(name, "checkerboard"))
+		return __check_one(name, set, count, MASK_WIDTH, MASK_HEIGHT, cells / 2);
+	if (!strcmp(name, "comb"))
+		return __check_one(name, set, count, MASK_WIDTH, MASK_HEIGHT,
+			MASK_WIDTH / 2 * (MASK_HEIGHT - 1) + MASK_WIDTH);
+	if (!strcmp(name, "full"))
+		return __check_one(name, set, count, MASK_WIDTH, MASK_HEIGHT, cells);
+
+	/* dots are 2 cells apart, within the gap, and merge as far as the candidates reach */
+	if (count <= 0 || count > REGION_SET_MAX) {
+		fprintf(stderr, "%s: %d regions\n", name, count);
+		return 1;
+	}
+
+	return 0;
+}
+
+static int __test_mask(region_extract_h extract, unsigned char *mask, const char *name, draw_fn draw)
+{
+	region_set_s set;
+	double worst = 0;
+	double total = 0;
+	int count = 0;
+	int failed = 0;
+	int i = 0;
+
+	draw(mask, MASK_WIDTH, MASK_HEIGHT);
+
+	/* The first run grows the label arrays and is not timed */
+	count = region_extract_run(extract, mask, MASK_WIDTH, MASK_HEIGHT, MASK_GAP, &set);
+	failed += __check_regions(name, &set, count);
+
+	for (i = 0; i < RUNS; i++) {
+		double start = __get_us();
+		double elapsed = 0;
+
+		count = region_extract_run(extract, mask, MASK_WIDTH, MASK_HEIGHT, MASK_GAP, &set);
+		elapsed = __get_us() - start;
+
+		total += elapsed;
+		if (elapsed > worst)
+			worst = elapsed;
+	}
+	failed += __check_regions(name, &set, count);
+
+	printf("%-12s %3d regions %9.0f us avg %9.0f us worst\n", name, count, total / RUNS, worst);
+	if (worst > REGION_EXTRACT_VGA_LATENCY_US) {
+		fprintf(stderr, "%s: %.0f us over the %d us bound\n", name, worst, REGION_EXTRACT_VGA_LATENCY_US);
+		failed++;
+	}
+
+	return failed;
+}
+
+int main(void)
+{
+	unsigned char *mask = malloc(MASK_WIDTH * MASK_HEIGHT);
+	region_extract_h extract = region_extract_create();
+	int failed = 0;
+
+	if (!mask || !extract) {
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+
+	failed += __test_mask(extract, mask, "checkerboard", __draw_checkerboard);
+	failed += __test_mask(extract, mask, "dots", __draw_dots);
+	failed += __test_mask(extract, mask, "comb", __draw_comb);
+	failed += __test_mask(extract, mask, "noise", __draw_noise);
+	failed += __test_mask(extract, mask, "full", __draw_full);
+
+	region_extract_destroy(extract);
+	free(mask);
+
+	printf("%s\n", failed ? "FAILED" : "worst case masks within the latency bound");
+
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host test of scene_change on synthetic 320x240 luma: lights switching on
+ * and off are LIGHTING, while a visitor filling most of the frame close to
+ * the lens, on a textured or a flat background, is left to the motion
+ * detector. A small person and a shaken camera are checked as well.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "scene_change.h"
+
+#define FRAME_WIDTH 320
+#define FRAME_HEIGHT 240
+
+typedef enum {
+	BACKGROUND_TEXTURED,
+	BACKGROUND_FLAT,
+} background_e;
+
+static unsigned char previous[FRAME_WIDTH * FRAME_HEIGHT];
+static unsigned char current[FRAME_WIDTH * FRAME_HEIGHT];
+
+static int __clip(int value)
+{
+	return value < 0 ? 0 : value > 255 ? 255 : value;
+}
+
+/* Luma 0 ~ 99 of a cell of the coarse random pattern, the same for each call */
+static int __cell(int cx, int cy)
+{
+	unsigned int hash = (unsigned int)cx * 73856093u ^ (unsigned int)cy * 19349663u;
+
+	hash ^= hash >> 13;
+	hash *= 0x5bd1e995u;
+	hash ^= hash >> 15;
+
+	return hash % 100;
+}
+
+/* Furniture and a window: a gradient under a smooth random pattern, with sensor noise */
+static void __draw_background(unsigned char *luma, background_e background, int dx)
+{
+	unsigned int x = 0;
+	unsigned int y = 0;
+
+	for (y = 0; y < FRAME_HEIGHT; y++) {
+		for (x = 0; x < FRAME_WIDTH; x++) {
+			int sx = x + dx + 64;
+			int fx = sx % 16;
+			int fy = y % 16;
+			int value = 150;
+
+			if (background == BACKGROUND_TEXTURED) {
+				int top = __cell(sx / 16, y / 16) * (16 - fx) + __cell(sx / 16 + 1, y / 16) * fx;
+				int bottom = __cell(sx / 16, y / 16 + 1) * (16 - fx) + __cell(sx / 16 + 1, y / 16 + 1) * fx;
+
+				value = 40 + (sx * 60) / FRAME_WIDTH + (top * (16 - fy) + bottom * fy) / 256;
+			}
+			luma[y * FRAME_WIDTH + x] = __clip(value + rand() % 5 - 2);
+		}
+	}
+}
+
+static void __scale(unsigned char *luma, int percent)
+{
+	unsigned int i = 0;
+
+	for (i = 0; i < FRAME_WIDTH * FRAME_HEIGHT; i++)
+		luma[i] = __clip(luma[i] * percent / 100 + rand() % 5 - 2);
+}
+
+/* A dark coat, with a bit of texture */
+static void __draw_box(unsigned char *luma, unsigned int x0, unsigned int y0, unsigned int width, unsigned int height)
+{
+	unsigned int x = 0;
+	unsigned int y = 0;
+
+	for (y = y0; y < y0 + height; y++)
+		for (x = x0; x < x0 + width; x++)
+			luma[y * FRAME_WIDTH + x] = 35 + ((x / 8 + y / 8) % 2) * 10 + rand() % 5 - 2;
+}
+
+static scene_change_e __compare(scene_change_info_s *info)
+{
+	image_luma_s luma = { previous, FRAME_WIDTH, FRAME_HEIGHT, FRAME_WIDTH };
+	scene_change_h scene = NULL;
+	scene_change_e change = SCENE_CHANGE_NONE;
+
+	scene = scene_change_create();
+	scene_change_update(scene, &luma);
+	luma.data = current;
+	change = scene_change_update(scene, &luma);
+	scene_change_get_info(scene, info);
+	scene_change_destroy(scene);
+
+	return change;
+}
+
+static int __check(const char *name, scene_change_e expected)
+{
+	static const char *names[] = { "none", "lighting", "shake" };
+	scene_change_info_s info;
+	scene_change_e change = __compare(&info);
+
+	printf("%-22s %-8s mean %3u -> %3u, %2u cells changed, gain %3u%% in %2u cells, histogram %2u%% moved %2u%% off\n",
+		name, names[change], info.previous_mean, info.mean, info.changed_cells,
+		info.gain, info.gain_cells, info.histogram_distance, info.histogram_reshape);
+	if (change != expected) {
+		fprintf(stderr, "%s: %s instead of %s\n", name, names[change], names[expected]);
+		return 1;
+	}
+
+	return 0;
+}
+
+int main(void)
+{
+	int failed = 0;
+
+	srand(1);
+
+	__draw_background(previous, BACKGROUND_TEXTURED, 0);
+	memcpy(current, previous, sizeof(current));
+	__scale(current, 150);
+	failed += __check("lights on", SCENE_CHANGE_LIGHTING);
+
+	memcpy(current, previous, sizeof(current));
+	__scale(current, 50);
+	failed += __check("lights off", SCENE_CHANGE_LIGHTING);
+
+	/* the window burns out */
+	memcpy(current, previous, sizeof(current));
+	__scale(current, 190);
+	failed += __check("lights on, clipped", SCENE_CHANGE_LIGHTING);
+
+	__draw_background(current, BACKGROUND_TEXTURED, 0);
+	__draw_box(current, 20, 10, 280, 230);
+	failed += __check("close to the lens", SCENE_CHANGE_NONE);
+
+	__draw_background(previous, BACKGROUND_FLAT, 0);
+	__draw_background(current, BACKGROUND_FLAT, 0);
+	__draw_box(current, 0, 0, FRAME_WIDTH, 200);
+	failed += __check("close, flat wall", SCENE_CHANGE_NONE);
+
+	__draw_background(previous, BACKGROUND_TEXTURED, 0);
+	__draw_background(current, BACKGROUND_TEXTURED, 0);
+	__draw_box(current, 140, 60, 40, 120);
+	failed += __check("person", SCENE_CHANGE_NONE);
+
+	__draw_background(current, BACKGROUND_TEXTURED, 8);
+	failed += __check("shake", SCENE_CHANGE_SHAKE);
+
+	printf("%s\n", failed ? "FAILED" : "lighting is told from large near objects");
+
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,250 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host test of the unchanged frame skip of controller.c together with the
+ * motion detector and the tracker. Every frame goes to the detector, and
+ * only encoding and writing is skipped for a frame the block signature
+ * finds unchanged while no track is alive, as in __is_static_frame().
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "frame_signature.h"
+#include "motion_detector.h"
+#include "region_tracker.h"
+
+#define FRAME_WIDTH 320
+#define FRAME_HEIGHT 240
+#define FRAME_INTERVAL_MS 50
+#define BACKGROUND 120
+
+/* the defaults of controller.c and controller_mv.c */
+#define STATIC_THRESHOLD 2
+#define STATIC_REFRESH_MS 10000
+#define TRACK_CONFIRM_HITS 5
+#define TRACK_TIMEOUT_MS 1000
+
+typedef struct {
+	motion_detector_h detector;
+	region_tracker_h tracker;
+	frame_signature_h signature;
+	long long int now;
+	long long int last_written;
+	unsigned int written;
+	unsigned int skipped;
+	unsigned int entered;
+	unsigned int last_id; // track of the largest region of the last frame
+	int regions; // of the last frame
+} pipeline_s;
+
+static unsigned char frame[FRAME_WIDTH * FRAME_HEIGHT * 3 / 2];
+
+static void __draw_background(void)
+{
+	memset(frame, BACKGROUND, FRAME_WIDTH * FRAME_HEIGHT);
+	memset(frame + FRAME_WIDTH * FRAME_HEIGHT, 128, FRAME_WIDTH * FRAME_HEIGHT / 2);
+}
+
+static void __draw_box(unsigned int x, unsigned int y, unsigned int width, unsigned int height, int value)
+{
+	unsigned int row = 0;
+
+	for (row = y; row < y + height; row++)
+		memset(frame + row * FRAME_WIDTH + x, value, width);
+}
+
+/* One frame through detection, tracking and the skip of controller.c */
+static void __push(pipeline_s *pipeline)
+{
+	unsigned int size = sizeof(frame);
+	unsigned int offsets[1] = { 0 };
+	image_luma_s luma = { frame, FRAME_WIDTH, FRAME_HEIGHT, FRAME_WIDTH };
+	region_track_info_s info[REGION_SET_MAX];
+	image_frame_view_s view;
+	region_set_s regions;
+	int unchanged = 0;
+
+	pipeline->now += FRAME_INTERVAL_MS;
+	image_frame_view_init(&view, CAMERA_PIXEL_FORMAT_I420, FRAME_WIDTH, FRAME_HEIGHT, frame, 1, offsets, &size, NULL);
+
+	pipeline->regions = motion_detector_process(pipeline->detector, &luma, &regions);
+	pipeline->last_id = 0;
+	if (pipeline->regions > 0) {
+		pipeline->entered += region_tracker_update(pipeline->tracker, &regions, NULL, pipeline->now, info);
+		pipeline->last_id = info[0].id;
+	}
+
+	if (region_tracker_get_count(pipeline->tracker, pipeline->now)) {
+		frame_signature_reset(pipeline->signature);
+		frame_signature_update(pipeline->signature, &view, STATIC_THRESHOLD);
+		pipeline->last_written = pipeline->now;
+		pipeline->written++;
+		return;
+	}
+
+	if (pipeline->now >= pipeline->last_written + STATIC_REFRESH_MS)
+		frame_signature_reset(pipeline->signature);
+	unchanged = frame_signature_update(pipeline->signature, &view, STATIC_THRESHOLD);
+	if (unchanged == 1) {
+		pipeline->skipped++;
+	} else {
+		pipeline->last_written = pipeline->now;
+		pipeline->written++;
+	}
+}
+
+static void __create(pipeline_s *pipeline)
+{
+	memset(pipeline, 0, sizeof(pipeline_s));
+	pipeline->detector = motion_detector_create(20);
+	pipeline->tracker = region_tracker_create(TRACK_CONFIRM_HITS, TRACK_TIMEOUT_MS);
+	pipeline->signature = frame_signature_create();
+
+	/* an empty scene to learn */
+	__draw_background();
+	while (pipeline->now < 2000)
+		__push(pipeline);
+}
+
+static void __destroy(pipeline_s *pipeline)
+{
+	frame_signature_destroy(pipeline->signature);
+	region_tracker_destroy(pipeline->tracker);
+	motion_detector_destroy(pipeline->detector);
+}
+
+/* Someone walks in, stands still for 3 s, then walks on: one track, one alert */
+static int __test_standing_person(void)
+{
+	pipeline_s pipeline;
+	unsigned int id = 0;
+	unsigned int x = 10;
+	unsigned int i = 0;
+	int failed = 0;
+
+	__create(&pipeline);
+
+	for (i = 0; i < 20; i++, x += 4) {
+		__draw_background();
+		__draw_box(x, 80, 32, 80, 40);
+		__push(&pipeline);
+	}
+	id = pipeline.last_id;
+
+	/* the same frame over and over, the signature finds nothing changed */
+	pipeline.skipped = 0;
+	for (i = 0; i < 3000 / FRAME_INTERVAL_MS; i++) {
+		__push(&pipeline);
+		if (pipeline.last_id != id) {
+			fprintf(stderr, "standing person: track %u became %u after %u ms still\n",
+				id, pipeline.last_id, i * FRAME_INTERVAL_MS);
+			failed++;
+			break;
+		}
+	}
+	if (pipeline.skipped) {
+		fprintf(stderr, "standing person: %u frames skipped while tracked\n", pipeline.skipped);
+		failed++;
+	}
+
+	for (i = 0; i < 20; i++, x += 4) {
+		__draw_background();
+		__draw_box(x, 80, 32, 80, 40);
+		__push(&pipeline);
+	}
+	if (!id || pipeline.last_id != id || pipeline.entered != 1) {
+		fprintf(stderr, "standing person: track %u then %u, %u alerts\n", id, pipeline.last_id, pipeline.entered);
+		failed++;
+	}
+	printf("standing person: track %u kept over 3 s still, %u alert\n", pipeline.last_id, pipeline.entered);
+
+	__destroy(&pipeline);
+
+	return failed;
+}
+
+/* A 4x4 object 30 levels off the background is below the signature threshold */
+static int __test_small_object(void)
+{
+	pipeline_s pipeline;
+	unsigned int i = 0;
+	int failed = 0;
+	int seen = 0;
+
+	__create(&pipeline);
+
+	pipeline.skipped = 0;
+	pipeline.written = 0;
+	__draw_box(160, 120, 4, 4, BACKGROUND - 30);
+	for (i = 0; i < 10; i++) {
+		__push(&pipeline);
+		if (pipeline.regions > 0)
+			seen++;
+	}
+
+	if (!seen || pipeline.skipped == i) {
+		fprintf(stderr, "small object: seen in %d frames, %u of %u skipped\n", seen, pipeline.skipped, i);
+		failed++;
+	}
+	printf("small object: detected in %d of %u frames, %u written\n", seen, i, pipeline.written);
+
+	__destroy(&pipeline);
+
+	return failed;
+}
+
+/* Once the tracks ended, a still scene is skipped but for the refresh */
+static int __test_still_scene(void)
+{
+	pipeline_s pipeline;
+	unsigned int frames = 0;
+	int failed = 0;
+
+	__create(&pipeline);
+
+	pipeline.skipped = 0;
+	pipeline.written = 0;
+	while (frames < 30000 / FRAME_INTERVAL_MS) {
+		__push(&pipeline);
+		frames++;
+	}
+
+	if (pipeline.written != 30000 / STATIC_REFRESH_MS || pipeline.skipped + pipeline.written != frames) {
+		fprintf(stderr, "still scene: %u written, %u skipped of %u\n", pipeline.written, pipeline.skipped, frames);
+		failed++;
+	}
+	printf("still scene: %u of %u frames written over 30 s\n", pipeline.written, frames);
+
+	__destroy(&pipeline);
+
+	return failed;
+}
+
+int main(void)
+{
+	int failed = 0;
+
+	failed += __test_standing_person();
+	failed += __test_small_object();
+	failed += __test_still_scene();
+
+	printf("%s\n", failed ? "FAILED" : "unchanged frames are skipped without losing motion");
+
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Reader of the frame ring the camera service writes next to latest.jpg,
+ * see camera/inc/jpeg_ring.h for the layout. The file is opened once and
+ * only the newest slot is read, so a frame costs two small reads and one
+ * read of the JPEG instead of opening and reading latest.jpg each time.
+ */
+
+var fs = require('fs');
+
+var MAGIC = 0x474e524a;
+var VERSION = 2;
+var HEADER_SIZE = 64;
+var SLOT_HEADER_SIZE = 64 + 1024;
+var READ_TRIES = 3;
+
+function JpegRing(path) {
+  this.path = path;
+  this.fd = -1;
+  this.slotCount = 0;
+  this.slotSize = 0;
+  this.header = new Buffer(HEADER_SIZE);
+  this.slotHeader = new Buffer(SLOT_HEADER_SIZE);
+  this.word = new Buffer(4);
+  this.frame = null;
+}
+
+JpegRing.prototype.open = function() {
+  var fd = fs.openSync(this.path, 'r');
+
+  if (fs.readSync(fd, this.header, 0, HEADER_SIZE, 0) != HEADER_SIZE ||
+      this.header.readUInt32LE(0) != MAGIC || this.header.readUInt32LE(4) != VERSION ||
+      !this.header.readUInt32LE(8) || this.header.readUInt32LE(12) <= SLOT_HEADER_SIZE ||
+      !this.header.readUInt32LE(20)) {
+    fs.closeSync(fd);
+    return false;
+  }
+
+  this.fd = fd;
+  this.slotCount = this.header.readUInt32LE(8);
+  this.slotSize = this.header.readUInt32LE(12);
+  return true;
+};
+
+JpegRing.prototype.close = function() {
+  if (this.fd >= 0)
+    fs.closeSync(this.fd);
+  this.fd = -1;
+  this.frame = null;
+};
+
+JpegRing.prototype.readWord = function(position) {
+  if (fs.readSync(this.fd, this.word, 0, 4, position) != 4)
+    return -1;
+  return this.word.readUInt32LE(0);
+};
+
+/*
+ * Returns the newest frame, { sequence, width, height, timestamp, meta, data },
+ * meta being the motion record of camera/inc/motion_meta.h,
+ * the same object until a newer one is written, or null when there is no
+ * ring or no frame yet. A ring closed or replaced by the camera service is
+ * opened again on the next call.
+ */
+JpegRing.prototype.read = function() {
+  var head, slot, lock, size, metaSize, data, i;
+
+  try {
+    if (this.fd < 0 && !this.open())
+      return null;
+
+    // open is the word at 20, cleared when the service stops
+    if (this.readWord(20) !== 1) {
+      this.close();
+      return null;
+    }
+
+    head = this.readWord(16);
+    if (head <= 0)
+      return null;
+    if (this.frame && this.frame.sequence == head)
+      return this.frame;
+
+    slot = HEADER_SIZE + ((head - 1) % this.slotCount) * this.slotSize;
+    for (i = 0; i < READ_TRIES; i++) {
+      // lock is odd while the service writes the slot
+      lock = this.readWord(slot);
+      if (lock & 1)
+        continue;
+      if (fs.readSync(this.fd, this.slotHeader, 0, SLOT_HEADER_SIZE, slot) != SLOT_HEADER_SIZE)
+        break;
+      size = this.slotHeader.readUInt32LE(24);
+      metaSize = this.slotHeader.readUInt32LE(28);
+      if (size > this.slotSize - SLOT_HEADER_SIZE || metaSize > SLOT_HEADER_SIZE - 64)
+        continue;
+      data = new Buffer(size);
+      if (fs.readSync(this.fd, data, 0, size, slot + SLOT_HEADER_SIZE) != size)
+        break;
+      if (this.readWord(slot) !== lock)
+        continue;
+
+      this.frame = {
+        sequence: this.slotHeader.readUInt32LE(4),
+        timestamp: this.slotHeader.readUInt32LE(8) * 1000 + this.slotHeader.readUInt32LE(12),
+        width: this.slotHeader.readUInt32LE(16),
+        height: this.slotHeader.readUInt32LE(20),
+        meta: this.slotHeader.slice(64, 64 + metaSize),
+        data: data
+      };
+      return this.frame;
+    }
+  } catch (err) {
+    this.close();
+    return null;
+  }
+
+  // the service kept writing over it, the previous frame is still whole
+  return this.frame;
+};
+
+module.exports = JpegRing;
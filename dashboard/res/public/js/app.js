@@ -80,6 +80,16 @@ window.onload = function(){
             console.log(res);
         })
     });
+
+    var buttonMaskElement = document.getElementById('button-mask');
+    buttonMaskElement.addEventListener('click', function () {
+        var roi = document.getElementById('mask-roi').value;
+        var exclude = document.getElementById('mask-exclude').value;
+
+        httpGetAsync("/mask?roi=" + encodeURIComponent(roi) + "&exclude=" + encodeURIComponent(exclude), function (res){
+            console.log(res);
+        })
+    });
 };
 
 function httpGetAsync(theUrl, callback)
@@ -20,6 +20,10 @@ var https = require('https');
 
 var SERVER_ROOT_FOLDER_PATH = '/opt/usr/globalapps/org.tizen.smart-surveillance-camera.dashboard/res/';
 var LATEST_FRAME_FILE_PATH = '/opt/usr/home/owner/apps_rw/org.tizen.smart-surveillance-camera/shared/data/latest.jpg'
+var FRAME_RING_FILE_PATH = '/opt/usr/home/owner/apps_rw/org.tizen.smart-surveillance-camera/shared/data/frames.ring'
+
+var JpegRing = require(SERVER_ROOT_FOLDER_PATH + 'jpeg_ring.js');
+var frameRing = new JpegRing(FRAME_RING_FILE_PATH);
 
 function extractPath(url) {
   var urlParts = url.split('/'),
@@ -66,6 +70,11 @@ http.createServer(function(req, res) {
       res.writeHead(200);
       res.end();
       sendCommand("send");
+    } else if (req.url.split('?')[0] == '/mask') {
+      // /mask?stream=N&roi=...&exclude=..., see mv.roi in the camera README
+      res.writeHead(200);
+      res.end();
+      sendCommand("mask", parseQuery(req.url, ['stream', 'roi', 'exclude']));
     } else {
       res.writeHead(404);
       res.end();
@@ -89,6 +98,7 @@ if (ENABLE_WEBSOCKET) {
   function Listener(ws) {
     console.log('Client connected: handshake done!');
     ws.ack = true;
+    ws.sequence = 0;
     ws.on('message', function (msg) {
       // console.log('Message received: %s', msg.toString());
       // ws.send(msg.toString(), {mask: true, binary: false}); //echo
@@ -110,6 +120,16 @@ if (ENABLE_WEBSOCKET) {
         return false;
       // var now = Date.now();
       var data;
+      // clients share the ring reader and only get frames they have not seen
+      var frame = frameRing.read();
+      if (frame) {
+        if (frame.sequence == ws.sequence)
+          return false;
+        ws.sequence = frame.sequence;
+        ws.send(frame.data, {mask: false, binary: true});
+        ws.ack = false;
+        return true;
+      }
       try {
         data = fs.readFileSync(LATEST_FRAME_FILE_PATH);
       } catch (err) {
@@ -147,12 +167,30 @@ var data = {
   command: 'command'
 };
 
-function sendCommand(msg) {
-  data.command = msg;
+function parseQuery(url, keys) {
+  var query = url.split('?')[1] || '';
+  var params = query.split('&');
+  var result = {};
+
+  for (var i = 0; i < params.length; i++) {
+    var pair = params[i].split('=');
+    if (keys.indexOf(pair[0]) >= 0 && pair.length == 2)
+      result[pair[0]] = decodeURIComponent(pair[1].replace(/\+/g, ' '));
+  }
+  return result;
+}
+
+function sendCommand(msg, extra) {
+  var extra_data = {};
+  for (var key in data)
+    extra_data[key] = data[key];
+  for (var key in extra)
+    extra_data[key] = extra[key];
+  extra_data.command = msg;
   try {
     var res = tizen.launchAppControl({
       app_id: app_id,
-      extra_data: data,
+      extra_data: extra_data,
     });
     console.log('Result', res);
   } catch(e) {